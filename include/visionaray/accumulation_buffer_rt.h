@@ -0,0 +1,85 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_ACCUMULATION_BUFFER_RT_H
+#define VSNRAY_ACCUMULATION_BUFFER_RT_H 1
+
+#include "detail/thread_pool.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+#include "pixel_format.h"
+#include "render_target.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Render target for progressive rendering
+//
+// Keeps a running sum of RGBA samples in float or double precision and a sample count per
+// pixel. Render with a uniform or jittered pixel sampler, the samples are added instead of
+// blended on top of the previous frame. resolve() converts the per-pixel means (optionally
+// tonemapped) to a display render target in a separate parallel pass, e.g. only when a frame
+// is presented:
+//
+//  accumulation_buffer_rt<double> accum;
+//  accum.resize(w, h);
+//  ...
+//  sched.frame(kernel, make_sched_params(pixel_sampler::jittered_type{}, cam, accum));
+//  accum.resolve(pool, display_rt.ref());
+//
+
+template <typename T = float>
+class accumulation_buffer_rt : public render_target
+{
+public:
+
+    using accum_type    = vector<4, T>;
+
+    using ref_type      = accumulation_target_ref<T>;
+
+public:
+
+    accum_type* sums();
+    unsigned* counts();
+
+    accum_type const* sums() const;
+    unsigned const* counts() const;
+
+    ref_type ref();
+
+    // Discard all samples
+    void clear();
+    void begin_frame();
+    void end_frame();
+    void resize(int w, int h);
+
+    // Add the samples of another buffer of the same size, e.g. a partial render of the
+    // same frames with a different sample offset
+    void merge(accumulation_buffer_rt const& rhs);
+
+    // Mean of the samples of pixel (x, y), 0 if the pixel has no samples
+    vec4 average(int x, int y) const;
+
+    // Store the per-pixel means in the color buffer of dst, which must have the same size
+    template <pixel_format CF, pixel_format DF>
+    void resolve(thread_pool& pool, render_target_ref<CF, DF> dst) const;
+
+    // Same, but apply tonemap (vec4 -> vec4) to each mean before color conversion
+    template <pixel_format CF, pixel_format DF, typename Tonemap>
+    void resolve(thread_pool& pool, render_target_ref<CF, DF> dst, Tonemap tonemap) const;
+
+private:
+
+    aligned_vector<accum_type> sum_buffer;
+    aligned_vector<unsigned>   count_buffer;
+
+};
+
+} // visionaray
+
+#include "detail/accumulation_buffer_rt.inl"
+
+#endif // VSNRAY_ACCUMULATION_BUFFER_RT_H
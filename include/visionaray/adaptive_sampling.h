@@ -0,0 +1,267 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_ADAPTIVE_SAMPLING_H
+#define VSNRAY_ADAPTIVE_SAMPLING_H 1
+
+#include <cfloat>
+#include <cstddef>
+#include <type_traits>
+
+#include "detail/color_conversion.h"
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+#include "math/vector.h"
+#include "packet_traits.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Running luminance statistics of a pixel (Welford's algorithm), and the estimated relative
+// error of the pixel's mean. The error is FLT_MAX until the pixel has enough samples
+//
+
+struct pixel_stats
+{
+    float    mean;
+    float    m2;
+    unsigned count;
+    float    error;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Convergence of an image rendered with adaptive sampling
+//
+
+struct convergence_info
+{
+    size_t num_pixels;
+    size_t num_converged;
+
+    // Mean and max error of the pixels with enough samples
+    float  mean_error;
+    float  max_error;
+
+    bool converged() const
+    {
+        return num_converged == num_pixels;
+    }
+};
+
+
+namespace detail
+{
+
+VSNRAY_FUNC
+inline pixel_stats initial_pixel_stats()
+{
+    return { 0.0f, 0.0f, 0U, FLT_MAX };
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Add a sample to the pixel stats, returns the weight of the sample in the pixel's mean
+//
+
+VSNRAY_FUNC
+inline float update_pixel_stats(pixel_stats& stats, float luminance, unsigned min_samples)
+{
+    stats.count++;
+
+    float delta = luminance - stats.mean;
+    stats.mean += delta / stats.count;
+    stats.m2 += delta * (luminance - stats.mean);
+
+    if (stats.count >= max(min_samples, 2U))
+    {
+        // Standard error of the mean, relative to the mean. Dark pixels are compared
+        // against a small absolute error instead
+        float variance = stats.m2 / (stats.count - 1);
+        stats.error = sqrt(variance / stats.count) / max(stats.mean, 1e-3f);
+    }
+
+    return 1.0f / stats.count;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Check if all pixels of a packet converged. Lanes are laid out like with expand_pixel,
+// lanes outside the image count as converged
+//
+
+VSNRAY_FUNC
+inline bool pixels_converged(
+        float               /* */,
+        pixel_stats const*  stats,
+        int                 x,
+        int                 y,
+        int                 width,
+        int                 height,
+        float               max_error
+        )
+{
+    return x >= width || y >= height || stats[y * width + x].error < max_error;
+}
+
+template <
+    typename S,
+    typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type
+    >
+VSNRAY_FUNC
+inline bool pixels_converged(
+        S                   /* */,
+        pixel_stats const*  stats,
+        int                 x,
+        int                 y,
+        int                 width,
+        int                 height,
+        float               max_error
+        )
+{
+    int w = packet_size<S>::w;
+
+    for (int i = 0; i < simd::num_elements<S>::value; ++i)
+    {
+        if (!pixels_converged(float{}, stats, x + i % w, y + i / w, width, height, max_error))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Add the samples of a packet to the pixel stats. Returns the per-pixel blend weights for
+// the samples, 0 for pixels that already converged
+//
+
+VSNRAY_FUNC
+inline float update_pixel_stats(
+        float               luminance,
+        pixel_stats*        stats,
+        int                 x,
+        int                 y,
+        int                 width,
+        int                 height,
+        float               max_error,
+        unsigned            min_samples
+        )
+{
+    if (pixels_converged(float{}, stats, x, y, width, height, max_error))
+    {
+        return 0.0f;
+    }
+
+    return update_pixel_stats(stats[y * width + x], luminance, min_samples);
+}
+
+template <
+    typename S,
+    typename = typename std::enable_if<simd::is_simd_vector<S>::value>::type
+    >
+VSNRAY_FUNC
+inline S update_pixel_stats(
+        S const&            luminance,
+        pixel_stats*        stats,
+        int                 x,
+        int                 y,
+        int                 width,
+        int                 height,
+        float               max_error,
+        unsigned            min_samples
+        )
+{
+    using float_array = simd::aligned_array_t<S>;
+
+    float_array lum;
+    float_array weights;
+
+    store(lum, luminance);
+
+    int w = packet_size<S>::w;
+
+    for (int i = 0; i < simd::num_elements<S>::value; ++i)
+    {
+        weights[i] = update_pixel_stats(
+                lum[i],
+                stats,
+                x + i % w,
+                y + i / w,
+                width,
+                height,
+                max_error,
+                min_samples
+                );
+    }
+
+    return S(weights);
+}
+
+template <typename S>
+VSNRAY_FUNC
+inline S sample_luminance(vector<4, S> const& color)
+{
+    return rgb_to_luminance(color.xyz());
+}
+
+template <typename S>
+VSNRAY_FUNC
+inline S sample_luminance(vector<3, S> const& color)
+{
+    return rgb_to_luminance(color);
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Compute the convergence metric from per-pixel stats
+//
+
+inline convergence_info compute_convergence(
+        pixel_stats const*  stats,
+        size_t              num_pixels,
+        float               max_error
+        )
+{
+    convergence_info result = { num_pixels, 0, 0.0f, 0.0f };
+
+    double error_sum = 0.0;
+    size_t num_valid = 0;
+
+    for (size_t i = 0; i < num_pixels; ++i)
+    {
+        float error = stats[i].error;
+
+        if (error < max_error)
+        {
+            ++result.num_converged;
+        }
+
+        if (error < FLT_MAX)
+        {
+            error_sum += error;
+            ++num_valid;
+            result.max_error = max(result.max_error, error);
+        }
+    }
+
+    result.mean_error = num_valid > 0 ? static_cast<float>(error_sum / num_valid) : FLT_MAX;
+
+    if (num_valid < num_pixels)
+    {
+        result.max_error = FLT_MAX;
+    }
+
+    return result;
+}
+
+} // visionaray
+
+#endif // VSNRAY_ADAPTIVE_SAMPLING_H
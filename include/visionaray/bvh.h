@@ -63,7 +63,8 @@ struct VSNRAY_ALIGN(32) bvh_node
         unsigned first_prim;
     };
     float bbox_max[3];
-    unsigned num_prims;
+    unsigned num_prims  : 30;
+    unsigned split_axis :  2; // Inner nodes: first child is on the lower side of this axis
 
     VSNRAY_FUNC bool is_inner() const { return num_prims == 0; }
     VSNRAY_FUNC bool is_leaf() const { return num_prims != 0; }
@@ -104,22 +105,32 @@ struct VSNRAY_ALIGN(32) bvh_node
         return num_prims;
     }
 
-    VSNRAY_FUNC void set_inner(aabb const& bounds, unsigned first_child_index)
+    VSNRAY_FUNC unsigned get_split_axis() const
     {
+        assert(is_inner());
+        return split_axis;
+    }
+
+    VSNRAY_FUNC void set_inner(aabb const& bounds, unsigned first_child_index, unsigned axis = 0)
+    {
+        assert(axis < 3);
+
         memcpy(bbox_min, &bounds.min, sizeof(bbox_min));
         memcpy(bbox_max, &bounds.max, sizeof(bbox_max));
         first_child = first_child_index;
         num_prims = 0;
+        split_axis = axis;
     }
 
     VSNRAY_FUNC void set_leaf(aabb const& bounds, unsigned first_primitive_index, unsigned count)
     {
-        assert(count > 0);
+        assert(count > 0 && count < (1U << 30));
 
         memcpy(bbox_min, &bounds.min, sizeof(bbox_min));
         memcpy(bbox_max, &bounds.max, sizeof(bbox_max));
         first_prim = first_primitive_index;
         num_prims = count;
+        split_axis = 0;
     }
 };
 
@@ -408,7 +419,7 @@ public:
 
     template <typename PV, typename NV>
     explicit bvh_t(bvh_t<PV, NV> const& rhs)
-        : primitives_(rhs.primitives())
+        : primitives_(rhs.primitives().begin(), rhs.primitives().end())
         , nodes_(rhs.nodes())
     {
     }
@@ -489,7 +500,7 @@ public:
 
     template <typename PV, typename NV, typename IV>
     explicit index_bvh_t(index_bvh_t<PV, NV, IV> const& rhs)
-        : primitives_(rhs.primitives())
+        : primitives_(rhs.primitives().begin(), rhs.primitives().end())
         , nodes_(rhs.nodes())
         , indices_(rhs.indices())
     {
@@ -606,6 +617,14 @@ struct is_any_bvh_inst : std::integral_constant<bool, is_bvh_inst<T>::value || i
 {
 };
 
+// BVHs with more than two children per node (specializations in detail/bvh/wide_bvh.h)
+template <typename T>
+struct is_wide_bvh : std::false_type {};
+
+// BVHs with quantized node bounds (specializations in detail/bvh/quantized_bvh.h)
+template <typename T>
+struct is_quantized_bvh : std::false_type {};
+
 
 //-------------------------------------------------------------------------------------------------
 // Typedefs
@@ -639,6 +658,16 @@ template <typename Tree, typename P>
 Tree build(P* primitives, size_t num_prims, bool use_spatial_splits = false);
 
 
+//-------------------------------------------------------------------------------------------------
+// refit() interface
+//
+// Updates the node bounds after the primitives were modified, keeps the topology
+//
+
+template <typename Tree>
+void refit(Tree& tree);
+
+
 //-------------------------------------------------------------------------------------------------
 // Traversal algorithms
 //
@@ -663,8 +692,13 @@ void traverse_parents(B const& b, N const& n, F func);
 #include "detail/bvh/get_tex_coord.h"
 #include "detail/bvh/hit_record.h"
 #include "detail/bvh/intersect.inl"
+#include "detail/bvh/intersect_stream.inl"
+#include "detail/bvh/intersect_wide.inl"
 #include "detail/bvh/prim_traits.h"
+#include "detail/bvh/quantized_bvh.h"
+#include "detail/bvh/refit.h"
 #include "detail/bvh/statistics.h"
 #include "detail/bvh/traverse.h"
+#include "detail/bvh/wide_bvh.h"
 
 #endif // VSNRAY_BVH_H
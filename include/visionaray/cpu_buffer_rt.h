@@ -8,6 +8,7 @@
 
 #include <memory>
 
+#include "adaptive_sampling.h"
 #include "pixel_traits.h"
 #include "render_target.h"
 
@@ -44,6 +45,13 @@ public:
     void resize(int w, int h);
     void display_color_buffer() const;
 
+    // Per-pixel statistics for pixel_sampler::adaptive_blend_type, allocated on first use.
+    // Reset by resize() and clear_color_buffer()
+    pixel_stats* stats();
+
+    // Convergence of the pixels rendered with adaptive sampling
+    convergence_info convergence(float max_error) const;
+
 private:
 
     struct impl;
@@ -0,0 +1,159 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+#include "color_conversion.h"
+#include "parallel_for.h"
+#include "range.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+struct identity_tonemap
+{
+    vec4 operator()(vec4 const& color) const
+    {
+        return color;
+    }
+};
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Accessors
+//
+
+template <typename T>
+typename accumulation_buffer_rt<T>::accum_type* accumulation_buffer_rt<T>::sums()
+{
+    return sum_buffer.data();
+}
+
+template <typename T>
+unsigned* accumulation_buffer_rt<T>::counts()
+{
+    return count_buffer.data();
+}
+
+template <typename T>
+typename accumulation_buffer_rt<T>::accum_type const* accumulation_buffer_rt<T>::sums() const
+{
+    return sum_buffer.data();
+}
+
+template <typename T>
+unsigned const* accumulation_buffer_rt<T>::counts() const
+{
+    return count_buffer.data();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Interface
+//
+
+template <typename T>
+typename accumulation_buffer_rt<T>::ref_type accumulation_buffer_rt<T>::ref()
+{
+    return { sums(), counts(), width(), height() };
+}
+
+template <typename T>
+void accumulation_buffer_rt<T>::clear()
+{
+    std::fill(sum_buffer.begin(), sum_buffer.end(), accum_type(0.0));
+    std::fill(count_buffer.begin(), count_buffer.end(), 0U);
+}
+
+template <typename T>
+void accumulation_buffer_rt<T>::begin_frame()
+{
+}
+
+template <typename T>
+void accumulation_buffer_rt<T>::end_frame()
+{
+}
+
+template <typename T>
+void accumulation_buffer_rt<T>::resize(int w, int h)
+{
+    render_target::resize(w, h);
+
+    // Samples of the old size are meaningless
+    sum_buffer.assign(static_cast<size_t>(w) * h, accum_type(0.0));
+    count_buffer.assign(static_cast<size_t>(w) * h, 0U);
+}
+
+template <typename T>
+void accumulation_buffer_rt<T>::merge(accumulation_buffer_rt const& rhs)
+{
+    assert(rhs.width() == width() && rhs.height() == height());
+
+    for (size_t i = 0; i < sum_buffer.size(); ++i)
+    {
+        sum_buffer[i] += rhs.sum_buffer[i];
+        count_buffer[i] += rhs.count_buffer[i];
+    }
+}
+
+template <typename T>
+vec4 accumulation_buffer_rt<T>::average(int x, int y) const
+{
+    size_t idx = static_cast<size_t>(y) * width() + x;
+
+    unsigned count = count_buffer[idx];
+
+    if (count == 0)
+    {
+        return vec4(0.0f);
+    }
+
+    return vec4(sum_buffer[idx] / T(count));
+}
+
+template <typename T>
+template <pixel_format CF, pixel_format DF>
+void accumulation_buffer_rt<T>::resolve(thread_pool& pool, render_target_ref<CF, DF> dst) const
+{
+    resolve(pool, dst, detail::identity_tonemap{});
+}
+
+template <typename T>
+template <pixel_format CF, pixel_format DF, typename Tonemap>
+void accumulation_buffer_rt<T>::resolve(
+        thread_pool&                pool,
+        render_target_ref<CF, DF>   dst,
+        Tonemap                     tonemap
+        ) const
+{
+    assert(dst.width() == width() && dst.height() == height());
+
+    auto color = dst.color();
+    int w = width();
+
+    // A few rows per work item, so that threads don't share cache lines of dst
+    parallel_for(pool, tiled_range1d<int>(0, height(), 4), [&](range1d<int> const& rows)
+    {
+        for (int y = rows.begin(); y != rows.end(); ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                convert(
+                    pixel_format_constant<CF>{},
+                    pixel_format_constant<PF_RGBA32F>{},
+                    color[y * w + x],
+                    tonemap(average(x, y))
+                    );
+            }
+        }
+    });
+}
+
+} // visionaray
@@ -42,6 +42,7 @@ inline light_sample<U> area_light<T, Geometry>::sample(Generator& gen) const
     result.normal = get_normal(hr, geometry_);
     result.area = U(area(geometry_));
     result.delta_light = false;
+    result.infinite_light = false;
 
     return result;
 }
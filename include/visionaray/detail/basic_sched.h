@@ -23,10 +23,47 @@ public:
     template <typename ...Args>
     void reset(Args&&... args);
 
+    // Tile size in pixels, rounded up to a multiple of the packet size. With 0 (the
+    // default), the tile size is adapted to the image size and the number of threads
+    void set_tile_size(int width, int height);
+
+    // Time budget per frame in seconds, e.g. to render at an interactive frame rate. Tiles
+    // that don't fit into the budget are rendered in the next frame, each tile is rendered
+    // once until all tiles were rendered. With 0 (the default), frames are always rendered
+    // completely. Requires backend support (tiled_sched).
+    // Pixels are rendered in different frames, so the samples must be accumulated per pixel,
+    // e.g. with accumulation_buffer_rt or adaptive_blend_type. frame() throws if the pixel
+    // sampler blends with per-frame blend factors (e.g. jittered_blend_type)
+    void set_frame_budget(double seconds);
+
+    // False if the last frame ran out of budget and tiles were carried over
+    bool frame_complete() const;
+
+    // Seed for the number generators of the pixel samplers, combined with pixel position
+    // and sample index. Frames only depend on the seed and the sample index, not on the
+    // order in which threads render the pixels (w/o frame budget)
+    void set_seed(unsigned seed);
+
+    // Sample index of the next frame, incremented after each frame. E.g. to split the
+    // samples of a progressive render over two processes, one renders frames [0..n), the
+    // other one starts with set_sample_offset(n), and the sums of both are merged
+    void set_sample_offset(unsigned offset);
+    unsigned sample_offset() const;
+
 private:
 
     Backend backend_;
 
+    int tile_width_ = 0;
+    int tile_height_ = 0;
+
+    double frame_budget_ = 0.0;
+
+    // Seeds random generators, advanced every frame
+    unsigned frame_num_ = 0;
+
+    unsigned seed_ = 0;
+
 };
 
 } // visionaray
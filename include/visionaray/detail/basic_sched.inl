@@ -1,10 +1,13 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <algorithm>
+#include <stdexcept>
 #include <type_traits>
 #include <utility>
 
 #include "../make_generator.h"
+#include "../pixel_sampler_types.h"
 #include "range.h"
 #include "sched_common.h"
 
@@ -16,22 +19,32 @@ namespace basic_sched_impl
 //-------------------------------------------------------------------------------------------------
 // Generate primary ray and sample pixel
 //
+// Primary rays are generated for image coordinates, results are stored at render target
+// coordinates (x, y). The two only differ for tile render targets
+//
 
-template <typename R, typename K, typename SP, typename Generator, typename ...Args>
+template <typename R, typename K, typename SP, typename Generator>
 void call_sample_pixel(
         std::false_type /* has intersector */,
         R               /* */,
         K               kernel,
         SP              sparams,
         Generator&      gen,
-        Args&&...       args
+        int             x,
+        int             y,
+        vec2i           offset,
+        vec2i           image_size
         )
 {
     auto r = detail::make_primary_rays(
             R{},
             sparams.sample_params,
             gen,
-            std::forward<Args>(args)...
+            x + offset.x,
+            y + offset.y,
+            image_size.x,
+            image_size.y,
+            sparams.cam
             );
 
     sample_pixel(
@@ -40,25 +53,36 @@ void call_sample_pixel(
             r,
             gen,
             sparams.rt.ref(),
-            std::forward<Args>(args)...
+            x,
+            y,
+            sparams.rt.width(),
+            sparams.rt.height(),
+            sparams.cam
             );
 }
 
-template <typename R, typename K, typename SP, typename Generator, typename ...Args>
+template <typename R, typename K, typename SP, typename Generator>
 void call_sample_pixel(
         std::true_type  /* has intersector */,
         R               /* */,
         K               kernel,
         SP              sparams,
         Generator&      gen,
-        Args&&...       args
+        int             x,
+        int             y,
+        vec2i           offset,
+        vec2i           image_size
         )
 {
     auto r = detail::make_primary_rays(
             R{},
             sparams.sample_params,
             gen,
-            std::forward<Args>(args)...
+            x + offset.x,
+            y + offset.y,
+            image_size.x,
+            image_size.y,
+            sparams.cam
             );
 
     sample_pixel(
@@ -69,10 +93,49 @@ void call_sample_pixel(
             r,
             gen,
             sparams.rt.ref(),
-            std::forward<Args>(args)...
+            x,
+            y,
+            sparams.rt.width(),
+            sparams.rt.height(),
+            sparams.cam
             );
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Pixel samplers that blend with the render target using per-frame blend factors
+//
+
+template <typename T>
+std::true_type is_blend_sampler_impl(pixel_sampler::basic_uniform_blend_type<T> const*);
+
+template <typename T>
+std::true_type is_blend_sampler_impl(pixel_sampler::basic_jittered_blend_type<T> const*);
+
+std::false_type is_blend_sampler_impl(void const*);
+
+template <typename PixelSampler>
+using is_blend_sampler = decltype(is_blend_sampler_impl(std::declval<PixelSampler const*>()));
+
+
+//-------------------------------------------------------------------------------------------------
+// Largest power of two tile size in [8..64] that results in a few tiles per thread
+//
+
+inline int adaptive_tile_size(int width, int height, unsigned concurrency)
+{
+    long min_tiles = 16L * std::max(concurrency, 1U);
+
+    int size = 64;
+
+    while (size > 8 && static_cast<long>(div_up(width, size)) * div_up(height, size) < min_tiles)
+    {
+        size /= 2;
+    }
+
+    return size;
+}
+
 } // basic_sched_impl
 
 
@@ -91,6 +154,14 @@ template <typename B, typename R>
 template <typename K, typename SP>
 void basic_sched<B, R>::frame(K kernel, SP sched_params)
 {
+    using pixel_sampler_type = typename std::decay<decltype(sched_params.sample_params)>::type;
+
+    if (frame_budget_ > 0.0 && basic_sched_impl::is_blend_sampler<pixel_sampler_type>::value)
+    {
+        // Tiles that are carried over would miss the blend factors of this frame
+        throw std::invalid_argument("Frame budget requires an accumulating pixel sampler or render target");
+    }
+
     sched_params.cam.begin_frame();
 
     sched_params.rt.begin_frame();
@@ -98,24 +169,49 @@ void basic_sched<B, R>::frame(K kernel, SP sched_params)
     int pw = packet_size<typename R::scalar_type>::w;
     int ph = packet_size<typename R::scalar_type>::h;
 
-    // Tile size must be be a multiple of packet size.
-    int dx = round_up(16, pw);
-    int dy = round_up(16, ph);
-
     int x0 = sched_params.scissor_box.x;
     int y0 = sched_params.scissor_box.y;
 
     int nx = x0 + sched_params.scissor_box.w;
     int ny = y0 + sched_params.scissor_box.h;
 
+    int dx = tile_width_;
+    int dy = tile_height_;
+
+    if (dx <= 0 || dy <= 0)
+    {
+        int size = basic_sched_impl::adaptive_tile_size(
+                sched_params.scissor_box.w,
+                sched_params.scissor_box.h,
+                backend_.concurrency()
+                );
+
+        dx = dx <= 0 ? size : dx;
+        dy = dy <= 0 ? size : dy;
+    }
+
+    // Tile size must be be a multiple of packet size.
+    dx = round_up(dx, pw);
+    dy = round_up(dy, ph);
+
+    unsigned frame_num = frame_num_++;
+    unsigned seed = seed_;
+
+    vec2i offset = detail::render_target_offset(sched_params.rt);
+    vec2i image_size = detail::render_target_image_size(sched_params.rt);
+
     backend_.for_each_packet(
         tiled_range2d<int>(x0, nx, dx, y0, ny, dy), pw, ph,
         [=](int x, int y)
         {
-            auto gen = make_generator(
+            auto gen = detail::make_pixel_generator(
                     typename R::scalar_type{},
                     sched_params.sample_params,
-                    detail::tic(typename R::scalar_type{})
+                    x + offset.x,
+                    y + offset.y,
+                    image_size.x,
+                    frame_num,
+                    seed
                     );
 
             basic_sched_impl::call_sample_pixel(
@@ -126,9 +222,8 @@ void basic_sched<B, R>::frame(K kernel, SP sched_params)
                     gen,
                     x,
                     y,
-                    sched_params.rt.width(),
-                    sched_params.rt.height(),
-                    sched_params.cam
+                    offset,
+                    image_size
                     );
         });
 
@@ -144,4 +239,42 @@ void basic_sched<B, R>::reset(Args&&... args)
     backend_.reset(std::forward<Args>(args)...);
 }
 
+template <typename B, typename R>
+void basic_sched<B, R>::set_tile_size(int width, int height)
+{
+    tile_width_ = width;
+    tile_height_ = height;
+}
+
+template <typename B, typename R>
+void basic_sched<B, R>::set_frame_budget(double seconds)
+{
+    frame_budget_ = seconds;
+    backend_.set_frame_budget(seconds);
+}
+
+template <typename B, typename R>
+bool basic_sched<B, R>::frame_complete() const
+{
+    return backend_.frame_complete();
+}
+
+template <typename B, typename R>
+void basic_sched<B, R>::set_seed(unsigned seed)
+{
+    seed_ = seed;
+}
+
+template <typename B, typename R>
+void basic_sched<B, R>::set_sample_offset(unsigned offset)
+{
+    frame_num_ = offset;
+}
+
+template <typename B, typename R>
+unsigned basic_sched<B, R>::sample_offset() const
+{
+    return frame_num_;
+}
+
 } // visionaray
@@ -8,11 +8,15 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <visionaray/aligned_vector.h>
 
 #include "../algorithm.h"
+#include "executor.h"
 
 namespace visionaray
 {
@@ -42,7 +46,7 @@ inline void build_top_down_impl(
     {
         auto first_child_index = static_cast<int>(nodes.size());
 
-        nodes[index].set_inner(leaf.prim_bounds, first_child_index);
+        nodes[index].set_inner(leaf.prim_bounds, first_child_index, childs.split_axis);
 
         nodes.emplace_back();
         nodes.emplace_back();
@@ -172,6 +176,275 @@ inline void build_top_down(Tree& tree, Builder& builder, I first, I last, int ma
     build_top_down_work(tree, builder, root, first, last, max_leaf_size, is_index_bvh<Tree>());
 }
 
+
+//--------------------------------------------------------------------------------------------------
+// build_top_down_parallel
+//
+// Builds the upper levels of the tree on the calling thread (the builder may use
+// the executor to process large nodes in parallel), then constructs the remaining
+// subtrees as independent tasks with build_top_down_impl. Each task uses its own
+// builder, obtained with Builder::fork(), and emits nodes and indices into local
+// lists that are finally merged into the tree.
+//
+// Requires the following builder interface in addition to build_top_down():
+//
+//  init(first, last, exec)
+//  split(childs, leaf, data, max_leaf_size, exec)
+//  fork(leaf)
+//  size(leaf)
+//
+
+template <typename Builder>
+struct build_task
+{
+    using leaf_info = typename Builder::leaf_info;
+
+    int         node_index;
+    leaf_info   leaf;
+    Builder     builder;
+};
+
+template <typename Node>
+struct build_task_result
+{
+    aligned_vector<Node, 32> nodes;
+    aligned_vector<unsigned> indices;
+};
+
+template <typename Nodes, typename Indices, typename Builder, typename Data, typename Executor>
+inline void build_top_down_parallel_impl(
+        Nodes&                      nodes,
+        Indices&                    indices,
+        Builder&                    builder,
+        typename Builder::leaf_info root,
+        Data const&                 data,
+        int                         max_leaf_size,
+        Executor&                   exec
+        )
+{
+    using node_type = typename std::decay<decltype(nodes[0])>::type;
+    using task      = build_task<Builder>;
+
+    enum
+    {
+        // Subtree tasks created per thread (for load balancing)
+        TasksPerThread = 8,
+        // Never create tasks smaller than this
+        MinTaskSize = 1024
+    };
+
+    int task_size = std::max(
+            builder.size(root) / static_cast<int>(TasksPerThread * exec.concurrency()),
+            static_cast<int>(MinTaskSize)
+            );
+
+    if (exec.concurrency() <= 1)
+    {
+        // Build the whole tree with a single task
+        task_size = builder.size(root);
+    }
+
+
+    // Split nodes on this thread until all subtrees are small enough
+
+    std::vector<task> open;
+    std::vector<task> tasks;
+
+    open.push_back({ 0, root, Builder() });
+    open.back().builder = builder.fork(open.back().leaf);
+
+    while (!open.empty())
+    {
+        task t = std::move(open.back());
+        open.pop_back();
+
+        typename Builder::leaf_infos childs;
+
+        if (t.builder.size(t.leaf) <= task_size
+         || !t.builder.split(childs, t.leaf, data, max_leaf_size, exec))
+        {
+            tasks.push_back(std::move(t));
+            continue;
+        }
+
+        auto first_child_index = static_cast<int>(nodes.size());
+
+        nodes[t.node_index].set_inner(t.leaf.prim_bounds, first_child_index, childs.split_axis);
+
+        nodes.emplace_back();
+        nodes.emplace_back();
+
+        // Right child first, the builder hands out references from the back
+        task r = { first_child_index + 1, childs[1], Builder() };
+        r.builder = t.builder.fork(r.leaf);
+
+        task l = { first_child_index + 0, childs[0], Builder() };
+        l.builder = t.builder.fork(l.leaf);
+
+        open.push_back(std::move(r));
+        open.push_back(std::move(l));
+    }
+
+
+    // Construct the subtrees in parallel
+
+    std::vector<build_task_result<node_type>> results(tasks.size());
+
+    exec.for_each(static_cast<long>(tasks.size()), [&](long i)
+    {
+        auto& t = tasks[i];
+        auto& r = results[i];
+
+        r.nodes.emplace_back();
+
+        build_top_down_impl(
+                0, // local root node index
+                r.nodes,
+                r.indices,
+                t.builder,
+                t.leaf,
+                data,
+                max_leaf_size
+                );
+
+        // Release the references early
+        t.builder = Builder();
+    });
+
+
+    // Merge the subtrees into the tree
+
+    std::vector<size_t> node_offsets(tasks.size());
+    std::vector<size_t> index_offsets(tasks.size());
+
+    size_t num_nodes = nodes.size();
+    size_t num_indices = indices.size();
+
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        // Local root is stored in the node the task was created for
+        node_offsets[i] = num_nodes - 1;
+        index_offsets[i] = num_indices;
+
+        num_nodes += results[i].nodes.size() - 1;
+        num_indices += results[i].indices.size();
+    }
+
+    nodes.resize(num_nodes);
+    indices.resize(num_indices);
+
+    exec.for_each(static_cast<long>(tasks.size()), [&](long i)
+    {
+        auto const& r = results[i];
+
+        auto node_offset = static_cast<unsigned>(node_offsets[i]);
+        auto index_offset = static_cast<unsigned>(index_offsets[i]);
+
+        for (size_t j = 0; j < r.nodes.size(); ++j)
+        {
+            auto n = r.nodes[j];
+
+            if (is_inner(n))
+            {
+                n.first_child += node_offset;
+            }
+            else
+            {
+                n.first_prim += index_offset;
+            }
+
+            nodes[j == 0 ? tasks[i].node_index : node_offset + j] = n;
+        }
+
+        std::copy(r.indices.begin(), r.indices.end(), indices.begin() + index_offset);
+    });
+}
+
+template <typename Tree, typename Builder, typename I, typename Executor>
+inline void build_top_down_parallel_work(
+        Tree&          tree,
+        Builder&       builder,
+        I              first,
+        I              last,
+        int            max_leaf_size,
+        Executor&      exec,
+        std::true_type /*is_index_bvh*/
+        )
+{
+    auto root = builder.init(first, last, exec);
+
+    tree.clear(2 * (std::distance(first, last) / max_leaf_size));
+    tree.nodes().emplace_back();
+
+    build_top_down_parallel_impl(
+            tree.nodes(),
+            tree.indices(),
+            builder,
+            root,
+            first, // primitive data
+            max_leaf_size,
+            exec
+            );
+}
+
+template <typename Tree, typename Builder, typename I, typename Executor>
+inline void build_top_down_parallel_work(
+        Tree&           tree,
+        Builder&        builder,
+        I               first,
+        I               last,
+        int             max_leaf_size,
+        Executor&       exec,
+        std::false_type /*is_index_bvh*/
+        )
+{
+    aligned_vector<unsigned> indices;
+
+    auto uss = builder.use_spatial_splits;
+
+    builder.use_spatial_splits = false;
+
+    auto root = builder.init(first, last, exec);
+
+    tree.clear(2 * (std::distance(first, last) / max_leaf_size));
+    tree.nodes().emplace_back();
+
+    build_top_down_parallel_impl(
+            tree.nodes(),
+            indices,
+            builder,
+            root,
+            first, // primitive data
+            max_leaf_size,
+            exec
+            );
+
+    builder.use_spatial_splits = uss;
+
+    assert(indices.size() == tree.primitives().size());
+
+    // Reorder the primitives according to the indices.
+    algo::reorder_n(indices.begin(), tree.primitives().begin(), indices.size());
+}
+
+template <typename Tree, typename Builder, typename I, typename Executor>
+inline void build_top_down_parallel(
+        Tree&       tree,
+        Builder&    builder,
+        I           first,
+        I           last,
+        Executor&   exec,
+        int         max_leaf_size = -1
+        )
+{
+    if (max_leaf_size <= 0)
+    {
+        max_leaf_size = 4;
+    }
+
+    build_top_down_parallel_work(tree, builder, first, last, max_leaf_size, exec, is_index_bvh<Tree>());
+}
+
 } // detail
 } // visionaray
 
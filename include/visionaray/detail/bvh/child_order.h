@@ -0,0 +1,67 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_CHILD_ORDER_H
+#define VSNRAY_DETAIL_BVH_CHILD_ORDER_H 1
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/ray.h>
+
+#include "../macros.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Policies that decide which child of a BVH node is visited first when both are hit
+//
+// Usage:
+//
+//  auto hr = intersect<detail::ClosestHit, 1, detail::split_axis_order>(ray, bvh, isect);
+//
+
+// Visit the child with the smaller entry distance first (default)
+struct distance_order
+{
+    template <typename T>
+    VSNRAY_FUNC explicit distance_order(basic_ray<T> const& /* */)
+    {
+    }
+
+    template <typename Node, typename HR>
+    VSNRAY_FUNC unsigned near_child(Node const& /* */, HR const& hr1, HR const& hr2) const
+    {
+        return all( hr1.tnear < hr2.tnear ) ? 0 : 1;
+    }
+};
+
+// Visit the child on the side of the split plane the ray starts on first. Uses the split
+// axis that the builder recorded in the node and the sign of the ray direction. Packets
+// visit the upper child first if any ray points in negative direction.
+struct split_axis_order
+{
+    template <typename T>
+    VSNRAY_FUNC explicit split_axis_order(basic_ray<T> const& ray)
+    {
+        dir_neg[0] = any( ray.dir.x < T(0.0) ) ? 1 : 0;
+        dir_neg[1] = any( ray.dir.y < T(0.0) ) ? 1 : 0;
+        dir_neg[2] = any( ray.dir.z < T(0.0) ) ? 1 : 0;
+    }
+
+    template <typename Node, typename HR>
+    VSNRAY_FUNC unsigned near_child(Node const& node, HR const& /* */, HR const& /* */) const
+    {
+        return dir_neg[node.get_split_axis()];
+    }
+
+    unsigned dir_neg[3];
+};
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_CHILD_ORDER_H
@@ -0,0 +1,161 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_EXECUTOR_H
+#define VSNRAY_DETAIL_BVH_EXECUTOR_H 1
+
+#include <visionaray/config.h>
+
+#include <algorithm>
+#include <thread>
+
+#if VSNRAY_HAVE_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#endif
+
+#include "../thread_pool.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Executors used by the BVH builders to run independent work items
+//
+// An executor provides:
+//
+//  concurrency()
+//      Number of work items that can run concurrently
+//
+//  for_each(N, FUNC)
+//      Calls FUNC(i) for i in [0..N) and blocks until all calls have returned.
+//      FUNC must not call for_each() on the same executor.
+//
+
+struct serial_executor
+{
+    unsigned concurrency() const
+    {
+        return 1;
+    }
+
+    template <typename Func>
+    void for_each(long n, Func const& func)
+    {
+        for (long i = 0; i < n; ++i)
+        {
+            func(i);
+        }
+    }
+};
+
+struct thread_pool_executor
+{
+    explicit thread_pool_executor(thread_pool& p)
+        : pool(p)
+    {
+    }
+
+    unsigned concurrency() const
+    {
+        return std::max(pool.num_threads, 1U);
+    }
+
+    template <typename Func>
+    void for_each(long n, Func const& func)
+    {
+        if (n <= 0)
+        {
+            return;
+        }
+
+        if (n == 1 || pool.num_threads == 0)
+        {
+            serial_executor().for_each(n, func);
+            return;
+        }
+
+        pool.run([&](long i) { func(i); }, n);
+    }
+
+    thread_pool& pool;
+};
+
+#if VSNRAY_HAVE_TBB
+
+struct tbb_executor
+{
+    unsigned concurrency() const
+    {
+        return static_cast<unsigned>(std::max(tbb::this_task_arena::max_concurrency(), 1));
+    }
+
+    template <typename Func>
+    void for_each(long n, Func const& func)
+    {
+        if (n <= 0)
+        {
+            return;
+        }
+
+        tbb::parallel_for(0L, n, [&](long i) { func(i); });
+    }
+};
+
+#endif // VSNRAY_HAVE_TBB
+
+
+//-------------------------------------------------------------------------------------------------
+// Split [0..count) into chunks of at least min_chunk_size items, one chunk per thread
+//
+
+struct chunk_list
+{
+    chunk_list(unsigned concurrency, int count, int min_chunk_size)
+        : count(count)
+    {
+        num_chunks = std::max(1, std::min(static_cast<int>(concurrency), count / std::max(min_chunk_size, 1)));
+    }
+
+    int first(int chunk) const
+    {
+        return static_cast<int>((static_cast<long long>(count) * chunk) / num_chunks);
+    }
+
+    int last(int chunk) const
+    {
+        return first(chunk + 1);
+    }
+
+    int count;
+    int num_chunks;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Call FUNC(i) for all i in [0..count), distributed in chunks over the executor
+//
+
+template <typename Executor, typename Func>
+inline void for_each_chunked(Executor& exec, int count, int min_chunk_size, Func const& func)
+{
+    // Some more chunks than threads for load balancing
+    chunk_list chunks(exec.concurrency() * 4, count, min_chunk_size);
+
+    exec.for_each(chunks.num_chunks, [&](long c)
+    {
+        for (int i = chunks.first(c); i != chunks.last(c); ++i)
+        {
+            func(i);
+        }
+    });
+}
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_EXECUTOR_H
@@ -13,13 +13,64 @@
 
 #include "../exit_traversal.h"
 #include "../multi_hit.h"
-#include "../stack.h"
 #include "../tags.h"
 #include "../traversal_result.h"
+#include "child_order.h"
 #include "hit_record.h"
+#include "intersect_primitives.h"
+#include "traversal_stack.h"
 
 namespace visionaray
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Start over after the traversal state overflowed
+//
+// Traverses again with the fallback state of the policy, or intersects all primitives if
+// the policy has none (Fallback is void).
+//
+
+template <traversal_type Traversal, size_t MultiHitMax, typename Order, typename Fallback>
+struct restart_traversal
+{
+    template <typename HR, typename RT, typename R, typename BVH, typename Intersector, typename Cond>
+    VSNRAY_FUNC
+    static void run(
+            RT&                     result,
+            R const&                ray,
+            BVH const&              b,
+            Intersector&            isect,
+            typename R::scalar_type max_t,
+            Cond                    update_cond
+            )
+    {
+        result = intersect<Traversal, MultiHitMax, Order, Fallback>(ray, b, isect, max_t, update_cond);
+    }
+};
+
+template <traversal_type Traversal, size_t MultiHitMax, typename Order>
+struct restart_traversal<Traversal, MultiHitMax, Order, void>
+{
+    template <typename HR, typename RT, typename R, typename BVH, typename Intersector, typename Cond>
+    VSNRAY_FUNC
+    static void run(
+            RT&                     result,
+            R const&                ray,
+            BVH const&              b,
+            Intersector&            isect,
+            typename R::scalar_type max_t,
+            Cond                    update_cond
+            )
+    {
+        result = RT();
+        intersect_primitives<Traversal, HR>(ray, b, isect, result, max_t, update_cond);
+    }
+};
+
+} // detail
+
 
 //-------------------------------------------------------------------------------------------------
 // Ray / BVH intersection
@@ -28,10 +79,13 @@ namespace visionaray
 template <
     detail::traversal_type Traversal,
     size_t MultiHitMax = 1,             // Max hits for multi-hit traversal
+    typename Order = detail::distance_order, // Child visiting order
+    typename Stack = detail::full_stack<>,   // Keeps track of the nodes to visit
     typename T,
     typename BVH,
     typename = typename std::enable_if<is_any_bvh<BVH>::value>::type,
     typename = typename std::enable_if<!is_any_bvh_inst<BVH>::value>::type,
+    typename = typename std::enable_if<!is_wide_bvh<BVH>::value && !is_quantized_bvh<BVH>::value>::type,
     typename Intersector,
     typename Cond = is_closer_t
     >
@@ -59,16 +113,18 @@ inline auto intersect(
 
     RT result;
 
-    stack<32> st;
-    st.push(0); // address of root node
+    Stack st;
+    unsigned addr = 0;
 
     auto inv_dir = T(1.0) / ray.dir;
 
+    Order order(ray);
+
     // while ray not terminated
 next:
-    while (!st.empty())
+    while (st.next(addr))
     {
-        auto node = b.node(st.pop());
+        auto node = b.node(addr);
 
         // while node does not contain primitives
         //     traverse to the next node
@@ -80,27 +136,19 @@ next:
             auto hr1 = isect(ray, children[0].get_bounds(), inv_dir);
             auto hr2 = isect(ray, children[1].get_bounds(), inv_dir);
 
-            auto b1 = any( is_closer(hr1, result, max_t) );
-            auto b2 = any( is_closer(hr2, result, max_t) );
+            bool hit[2] = {
+                any( is_closer(hr1, result, max_t) ),
+                any( is_closer(hr2, result, max_t) )
+                };
 
-            if (b1 && b2)
-            {
-                unsigned near_addr = all( hr1.tnear < hr2.tnear ) ? 0 : 1;
-                st.push(node.get_child(!near_addr));
-                node = b.node(node.get_child(near_addr));
-            }
-            else if (b1)
-            {
-                node = b.node(node.get_child(0));
-            }
-            else if (b2)
-            {
-                node = b.node(node.get_child(1));
-            }
-            else
+            unsigned near_addr = order.near_child(node, hr1, hr2);
+
+            if (!st.descend(node, near_addr, hit[near_addr], hit[!near_addr], addr))
             {
                 goto next;
             }
+
+            node = b.node(addr);
         }
 
 
@@ -131,6 +179,165 @@ next:
         }
     }
 
+    if (st.overflow())
+    {
+        // The tree is too deep for the traversal state, start over
+        restart_traversal<Traversal, MultiHitMax, Order, typename Stack::fallback_type>::template run<HR>(
+                result,
+                ray,
+                b,
+                isect,
+                max_t,
+                update_cond
+                );
+    }
+
+    return result;
+
+}
+
+
+// Overload for BVHs with quantized nodes -----------------
+//
+// Nodes store the bounds of both children, leaf children are intersected right away.
+// Decoded bounds are conservative, so the result matches the full-precision BVH. Nodes
+// do not store a split axis, so distance_order is the only child order.
+//
+
+template <
+    detail::traversal_type Traversal,
+    size_t MultiHitMax = 1,             // Max hits for multi-hit traversal
+    typename Order = detail::distance_order, // Child visiting order
+    typename Stack = detail::full_stack<>,   // Keeps track of the nodes to visit
+    typename T,
+    typename BVH,
+    typename = typename std::enable_if<is_quantized_bvh<BVH>::value>::type,
+    typename = void,
+    typename Intersector,
+    typename Cond = is_closer_t
+    >
+VSNRAY_FUNC
+inline auto intersect(
+        basic_ray<T> const& ray,
+        BVH const&          b,
+        Intersector&        isect,
+        T                   max_t = numeric_limits<T>::max(),
+        Cond                update_cond = Cond()
+        )
+    -> typename detail::traversal_result< hit_record_bvh<
+            basic_ray<T>,
+            decltype( isect(ray, std::declval<typename BVH::primitive_type>()) )
+            >, Traversal, MultiHitMax>::type
+{
+
+    using namespace detail;
+    using HR = hit_record_bvh<
+        basic_ray<T>,
+        decltype( isect(ray, std::declval<typename BVH::primitive_type>()) )
+        >;
+
+    using RT = typename detail::traversal_result<HR, Traversal, MultiHitMax>::type;
+
+    RT result;
+
+    if (b.num_nodes() == 0)
+    {
+        return result;
+    }
+
+    Stack st;
+    unsigned addr = 0;
+
+    auto inv_dir = T(1.0) / ray.dir;
+
+    Order order(ray);
+
+    // while ray not terminated
+next:
+    while (st.next(addr))
+    {
+        auto node = b.node(addr);
+
+        for (;;)
+        {
+            auto hr1 = isect(ray, node.get_bounds(0), inv_dir);
+            auto hr2 = isect(ray, node.get_bounds(1), inv_dir);
+
+            bool hit[2] = {
+                any( is_closer(hr1, result, max_t) ),
+                !node.is_empty(1) && any( is_closer(hr2, result, max_t) )
+                };
+
+            unsigned near_addr = order.near_child(node, hr1, hr2);
+
+            // intersect leaf children front to back, unless that
+            // happened on an earlier visit of this node
+
+            if (!st.revisiting())
+            {
+                for (unsigned j = 0; j < 2; ++j)
+                {
+                    unsigned c = j == 0 ? near_addr : !near_addr;
+
+                    if (!hit[c] || !node.is_leaf(c))
+                    {
+                        continue;
+                    }
+
+                    for (auto i = node.get_indices(c).first; i != node.get_indices(c).last; ++i)
+                    {
+                        auto prim = b.primitive(i);
+
+                        auto hr = HR(isect(ray, prim), i);
+                        auto closer = update_cond(hr, result, max_t);
+
+#ifndef __CUDA_ARCH__
+                        if (!any(closer))
+                        {
+                            continue;
+                        }
+#endif
+
+                        update_if(result, hr, closer);
+
+                        exit_traversal<Traversal> early_exit;
+                        if (early_exit.check(result))
+                        {
+                            return result;
+                        }
+                    }
+                }
+            }
+
+            // traverse to the next inner node
+
+            bool inner[2] = {
+                hit[0] && node.is_inner(0),
+                hit[1] && node.is_inner(1)
+                };
+
+            if (!st.descend(node, near_addr, inner[near_addr], inner[!near_addr], addr))
+            {
+                goto next;
+            }
+
+            node = b.node(addr);
+        }
+    }
+
+    if (st.overflow())
+    {
+        // The tree is too deep for the traversal state, start over
+        restart_traversal<Traversal, MultiHitMax, Order, typename Stack::fallback_type>::template run<HR>(
+                result,
+                ray,
+                b,
+                isect,
+                max_t,
+                update_cond
+                );
+    }
+
     return result;
 
 }
@@ -141,6 +348,8 @@ next:
 template <
     detail::traversal_type Traversal,
     size_t MultiHitMax = 1,             // Max hits for multi-hit traversal
+    typename Order = detail::distance_order, // Child visiting order
+    typename Stack = detail::full_stack<>,   // Keeps track of the nodes to visit
     typename T,
     typename BVH,
     typename = typename std::enable_if<is_any_bvh_inst<BVH>::value>::type,
@@ -173,7 +382,7 @@ inline auto intersect(
     transformed_ray.dir = (matrix<4, 4, T>(b.transform_inv()) * vector<4, T>(ray.dir, T(0.0))).xyz();
     // NOTE: dir is in general *not* normalized!
 
-    auto hr = intersect<Traversal, MultiHitMax>(
+    auto hr = intersect<Traversal, MultiHitMax, Order, Stack>(
             transformed_ray,
             b.get_ref(),
             isect,
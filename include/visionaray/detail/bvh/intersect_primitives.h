@@ -0,0 +1,102 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_INTERSECT_PRIMITIVES_H
+#define VSNRAY_DETAIL_BVH_INTERSECT_PRIMITIVES_H 1
+
+#include <cstddef>
+#include <type_traits>
+
+#include <visionaray/update_if.h>
+
+#include "../exit_traversal.h"
+#include "../macros.h"
+#include "../tags.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Number of primitive references that leaves can address
+//
+
+template <typename BVH>
+VSNRAY_FUNC
+inline size_t num_leaf_primitives(BVH const& b, std::true_type /* index BVH */)
+{
+    return b.num_indices();
+}
+
+template <typename BVH>
+VSNRAY_FUNC
+inline size_t num_leaf_primitives(BVH const& b, std::false_type /* index BVH */)
+{
+    return b.num_primitives();
+}
+
+template <typename BVH>
+VSNRAY_FUNC
+inline size_t num_leaf_primitives(BVH const& b)
+{
+    return num_leaf_primitives(b, std::integral_constant<bool, is_index_bvh<BVH>::value>{});
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Intersect all primitives of a BVH without traversing it
+//
+// Fallback for traversal states that overflow, e.g. a fixed-size stack on a tree that is
+// deeper than expected. Takes time linear in the number of primitives, but needs no memory
+// that depends on the tree depth. Results are merged into result, hit records refer to the
+// primitives the same way as with traversal.
+//
+
+template <
+    traversal_type Traversal,
+    typename HR,
+    typename RT,
+    typename R,
+    typename BVH,
+    typename Intersector,
+    typename Cond
+    >
+VSNRAY_FUNC
+inline void intersect_primitives(
+        R const&                ray,
+        BVH const&              b,
+        Intersector&            isect,
+        RT&                     result,
+        typename R::scalar_type max_t,
+        Cond                    update_cond
+        )
+{
+    unsigned count = static_cast<unsigned>(num_leaf_primitives(b));
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        auto hr = HR(isect(ray, b.primitive(i)), i);
+        auto closer = update_cond(hr, result, max_t);
+
+        if (!any(closer))
+        {
+            continue;
+        }
+
+        update_if(result, hr, closer);
+
+        exit_traversal<Traversal> early_exit;
+        if (early_exit.check(result))
+        {
+            return;
+        }
+    }
+}
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_INTERSECT_PRIMITIVES_H
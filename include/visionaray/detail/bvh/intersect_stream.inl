@@ -0,0 +1,464 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <visionaray/math/simd/gather.h>
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/limits.h>
+#include <visionaray/math/ray.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/intersector.h>
+#include <visionaray/ray_stream.h>
+#include <visionaray/update_if.h>
+
+#include "../macros.h"
+#include "../tags.h"
+#include "hit_record.h"
+#include "intersect_primitives.h"
+#include "traversal_stack.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Gather the rays with the given indices from a ray stream
+//
+
+template <typename S, typename I>
+inline basic_ray<S> gather_rays(ray_stream<S> const& stream, I const& index)
+{
+    return basic_ray<S>(
+            vector<3, S>(
+                simd::gather(stream.ori_x.data(), index),
+                simd::gather(stream.ori_y.data(), index),
+                simd::gather(stream.ori_z.data(), index)
+                ),
+            vector<3, S>(
+                simd::gather(stream.dir_x.data(), index),
+                simd::gather(stream.dir_y.data(), index),
+                simd::gather(stream.dir_z.data(), index)
+                )
+            );
+}
+
+template <typename S, typename I>
+inline vector<3, S> gather_inv_dir(ray_stream<S> const& stream, I const& index)
+{
+    return vector<3, S>(
+            simd::gather(stream.inv_dir_x.data(), index),
+            simd::gather(stream.inv_dir_y.data(), index),
+            simd::gather(stream.inv_dir_z.data(), index)
+            );
+}
+
+// Trace a single ray of the stream through the subtree below a node
+template <
+    traversal_type Traversal,
+    typename HR,
+    typename S,
+    typename BVH,
+    typename Intersector,
+    typename Cond
+    >
+inline void intersect_subtree(
+        ray_stream<S>&      stream,
+        int                 index,
+        unsigned            root,
+        BVH const&          b,
+        Intersector&        isect,
+        HR&                 result,
+        float               max_t,
+        Cond                update_cond
+        )
+{
+    auto ray = stream.get(index);
+    vec3 inv_dir(stream.inv_dir_x[index], stream.inv_dir_y[index], stream.inv_dir_z[index]);
+
+    result.t = stream.t[index];
+
+    // Short stack with restart trail
+    restart_trail<> st(root);
+    unsigned addr = root;
+
+next:
+    while (st.next(addr))
+    {
+        auto node = b.node(addr);
+
+        while (!is_leaf(node))
+        {
+            auto children = &b.node(node.get_child(0));
+
+            auto hr1 = isect(ray, children[0].get_bounds(), inv_dir);
+            auto hr2 = isect(ray, children[1].get_bounds(), inv_dir);
+
+            bool hit[2] = {
+                is_closer(hr1, result, max_t),
+                is_closer(hr2, result, max_t)
+                };
+
+            unsigned near_addr = hr1.tnear < hr2.tnear ? 0 : 1;
+
+            if (!st.descend(node, near_addr, hit[near_addr], hit[!near_addr], addr))
+            {
+                goto next;
+            }
+
+            node = b.node(addr);
+        }
+
+        for (auto i = node.get_indices().first; i != node.get_indices().last; ++i)
+        {
+            auto hr = HR(isect(ray, b.primitive(i)), i);
+
+            if (update_cond(hr, result, max_t))
+            {
+                result = hr;
+
+                if (Traversal == AnyHit)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    if (st.overflow())
+    {
+        // The subtree is too deep for the restart trail, intersect all primitives
+        intersect_primitives<Traversal, HR>(ray, b, isect, result, max_t, update_cond);
+    }
+}
+
+// Load the next (up to) Width indices of an active ray list, pad with the last one
+template <size_t Width>
+inline int load_indices(int (&dst)[Width], int const* src, size_t count)
+{
+    int num = count < Width ? static_cast<int>(count) : static_cast<int>(Width);
+
+    for (int i = 0; i < static_cast<int>(Width); ++i)
+    {
+        dst[i] = src[i < num ? i : num - 1];
+    }
+
+    return num;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Ray stream / BVH intersection
+//
+// Traverses the BVH depth-first with the whole stream of rays. At each inner node, the
+// indices of the rays that hit a child are compacted into a new list, so the SIMD vectors
+// that are gathered from the lists are always filled with active rays, no matter how
+// incoherent the rays are. Children are visited in the order that most rays prefer. When
+// fewer rays than SIMD lanes reach a node, they traverse its subtree one by one.
+// Writes one hit record per ray to hits.
+//
+// Supports closest hit and any hit traversal.
+//
+// cf. Barringer and Akenine-Möller (2014): Dynamic Ray Stream Traversal
+//
+
+template <
+    detail::traversal_type Traversal,
+    typename S,
+    typename BVH,
+    typename = typename std::enable_if<is_any_bvh<BVH>::value>::type,
+    typename = typename std::enable_if<!is_any_bvh_inst<BVH>::value>::type,
+    typename = typename std::enable_if<!is_wide_bvh<BVH>::value && !is_quantized_bvh<BVH>::value>::type,
+    typename Intersector,
+    typename HR,
+    typename Cond = is_closer_t
+    >
+inline void intersect(
+        ray_stream<S>&      stream,
+        BVH const&          b,
+        Intersector&        isect,
+        aligned_vector<HR>& hits,
+        float               max_t = numeric_limits<float>::max(),
+        Cond                update_cond = Cond()
+        )
+{
+    static_assert(Traversal != detail::MultiHit, "Multi-hit traversal not supported with ray streams");
+
+    using namespace detail;
+
+    using I = simd::int_type_t<S>;
+    using M = simd::mask_type_t<S>;
+    using PHR = hit_record_bvh<
+        basic_ray<S>,
+        decltype( isect(std::declval<basic_ray<S>>(), std::declval<typename BVH::primitive_type>()) )
+        >;
+
+    enum { Width = ray_stream<S>::Width };
+
+    size_t num_rays = stream.size();
+
+    hits.assign(num_rays, HR());
+
+    if (num_rays == 0 || b.num_nodes() == 0)
+    {
+        return;
+    }
+
+
+    // Prepare the stream
+
+    stream.inv_dir_x.resize(num_rays);
+    stream.inv_dir_y.resize(num_rays);
+    stream.inv_dir_z.resize(num_rays);
+    stream.t.assign(num_rays, numeric_limits<float>::max());
+    stream.active.resize(num_rays);
+
+    for (size_t i = 0; i < num_rays; ++i)
+    {
+        stream.inv_dir_x[i] = 1.0f / stream.dir_x[i];
+        stream.inv_dir_y[i] = 1.0f / stream.dir_y[i];
+        stream.inv_dir_z[i] = 1.0f / stream.dir_z[i];
+        stream.active[i] = static_cast<int>(i);
+    }
+
+    VSNRAY_ALIGN(64) int lane[Width];
+
+    for (int i = 0; i < Width; ++i)
+    {
+        lane[i] = i;
+    }
+
+    I lane_index(lane);
+
+    // Rays that terminated (any hit) don't intersect anything anymore
+    float const terminated = -numeric_limits<float>::max();
+
+    stream.todo.clear();
+    stream.todo.push_back({ 0, 0, num_rays });
+
+    while (!stream.todo.empty())
+    {
+        auto rays = stream.todo.back();
+        stream.todo.pop_back();
+
+        // Lists of nodes that were visited before are no longer needed
+        stream.active.resize(rays.first + rays.count);
+
+        auto const& node = b.node(rays.node);
+
+        if (rays.count < Width)
+        {
+            // Too few rays to fill a SIMD vector, trace them one by one
+
+            for (size_t r = 0; r < rays.count; ++r)
+            {
+                int index = stream.active[rays.first + r];
+
+                HR result;
+                intersect_subtree<Traversal>(stream, index, rays.node, b, isect, result, max_t, update_cond);
+
+                if (result.hit)
+                {
+                    hits[index] = result;
+                    stream.t[index] = Traversal == AnyHit ? terminated : result.t;
+                }
+            }
+
+            continue;
+        }
+
+        if (is_leaf(node))
+        {
+            // Intersect each packet of active rays with all primitives in the leaf
+
+            for (size_t r = 0; r < rays.count; r += Width)
+            {
+                VSNRAY_ALIGN(64) int index[Width];
+                int num = load_indices(index, stream.active.data() + rays.first + r, rays.count - r);
+
+                I ray_index(index);
+                M valid = lane_index < I(num);
+
+                auto ray = gather_rays(stream, ray_index);
+
+                PHR result;
+                result.t = simd::gather(stream.t.data(), ray_index);
+
+                for (auto i = node.get_indices().first; i != node.get_indices().last; ++i)
+                {
+                    auto prim = b.primitive(i);
+
+                    auto hr = PHR(isect(ray, prim), I(static_cast<int>(i)));
+                    auto closer = update_cond(hr, result, S(max_t)) & valid;
+
+                    if (!any(closer))
+                    {
+                        continue;
+                    }
+
+                    update_if(result, hr, closer);
+
+                    if (Traversal == AnyHit && all(result.hit | !valid))
+                    {
+                        break;
+                    }
+                }
+
+                if (!any(result.hit))
+                {
+                    continue;
+                }
+
+                // Write back the lanes that found a closer hit
+
+                auto unpacked = simd::unpack(result);
+
+                for (int j = 0; j < num; ++j)
+                {
+                    if (unpacked[j].hit)
+                    {
+                        hits[index[j]] = unpacked[j];
+                        stream.t[index[j]] = Traversal == AnyHit ? terminated : unpacked[j].t;
+                    }
+                }
+            }
+
+            continue;
+        }
+
+
+        // Filter the active rays into one list per child
+
+        auto children = &b.node(node.get_child(0));
+
+        stream.child_active[0].clear();
+        stream.child_active[1].clear();
+
+        // Number of rays that hit child 0 before child 1, minus the opposite
+        ptrdiff_t votes = 0;
+
+        for (size_t r = 0; r < rays.count; r += Width)
+        {
+            VSNRAY_ALIGN(64) int index[Width];
+            int num = load_indices(index, stream.active.data() + rays.first + r, rays.count - r);
+
+            I ray_index(index);
+            M valid = lane_index < I(num);
+
+            auto ray = gather_rays(stream, ray_index);
+            auto inv_dir = gather_inv_dir(stream, ray_index);
+
+            PHR result;
+            result.t = simd::gather(stream.t.data(), ray_index);
+
+            auto hr1 = isect(ray, children[0].get_bounds(), inv_dir);
+            auto hr2 = isect(ray, children[1].get_bounds(), inv_dir);
+
+            auto b1 = is_closer(hr1, result, S(max_t)) & valid;
+            auto b2 = is_closer(hr2, result, S(max_t)) & valid;
+
+            if (!any(b1 | b2))
+            {
+                continue;
+            }
+
+            VSNRAY_ALIGN(64) int hit1[Width];
+            VSNRAY_ALIGN(64) int hit2[Width];
+            VSNRAY_ALIGN(64) int first1[Width];
+
+            store(hit1, select(b1, I(1), I(0)));
+            store(hit2, select(b2, I(1), I(0)));
+            store(first1, select(hr1.tnear < hr2.tnear, I(1), I(0)));
+
+            for (int j = 0; j < num; ++j)
+            {
+                if (hit1[j])
+                {
+                    stream.child_active[0].push_back(index[j]);
+                }
+
+                if (hit2[j])
+                {
+                    stream.child_active[1].push_back(index[j]);
+                }
+
+                if (hit1[j] && hit2[j])
+                {
+                    votes += first1[j] ? 1 : -1;
+                }
+            }
+        }
+
+        // Append the list of the far child first, the near child is processed next
+
+        unsigned near_addr = votes >= 0 ? 0 : 1;
+        unsigned order[2] = { !near_addr, near_addr };
+
+        for (unsigned c : order)
+        {
+            auto const& list = stream.child_active[c];
+
+            if (list.empty())
+            {
+                continue;
+            }
+
+            size_t first = stream.active.size();
+            stream.active.insert(stream.active.end(), list.begin(), list.end());
+            stream.todo.push_back({ node.get_child(c), first, list.size() });
+        }
+    }
+}
+
+
+// Overload that returns the hit records ------------------
+
+template <
+    detail::traversal_type Traversal = detail::ClosestHit,
+    typename S,
+    typename BVH,
+    typename = typename std::enable_if<is_any_bvh<BVH>::value>::type,
+    typename Intersector
+    >
+inline auto intersect(
+        ray_stream<S>&      stream,
+        BVH const&          b,
+        Intersector&        isect,
+        float               max_t = numeric_limits<float>::max()
+        )
+    -> aligned_vector<hit_record_bvh<
+            basic_ray<float>,
+            decltype( isect(std::declval<basic_ray<float>>(), std::declval<typename BVH::primitive_type>()) )
+            >>
+{
+    aligned_vector<hit_record_bvh<
+            basic_ray<float>,
+            decltype( isect(std::declval<basic_ray<float>>(), std::declval<typename BVH::primitive_type>()) )
+            >> hits;
+
+    intersect<Traversal>(stream, b, isect, hits, max_t);
+
+    return hits;
+}
+
+// Overload w/ default intersector ------------------------
+
+template <
+    detail::traversal_type Traversal = detail::ClosestHit,
+    typename S,
+    typename BVH,
+    typename = typename std::enable_if<is_any_bvh<BVH>::value>::type
+    >
+inline auto intersect(ray_stream<S>& stream, BVH const& b)
+    -> decltype( intersect<Traversal>(stream, b, std::declval<default_intersector&>()) )
+{
+    default_intersector isect;
+    return intersect<Traversal>(stream, b, isect);
+}
+
+} // visionaray
@@ -0,0 +1,304 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/limits.h>
+#include <visionaray/math/ray.h>
+#include <visionaray/intersector.h>
+#include <visionaray/update_if.h>
+
+#include "../exit_traversal.h"
+#include "../macros.h"
+#include "../multi_hit.h"
+#include "../stack.h"
+#include "../tags.h"
+#include "../traversal_result.h"
+#include "child_order.h"
+#include "hit_record.h"
+#include "intersect_primitives.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Test a ray against all children of a wide BVH node
+//
+// Returns the number of children that are closer than the current result. Their slot
+// indices are stored in slots, sorted by ascending distance.
+//
+
+template <typename T, typename Node>
+inline void sort_children(unsigned (&slots)[Node::width], T (&tnear)[Node::width], unsigned count)
+{
+    // Insertion sort, at most Width elements
+    for (unsigned i = 1; i < count; ++i)
+    {
+        unsigned s = slots[i];
+        T t = tnear[i];
+
+        unsigned j = i;
+
+        for ( ; j > 0 && t < tnear[j - 1]; --j)
+        {
+            slots[j] = slots[j - 1];
+            tnear[j] = tnear[j - 1];
+        }
+
+        slots[j] = s;
+        tnear[j] = t;
+    }
+}
+
+// Single ray: test all children at once with SIMD, the ray is broadcast to a ray
+// packet and the child bounds form a SIMD box, both are passed to the intersector
+template <typename Node, typename Intersector, typename RT>
+inline unsigned intersect_children(
+        basic_ray<float> const& ray,
+        vector<3, float> const& inv_dir,
+        Node const&             node,
+        Intersector&            isect,
+        RT const&               result,
+        float                   max_t,
+        unsigned                (&slots)[Node::width]
+        )
+{
+    using F = simd::float_from_simd_width_t<Node::width>;
+
+    basic_ray<F> r(vector<3, F>(ray.ori), vector<3, F>(ray.dir));
+
+    basic_aabb<F> bounds(
+            vector<3, F>(F(node.bbox_min_x), F(node.bbox_min_y), F(node.bbox_min_z)),
+            vector<3, F>(F(node.bbox_max_x), F(node.bbox_max_y), F(node.bbox_max_z))
+            );
+
+    vector<3, F> const idir(inv_dir);
+
+    auto hr = isect(r, bounds, idir);
+
+    VSNRAY_ALIGN(32) float tnear[Node::width];
+    VSNRAY_ALIGN(32) float tfar[Node::width];
+    VSNRAY_ALIGN(32) float hit[Node::width];
+
+    simd::store(tnear, hr.tnear);
+    simd::store(tfar, hr.tfar);
+    simd::store(hit, select(hr.hit, F(1.0f), F(0.0f)));
+
+    float keys[Node::width];
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < Node::width; ++i)
+    {
+        if (node.is_empty(i))
+        {
+            continue;
+        }
+
+        hit_record<basic_ray<float>, basic_aabb<float>> child;
+        child.hit   = hit[i] != 0.0f;
+        child.tnear = tnear[i];
+        child.tfar  = tfar[i];
+
+        if (is_closer(child, result, max_t))
+        {
+            slots[count] = i;
+            keys[count] = tnear[i];
+            ++count;
+        }
+    }
+
+    sort_children<float, Node>(slots, keys, count);
+
+    return count;
+}
+
+// Ray packets: test the children one after another, the packet is already SIMD
+template <typename T, typename Node, typename Intersector, typename RT>
+inline unsigned intersect_children(
+        basic_ray<T> const&     ray,
+        vector<3, T> const&     inv_dir,
+        Node const&             node,
+        Intersector&            isect,
+        RT const&               result,
+        T                       max_t,
+        unsigned                (&slots)[Node::width]
+        )
+{
+    float keys[Node::width];
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < Node::width; ++i)
+    {
+        if (node.is_empty(i))
+        {
+            continue;
+        }
+
+        auto hr = isect(ray, node.get_bounds(i), inv_dir);
+        auto closer = is_closer(hr, result, max_t);
+
+        if (!any(closer))
+        {
+            continue;
+        }
+
+        // Order by the nearest active ray
+        simd::aligned_array_t<T> tnear;
+        store(tnear, select(closer, hr.tnear, T(numeric_limits<float>::max())));
+
+        float key = tnear[0];
+        for (size_t j = 1; j < simd::num_elements<T>::value; ++j)
+        {
+            key = std::min(key, tnear[j]);
+        }
+
+        slots[count] = i;
+        keys[count] = key;
+        ++count;
+    }
+
+    sort_children<float, Node>(slots, keys, count);
+
+    return count;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Ray / wide BVH intersection
+//
+// All children of a node are tested together, leaf children are intersected immediately,
+// inner children are visited front to back. Children are always ordered by distance,
+// Order is accepted for a uniform interface with the binary BVH. Stack is a plain node
+// stack (detail::stack<N>), a node pushes up to Width - 1 children. If the stack runs
+// full, traversal starts over without the tree.
+//
+
+template <
+    detail::traversal_type Traversal,
+    size_t MultiHitMax = 1,             // Max hits for multi-hit traversal
+    typename Order = detail::distance_order, // Ignored, children are visited by distance
+    typename Stack = detail::stack<128>,     // Keeps track of the nodes to visit
+    typename T,
+    typename BVH,
+    typename = typename std::enable_if<is_wide_bvh<BVH>::value>::type,
+    typename Intersector,
+    typename Cond = is_closer_t
+    >
+inline auto intersect(
+        basic_ray<T> const& ray,
+        BVH const&          b,
+        Intersector&        isect,
+        T                   max_t = numeric_limits<T>::max(),
+        Cond                update_cond = Cond()
+        )
+    -> typename detail::traversal_result< hit_record_bvh<
+            basic_ray<T>,
+            decltype( isect(ray, std::declval<typename BVH::primitive_type>()) )
+            >, Traversal, MultiHitMax>::type
+{
+    using namespace detail;
+    using HR = hit_record_bvh<
+        basic_ray<T>,
+        decltype( isect(ray, std::declval<typename BVH::primitive_type>()) )
+        >;
+
+    using RT = typename detail::traversal_result<HR, Traversal, MultiHitMax>::type;
+
+    using node_type = typename std::decay<decltype(b.node(0))>::type;
+
+    enum { Width = node_type::width };
+
+    RT result;
+
+    if (b.num_nodes() == 0)
+    {
+        return result;
+    }
+
+    Stack st;
+    st.push(0); // address of root node
+
+    bool overflow = false;
+
+    auto inv_dir = T(1.0) / ray.dir;
+
+    while (!overflow && !st.empty())
+    {
+        auto const& node = b.node(st.pop());
+
+        unsigned slots[Width];
+        unsigned count = intersect_children(ray, inv_dir, node, isect, result, max_t, slots);
+
+        // Intersect leaves front to back, then push inner nodes back to front
+
+        for (unsigned s = 0; s < count; ++s)
+        {
+            unsigned c = slots[s];
+
+            if (!node.is_leaf(c))
+            {
+                continue;
+            }
+
+            auto indices = node.get_indices(c);
+
+            for (auto i = indices.first; i != indices.last; ++i)
+            {
+                auto prim = b.primitive(i);
+
+                auto hr = HR(isect(ray, prim), i);
+                auto closer = update_cond(hr, result, max_t);
+
+                if (!any(closer))
+                {
+                    continue;
+                }
+
+                update_if(result, hr, closer);
+
+                exit_traversal<Traversal> early_exit;
+                if (early_exit.check(result))
+                {
+                    return result;
+                }
+            }
+        }
+
+        for (unsigned s = count; s > 0; --s)
+        {
+            unsigned c = slots[s - 1];
+
+            if (!node.is_inner(c))
+            {
+                continue;
+            }
+
+            if (st.full())
+            {
+                overflow = true;
+                break;
+            }
+
+            st.push(node.get_child(c));
+        }
+    }
+
+    if (overflow)
+    {
+        // The tree is too deep for the stack, start over without it
+        result = RT();
+        intersect_primitives<Traversal, HR>(ray, b, isect, result, max_t, update_cond);
+    }
+
+    return result;
+}
+
+} // visionaray
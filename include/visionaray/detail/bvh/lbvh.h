@@ -6,12 +6,26 @@
 #ifndef VSNRAY_DETAIL_BVH_LBVH_H
 #define VSNRAY_DETAIL_BVH_LBVH_H 1
 
+#include <visionaray/config.h>
+
 #include <algorithm>
 #include <array>
-
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <visionaray/math/aabb.h>
 #include <visionaray/aligned_vector.h>
 #include <visionaray/morton.h>
 
+#include "../algorithm.h"
+#include "../thread_pool.h"
+#include "executor.h"
+
 #ifdef _WIN32
 #include <intrin.h>
 #endif
@@ -35,21 +49,127 @@ inline unsigned clz(unsigned val)
 #endif
 }
 
-} // detail
+VSNRAY_FUNC
+inline unsigned clz(unsigned long long val)
+{
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 200
+    return __clzll(val);
+#elif defined(__KALMAR_ACCELERATOR__)
+    // TODO
+#elif defined(_WIN32)
+    return static_cast<unsigned>(__lzcnt64(val));
+#else
+    return __builtin_clzll(val);
+#endif
+}
 
-struct lbvh_builder
+
+//-------------------------------------------------------------------------------------------------
+// radix_sort
+//
+// Stable LSD radix sort of ITEMS by the lowest NUM_BITS bits of KEY(item).
+// Each pass computes per-chunk histograms and scatters the chunks in parallel.
+//
+// [in,out] ITEMS
+//      Items to sort.
+//
+// [in,out] TMP
+//      Temporary storage, resized to the size of ITEMS.
+//
+// [in] NUM_BITS
+//      Number of significant key bits.
+//
+// [in] KEY
+//      Sort key function object.
+//
+// [in] EXEC
+//      Executor used to process the chunks.
+//
+
+template <typename T, typename Key, typename Executor>
+void radix_sort(aligned_vector<T>& items, aligned_vector<T>& tmp, int num_bits, Key key, Executor& exec)
 {
-    struct leaf_info
+    enum
     {
-        int first;
-        int last;
-        aabb prim_bounds;
+        RadixBits = 8,
+        NumBuckets = 1 << RadixBits,
+        MinChunkSize = 1 << 14
     };
 
+    using histogram = std::array<int, NumBuckets>;
+
+    chunk_list chunks(exec.concurrency(), static_cast<int>(items.size()), MinChunkSize);
+
+    std::vector<histogram> hist(chunks.num_chunks);
+
+    tmp.resize(items.size());
+
+    for (int shift = 0; shift < num_bits; shift += RadixBits)
+    {
+        auto digit = [&](T const& item)
+        {
+            return static_cast<int>((key(item) >> shift) & (NumBuckets - 1));
+        };
+
+        exec.for_each(chunks.num_chunks, [&](long c)
+        {
+            auto& h = hist[c];
+
+            std::fill(h.begin(), h.end(), 0);
+
+            for (int i = chunks.first(c); i != chunks.last(c); ++i)
+            {
+                ++h[digit(items[i])];
+            }
+        });
+
+        // Exclusive prefix sum, bucket-major so that the sort is stable
+        int sum = 0;
+
+        for (int b = 0; b < NumBuckets; ++b)
+        {
+            for (int c = 0; c < chunks.num_chunks; ++c)
+            {
+                int count = hist[c][b];
+                hist[c][b] = sum;
+                sum += count;
+            }
+        }
+
+        exec.for_each(chunks.num_chunks, [&](long c)
+        {
+            auto& h = hist[c];
+
+            for (int i = chunks.first(c); i != chunks.last(c); ++i)
+            {
+                tmp[h[digit(items[i])]++] = items[i];
+            }
+        });
+
+        std::swap(items, tmp);
+    }
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Linear BVH builder
+//
+// cf. Karras (2012): Maximizing Parallelism in the Construction of BVHs, Octrees, and k-d Trees
+//
+// All phases run in parallel on the executor: primitive and centroid bounds, morton codes, a radix
+// sort of the primitive references, emission of the binary radix tree's internal nodes (each one
+// computed independently from the sorted codes) and a bottom-up pass that computes the node bounds.
+// Subtrees with no more than max_leaf_size primitives are collapsed into leaves.
+//
+
+struct lbvh_builder
+{
     struct prim_ref
     {
         int id;
-        unsigned morton_code;
+        unsigned long long morton_code;
 
         VSNRAY_FUNC
         bool operator<(prim_ref rhs) const
@@ -58,163 +178,444 @@ struct lbvh_builder
         }
     };
 
-    using leaf_infos = std::array<leaf_info, 2>;
+    // Node of the binary radix tree, covers the sorted references [first..last]
+    struct radix_node
+    {
+        int first;
+        int last;
+        int split;  // Left child covers [first..split], right child covers [split+1..last]
+        int parent;
+    };
 
     aligned_vector<prim_ref> prim_refs;
     aligned_vector<aabb> prim_bounds;
 
-    VSNRAY_FUNC
-    int find_split(prim_ref const* refs, int first, int last) const
+    // Whether to use 63-bit (instead of 30-bit) morton codes
+    bool use_64bit_morton_codes = false;
+    // Whether to build the tree with multiple threads
+    bool use_parallel_build = false;
+
+    void enable_64bit_morton_codes(bool enable)
     {
-        unsigned code_first = refs[first].morton_code;
-        unsigned code_last  = refs[last - 1].morton_code;
+        use_64bit_morton_codes = enable;
+    }
 
-        if (code_first == code_last)
+    void enable_parallel_build(bool enable)
+    {
+        use_parallel_build = enable;
+    }
+
+    template <typename Tree, typename P>
+    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
+    {
+        if (use_parallel_build)
         {
-            return (first + last) / 2;
+#if VSNRAY_HAVE_TBB
+            detail::tbb_executor exec;
+#else
+            thread_pool pool(std::max(std::thread::hardware_concurrency(), 1U));
+            detail::thread_pool_executor exec(pool);
+#endif
+            return build_impl<Tree>(primitives, num_prims, max_leaf_size, exec);
         }
+        else
+        {
+            detail::serial_executor exec;
+            return build_impl<Tree>(primitives, num_prims, max_leaf_size, exec);
+        }
+    }
 
-        unsigned common_prefix = detail::clz(code_first ^ code_last);
+    // Build in parallel, use the given thread pool to run the build phases.
+    template <typename Tree, typename P>
+    Tree build(Tree /* */, P* primitives, size_t num_prims, thread_pool& pool, int max_leaf_size = -1)
+    {
+        detail::thread_pool_executor exec(pool);
+        return build_impl<Tree>(primitives, num_prims, max_leaf_size, exec);
+    }
 
-        int result = first;
-        int step = last - first;
+private:
 
-        do
+    enum
+    {
+        // Number of items processed by one work item
+        MinChunkSize = 1 << 12
+    };
+
+    template <typename Executor, typename Func>
+    static void for_each_chunked(Executor& exec, int count, Func const& func)
+    {
+        detail::for_each_chunked(exec, count, MinChunkSize, func);
+    }
+
+    // Length of the common prefix of the keys at sorted positions i and j,
+    // disambiguates duplicate codes with the positions, -1 if j is out of range
+    int delta(int i, int j) const
+    {
+        if (j < 0 || j >= static_cast<int>(prim_refs.size()))
         {
-            step = (step + 1) / 2;
-            int next = result + step;
+            return -1;
+        }
 
-            if (next < last)
-            {
-                unsigned code = refs[next].morton_code;
-                if (code_first == code || detail::clz(code_first ^ code) > common_prefix)
-                {
-                    result = next;
-                }
-            }
+        auto a = prim_refs[i].morton_code;
+        auto b = prim_refs[j].morton_code;
+
+        if (a == b)
+        {
+            return 64 + static_cast<int>(detail::clz(static_cast<unsigned>(i ^ j)));
         }
-        while (step > 1);
 
-        return result;
+        return static_cast<int>(detail::clz(a ^ b));
     }
 
-    template <typename Tree, typename P>
-    Tree build(Tree /* */, P* primitives, size_t num_prims, int max_leaf_size = -1)
+    // Axis of the highest bit that differs between the children of node (x: bit 0, y: bit 1, ...),
+    // the left child is on the lower side. 0 if all codes are the same.
+    int split_axis(radix_node const& node) const
     {
-        Tree tree(primitives, num_prims);
+        auto a = prim_refs[node.first].morton_code;
+        auto b = prim_refs[node.last].morton_code;
 
-        detail::build_top_down(tree, *this, primitives, primitives + num_prims, max_leaf_size);
+        if (a == b)
+        {
+            return 0;
+        }
 
-        return tree;
+        return (63 - static_cast<int>(detail::clz(a ^ b))) % 3;
     }
 
-    template <typename I>
-    leaf_info init(I first, I last)
+    // Determine the range and the split position of internal node i
+    radix_node make_radix_node(int i) const
     {
-        // Calculate bounding box for all primitives
+        // Direction of the range
+        int d = delta(i, i + 1) - delta(i, i - 1) > 0 ? 1 : -1;
 
-        aabb scene_bounds;
-        scene_bounds.invalidate();
+        // Upper bound for the length of the range
+        int delta_min = delta(i, i - d);
 
+        int lmax = 2;
+        while (delta(i, i + lmax * d) > delta_min)
+        {
+            lmax *= 2;
+        }
 
-        // Also calculate bounding box for all centroids
+        // Find the other end with binary search
+        int l = 0;
+        for (int t = lmax / 2; t >= 1; t /= 2)
+        {
+            if (delta(i, i + (l + t) * d) > delta_min)
+            {
+                l += t;
+            }
+        }
 
-        aabb centroid_bounds;
-        centroid_bounds.invalidate();
+        int j = i + l * d;
 
+        // Find the split position with binary search
+        int delta_node = delta(i, j);
 
-        prim_bounds.resize(last - first);
-        aligned_vector<vec3> centroids(last - first);
+        int s = 0;
+        int t = l;
 
-        int i = 0;
-        for (auto it = first; it != last; ++it, ++i)
+        do
         {
-            prim_bounds[i] = get_bounds(*it);
-            scene_bounds.insert(prim_bounds[i]);
+            t = (t + 1) / 2;
 
-            centroids[i] = prim_bounds[i].center();
-            centroid_bounds.insert(centroids[i]);
+            if (delta(i, i + (s + t) * d) > delta_node)
+            {
+                s += t;
+            }
+        }
+        while (t > 1);
+
+        radix_node result;
+        result.first = std::min(i, j);
+        result.last = std::max(i, j);
+        result.split = i + s * d + std::min(d, 0);
+        result.parent = -1;
+        return result;
+    }
+
+    template <typename P, typename Executor>
+    void init(P* first, int count, Executor& exec)
+    {
+        // Calculate primitive bounds, and bounding boxes for all primitives and all centroids
+
+        prim_bounds.resize(count);
+
+        detail::chunk_list chunks(exec.concurrency(), count, MinChunkSize);
+
+        std::vector<aabb> chunk_bounds(chunks.num_chunks);
+
+        exec.for_each(chunks.num_chunks, [&](long c)
+        {
+            aabb& cb = chunk_bounds[c];
+            cb.invalidate();
+
+            for (int i = chunks.first(c); i != chunks.last(c); ++i)
+            {
+                prim_bounds[i] = get_bounds(first[i]);
+                cb.insert(prim_bounds[i].center());
+            }
+        });
+
+        aabb centroid_bounds;
+        centroid_bounds.invalidate();
+
+        for (auto const& cb : chunk_bounds)
+        {
+            centroid_bounds.insert(cb);
         }
 
 
         // Calculate morton codes for centroids
 
-        prim_refs.resize(last - first);
+        float quantize = use_64bit_morton_codes ? 2097152.0f : 1024.0f;
 
-        for (int i = 0; i < last - first; ++i)
+        vec3 size = centroid_bounds.size();
+
+        for (int d = 0; d < 3; ++d)
         {
-            vec3 centroid = centroids[i];
+            // Guard against degenerate (flat) centroid bounds
+            size[d] = size[d] > 0.0f ? size[d] : 1.0f;
+        }
 
+        prim_refs.resize(count);
+
+        for_each_chunked(exec, count, [&](int i)
+        {
             // Express centroid in [0..1] relative to bounding box
-            centroid -= centroid_bounds.center();
-            centroid = (centroid + centroid_bounds.size() * 0.5f) / centroid_bounds.size();
+            vec3 centroid = (prim_bounds[i].center() - centroid_bounds.min) / size;
+
+            // Quantize centroid to 10-bit (21-bit)
+            centroid = min(max(centroid * quantize, vec3(0.0f)), vec3(quantize - 1.0f));
 
-            // Quantize centroid to 10-bit
-            centroid = min(max(centroid * 1024.0f, vec3(0.0f)), vec3(1023.0f));
+            auto x = static_cast<unsigned>(centroid.x);
+            auto y = static_cast<unsigned>(centroid.y);
+            auto z = static_cast<unsigned>(centroid.z);
 
             prim_refs[i].id = i;
-            prim_refs[i].morton_code = morton_encode3D(
-                    static_cast<int>(centroid.x),
-                    static_cast<int>(centroid.y),
-                    static_cast<int>(centroid.z)
-                    );
-        }
+            prim_refs[i].morton_code = use_64bit_morton_codes
+                    ? morton_encode3D_64(x, y, z)
+                    : static_cast<unsigned long long>(morton_encode3D(x, y, z));
+        });
+
+
+        // Sort references by morton code
 
-        std::stable_sort(prim_refs.begin(), prim_refs.end());
+        aligned_vector<prim_ref> tmp;
 
-        return { 0, static_cast<int>(last - first), scene_bounds };
+        detail::radix_sort(
+                prim_refs,
+                tmp,
+                use_64bit_morton_codes ? 63 : 30,
+                [](prim_ref const& ref) { return ref.morton_code; },
+                exec
+                );
     }
 
-    // Inserts primitive indices into INDICES.
-    template <typename Indices>
-    int insert_indices(Indices& indices, leaf_info const& leaf)
+    template <typename Nodes, typename Indices, typename Executor>
+    void emit_nodes(Nodes& nodes, Indices& indices, int max_leaf_size, Executor& exec)
     {
-        for (int i = leaf.first; i < leaf.last; ++i)
+        int n = static_cast<int>(prim_refs.size());
+
+        indices.resize(n);
+
+        for_each_chunked(exec, n, [&](int i)
         {
-            indices.push_back(prim_refs[i].id);
+            indices[i] = prim_refs[i].id;
+        });
+
+        if (n <= max_leaf_size)
+        {
+            aabb bounds;
+            bounds.invalidate();
+
+            for (auto const& b : prim_bounds)
+            {
+                bounds.insert(b);
+            }
+
+            nodes.resize(1);
+            nodes[0].set_leaf(bounds, 0, n);
+            return;
         }
 
-        return leaf.last - leaf.first;
-    }
 
-    // Return true if the leaf should be split into two new leaves. In this case
-    // sr.leaves contains the information of the left/right leaves and the
-    // method returns true. If the leaf should not be split, returns false.
-    template <typename Data>
-    bool split(leaf_infos& childs, leaf_info const& leaf, Data const& /*data*/, int max_leaf_size)
-    {
-        if (leaf.last - leaf.first <= max_leaf_size)
+        // Construct the internal nodes of the radix tree, root is node 0
+
+        std::vector<radix_node> inner(n - 1);
+        std::vector<int> leaf_parents(n);
+
+        for_each_chunked(exec, n - 1, [&](int i)
+        {
+            inner[i] = make_radix_node(i);
+        });
+
+        // Children are leaves if their range contains a single reference
+        auto is_leaf_child = [&](radix_node const& node, int child)
+        {
+            return child == 0 ? node.split == node.first : node.split + 1 == node.last;
+        };
+
+        for_each_chunked(exec, n - 1, [&](int i)
         {
-            return false;
+            auto const& node = inner[i];
+
+            (is_leaf_child(node, 0) ? leaf_parents[node.split] : inner[node.split].parent) = i;
+            (is_leaf_child(node, 1) ? leaf_parents[node.split + 1] : inner[node.split + 1].parent) = i;
+        });
+
+
+        // Compute bounds bottom-up, the second thread to arrive at a node processes it
+
+        std::vector<aabb> inner_bounds(n - 1);
+        std::unique_ptr<std::atomic<int>[]> visited(new std::atomic<int>[n - 1]);
+
+        for_each_chunked(exec, n - 1, [&](int i)
+        {
+            visited[i] = 0;
+        });
+
+        auto child_bounds = [&](radix_node const& node, int child)
+        {
+            int index = node.split + child;
+            return is_leaf_child(node, child) ? prim_bounds[prim_refs[index].id] : inner_bounds[index];
+        };
+
+        for_each_chunked(exec, n, [&](int i)
+        {
+            int p = leaf_parents[i];
+
+            while (p >= 0 && visited[p].fetch_add(1, std::memory_order_acq_rel) == 1)
+            {
+                inner_bounds[p] = combine(child_bounds(inner[p], 0), child_bounds(inner[p], 1));
+                p = inner[p].parent;
+            }
+        });
+
+
+        // Collapse subtrees with at most max_leaf_size references and store the children
+        // of the remaining inner nodes pairwise. Inner node with rank r (among all inner
+        // nodes that are not collapsed) stores its children at 2r + 1 and 2r + 2.
+
+        auto is_collapsed = [&](radix_node const& node)
+        {
+            return node.last - node.first + 1 <= max_leaf_size;
+        };
+
+        std::vector<int> rank(n - 1);
+
+        detail::chunk_list chunks(exec.concurrency(), n - 1, MinChunkSize);
+        std::vector<int> chunk_counts(chunks.num_chunks);
+
+        exec.for_each(chunks.num_chunks, [&](long c)
+        {
+            int count = 0;
+
+            for (int i = chunks.first(c); i != chunks.last(c); ++i)
+            {
+                rank[i] = count;
+                count += is_collapsed(inner[i]) ? 0 : 1;
+            }
+
+            chunk_counts[c] = count;
+        });
+
+        int num_inner = 0;
+
+        for (int c = 0; c < chunks.num_chunks; ++c)
+        {
+            int count = chunk_counts[c];
+            chunk_counts[c] = num_inner;
+            num_inner += count;
         }
 
-        int split = find_split(prim_refs.data(), leaf.first, leaf.last);
+        exec.for_each(chunks.num_chunks, [&](long c)
+        {
+            for (int i = chunks.first(c); i != chunks.last(c); ++i)
+            {
+                rank[i] += chunk_counts[c];
+            }
+        });
+
+        nodes.resize(2 * num_inner + 1);
+
+        // Root is the first inner node that is not collapsed
+        nodes[0].set_inner(inner_bounds[0], 1, split_axis(inner[0]));
+
+        for_each_chunked(exec, n - 1, [&](int i)
+        {
+            auto const& node = inner[i];
+
+            if (is_collapsed(node))
+            {
+                return;
+            }
+
+            for (int child = 0; child < 2; ++child)
+            {
+                auto& out = nodes[2 * rank[i] + 1 + child];
+
+                int index = node.split + child;
+
+                if (is_leaf_child(node, child))
+                {
+                    out.set_leaf(prim_bounds[prim_refs[index].id], index, 1);
+                }
+                else if (is_collapsed(inner[index]))
+                {
+                    auto const& c = inner[index];
+                    out.set_leaf(inner_bounds[index], c.first, c.last - c.first + 1);
+                }
+                else
+                {
+                    out.set_inner(inner_bounds[index], 2 * rank[index] + 1, split_axis(inner[index]));
+                }
+            }
+        });
+    }
+
+    template <typename Tree, typename Executor>
+    void build_work(Tree& tree, int max_leaf_size, Executor& exec, std::true_type /*is_index_bvh*/)
+    {
+        emit_nodes(tree.nodes(), tree.indices(), max_leaf_size, exec);
+    }
+
+    template <typename Tree, typename Executor>
+    void build_work(Tree& tree, int max_leaf_size, Executor& exec, std::false_type /*is_index_bvh*/)
+    {
+        aligned_vector<unsigned> indices;
+
+        emit_nodes(tree.nodes(), indices, max_leaf_size, exec);
 
-        childs[0].first = leaf.first;
-        childs[0].last = split + 1;
-        childs[0].prim_bounds.invalidate();
-        for (int i = childs[0].first; i != childs[0].last; ++i)
+        // Reorder the primitives according to the indices.
+        algo::reorder_n(indices.begin(), tree.primitives().begin(), indices.size());
+    }
+
+    template <typename Tree, typename P, typename Executor>
+    Tree build_impl(P* primitives, size_t num_prims, int max_leaf_size, Executor& exec)
+    {
+        Tree tree(primitives, num_prims);
+
+        if (num_prims == 0)
         {
-            childs[0].prim_bounds = combine(
-                    childs[0].prim_bounds,
-                    prim_bounds[prim_refs[i].id]
-                    );
+            return tree;
         }
 
-        childs[1].first = split + 1;
-        childs[1].last = leaf.last;
-        childs[1].prim_bounds.invalidate();
-        for (int i = childs[1].first; i != childs[1].last; ++i)
+        if (max_leaf_size <= 0)
         {
-            childs[1].prim_bounds = combine(
-                    childs[1].prim_bounds,
-                    prim_bounds[prim_refs[i].id]
-                    );
+            max_leaf_size = 4;
         }
 
-        return true;
+        init(primitives, static_cast<int>(num_prims), exec);
+
+        tree.clear();
+
+        build_work(tree, max_leaf_size, exec, is_index_bvh<Tree>());
+
+        return tree;
     }
 
+public:
 
     // TODO:
     bool use_spatial_splits;
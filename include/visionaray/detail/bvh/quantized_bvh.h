@@ -0,0 +1,446 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_QUANTIZED_BVH_H
+#define VSNRAY_DETAIL_BVH_QUANTIZED_BVH_H 1
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include <visionaray/math/aabb.h>
+#include <visionaray/aligned_vector.h>
+
+#include "../macros.h"
+
+namespace visionaray
+{
+
+//--------------------------------------------------------------------------------------------------
+// quantized_bvh_node
+//
+// Inner node that stores the bounds of its two children with 8 or 16 bit integers relative to
+// a frame spanned by the node's own bounds (origin and power-of-two scale per axis). Leaves are
+// stored inline in their parent's child slots, so there is one node per inner node of the
+// binary tree.
+//
+// Bounds are rounded outwards when quantizing, decoding is exact, so the decoded boxes always
+// contain the original ones.
+//
+
+template <typename Q>
+struct quantized_bvh_node
+{
+    static_assert(std::is_same<Q, uint8_t>::value || std::is_same<Q, uint16_t>::value,
+            "Child bounds must be quantized to 8 or 16 bits");
+
+    using quant_type = Q;
+
+    enum : unsigned { QuantMax = std::numeric_limits<Q>::max() };
+
+    float       origin[3];
+    int8_t      exponent[3];
+    uint8_t     pad;
+    Q           qmin[2][3];
+    Q           qmax[2][3];
+    unsigned    child[2];       // Inner nodes: index of child node, leaves: first primitive
+    uint16_t    num_prims[2];   // 0: inner node
+
+    // Node 0 is the root and never a child, it marks empty slots
+    VSNRAY_FUNC bool is_empty(unsigned i) const { return num_prims[i] == 0 && child[i] == 0; }
+    VSNRAY_FUNC bool is_inner(unsigned i) const { return num_prims[i] == 0 && child[i] != 0; }
+    VSNRAY_FUNC bool is_leaf(unsigned i) const { return num_prims[i] != 0; }
+
+    VSNRAY_FUNC aabb get_bounds(unsigned i) const
+    {
+        vec3 s(scale(exponent[0]), scale(exponent[1]), scale(exponent[2]));
+        vec3 o(origin[0], origin[1], origin[2]);
+
+        return aabb(
+                o + vec3(qmin[i][0], qmin[i][1], qmin[i][2]) * s,
+                o + vec3(qmax[i][0], qmax[i][1], qmax[i][2]) * s
+                );
+    }
+
+    // Bounds of both children
+    VSNRAY_FUNC aabb get_bounds() const
+    {
+        return is_empty(1) ? get_bounds(0) : combine(get_bounds(0), get_bounds(1));
+    }
+
+    VSNRAY_FUNC unsigned get_child(unsigned i) const
+    {
+        assert(is_inner(i));
+        return child[i];
+    }
+
+    VSNRAY_FUNC bvh_node::index_range get_indices(unsigned i) const
+    {
+        assert(is_leaf(i));
+        return { child[i], child[i] + num_prims[i] };
+    }
+
+    // 2^e, e in [-126..127]
+    VSNRAY_FUNC static float scale(int e)
+    {
+        unsigned bits = static_cast<unsigned>(e + 127) << 23;
+        float result;
+        memcpy(&result, &bits, sizeof(float));
+        return result;
+    }
+
+    // Set the frame that the child bounds are quantized relative to
+    void set_frame(aabb const& bounds)
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            origin[a] = bounds.min[a];
+
+            float extent = bounds.max[a] - bounds.min[a];
+
+            // Smallest power of two so that QuantMax steps cover the extent
+            int e = -126;
+
+            if (extent > 0.0f)
+            {
+                std::frexp(extent / QuantMax, &e);
+                e = std::max(e, -126);
+            }
+
+            while (e < 127 && decode(a, QuantMax, e) < bounds.max[a])
+            {
+                ++e;
+            }
+
+            exponent[a] = static_cast<int8_t>(e);
+        }
+
+        pad = 0;
+    }
+
+    void set_empty(unsigned i)
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            qmin[i][a] = 0;
+            qmax[i][a] = 0;
+        }
+
+        child[i] = 0;
+        num_prims[i] = 0;
+    }
+
+    void set_inner(unsigned i, aabb const& bounds, unsigned child_index)
+    {
+        assert(child_index != 0);
+
+        quantize(i, bounds);
+        child[i] = child_index;
+        num_prims[i] = 0;
+    }
+
+    void set_leaf(unsigned i, aabb const& bounds, unsigned first_primitive_index, unsigned count)
+    {
+        if (count == 0 || count > std::numeric_limits<uint16_t>::max())
+        {
+            throw std::out_of_range("Leaf size not supported by quantized BVH");
+        }
+
+        quantize(i, bounds);
+        child[i] = first_primitive_index;
+        num_prims[i] = static_cast<uint16_t>(count);
+    }
+
+private:
+
+    float decode(int axis, unsigned q, int e) const
+    {
+        return origin[axis] + static_cast<float>(q) * scale(e);
+    }
+
+    // Round outwards, the frame must already be set
+    void quantize(unsigned i, aabb const& bounds)
+    {
+        for (int a = 0; a < 3; ++a)
+        {
+            float s = scale(exponent[a]);
+
+            float lo = std::floor((bounds.min[a] - origin[a]) / s);
+            float hi = std::ceil((bounds.max[a] - origin[a]) / s);
+
+            unsigned qlo = static_cast<unsigned>(std::max(0.0f, std::min(lo, static_cast<float>(QuantMax))));
+            unsigned qhi = static_cast<unsigned>(std::max(0.0f, std::min(hi, static_cast<float>(QuantMax))));
+
+            // Compensate for rounding errors in decode()
+            while (qlo > 0 && decode(a, qlo, exponent[a]) > bounds.min[a])
+            {
+                --qlo;
+            }
+
+            while (qhi < QuantMax && decode(a, qhi, exponent[a]) < bounds.max[a])
+            {
+                ++qhi;
+            }
+
+            qmin[i][a] = static_cast<Q>(qlo);
+            qmax[i][a] = static_cast<Q>(qhi);
+        }
+    }
+};
+
+static_assert( sizeof(quantized_bvh_node<uint8_t>)  == 40, "Size mismatch" );
+static_assert( sizeof(quantized_bvh_node<uint16_t>) == 52, "Size mismatch" );
+
+
+//--------------------------------------------------------------------------------------------------
+// quantized_bvh_ref_t
+//
+
+template <typename PrimitiveType, typename Q>
+class quantized_bvh_ref_t
+{
+public:
+
+    using primitive_type = PrimitiveType;
+    using node_type = quantized_bvh_node<Q>;
+
+private:
+
+    using P = const PrimitiveType;
+    using N = const node_type;
+
+    P* primitives_first;
+    P* primitives_last;
+    N* nodes_first;
+    N* nodes_last;
+
+public:
+
+    quantized_bvh_ref_t() = default;
+
+    VSNRAY_FUNC quantized_bvh_ref_t(P* p0, P* p1, N* n0, N* n1)
+        : primitives_first(p0)
+        , primitives_last(p1)
+        , nodes_first(n0)
+        , nodes_last(n1)
+    {
+    }
+
+    VSNRAY_FUNC size_t num_primitives() const { return primitives_last - primitives_first; }
+    VSNRAY_FUNC size_t num_nodes() const { return nodes_last - nodes_first; }
+
+    VSNRAY_FUNC P& primitive(size_t index) const
+    {
+        return primitives_first[index];
+    }
+
+    VSNRAY_FUNC N& node(size_t index) const
+    {
+        return nodes_first[index];
+    }
+
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// quantized_bvh_t
+//
+// Constructed from a binary BVH (bvh_t or index_bvh_t). Primitives are stored in leaf order
+// (indirect indices are resolved).
+//
+// Usage:
+//
+//  lbvh_builder builder;
+//  auto b = builder.build(index_bvh<P>{}, prims, num_prims);
+//  quantized_bvh<P> qb(b);
+//
+
+template <typename PrimitiveVector, typename NodeVector>
+class quantized_bvh_t
+{
+public:
+
+    using primitive_type    = typename PrimitiveVector::value_type;
+    using primitive_vector  = PrimitiveVector;
+    using node_type         = typename NodeVector::value_type;
+    using node_vector       = NodeVector;
+
+    using bvh_ref = quantized_bvh_ref_t<primitive_type, typename node_type::quant_type>;
+
+public:
+
+    quantized_bvh_t() = default;
+
+    template <
+        typename BVH,
+        typename = typename std::enable_if<is_any_bvh<BVH>::value>::type,
+        typename = typename std::enable_if<!is_any_bvh_inst<BVH>::value>::type
+        >
+    explicit quantized_bvh_t(BVH const& b)
+    {
+        convert(b);
+    }
+
+    template <typename PV, typename NV>
+    explicit quantized_bvh_t(quantized_bvh_t<PV, NV> const& rhs)
+        : primitives_(rhs.primitives())
+        , nodes_(rhs.nodes())
+    {
+    }
+
+    primitive_vector const& primitives() const  { return primitives_; }
+    primitive_vector&       primitives()        { return primitives_; }
+
+    node_vector const&      nodes() const       { return nodes_; }
+    node_vector&            nodes()             { return nodes_; }
+
+    size_t num_primitives() const               { return primitives_.size(); }
+    size_t num_nodes() const                    { return nodes_.size(); }
+
+    bvh_ref ref() const
+    {
+        auto p0 = detail::get_pointer(primitives());
+        auto p1 = p0 + primitives().size();
+
+        auto n0 = detail::get_pointer(nodes());
+        auto n1 = n0 + nodes().size();
+
+        return { p0, p1, n0, n1 };
+    }
+
+    primitive_type const& primitive(size_t index) const
+    {
+        return primitives_[index];
+    }
+
+    node_type const& node(size_t index) const
+    {
+        return nodes_[index];
+    }
+
+    void clear(size_t capacity = 0)
+    {
+        nodes_.clear();
+        nodes_.reserve(capacity);
+    }
+
+private:
+
+    primitive_vector primitives_;
+    node_vector nodes_;
+
+    template <typename BVH>
+    void convert(BVH const& b)
+    {
+        clear();
+        primitives_.clear();
+
+        if (b.num_nodes() == 0)
+        {
+            return;
+        }
+
+        // Copy primitives in leaf order
+
+        size_t num_prims = 0;
+
+        for (auto const& n : b.nodes())
+        {
+            if (is_leaf(n))
+            {
+                num_prims = std::max(num_prims, static_cast<size_t>(n.get_indices().last));
+            }
+        }
+
+        primitives_.resize(num_prims);
+
+        for (size_t i = 0; i < num_prims; ++i)
+        {
+            primitives_[i] = b.primitive(i);
+        }
+
+        // One node per inner node
+
+        nodes_.reserve(b.num_nodes() / 2 + 1);
+        nodes_.emplace_back();
+
+        auto const& root = b.node(0);
+
+        if (is_leaf(root))
+        {
+            nodes_[0].set_frame(root.get_bounds());
+            nodes_[0].set_leaf(0, root.get_bounds(), root.get_first_primitive(), root.get_num_primitives());
+            nodes_[0].set_empty(1);
+        }
+        else
+        {
+            convert_node(b, 0, 0);
+        }
+    }
+
+    // Fill node INDEX with the children of binary inner node N
+    template <typename BVH>
+    void convert_node(BVH const& b, size_t index, size_t n)
+    {
+        nodes_[index].set_frame(b.node(n).get_bounds());
+
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            auto ci = b.node(n).get_child(i);
+            auto const& c = b.node(ci);
+
+            if (is_leaf(c))
+            {
+                nodes_[index].set_leaf(i, c.get_bounds(), c.get_first_primitive(), c.get_num_primitives());
+            }
+            else
+            {
+                auto child_index = nodes_.size();
+
+                nodes_.emplace_back();
+                nodes_[index].set_inner(i, c.get_bounds(), static_cast<unsigned>(child_index));
+
+                convert_node(b, child_index, ci);
+            }
+        }
+    }
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// quantized bvh traits
+//
+
+template <typename T1, typename T2>
+struct is_quantized_bvh<quantized_bvh_t<T1, T2>> : std::true_type {};
+
+template <typename T, typename Q>
+struct is_quantized_bvh<quantized_bvh_ref_t<T, Q>> : std::true_type {};
+
+// Quantized BVHs store their primitives directly, like bvh_t
+template <typename T1, typename T2>
+struct is_bvh<quantized_bvh_t<T1, T2>> : std::true_type {};
+
+template <typename T, typename Q>
+struct is_bvh<quantized_bvh_ref_t<T, Q>> : std::true_type {};
+
+
+//-------------------------------------------------------------------------------------------------
+// Typedefs
+//
+
+template <typename P, typename Q = uint8_t>
+using quantized_bvh = quantized_bvh_t<aligned_vector<P>, aligned_vector<quantized_bvh_node<Q>>>;
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_QUANTIZED_BVH_H
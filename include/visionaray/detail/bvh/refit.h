@@ -0,0 +1,342 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_REFIT_H
+#define VSNRAY_DETAIL_BVH_REFIT_H 1
+
+#include <visionaray/config.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <visionaray/math/aabb.h>
+
+#include "../thread_pool.h"
+#include "executor.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// BVH refitter
+//
+// Updates the node bounds of a BVH after its primitives were modified (e.g. for deforming
+// geometry), while keeping the topology. Leaf bounds are recomputed from the primitives and
+// propagated to the root in parallel (the second thread that arrives at a node processes it).
+//
+// Refitting degrades the tree quality when primitives move a lot. If a threshold is set, the
+// refitter compares the SAH cost after refitting with the cost of the tree as it was passed in
+// the first time (i.e. after it was built). If the cost exceeds threshold * that cost, the tree
+// is restructured with local tree rotations.
+//
+// cf. Kopta et al. (2012): Fast, Effective BVH Updates for Animated Scenes
+//
+// NOTE: primitives are modified through tree.primitives(). Index BVHs keep the original
+// primitive order, with plain BVHs the primitives were reordered during construction!
+//
+
+struct bvh_refitter
+{
+    // Restructure if SAH cost exceeds this factor times the initial cost (0: never)
+    float restructure_threshold = 0.0f;
+    // Whether to refit the tree with multiple threads
+    bool use_parallel_refit = false;
+
+    void set_restructure_threshold(float value)
+    {
+        restructure_threshold = value;
+    }
+
+    void enable_parallel_refit(bool enable)
+    {
+        use_parallel_refit = enable;
+    }
+
+    // Forget the SAH cost of the initial tree, call this after rebuilding the tree.
+    void reset()
+    {
+        reference_cost_ = -1.0f;
+    }
+
+    // SAH cost of the tree when it was first refitted, or -1 if unknown.
+    float reference_cost() const
+    {
+        return reference_cost_;
+    }
+
+    template <typename Tree>
+    void refit(Tree& tree)
+    {
+        if (use_parallel_refit)
+        {
+#if VSNRAY_HAVE_TBB
+            detail::tbb_executor exec;
+#else
+            thread_pool pool(std::max(std::thread::hardware_concurrency(), 1U));
+            detail::thread_pool_executor exec(pool);
+#endif
+            refit_impl(tree, exec);
+        }
+        else
+        {
+            detail::serial_executor exec;
+            refit_impl(tree, exec);
+        }
+    }
+
+    // Refit in parallel, use the given thread pool.
+    template <typename Tree>
+    void refit(Tree& tree, thread_pool& pool)
+    {
+        detail::thread_pool_executor exec(pool);
+        refit_impl(tree, exec);
+    }
+
+private:
+
+    enum
+    {
+        // Number of nodes processed by one work item
+        MinChunkSize = 1 << 12,
+        // Subtrees restructured in parallel per thread
+        TasksPerThread = 8
+    };
+
+    float reference_cost_ = -1.0f;
+
+    template <typename Tree, typename Executor>
+    void refit_impl(Tree& tree, Executor& exec)
+    {
+        if (tree.num_nodes() == 0)
+        {
+            return;
+        }
+
+        if (restructure_threshold > 0.0f && reference_cost_ < 0.0f)
+        {
+            reference_cost_ = sah_cost(tree);
+        }
+
+        refit_bounds(tree, exec);
+
+        if (restructure_threshold > 0.0f && sah_cost(tree) > restructure_threshold * reference_cost_)
+        {
+            restructure(tree, exec);
+        }
+    }
+
+    template <typename Tree, typename Executor>
+    void refit_bounds(Tree& tree, Executor& exec)
+    {
+        auto& nodes = tree.nodes();
+
+        int num_nodes = static_cast<int>(nodes.size());
+
+        std::vector<int> parents(num_nodes);
+        std::unique_ptr<std::atomic<int>[]> visited(new std::atomic<int>[num_nodes]);
+
+        parents[0] = -1;
+
+        detail::for_each_chunked(exec, num_nodes, MinChunkSize, [&](int i)
+        {
+            visited[i] = 0;
+
+            if (is_inner(nodes[i]))
+            {
+                parents[nodes[i].get_child(0)] = i;
+                parents[nodes[i].get_child(1)] = i;
+            }
+        });
+
+        detail::for_each_chunked(exec, num_nodes, MinChunkSize, [&](int i)
+        {
+            auto& n = nodes[i];
+
+            if (is_inner(n))
+            {
+                return;
+            }
+
+            aabb bounds;
+            bounds.invalidate();
+
+            auto indices = n.get_indices();
+
+            for (auto j = indices.first; j != indices.last; ++j)
+            {
+                bounds.insert(get_bounds(tree.primitive(j)));
+            }
+
+            n.set_leaf(bounds, n.get_first_primitive(), n.get_num_primitives());
+
+            int p = parents[i];
+
+            while (p >= 0 && visited[p].fetch_add(1, std::memory_order_acq_rel) == 1)
+            {
+                auto& pn = nodes[p];
+                pn.set_inner(
+                        combine(nodes[pn.get_child(0)].get_bounds(), nodes[pn.get_child(1)].get_bounds()),
+                        pn.get_child(0),
+                        pn.get_split_axis()
+                        );
+                p = parents[p];
+            }
+        });
+    }
+
+
+    //---------------------------------------------------------------------------------------------
+    // Tree rotations
+    //
+
+    // Swap nodes and recompute the bounds of parent P (one of the nodes must be a child of P)
+    template <typename Nodes>
+    static void swap_nodes(Nodes& nodes, unsigned a, unsigned b, unsigned p)
+    {
+        std::swap(nodes[a], nodes[b]);
+
+        auto& pn = nodes[p];
+        pn.set_inner(
+                combine(nodes[pn.get_child(0)].get_bounds(), nodes[pn.get_child(1)].get_bounds()),
+                pn.get_child(0),
+                pn.get_split_axis()
+                );
+    }
+
+    // Apply the rotation that reduces the surface area of one of the children of node I the most.
+    // Rotations swap one child with a child of its sibling.
+    template <typename Nodes>
+    static void rotate(Nodes& nodes, unsigned i)
+    {
+        auto const& n = nodes[i];
+
+        float best_delta = 0.0f;
+        unsigned best_a = 0;
+        unsigned best_b = 0;
+        unsigned best_p = 0;
+
+        for (unsigned c = 0; c < 2; ++c)
+        {
+            // Swap child c with a child of its sibling s
+            unsigned a = n.get_child(c);
+            unsigned s = n.get_child(1 - c);
+
+            if (is_leaf(nodes[s]))
+            {
+                continue;
+            }
+
+            float area = surface_area(nodes[s].get_bounds());
+
+            for (unsigned g = 0; g < 2; ++g)
+            {
+                unsigned b = nodes[s].get_child(g);
+                unsigned other = nodes[s].get_child(1 - g);
+
+                float delta = surface_area(combine(nodes[a].get_bounds(), nodes[other].get_bounds())) - area;
+
+                if (delta < best_delta)
+                {
+                    best_delta = delta;
+                    best_a = a;
+                    best_b = b;
+                    best_p = s;
+                }
+            }
+        }
+
+        if (best_delta < 0.0f)
+        {
+            swap_nodes(nodes, best_a, best_b, best_p);
+        }
+    }
+
+    // Rotate the nodes of the subtree bottom-up, stop at depth max_depth (if >= 0)
+    template <typename Nodes>
+    static void rotate_subtree(Nodes& nodes, unsigned i, int max_depth)
+    {
+        if (is_leaf(nodes[i]) || max_depth == 0)
+        {
+            return;
+        }
+
+        rotate_subtree(nodes, nodes[i].get_child(0), max_depth - 1);
+        rotate_subtree(nodes, nodes[i].get_child(1), max_depth - 1);
+
+        rotate(nodes, i);
+    }
+
+    template <typename Tree, typename Executor>
+    void restructure(Tree& tree, Executor& exec)
+    {
+        auto& nodes = tree.nodes();
+
+        // Restructure the subtrees at depth d in parallel, then the nodes above them
+
+        int d = 0;
+
+        std::vector<unsigned> subtrees(1, 0);
+
+        while (subtrees.size() < TasksPerThread * exec.concurrency())
+        {
+            std::vector<unsigned> next;
+
+            for (auto i : subtrees)
+            {
+                if (is_inner(nodes[i]))
+                {
+                    next.push_back(nodes[i].get_child(0));
+                    next.push_back(nodes[i].get_child(1));
+                }
+            }
+
+            if (next.size() == subtrees.size() * 2)
+            {
+                subtrees.swap(next);
+                ++d;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if (exec.concurrency() <= 1)
+        {
+            d = 0;
+            subtrees.assign(1, 0);
+        }
+
+        exec.for_each(static_cast<long>(subtrees.size()), [&](long i)
+        {
+            rotate_subtree(nodes, subtrees[i], -1);
+        });
+
+        if (d > 0)
+        {
+            rotate_subtree(nodes, 0, d);
+        }
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// refit() interface
+//
+
+template <typename Tree>
+void refit(Tree& tree)
+{
+    bvh_refitter refitter;
+    refitter.refit(tree);
+}
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_REFIT_H
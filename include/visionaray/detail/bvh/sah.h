@@ -6,16 +6,22 @@
 #ifndef VSNRAY_DETAIL_BVH_SAH_H
 #define VSNRAY_DETAIL_BVH_SAH_H 1
 
+#include <visionaray/config.h>
+
 #include <cassert>
 #include <array>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
 #include <visionaray/math/aabb.h>
 #include <visionaray/math/sphere.h>
 #include <visionaray/math/triangle.h>
+#include <visionaray/math/woop_triangle.h>
 
+#include "../thread_pool.h"
 #include "build_top_down.h"
+#include "executor.h"
 
 namespace visionaray
 {
@@ -65,6 +71,12 @@ void split_primitive(aabb& L, aabb& R, float plane, int axis, basic_triangle<Dim
     detail::split_edge(L, R, v2, v0, plane, axis);
 }
 
+template <typename T, typename P>
+void split_primitive(aabb& L, aabb& R, float plane, int axis, basic_woop_triangle<T, P> const& prim)
+{
+    split_primitive(L, R, plane, axis, static_cast<basic_triangle<3, T, P> const&>(prim));
+}
+
 template <typename T, typename P>
 void split_primitive(aabb& L, aabb& R, float plane, int axis, basic_sphere<T, P> const& prim)
 {
@@ -191,31 +203,92 @@ struct binned_sah_builder
     {
         Tree tree(primitives, num_prims);
 
-        detail::build_top_down(tree, *this, primitives, primitives + num_prims, max_leaf_size);
+        if (use_parallel_build)
+        {
+#if VSNRAY_HAVE_TBB
+            detail::tbb_executor exec;
+#else
+            thread_pool pool(std::max(std::thread::hardware_concurrency(), 1U));
+            detail::thread_pool_executor exec(pool);
+#endif
+            detail::build_top_down_parallel(tree, *this, primitives, primitives + num_prims, exec, max_leaf_size);
+        }
+        else
+        {
+            detail::build_top_down(tree, *this, primitives, primitives + num_prims, max_leaf_size);
+        }
+
+        return tree;
+    }
+
+    // Build in parallel, use the given thread pool to run the build tasks.
+    template <typename Tree, typename P>
+    Tree build(Tree /* */, P* primitives, size_t num_prims, thread_pool& pool, int max_leaf_size = -1)
+    {
+        Tree tree(primitives, num_prims);
+
+        detail::thread_pool_executor exec(pool);
+        detail::build_top_down_parallel(tree, *this, primitives, primitives + num_prims, exec, max_leaf_size);
 
         return tree;
     }
 
     template <typename I>
     static void init(prim_refs& refs, aabb& prim_bounds, aabb& cent_bounds, I first, I last)
+    {
+        detail::serial_executor exec;
+        init(refs, prim_bounds, cent_bounds, first, last, exec);
+    }
+
+    template <typename I, typename Executor>
+    static void init(prim_refs& refs, aabb& prim_bounds, aabb& cent_bounds, I first, I last, Executor& exec)
     {
         refs.resize(last - first);
 
+        detail::chunk_list chunks(exec.concurrency(), static_cast<int>(last - first), MinParallelSize);
+
+        std::vector<aabb> chunk_bounds(chunks.num_chunks * 2);
+
+        exec.for_each(chunks.num_chunks, [&](long c)
+        {
+            aabb& pb = chunk_bounds[c * 2];
+            aabb& cb = chunk_bounds[c * 2 + 1];
+
+            pb.invalidate();
+            cb.invalidate();
+
+            for (int i = chunks.first(c); i != chunks.last(c); ++i)
+            {
+                refs[i].assign(first[i], i);
+
+                pb.insert(refs[i].bounds);
+                cb.insert(refs[i].bounds.center());
+            }
+        });
+
         prim_bounds.invalidate();
         cent_bounds.invalidate();
 
-        for (int i = 0; first != last; ++first, ++i)
+        for (int c = 0; c < chunks.num_chunks; ++c)
         {
-            refs[i].assign(*first, i);
-
-            prim_bounds.insert(refs[i].bounds);
-            cent_bounds.insert(refs[i].bounds.center());
+            prim_bounds.insert(chunk_bounds[c * 2]);
+            cent_bounds.insert(chunk_bounds[c * 2 + 1]);
         }
     }
 
+    struct leaf_info
+    {
+        aabb prim_bounds; // Primitive bounds
+        aabb cent_bounds; // Centroid bounds
+        int first;        // Index of first primitive reference in this leaf
+    };
+
     enum
     {
-        NumBins = 16
+        NumBins = 16,
+
+        // Bin nodes with at least this many references in parallel (parallel build only)
+        MinParallelSize = 1 << 14
     };
 
     struct bin
@@ -249,6 +322,43 @@ struct binned_sah_builder
 
     using bin_list = std::array<bin, NumBins>;
 
+    // Calls FUNC(bins, ref) for all references of LEAF. References are
+    // binned in chunks that are processed in parallel and then merged.
+    template <typename Func, typename Executor>
+    static bin_list bin_references(prim_refs const& refs, leaf_info const& leaf, Func func, Executor& exec)
+    {
+        auto count = static_cast<int>(refs.size() - leaf.first);
+
+        detail::chunk_list chunks(exec.concurrency(), count, MinParallelSize);
+
+        std::vector<bin_list> chunk_bins(chunks.num_chunks);
+
+        exec.for_each(chunks.num_chunks, [&](long c)
+        {
+            auto& bins = chunk_bins[c];
+
+            for (auto& b : bins)
+            {
+                b.clear();
+            }
+
+            for (int i = chunks.first(c); i != chunks.last(c); ++i)
+            {
+                func(bins, refs[leaf.first + i]);
+            }
+        });
+
+        for (int c = 1; c < chunks.num_chunks; ++c)
+        {
+            for (int i = 0; i < NumBins; ++i)
+            {
+                chunk_bins[0][i] = merge(chunk_bins[0][i], chunk_bins[c][i]);
+            }
+        }
+
+        return chunk_bins[0];
+    }
+
     struct projection
     {
         float k0;
@@ -295,14 +405,15 @@ struct binned_sah_builder
         }
     };
 
-    struct leaf_info
+    // Left/right leaves of a split
+    struct leaf_infos
     {
-        aabb prim_bounds; // Primitive bounds
-        aabb cent_bounds; // Centroid bounds
-        int first;        // Index of first primitive reference in this leaf
-    };
+        leaf_info& operator[](size_t i) { return leaves[i]; }
+        leaf_info const& operator[](size_t i) const { return leaves[i]; }
 
-    using leaf_infos = std::array<leaf_info, 2>;
+        std::array<leaf_info, 2> leaves;
+        int split_axis = 0; // The left leaf is on the lower side of the split plane
+    };
 
     static float compute_leaf_cost(int size)
     {
@@ -412,19 +523,15 @@ struct binned_sah_builder
     }
 
     // Find the best object split.
-    static split_result find_object_split(prim_refs& refs, leaf_info const& leaf, projection pr)
+    template <typename Executor>
+    static split_result find_object_split(prim_refs& refs, leaf_info const& leaf, projection pr, Executor& exec)
     {
-        bin_list bins;
-
-        for (auto& b : bins)
-        {
-            b.clear();
-        }
-
-        for (auto I = refs.begin() + leaf.first, E = refs.end(); I != E; ++I)
-        {
-            project_object(bins, *I, pr);
-        }
+        auto bins = bin_references(
+                refs,
+                leaf,
+                [&](bin_list& b, prim_ref const& ref) { project_object(b, ref, pr); },
+                exec
+                );
 
         return find_split(bins, leaf.prim_bounds);
     }
@@ -449,6 +556,7 @@ struct binned_sah_builder
 
         childs[0].first = leaf.first;
         childs[1].first = static_cast<int>(pivot - refs.begin());
+        childs.split_axis = pr.axis;
     }
 
     //--------------------------------------------------------------------------
@@ -508,21 +616,21 @@ struct binned_sah_builder
         bins[imax].leave++;
     }
 
-    template <typename Data>
-    static split_result
-    find_spatial_split(prim_refs const& refs, leaf_info const& leaf, projection pr, Data const& data)
+    template <typename Data, typename Executor>
+    static split_result find_spatial_split(
+            prim_refs const&    refs,
+            leaf_info const&    leaf,
+            projection          pr,
+            Data const&         data,
+            Executor&           exec
+            )
     {
-        bin_list bins;
-
-        for (auto& b : bins)
-        {
-            b.clear();
-        }
-
-        for (auto I = refs.begin() + leaf.first, E = refs.end(); I != E; ++I)
-        {
-            split_object(bins, *I, pr, data);
-        }
+        auto bins = bin_references(
+                refs,
+                leaf,
+                [&](bin_list& b, prim_ref const& ref) { split_object(b, ref, pr, data); },
+                exec
+                );
 
         return find_split(bins, leaf.prim_bounds);
     }
@@ -539,6 +647,8 @@ struct binned_sah_builder
     {
         auto plane = pr.unproject(sr.index);
 
+        childs.split_axis = pr.axis;
+
         auto pivot = leaf.first;
         auto i = leaf.first;
         auto last = static_cast<int>(refs.size());
@@ -657,6 +767,8 @@ struct binned_sah_builder
     float alpha = 1.0e-5f;
     // Whether to use spatial splits
     bool use_spatial_splits = false;
+    // Whether to build the tree with multiple threads
+    bool use_parallel_build = false;
 
     void set_alpha(float value)
     {
@@ -668,19 +780,58 @@ struct binned_sah_builder
         use_spatial_splits = enable;
     }
 
+    void enable_parallel_build(bool enable)
+    {
+        use_parallel_build = enable;
+    }
+
     template <typename I>
     leaf_info init(I first, I last)
+    {
+        detail::serial_executor exec;
+        return init(first, last, exec);
+    }
+
+    template <typename I, typename Executor>
+    leaf_info init(I first, I last, Executor& exec)
     {
         aabb prim_bounds;
         aabb cent_bounds;
 
-        init(refs, prim_bounds, cent_bounds, first, last);
+        init(refs, prim_bounds, cent_bounds, first, last, exec);
 
         sa_threshold = alpha * safe_surface_area(prim_bounds);
 
         return { prim_bounds, cent_bounds, 0 };
     }
 
+    // Number of primitive references in the given leaf.
+    int size(leaf_info const& leaf) const
+    {
+        return static_cast<int>(refs.size() - leaf.first);
+    }
+
+    // Moves the primitive references of LEAF into a new builder that can
+    // construct the subtree independently. LEAF must be the last leaf in
+    // the list of references, it is updated to refer to the new builder.
+    binned_sah_builder fork(leaf_info& leaf)
+    {
+        binned_sah_builder result;
+
+        result.sa_threshold = sa_threshold;
+        result.alpha = alpha;
+        result.use_spatial_splits = use_spatial_splits;
+        result.use_parallel_build = use_parallel_build;
+
+        result.refs.assign(refs.begin() + leaf.first, refs.end());
+
+        refs.resize(leaf.first);
+
+        leaf.first = 0;
+
+        return result;
+    }
+
     // Inserts primitive indices into INDICES and removes them from the current list.
     template <typename Indices>
     int insert_indices(Indices& indices, leaf_info const& leaf)
@@ -704,12 +855,20 @@ struct binned_sah_builder
     // method returns true. If the leaf should not be split, returns false.
     template <typename Data>
     bool split(leaf_infos& childs, leaf_info const& leaf, Data const& data, int max_leaf_size)
+    {
+        detail::serial_executor exec;
+        return split(childs, leaf, data, max_leaf_size, exec);
+    }
+
+    // Same as above, uses EXEC to bin large nodes in parallel.
+    template <typename Data, typename Executor>
+    bool split(leaf_infos& childs, leaf_info const& leaf, Data const& data, int max_leaf_size, Executor& exec)
     {
         // FIXME:
         // Create a leaf if max_depth is reached...
         // Or check this in build_tree?
 
-        auto leaf_size = static_cast<int>(refs.size() - leaf.first);
+        auto leaf_size = size(leaf);
 
         if (leaf_size <= max_leaf_size)
         {
@@ -731,7 +890,7 @@ struct binned_sah_builder
 
         projection pr(leaf.cent_bounds, static_cast<int>(axis));
 
-        auto sr = find_object_split(refs, leaf, pr);
+        auto sr = find_object_split(refs, leaf, pr, exec);
 
         // Spatial split -------------------------------------------------------
 
@@ -754,7 +913,7 @@ struct binned_sah_builder
 
                 projection pr2(leaf.prim_bounds, static_cast<int>(axis));
 
-                auto sr2 = find_spatial_split(refs, leaf, pr2, data);
+                auto sr2 = find_spatial_split(refs, leaf, pr2, data, exec);
 
                 if (sr2.cost < sr.cost /* && (sr2.count[0] + sr2.count[1] < 1.5 * leaf_size) */)
                 {
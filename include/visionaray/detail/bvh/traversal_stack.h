@@ -0,0 +1,333 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_TRAVERSAL_STACK_H
+#define VSNRAY_DETAIL_BVH_TRAVERSAL_STACK_H 1
+
+#include <cstdint>
+
+#include "../macros.h"
+#include "../stack.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Policies that keep track of the BVH nodes that still have to be visited
+//
+// Usage:
+//
+//  auto hr = intersect<detail::ClosestHit, 1, detail::distance_order, detail::restart_trail<>>(
+//          ray,
+//          bvh,
+//          isect
+//          );
+//
+// next(addr) returns the next node to visit, or false if traversal is finished.
+// descend(node, near, hit_near, hit_far, addr) selects the child of an inner node to visit
+// next, or returns false if no child is hit.
+// revisiting() tells if the current node was already visited before, traversals that
+// intersect leaf children at their parent must not intersect them again.
+// overflow() tells if traversal stopped because the state ran out of space. Traversal is
+// then incomplete, the caller starts over with the state fallback_type, or intersects all
+// primitives if that is void (cf. intersect_primitives()).
+//
+// Packets are traversed as a whole, so the state is kept once per packet and not per lane.
+//
+
+// Restart trail with a short stack
+//
+// A trail bit per tree level tells if the near child at that level was already processed.
+// Far children are pushed onto a short stack that drops its oldest entry when full. When
+// the stack runs empty, traversal restarts at the root and follows the trail down to the
+// next unprocessed node, so the stack never overflows. The near child must be chosen
+// deterministically, which both distance_order and split_axis_order do.
+//
+// There are trail bits for MaxDepth levels of inner nodes, the default covers LBVHs built
+// with 64-bit Morton codes (at most 96 levels). Deeper trees stop traversal and report
+// overflow(), there is no fallback state. Stack entries store the tree level as an index, restart_trail<> takes 104
+// bytes compared to 136 bytes for full_stack<>.
+//
+// cf. Laine (2010): Restart Trail for Stackless BVH Traversal
+//
+
+template <unsigned N = 8, unsigned MaxDepth = 128>
+struct restart_trail
+{
+    static_assert( N > 0 && (N & (N - 1)) == 0, "Stack size must be a power of two" );
+    static_assert( MaxDepth > 0 && MaxDepth % 64 == 0, "Max depth must be a multiple of 64" );
+
+    enum { Words = MaxDepth / 64 };
+
+    // Intersect all primitives on overflow
+    using fallback_type = void;
+
+    // Traverse the subtree below root
+    VSNRAY_FUNC explicit restart_trail(unsigned root = 0)
+        : root(root)
+    {
+    }
+
+    VSNRAY_FUNC bool next(unsigned& addr)
+    {
+        if (overflowed)
+        {
+            return false;
+        }
+
+        if (depth < 0)
+        {
+            // first call: start at the root
+            addr = root;
+            depth = 0;
+            return true;
+        }
+
+        // The subtree of the current node is processed, advance the
+        // trail to the next level where the far child is pending
+
+        clear_trail_from(depth);
+
+        int d = depth - 1;
+
+        for (;;)
+        {
+            // Increment the trail at d, levels whose far child
+            // was processed, too, carry over to their parent
+            while (d >= 0 && test_trail(d))
+            {
+                reset_trail(d);
+                --d;
+            }
+
+            if (d < 0)
+            {
+                // All levels up to the root are processed
+                return false;
+            }
+
+            set_trail(d);
+
+            // Entries below d belong to subtrees that are already processed
+            while (size > 0 && entries[top].depth > static_cast<unsigned>(d))
+            {
+                pop();
+            }
+
+            if (size == 0)
+            {
+                // Follow the trail from the root, nodes down to level d
+                // are visited again
+                addr = root;
+                depth = 0;
+                revisit_depth = d;
+                return true;
+            }
+
+            if (entries[top].depth == static_cast<unsigned>(d))
+            {
+                addr = entries[top].addr;
+                depth = d + 1;
+                revisit_depth = -1;
+                pop();
+                return true;
+            }
+
+            // The far child at d was not hit, advance further
+        }
+    }
+
+    template <typename Node>
+    VSNRAY_FUNC bool descend(Node const& node, unsigned near, bool hit_near, bool hit_far, unsigned& addr)
+    {
+        if (depth >= static_cast<int>(MaxDepth))
+        {
+            // No trail bits left
+            overflowed = true;
+            return false;
+        }
+
+        unsigned child = near;
+
+        if (test_trail(depth))
+        {
+            // The near child was already processed
+            if (!hit_far)
+            {
+                return false;
+            }
+
+            child = !near;
+        }
+        else if (hit_near && hit_far)
+        {
+            push(node.get_child(!near), depth);
+        }
+        else if (hit_far)
+        {
+            // The near child need not be processed
+            set_trail(depth);
+            child = !near;
+        }
+        else if (!hit_near)
+        {
+            return false;
+        }
+
+        addr = node.get_child(child);
+        ++depth;
+        return true;
+    }
+
+    VSNRAY_FUNC bool revisiting() const
+    {
+        return depth <= revisit_depth;
+    }
+
+    VSNRAY_FUNC bool overflow() const
+    {
+        return overflowed;
+    }
+
+    VSNRAY_FUNC void push(unsigned a, unsigned d)
+    {
+        top = (top + 1) & (N - 1);
+        entries[top].addr = a;
+        entries[top].depth = d;
+        size = size < N ? size + 1 : N;
+    }
+
+    VSNRAY_FUNC void pop()
+    {
+        top = (top + N - 1) & (N - 1);
+        --size;
+    }
+
+    VSNRAY_FUNC bool test_trail(int d) const
+    {
+        return (trail[d / 64] >> (d % 64)) & 1;
+    }
+
+    VSNRAY_FUNC void set_trail(int d)
+    {
+        trail[d / 64] |= uint64_t(1) << (d % 64);
+    }
+
+    VSNRAY_FUNC void reset_trail(int d)
+    {
+        trail[d / 64] &= ~(uint64_t(1) << (d % 64));
+    }
+
+    // Reset the trail for levels d and below
+    VSNRAY_FUNC void clear_trail_from(int d)
+    {
+        for (int w = d / 64; w < Words; ++w)
+        {
+            trail[w] = w == d / 64 ? trail[w] & ((uint64_t(1) << (d % 64)) - 1) : 0;
+        }
+    }
+
+    struct entry
+    {
+        unsigned addr;
+        unsigned depth;
+    };
+
+    uint64_t trail[Words] = {};
+
+    unsigned root;
+
+    // Level of the current node, -1 before the first call to next()
+    int depth = -1;
+
+    // Nodes down to this level are visited again after a restart
+    int revisit_depth = -1;
+
+    bool overflowed = false;
+
+    unsigned top = 0;
+    unsigned size = 0;
+    entry entries[N];
+};
+
+
+// Full stack with N - 1 entries (default)
+//
+// Holds at most one far child per tree level. Trees with more than N - 1 levels of inner
+// nodes can run the stack full, traversal then reports overflow() and starts over with a
+// restart trail.
+//
+
+template <unsigned N = 32>
+struct full_stack
+{
+    using fallback_type = restart_trail<>;
+
+    VSNRAY_FUNC full_stack()
+    {
+        st.push(0); // address of root node
+    }
+
+    VSNRAY_FUNC bool next(unsigned& addr)
+    {
+        if (overflowed || st.empty())
+        {
+            return false;
+        }
+
+        addr = st.pop();
+        return true;
+    }
+
+    template <typename Node>
+    VSNRAY_FUNC bool descend(Node const& node, unsigned near, bool hit_near, bool hit_far, unsigned& addr)
+    {
+        if (hit_near && hit_far)
+        {
+            if (st.full())
+            {
+                overflowed = true;
+                return false;
+            }
+
+            st.push(node.get_child(!near));
+            addr = node.get_child(near);
+        }
+        else if (hit_near)
+        {
+            addr = node.get_child(near);
+        }
+        else if (hit_far)
+        {
+            addr = node.get_child(!near);
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    VSNRAY_FUNC bool revisiting() const
+    {
+        return false;
+    }
+
+    VSNRAY_FUNC bool overflow() const
+    {
+        return overflowed;
+    }
+
+    stack<N> st;
+    bool overflowed = false;
+};
+
+} // detail
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_TRAVERSAL_STACK_H
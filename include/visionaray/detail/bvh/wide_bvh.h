@@ -0,0 +1,423 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_BVH_WIDE_BVH_H
+#define VSNRAY_DETAIL_BVH_WIDE_BVH_H 1
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/aabb.h>
+#include <visionaray/math/limits.h>
+#include <visionaray/aligned_vector.h>
+
+namespace visionaray
+{
+
+//--------------------------------------------------------------------------------------------------
+// wide_bvh_node
+//
+// Node with up to Width children, stores the children's bounds in SoA layout so that
+// all children can be tested with a single SIMD instruction sequence. Leaves are stored
+// inline in their parent node's child slots.
+//
+
+template <unsigned Width>
+struct VSNRAY_ALIGN(32) wide_bvh_node
+{
+    static_assert(Width == 4 || Width == 8, "Wide BVH nodes must have 4 or 8 children");
+
+    enum { width = Width };
+
+    // num_prims of empty child slots
+    enum : unsigned { EmptySlot = ~0U };
+
+    float bbox_min_x[Width];
+    float bbox_min_y[Width];
+    float bbox_min_z[Width];
+    float bbox_max_x[Width];
+    float bbox_max_y[Width];
+    float bbox_max_z[Width];
+
+    union
+    {
+        unsigned child[Width];      // Inner nodes: index of child node
+        unsigned first_prim[Width]; // Leaves: index of first primitive
+    };
+
+    unsigned num_prims[Width];      // 0: inner node, EmptySlot: empty
+
+    bool is_empty(unsigned i) const { return num_prims[i] == EmptySlot; }
+    bool is_inner(unsigned i) const { return num_prims[i] == 0; }
+    bool is_leaf(unsigned i) const { return num_prims[i] != 0 && num_prims[i] != EmptySlot; }
+
+    aabb get_bounds(unsigned i) const
+    {
+        return aabb(
+                vec3(bbox_min_x[i], bbox_min_y[i], bbox_min_z[i]),
+                vec3(bbox_max_x[i], bbox_max_y[i], bbox_max_z[i])
+                );
+    }
+
+    // Bounds of all children
+    aabb get_bounds() const
+    {
+        aabb result;
+        result.invalidate();
+
+        for (unsigned i = 0; i < Width; ++i)
+        {
+            if (!is_empty(i))
+            {
+                result.insert(get_bounds(i));
+            }
+        }
+
+        return result;
+    }
+
+    unsigned get_child(unsigned i) const
+    {
+        assert(is_inner(i));
+        return child[i];
+    }
+
+    bvh_node::index_range get_indices(unsigned i) const
+    {
+        assert(is_leaf(i));
+        return { first_prim[i], first_prim[i] + num_prims[i] };
+    }
+
+    void set_bounds(unsigned i, aabb const& bounds)
+    {
+        bbox_min_x[i] = bounds.min.x;
+        bbox_min_y[i] = bounds.min.y;
+        bbox_min_z[i] = bounds.min.z;
+        bbox_max_x[i] = bounds.max.x;
+        bbox_max_y[i] = bounds.max.y;
+        bbox_max_z[i] = bounds.max.z;
+    }
+
+    void set_empty(unsigned i)
+    {
+        // Bounds are never tested for empty slots, make them harmless nevertheless
+        set_bounds(i, aabb(vec3(0.0f), vec3(0.0f)));
+        child[i] = 0;
+        num_prims[i] = EmptySlot;
+    }
+
+    void set_inner(unsigned i, aabb const& bounds, unsigned child_index)
+    {
+        set_bounds(i, bounds);
+        child[i] = child_index;
+        num_prims[i] = 0;
+    }
+
+    void set_leaf(unsigned i, aabb const& bounds, unsigned first_primitive_index, unsigned count)
+    {
+        assert(count > 0 && count != EmptySlot);
+
+        set_bounds(i, bounds);
+        first_prim[i] = first_primitive_index;
+        num_prims[i] = count;
+    }
+};
+
+static_assert( sizeof(wide_bvh_node<4>) == 128, "Size mismatch" );
+static_assert( sizeof(wide_bvh_node<8>) == 256, "Size mismatch" );
+
+
+//--------------------------------------------------------------------------------------------------
+// wide_bvh_ref_t
+//
+
+template <typename PrimitiveType, unsigned Width>
+class wide_bvh_ref_t
+{
+public:
+
+    using primitive_type = PrimitiveType;
+    using node_type = wide_bvh_node<Width>;
+
+private:
+
+    using P = const PrimitiveType;
+    using N = const node_type;
+
+    P* primitives_first;
+    P* primitives_last;
+    N* nodes_first;
+    N* nodes_last;
+
+public:
+
+    wide_bvh_ref_t() = default;
+
+    wide_bvh_ref_t(P* p0, P* p1, N* n0, N* n1)
+        : primitives_first(p0)
+        , primitives_last(p1)
+        , nodes_first(n0)
+        , nodes_last(n1)
+    {
+    }
+
+    size_t num_primitives() const { return primitives_last - primitives_first; }
+    size_t num_nodes() const { return nodes_last - nodes_first; }
+
+    P& primitive(size_t index) const
+    {
+        return primitives_first[index];
+    }
+
+    N& node(size_t index) const
+    {
+        return nodes_first[index];
+    }
+
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// wide_bvh_t
+//
+// Constructed by collapsing a binary BVH (bvh_t or index_bvh_t). Children are pulled up
+// greedily, always expanding the inner child with the largest surface area, until a node
+// is full. Primitives are stored in leaf order (indirect indices are resolved).
+//
+// Usage:
+//
+//  binned_sah_builder builder;
+//  auto b = builder.build(index_bvh<P>{}, prims, num_prims);
+//  bvh4<P> wide(b);
+//
+
+template <typename PrimitiveVector, typename NodeVector>
+class wide_bvh_t
+{
+public:
+
+    using primitive_type    = typename PrimitiveVector::value_type;
+    using primitive_vector  = PrimitiveVector;
+    using node_type         = typename NodeVector::value_type;
+    using node_vector       = NodeVector;
+
+    enum { width = node_type::width };
+
+    using bvh_ref = wide_bvh_ref_t<primitive_type, width>;
+
+public:
+
+    wide_bvh_t() = default;
+
+    template <
+        typename BVH,
+        typename = typename std::enable_if<is_any_bvh<BVH>::value>::type,
+        typename = typename std::enable_if<!is_any_bvh_inst<BVH>::value>::type
+        >
+    explicit wide_bvh_t(BVH const& b)
+    {
+        collapse(b);
+    }
+
+    template <typename PV, typename NV>
+    explicit wide_bvh_t(wide_bvh_t<PV, NV> const& rhs)
+        : primitives_(rhs.primitives())
+        , nodes_(rhs.nodes())
+    {
+    }
+
+    primitive_vector const& primitives() const  { return primitives_; }
+    primitive_vector&       primitives()        { return primitives_; }
+
+    node_vector const&      nodes() const       { return nodes_; }
+    node_vector&            nodes()             { return nodes_; }
+
+    size_t num_primitives() const               { return primitives_.size(); }
+    size_t num_nodes() const                    { return nodes_.size(); }
+
+    bvh_ref ref() const
+    {
+        auto p0 = detail::get_pointer(primitives());
+        auto p1 = p0 + primitives().size();
+
+        auto n0 = detail::get_pointer(nodes());
+        auto n1 = n0 + nodes().size();
+
+        return { p0, p1, n0, n1 };
+    }
+
+    primitive_type const& primitive(size_t index) const
+    {
+        return primitives_[index];
+    }
+
+    node_type const& node(size_t index) const
+    {
+        return nodes_[index];
+    }
+
+    void clear(size_t capacity = 0)
+    {
+        nodes_.clear();
+        nodes_.reserve(capacity);
+    }
+
+private:
+
+    primitive_vector primitives_;
+    node_vector nodes_;
+
+    template <typename BVH>
+    void collapse(BVH const& b)
+    {
+        clear();
+        primitives_.clear();
+
+        if (b.num_nodes() == 0)
+        {
+            return;
+        }
+
+        // Copy primitives in leaf order
+
+        size_t num_prims = 0;
+
+        for (auto const& n : b.nodes())
+        {
+            if (is_leaf(n))
+            {
+                num_prims = std::max(num_prims, static_cast<size_t>(n.get_indices().last));
+            }
+        }
+
+        primitives_.resize(num_prims);
+
+        for (size_t i = 0; i < num_prims; ++i)
+        {
+            primitives_[i] = b.primitive(i);
+        }
+
+        // Collapse nodes
+
+        nodes_.reserve(b.num_nodes() / (width - 1) + 1);
+        nodes_.emplace_back();
+
+        if (is_leaf(b.node(0)))
+        {
+            auto const& n = b.node(0);
+
+            nodes_[0].set_leaf(0, n.get_bounds(), n.get_first_primitive(), n.get_num_primitives());
+
+            for (unsigned i = 1; i < width; ++i)
+            {
+                nodes_[0].set_empty(i);
+            }
+        }
+        else
+        {
+            collapse_node(b, 0, 0);
+        }
+    }
+
+    // Fill wide node INDEX with the descendants of binary inner node N
+    template <typename BVH>
+    void collapse_node(BVH const& b, size_t index, size_t n)
+    {
+        size_t children[width];
+        unsigned count = 2;
+
+        children[0] = b.node(n).get_child(0);
+        children[1] = b.node(n).get_child(1);
+
+        while (count < width)
+        {
+            // Pull up the children of the inner child with the largest surface area
+            int best = -1;
+            float best_area = -1.0f;
+
+            for (unsigned i = 0; i < count; ++i)
+            {
+                auto const& c = b.node(children[i]);
+
+                if (is_inner(c) && surface_area(c.get_bounds()) > best_area)
+                {
+                    best = static_cast<int>(i);
+                    best_area = surface_area(c.get_bounds());
+                }
+            }
+
+            if (best < 0)
+            {
+                break;
+            }
+
+            auto const& c = b.node(children[best]);
+
+            children[best] = c.get_child(0);
+            children[count++] = c.get_child(1);
+        }
+
+        for (unsigned i = 0; i < width; ++i)
+        {
+            if (i >= count)
+            {
+                nodes_[index].set_empty(i);
+                continue;
+            }
+
+            auto const& c = b.node(children[i]);
+
+            if (is_leaf(c))
+            {
+                nodes_[index].set_leaf(i, c.get_bounds(), c.get_first_primitive(), c.get_num_primitives());
+            }
+            else
+            {
+                auto child_index = nodes_.size();
+
+                nodes_.emplace_back();
+                nodes_[index].set_inner(i, c.get_bounds(), static_cast<unsigned>(child_index));
+
+                collapse_node(b, child_index, children[i]);
+            }
+        }
+    }
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// wide bvh traits
+//
+
+template <typename T1, typename T2>
+struct is_wide_bvh<wide_bvh_t<T1, T2>> : std::true_type {};
+
+template <typename T, unsigned W>
+struct is_wide_bvh<wide_bvh_ref_t<T, W>> : std::true_type {};
+
+// Wide BVHs store their primitives directly, like bvh_t
+template <typename T1, typename T2>
+struct is_bvh<wide_bvh_t<T1, T2>> : std::true_type {};
+
+template <typename T, unsigned W>
+struct is_bvh<wide_bvh_ref_t<T, W>> : std::true_type {};
+
+
+//-------------------------------------------------------------------------------------------------
+// Typedefs
+//
+
+template <typename P>
+using bvh4 = wide_bvh_t<aligned_vector<P>, aligned_vector<wide_bvh_node<4>, 32>>;
+template <typename P>
+using bvh8 = wide_bvh_t<aligned_vector<P>, aligned_vector<wide_bvh_node<8>, 32>>;
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_BVH_WIDE_BVH_H
@@ -2,15 +2,81 @@
 // See the LICENSE file for details.
 
 #include <algorithm>
+#include <cstddef>
+#include <vector>
 
 #include <visionaray/gl/compositing.h>
 #include <visionaray/aligned_vector.h>
 
+#include "aligned_allocator.h"
 #include "color_conversion.h"
+#include "numa.h"
 
 
 namespace visionaray
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Aligned allocator that default-initializes elements, so that resizing a vector doesn't
+// touch the pages of pixel types w/o constructor
+//
+
+template <typename T>
+class default_init_allocator : public aligned_allocator<T, 16>
+{
+public:
+
+    template <typename U>
+    struct rebind
+    {
+        typedef default_init_allocator<U> other;
+    };
+
+    default_init_allocator() = default;
+
+    template <typename U>
+    default_init_allocator(default_init_allocator<U> const& /* rhs */)
+    {
+    }
+
+    using aligned_allocator<T, 16>::construct;
+
+    template <typename U>
+    void construct(U* p)
+    {
+        ::new(static_cast<void*>(p)) U;
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// (Re)allocate a frame buffer with w x h pixels and fill it with value. The buffer is filled
+// in one horizontal band per NUMA node, by a thread on that node, so that the pages are
+// placed like tiled_sched renders the tiles with PinnedPerNumaNode affinity (first touch)
+//
+
+template <typename T>
+void first_touch_resize(std::vector<T, default_init_allocator<T>>& buffer, int w, int h, T const& value)
+{
+    // Fresh allocation, pages are untouched
+    std::vector<T, default_init_allocator<T>>().swap(buffer);
+    buffer.resize(static_cast<size_t>(w) * h);
+
+    unsigned num_nodes = numa_num_nodes();
+
+    for_each_numa_node([&](unsigned node)
+    {
+        size_t first_row = static_cast<size_t>(h) * node / num_nodes;
+        size_t last_row = static_cast<size_t>(h) * (node + 1) / num_nodes;
+
+        std::fill(buffer.begin() + first_row * w, buffer.begin() + last_row * w, value);
+    });
+}
+
+} // detail
+
 
 //-------------------------------------------------------------------------------------------------
 // Private implementation
@@ -19,12 +85,16 @@ namespace visionaray
 template <pixel_format ColorFormat, pixel_format DepthFormat>
 struct cpu_buffer_rt<ColorFormat, DepthFormat>::impl
 {
+    template <typename T>
+    using buffer_type = std::vector<T, detail::default_init_allocator<T>>;
+
     impl() : compositor(nullptr) {}
 
     std::unique_ptr<gl::depth_compositor>   compositor;
 
-    aligned_vector<color_type>              color_buffer;
-    aligned_vector<depth_type>              depth_buffer;
+    buffer_type<color_type>                 color_buffer;
+    buffer_type<depth_type>                 depth_buffer;
+    buffer_type<pixel_stats>                stats_buffer;
 };
 
 
@@ -94,6 +164,8 @@ void cpu_buffer_rt<ColorFormat, DepthFormat>::clear_color_buffer(vec4 const& c)
         );
 
     std::fill(impl_->color_buffer.begin(), impl_->color_buffer.end(), cc);
+
+    std::fill(impl_->stats_buffer.begin(), impl_->stats_buffer.end(), detail::initial_pixel_stats());
 }
 
 template <pixel_format ColorFormat, pixel_format DepthFormat>
@@ -127,13 +199,18 @@ void cpu_buffer_rt<ColorFormat, DepthFormat>::resize(int w, int h)
     render_target::resize(w, h);
 
 
-    // Allocate storage
+    // Allocate storage, zero-initialized
 
-    impl_->color_buffer.resize(w * h);
+    detail::first_touch_resize(impl_->color_buffer, w, h, color_type());
 
     if (DepthFormat != PF_UNSPECIFIED)
     {
-        impl_->depth_buffer.resize(w * h);
+        detail::first_touch_resize(impl_->depth_buffer, w, h, depth_type());
+    }
+
+    if (!impl_->stats_buffer.empty())
+    {
+        detail::first_touch_resize(impl_->stats_buffer, w, h, detail::initial_pixel_stats());
     }
 
     if (!impl_->compositor)
@@ -156,6 +233,29 @@ void cpu_buffer_rt<ColorFormat, DepthFormat>::resize(int w, int h)
     }
 }
 
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+pixel_stats* cpu_buffer_rt<ColorFormat, DepthFormat>::stats()
+{
+    size_t num_pixels = static_cast<size_t>(width()) * height();
+
+    if (impl_->stats_buffer.size() != num_pixels)
+    {
+        detail::first_touch_resize(impl_->stats_buffer, width(), height(), detail::initial_pixel_stats());
+    }
+
+    return impl_->stats_buffer.data();
+}
+
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+convergence_info cpu_buffer_rt<ColorFormat, DepthFormat>::convergence(float max_error) const
+{
+    return compute_convergence(
+            impl_->stats_buffer.data(),
+            impl_->stats_buffer.size(),
+            max_error
+            );
+}
+
 template <pixel_format ColorFormat, pixel_format DepthFormat>
 void cpu_buffer_rt<ColorFormat, DepthFormat>::display_color_buffer() const
 {
@@ -38,10 +38,20 @@ public:
     template <typename K, typename SP>
     void frame(K kernel, SP sched_params, size_t smem = 0, cudaStream_t const& stream = 0);
 
+    // Seed and sample index of the next frame, see basic_sched
+    void set_seed(unsigned seed);
+    void set_sample_offset(unsigned offset);
+    unsigned sample_offset() const;
+
 private:
 
     vec2ui block_size_ = vec2ui(16, 16);
 
+    // Seeds random generators, advanced every frame
+    unsigned frame_num_ = 0;
+
+    unsigned seed_ = 0;
+
 };
 
 } // visionaray
@@ -18,35 +18,6 @@ namespace visionaray
 namespace detail
 {
 
-//-------------------------------------------------------------------------------------------------
-// RNG seed
-//
-
-// https://code.google.com/p/thrust/source/browse/examples/monte_carlo.cu
-
-VSNRAY_GPU_FUNC
-inline unsigned cuda_hash(unsigned a)
-{
-    a = (a + 0x7ed55d16) + (a << 12);
-    a = (a ^ 0xc761c23c) ^ (a >> 19);
-    a = (a + 0x165667b1) + (a << 5);
-    a = (a + 0xd3a2646c) ^ (a << 9);
-    a = (a + 0xfd7046c5) + (a << 3);
-    a = (a ^ 0xb55a4f09) ^ (a >> 16);
-    return a;
-}
-
-VSNRAY_GPU_FUNC
-inline unsigned cuda_seed()
-{
-    unsigned x = blockIdx.x * blockDim.x + threadIdx.x;
-    unsigned y = blockIdx.y * blockDim.y + threadIdx.y;
-    unsigned w = blockDim.x * gridDim.x;
-
-    return cuda_hash(tic(float{} /*TODO*/) + y * w + x);
-}
-
-
 //-------------------------------------------------------------------------------------------------
 // CUDA kernels
 //
@@ -62,6 +33,8 @@ template <
 __global__ void render(
         PxSamplerT      sample_params,
         Rect            scissor_box,
+        unsigned        frame_num,
+        unsigned        seed,
         RTRef           rt_ref,
         K               kernel,
         Args...         args
@@ -75,10 +48,14 @@ __global__ void render(
         return;
     }
 
-    auto gen = make_generator(
+    auto gen = make_pixel_generator(
             typename R::scalar_type{},
             sample_params,
-            detail::cuda_seed()
+            x,
+            y,
+            rt_ref.width(),
+            frame_num,
+            seed
             );
 
     auto r = detail::make_primary_rays(
@@ -116,6 +93,8 @@ __global__ void render(
         PxSamplerT                      sample_params,
         Intersector                     intersector,
         Rect                            scissor_box,
+        unsigned                        frame_num,
+        unsigned                        seed,
         RTRef                           rt_ref,
         K                               kernel,
         Args...                         args
@@ -129,8 +108,15 @@ __global__ void render(
         return;
     }
 
-    // TODO: support any sampler
-    random_generator<typename R::scalar_type> gen(detail::cuda_seed());
+    auto gen = make_pixel_generator(
+            typename R::scalar_type{},
+            sample_params,
+            x,
+            y,
+            rt_ref.width(),
+            frame_num,
+            seed
+            );
 
     auto r = detail::make_primary_rays(
             R{},
@@ -169,12 +155,16 @@ inline void cuda_sched_impl_call_render(
         size_t              smem,
         cudaStream_t const& stream,
         Rect const&         scissor_box,
+        unsigned            frame_num,
+        unsigned            seed,
         Args&&...           args
         )
 {
     render<R, typename SP::pixel_sampler_type><<<grid_size, block_size, smem, stream>>>(
             sparams.sample_params,
             scissor_box,
+            frame_num,
+            seed,
             std::forward<Args>(args)...
             );
 }
@@ -188,6 +178,8 @@ inline void cuda_sched_impl_call_render(
         size_t              smem,
         cudaStream_t const& stream,
         Rect const&         scissor_box,
+        unsigned            frame_num,
+        unsigned            seed,
         Args&&...           args
         )
 {
@@ -196,6 +188,8 @@ inline void cuda_sched_impl_call_render(
             sparams.sample_params,
             sparams.intersector,
             scissor_box,
+            frame_num,
+            seed,
             std::forward<Args>(args)...
             );
 }
@@ -207,7 +201,9 @@ inline void cuda_sched_impl_frame(
         SP                  sparams,
         dim3 const&         block_size,
         size_t              smem,
-        cudaStream_t const& stream
+        cudaStream_t const& stream,
+        unsigned            frame_num,
+        unsigned            seed
         )
 {
     using cuda_dim_t = decltype(block_size.x);
@@ -228,6 +224,8 @@ inline void cuda_sched_impl_frame(
             smem,
             stream,
             sparams.scissor_box,
+            frame_num,
+            seed,
             sparams.rt.ref(),
             kernel,
             sparams.rt.width(),
@@ -268,7 +266,9 @@ void cuda_sched<R>::frame(K kernel, SP sched_params, size_t smem, cudaStream_t c
             sched_params,
             dim3(block_size_.x, block_size_.y),
             smem,
-            stream
+            stream,
+            frame_num_++,
+            seed_
             );
 
     sched_params.rt.end_frame();
@@ -276,4 +276,22 @@ void cuda_sched<R>::frame(K kernel, SP sched_params, size_t smem, cudaStream_t c
     sched_params.cam.end_frame();
 }
 
+template <typename R>
+void cuda_sched<R>::set_seed(unsigned seed)
+{
+    seed_ = seed;
+}
+
+template <typename R>
+void cuda_sched<R>::set_sample_offset(unsigned offset)
+{
+    frame_num_ = offset;
+}
+
+template <typename R>
+unsigned cuda_sched<R>::sample_offset() const
+{
+    return frame_num_;
+}
+
 } // visionaray
@@ -0,0 +1,228 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <type_traits>
+
+#include "../math/simd/gather.h"
+#include "../math/simd/type_traits.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Sample a piecewise-constant 1D distribution with n cells, cdf has n + 1 entries.
+// Returns the cell, offset is the position in [0..1) inside the cell
+//
+
+VSNRAY_FUNC
+inline int sample_cdf(float const* cdf, int n, float u, float& offset)
+{
+    // Last cell with cdf[i] <= u
+    int first = 0;
+    int last = n;
+
+    while (last - first > 1)
+    {
+        int mid = (first + last) / 2;
+
+        if (cdf[mid] <= u)
+        {
+            first = mid;
+        }
+        else
+        {
+            last = mid;
+        }
+    }
+
+    float width = cdf[first + 1] - cdf[first];
+    offset = width > 0.0f ? min((u - cdf[first]) / width, 0.99999994f) : 0.0f;
+
+    return first;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Lookup density values, gather for SIMD indices
+//
+
+VSNRAY_FUNC
+inline float lookup_density(float const* data, int index)
+{
+    return data[index];
+}
+
+template <
+    typename I,
+    typename = typename std::enable_if<simd::is_simd_vector<I>::value>::type
+    >
+inline auto lookup_density(float const* data, I const& index)
+    -> decltype( gather(data, index) )
+{
+    return gather(data, index);
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// distribution_2d_ref
+//
+
+VSNRAY_FUNC
+inline distribution_2d_ref::distribution_2d_ref(
+        float const*    pdf,
+        float const*    conditional_cdf,
+        float const*    marginal_cdf,
+        int             width,
+        int             height
+        )
+    : pdf_(pdf)
+    , conditional_cdf_(conditional_cdf)
+    , marginal_cdf_(marginal_cdf)
+    , width_(width)
+    , height_(height)
+{
+}
+
+VSNRAY_FUNC
+inline vec2 distribution_2d_ref::sample(float u1, float u2, float& pdf) const
+{
+    float dv = 0.0f;
+    int y = detail::sample_cdf(marginal_cdf_, height_, u2, dv);
+
+    float du = 0.0f;
+    int x = detail::sample_cdf(conditional_cdf_ + y * (width_ + 1), width_, u1, du);
+
+    pdf = pdf_[y * width_ + x];
+
+    return vec2(
+            (x + du) / width_,
+            (y + dv) / height_
+            );
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline T distribution_2d_ref::pdf(vector<2, T> const& uv) const
+{
+    using I = simd::int_type_t<T>;
+
+    I x = convert_to_int(uv.x * T(static_cast<float>(width_)));
+    I y = convert_to_int(uv.y * T(static_cast<float>(height_)));
+
+    x = min(max(x, I(0)), I(width_ - 1));
+    y = min(max(y, I(0)), I(height_ - 1));
+
+    return detail::lookup_density(pdf_, y * I(width_) + x);
+}
+
+VSNRAY_FUNC
+inline int distribution_2d_ref::width() const
+{
+    return width_;
+}
+
+VSNRAY_FUNC
+inline int distribution_2d_ref::height() const
+{
+    return height_;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// distribution_2d
+//
+
+inline distribution_2d::distribution_2d(float const* func, int width, int height)
+{
+    build(func, width, height);
+}
+
+inline void distribution_2d::build(float const* func, int width, int height)
+{
+    width_ = width;
+    height_ = height;
+
+    size_t num_cells = static_cast<size_t>(width) * height;
+
+    pdf_.resize(num_cells);
+    conditional_cdf_.resize(static_cast<size_t>(width + 1) * height);
+    marginal_cdf_.resize(height + 1);
+
+    double total = 0.0;
+
+    for (size_t i = 0; i < num_cells; ++i)
+    {
+        total += max(func[i], 0.0f);
+    }
+
+    // Function values or 1 for the uniform distribution
+    auto f = [&](int x, int y)
+    {
+        return total > 0.0 ? static_cast<double>(max(func[y * width + x], 0.0f)) : 1.0;
+    };
+
+    double sum = total > 0.0 ? total : static_cast<double>(num_cells);
+
+    marginal_cdf_[0] = 0.0f;
+    double marginal = 0.0;
+
+    for (int y = 0; y < height; ++y)
+    {
+        float* cdf = conditional_cdf_.data() + y * (width + 1);
+
+        double row = 0.0;
+
+        for (int x = 0; x < width; ++x)
+        {
+            row += f(x, y);
+        }
+
+        cdf[0] = 0.0f;
+        double conditional = 0.0;
+
+        for (int x = 0; x < width; ++x)
+        {
+            // Rows w/o contribution are never sampled, keep their cdfs valid
+            conditional += row > 0.0 ? f(x, y) / row : 1.0 / width;
+            cdf[x + 1] = static_cast<float>(conditional);
+
+            // Density over [0..1)^2
+            pdf_[y * width + x] = static_cast<float>(f(x, y) * num_cells / sum);
+        }
+
+        cdf[width] = 1.0f;
+
+        marginal += row / sum;
+        marginal_cdf_[y + 1] = static_cast<float>(marginal);
+    }
+
+    marginal_cdf_[height] = 1.0f;
+}
+
+inline distribution_2d::ref_type distribution_2d::ref() const
+{
+    return ref_type(
+            pdf_.data(),
+            conditional_cdf_.data(),
+            marginal_cdf_.data(),
+            width_,
+            height_
+            );
+}
+
+inline int distribution_2d::width() const
+{
+    return width_;
+}
+
+inline int distribution_2d::height() const
+{
+    return height_;
+}
+
+} // visionaray
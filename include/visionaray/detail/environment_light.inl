@@ -0,0 +1,219 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "../math/constants.h"
+#include "../texture/texture.h"
+#include "color_conversion.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Latitude-longitude mapping
+//
+
+template <typename T>
+VSNRAY_FUNC
+inline vector<2, T> direction_to_latlong(vector<3, T> const& dir)
+{
+    return vector<2, T>(
+            atan2(dir.x, -dir.z) * constants::inv_pi<T>() * T(0.5) + T(0.5),
+            acos(clamp(dir.y, T(-1.0), T(1.0))) * constants::inv_pi<T>()
+            );
+}
+
+template <typename T>
+VSNRAY_FUNC
+inline vector<3, T> latlong_to_direction(vector<2, T> const& uv, T& sin_theta)
+{
+    T phi = (uv.x - T(0.5)) * constants::two_pi<T>();
+    T theta = uv.y * constants::pi<T>();
+
+    sin_theta = sin(theta);
+
+    return vector<3, T>(
+            sin_theta * sin(phi),
+            cos(theta),
+            -sin_theta * cos(phi)
+            );
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// environment_light members
+//
+
+template <typename T, typename Texture>
+inline environment_light<T, Texture>::environment_light(
+        Texture             texture,
+        distribution_2d_ref distribution
+        )
+    : texture_(texture)
+    , distribution_(distribution)
+{
+}
+
+template <typename T, typename Texture>
+template <typename U>
+VSNRAY_FUNC
+inline vector<3, U> environment_light<T, Texture>::intensity(vector<3, U> const& pos) const
+{
+    return radiance(normalize(pos));
+}
+
+template <typename T, typename Texture>
+template <typename U>
+VSNRAY_FUNC
+inline vector<3, U> environment_light<T, Texture>::radiance(vector<3, U> const& dir) const
+{
+    auto uv = detail::direction_to_latlong(normalize(matrix<3, 3, U>(world_to_light_) * dir));
+
+    auto texel = tex2D(texture_, uv);
+
+    return vector<3, U>(texel.xyz()) * U(scale_);
+}
+
+template <typename T, typename Texture>
+template <typename U>
+VSNRAY_FUNC
+inline U environment_light<T, Texture>::pdf(vector<3, U> const& dir) const
+{
+    auto d = normalize(matrix<3, 3, U>(world_to_light_) * dir);
+
+    auto sin_theta = sqrt(max(U(1.0) - d.y * d.y, U(0.0)));
+
+    auto pdf = distribution_.pdf(detail::direction_to_latlong(d));
+
+    // Map density over [0..1)^2 to solid angle
+    return select(
+            sin_theta > U(0.0),
+            pdf / (U(2.0) * constants::pi<U>() * constants::pi<U>() * sin_theta),
+            U(0.0)
+            );
+}
+
+template <typename T, typename Texture>
+template <typename Generator, typename U>
+VSNRAY_FUNC
+inline light_sample<U> environment_light<T, Texture>::sample(Generator& gen) const
+{
+    light_sample<U> result;
+
+    float u1 = static_cast<float>(gen.next());
+    float u2 = static_cast<float>(gen.next());
+
+    float pdf = 0.0f;
+    vector<2, U> uv(distribution_.sample(u1, u2, pdf));
+
+    U sin_theta(0.0);
+    auto dir = normalize(matrix<3, 3, U>(light_to_world_) * detail::latlong_to_direction(uv, sin_theta));
+
+    U solid_angle_pdf = sin_theta > U(0.0)
+            ? U(pdf) / (U(2.0) * constants::pi<U>() * constants::pi<U>() * sin_theta)
+            : U(0.0);
+
+    result.pos = dir;
+    result.intensity = solid_angle_pdf > U(0.0) ? radiance(dir) : vector<3, U>(0.0);
+    result.normal = -dir;
+    result.area = solid_angle_pdf > U(0.0) ? U(1.0) / solid_angle_pdf : U(0.0);
+    result.delta_light = false;
+    result.infinite_light = true;
+
+    return result;
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline vector<3, T> environment_light<T, Texture>::position() const
+{
+    return vector<3, T>(0.0);
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline Texture const& environment_light<T, Texture>::texture() const
+{
+    return texture_;
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline distribution_2d_ref const& environment_light<T, Texture>::distribution() const
+{
+    return distribution_;
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline void environment_light<T, Texture>::set_texture(Texture const& texture)
+{
+    texture_ = texture;
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline void environment_light<T, Texture>::set_distribution(distribution_2d_ref const& distribution)
+{
+    distribution_ = distribution;
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline void environment_light<T, Texture>::set_scale(T scale)
+{
+    scale_ = scale;
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline T environment_light<T, Texture>::scale() const
+{
+    return scale_;
+}
+
+template <typename T, typename Texture>
+VSNRAY_FUNC
+inline void environment_light<T, Texture>::set_light_to_world_transform(matrix<4, 4, T> const& light_to_world)
+{
+    light_to_world_ = top_left(light_to_world);
+    world_to_light_ = inverse(light_to_world_);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Sampling distribution for latitude-longitude maps
+//
+
+template <typename Texture>
+inline distribution_2d make_environment_distribution(Texture const& texture)
+{
+    int width = static_cast<int>(texture.width());
+    int height = static_cast<int>(texture.height());
+
+    std::vector<float> func(static_cast<size_t>(width) * height);
+
+    for (int y = 0; y < height; ++y)
+    {
+        // Texels near the poles cover less solid angle
+        float sin_theta = std::sin(constants::pi<float>() * (y + 0.5f) / height);
+
+        for (int x = 0; x < width; ++x)
+        {
+            auto texel = texture.data()[y * width + x];
+
+            func[y * width + x] = max(rgb_to_luminance(vec3(texel.xyz())), 0.0f) * sin_theta;
+        }
+    }
+
+    return distribution_2d(func.data(), width, height);
+}
+
+} // visionaray
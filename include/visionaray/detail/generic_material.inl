@@ -2,6 +2,8 @@
 // See the LICENSE file for details.
 
 #include <cstddef>
+#include <type_traits>
+#include <utility>
 
 #include <visionaray/math/array.h>
 #include <visionaray/material.h>
@@ -153,12 +155,39 @@ struct generic_material<T, Ts...>::pdf_visitor
 };
 
 
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Check if N materials of type M can be packed into a SIMD material
+//
+
+template <typename M, size_t N, typename = void>
+struct is_packable : std::false_type
+{
+};
+
+template <typename M, size_t N>
+struct is_packable<M, N, decltype(simd::pack(std::declval<array<M, N>>()), void())>
+    : std::true_type
+{
+};
+
+} // detail
+
+
 namespace simd
 {
 
 //-------------------------------------------------------------------------------------------------
 // SIMD type used internally. Contains N generic materials
 //
+// Materials are evaluated once per material type present in the packet: the lanes' materials
+// of that type are packed into a SIMD material and evaluated for all lanes, results are
+// blended into the lanes of that type. If all lanes share a material type (e.g. primary
+// rays), that is a single SIMD evaluation. Material types w/o SIMD representation are
+// evaluated lane by lane. Lanes w/o valid material (default constructed) return zero.
+//
 
 template <size_t N, typename ...Ts>
 class generic_material
@@ -190,21 +219,209 @@ public:
 
     VSNRAY_FUNC
     spectrum<scalar_type> ambient() const
+    {
+        spectrum<scalar_type> result(0.0);
+
+        ambient_impl(lane_types(), result, first_type{});
+
+        return result;
+    }
+
+
+    template <typename SR>
+    VSNRAY_FUNC
+    spectrum<scalar_type> shade(SR const& sr) const
+    {
+        spectrum<scalar_type> result(0.0);
+
+        shade_impl(sr, lane_types(), result, first_type{});
+
+        return result;
+    }
+
+    template <typename SR, typename Generator>
+    VSNRAY_FUNC
+    spectrum<scalar_type> sample(
+            SR const&                sr,
+            vector<3, scalar_type>&  refl_dir,
+            scalar_type&             pdf,
+            int_type_t<scalar_type>& inter,
+            Generator&               gen
+            ) const
+    {
+        spectrum<scalar_type> result(0.0);
+
+        refl_dir = vector<3, scalar_type>(0.0);
+        pdf = scalar_type(0.0);
+        inter = int_type_t<scalar_type>(0);
+
+        sample_impl(sr, refl_dir, pdf, inter, gen, lane_types(), result, first_type{});
+
+        return result;
+    }
+
+    template <typename SR, typename Interaction>
+    VSNRAY_FUNC
+    scalar_type pdf(SR const& sr, Interaction const& inter) const
+    {
+        scalar_type result(0.0);
+
+        pdf_impl(sr, inter, lane_types(), result, first_type{});
+
+        return result;
+    }
+
+private:
+
+    using int_type   = int_type_t<scalar_type>;
+    using first_type = visionaray::detail::type_index<0>;
+    using last_type  = visionaray::detail::type_index<sizeof...(Ts)>;
+
+    template <unsigned I>
+    using material_at = visionaray::detail::type_at<I + 1, Ts...>;
+
+    template <unsigned I>
+    using packable = visionaray::detail::is_packable<material_at<I>, N>;
+
+    array<single_material, N> mats_;
+
+
+    // Material type index per lane, -1 for lanes w/o valid material
+    VSNRAY_FUNC
+    int_type lane_types() const
+    {
+        aligned_array_t<int_type> types;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            types[i] = static_cast<int>(mats_[i].which());
+        }
+
+        return int_type(types);
+    }
+
+    // Pack the materials of type M, lanes of other types get a copy of a material of type M
+    template <typename M>
+    VSNRAY_FUNC
+    auto pack_type() const
+        -> decltype(pack(std::declval<array<M, N>>()))
+    {
+        M const* any = nullptr;
+
+        for (size_t i = 0; i < N && !any; ++i)
+        {
+            any = mats_[i].template as<M>();
+        }
+
+        array<M, N> mats;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            auto ptr = mats_[i].template as<M>();
+            mats[i] = ptr ? *ptr : *any;
+        }
+
+        return pack(mats);
+    }
+
+
+    // ambient ------------------------------------------------
+
+    template <unsigned I>
+    VSNRAY_FUNC
+    void ambient_impl(int_type const& types, spectrum<scalar_type>& result, visionaray::detail::type_index<I>) const
+    {
+        auto mask = types == int_type(I);
+
+        if (any(mask))
+        {
+            auto amb = ambient_type<material_at<I>>(std::integral_constant<bool, packable<I>::value>{});
+
+            if (all(mask))
+            {
+                result = amb;
+                return;
+            }
+
+            result = select(mask, amb, result);
+        }
+
+        ambient_impl(types, result, visionaray::detail::type_index<I + 1>{});
+    }
+
+    VSNRAY_FUNC
+    void ambient_impl(int_type const&, spectrum<scalar_type>&, last_type) const
+    {
+    }
+
+    template <typename M>
+    VSNRAY_FUNC
+    spectrum<scalar_type> ambient_type(std::true_type /* packable */) const
+    {
+        return pack_type<M>().ambient();
+    }
+
+    template <typename M>
+    VSNRAY_FUNC
+    spectrum<scalar_type> ambient_type(std::false_type /* packable */) const
     {
         array<spectrum<float>, N> amb;
 
         for (size_t i = 0; i < N; ++i)
         {
-            amb[i] = mats_[i].ambient();
+            auto ptr = mats_[i].template as<M>();
+            amb[i] = ptr ? ptr->ambient() : spectrum<float>(0.0f);
         }
 
         return pack(amb);
     }
 
 
+    // shade --------------------------------------------------
+
+    template <typename SR, unsigned I>
+    VSNRAY_FUNC
+    void shade_impl(
+            SR const&                       sr,
+            int_type const&                 types,
+            spectrum<scalar_type>&          result,
+            visionaray::detail::type_index<I>
+            ) const
+    {
+        auto mask = types == int_type(I);
+
+        if (any(mask))
+        {
+            auto shaded = shade_type<material_at<I>>(sr, std::integral_constant<bool, packable<I>::value>{});
+
+            if (all(mask))
+            {
+                result = shaded;
+                return;
+            }
+
+            result = select(mask, shaded, result);
+        }
+
+        shade_impl(sr, types, result, visionaray::detail::type_index<I + 1>{});
+    }
+
     template <typename SR>
     VSNRAY_FUNC
-    spectrum<scalar_type> shade(SR const& sr) const
+    void shade_impl(SR const&, int_type const&, spectrum<scalar_type>&, last_type) const
+    {
+    }
+
+    template <typename M, typename SR>
+    VSNRAY_FUNC
+    spectrum<scalar_type> shade_type(SR const& sr, std::true_type /* packable */) const
+    {
+        return pack_type<M>().shade(sr);
+    }
+
+    template <typename M, typename SR>
+    VSNRAY_FUNC
+    spectrum<scalar_type> shade_type(SR const& sr, std::false_type /* packable */) const
     {
         auto srs = unpack(sr);
 
@@ -212,24 +429,121 @@ public:
 
         for (size_t i = 0; i < N; ++i)
         {
-            shaded[i] = mats_[i].shade(srs[i]);
+            auto ptr = mats_[i].template as<M>();
+            shaded[i] = ptr ? ptr->shade(srs[i]) : spectrum<float>(0.0f);
         }
 
         return pack(shaded);
     }
 
+
+    // sample -------------------------------------------------
+
+    template <typename SR, typename Generator, unsigned I>
+    VSNRAY_FUNC
+    void sample_impl(
+            SR const&                       sr,
+            vector<3, scalar_type>&         refl_dir,
+            scalar_type&                    pdf,
+            int_type&                       inter,
+            Generator&                      gen,
+            int_type const&                 types,
+            spectrum<scalar_type>&          result,
+            visionaray::detail::type_index<I>
+            ) const
+    {
+        auto mask = types == int_type(I);
+
+        if (any(mask))
+        {
+            vector<3, scalar_type> rd(0.0);
+            scalar_type pd(0.0);
+            int_type it(0);
+
+            auto sampled = sample_type<material_at<I>>(
+                    sr,
+                    rd,
+                    pd,
+                    it,
+                    gen,
+                    mask,
+                    std::integral_constant<bool, packable<I>::value>{}
+                    );
+
+            if (all(mask))
+            {
+                refl_dir = rd;
+                pdf = pd;
+                inter = it;
+                result = sampled;
+                return;
+            }
+
+            refl_dir = select(mask, rd, refl_dir);
+            pdf = select(mask, pd, pdf);
+            inter = select(mask, it, inter);
+            result = select(mask, sampled, result);
+        }
+
+        sample_impl(sr, refl_dir, pdf, inter, gen, types, result, visionaray::detail::type_index<I + 1>{});
+    }
+
     template <typename SR, typename Generator>
     VSNRAY_FUNC
-    spectrum<scalar_type> sample(
+    void sample_impl(
+            SR const&,
+            vector<3, scalar_type>&,
+            scalar_type&,
+            int_type&,
+            Generator&,
+            int_type const&,
+            spectrum<scalar_type>&,
+            last_type
+            ) const
+    {
+    }
+
+    // All lanes draw numbers, but only those in mask advance their streams. Lanes sample
+    // the same numbers as with scalar materials, no matter which other materials the
+    // packet contains
+    template <typename M, typename SR, typename Generator, typename Mask>
+    VSNRAY_FUNC
+    spectrum<scalar_type> sample_type(
             SR const&                sr,
             vector<3, scalar_type>&  refl_dir,
             scalar_type&             pdf,
-            int_type_t<scalar_type>& inter,
-            Generator&               gen
+            int_type&                inter,
+            Generator&               gen,
+            Mask const&              mask,
+            std::true_type           /* packable */
+            ) const
+    {
+        if (all(mask))
+        {
+            return pack_type<M>().sample(sr, refl_dir, pdf, inter, gen);
+        }
+
+        Generator g(gen);
+        auto result = pack_type<M>().sample(sr, refl_dir, pdf, inter, g);
+        gen = select(mask, g, gen);
+        return result;
+    }
+
+    // Lanes draw from their own streams, lanes of other materials don't draw at all
+    template <typename M, typename SR, typename Generator, typename Mask>
+    VSNRAY_FUNC
+    spectrum<scalar_type> sample_type(
+            SR const&                sr,
+            vector<3, scalar_type>&  refl_dir,
+            scalar_type&             pdf,
+            int_type&                inter,
+            Generator&               gen,
+            Mask const&              /* mask */,
+            std::false_type          /* packable */
             ) const
     {
         using float_array = aligned_array_t<scalar_type>;
-        using int_array = aligned_array_t<int_type_t<scalar_type>>;
+        using int_array = aligned_array_t<int_type>;
 
         auto srs = unpack(sr);
 
@@ -240,21 +554,73 @@ public:
 
         for (size_t i = 0; i < N; ++i)
         {
-            sampled[i] = mats_[i].sample(srs[i], rds[i], pdfs[i], inters[i], gen.get_generator(i));
+            rds[i] = vector<3, float>(0.0f);
+            pdfs[i] = 0.0f;
+            inters[i] = 0;
+            sampled[i] = spectrum<float>(0.0f);
+
+            if (auto ptr = mats_[i].template as<M>())
+            {
+                sampled[i] = ptr->sample(srs[i], rds[i], pdfs[i], inters[i], gen.get_generator(i));
+            }
         }
 
         refl_dir = pack(rds);
         pdf = scalar_type(pdfs);
-        inter = int_type_t<scalar_type>(inters);
+        inter = int_type(inters);
         return pack(sampled);
     }
 
+
+    // pdf ----------------------------------------------------
+
+    template <typename SR, typename Interaction, unsigned I>
+    VSNRAY_FUNC
+    void pdf_impl(
+            SR const&                       sr,
+            Interaction const&              inter,
+            int_type const&                 types,
+            scalar_type&                    result,
+            visionaray::detail::type_index<I>
+            ) const
+    {
+        auto mask = types == int_type(I);
+
+        if (any(mask))
+        {
+            auto pd = pdf_type<material_at<I>>(sr, inter, std::integral_constant<bool, packable<I>::value>{});
+
+            if (all(mask))
+            {
+                result = pd;
+                return;
+            }
+
+            result = select(mask, pd, result);
+        }
+
+        pdf_impl(sr, inter, types, result, visionaray::detail::type_index<I + 1>{});
+    }
+
     template <typename SR, typename Interaction>
     VSNRAY_FUNC
-    scalar_type pdf(SR const& sr, Interaction const& inter) const
+    void pdf_impl(SR const&, Interaction const&, int_type const&, scalar_type&, last_type) const
+    {
+    }
+
+    template <typename M, typename SR, typename Interaction>
+    VSNRAY_FUNC
+    scalar_type pdf_type(SR const& sr, Interaction const& inter, std::true_type /* packable */) const
+    {
+        return pack_type<M>().pdf(sr, inter);
+    }
+
+    template <typename M, typename SR, typename Interaction>
+    VSNRAY_FUNC
+    scalar_type pdf_type(SR const& sr, Interaction const& inter, std::false_type /* packable */) const
     {
         using float_array = aligned_array_t<scalar_type>;
-        using int_array = aligned_array_t<int_type_t<scalar_type>>;
+        using int_array = aligned_array_t<int_type>;
 
         auto srs = unpack(sr);
         int_array inters;
@@ -264,16 +630,13 @@ public:
 
         for (size_t i = 0; i < N; ++i)
         {
-            pdfs[i] = mats_[i].pdf(srs[i], inters[i]);
+            auto ptr = mats_[i].template as<M>();
+            pdfs[i] = ptr ? ptr->pdf(srs[i], inters[i]) : 0.0f;
         }
 
         return scalar_type(pdfs);
     }
 
-private:
-
-    array<single_material, N> mats_;
-
 };
 
 
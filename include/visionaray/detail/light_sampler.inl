@@ -0,0 +1,872 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "../math/constants.h"
+#include "color_conversion.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Normal bounds of light geometry, emits in all directions by default
+//
+
+template <typename Geometry>
+inline void get_normal_bounds(Geometry const& geometry, vec3& axis, float& theta_o)
+{
+    VSNRAY_UNUSED(geometry);
+
+    axis = vec3(0.0f, 0.0f, 1.0f);
+    theta_o = constants::pi_over_two<float>();
+}
+
+template <typename T, typename P>
+inline void get_normal_bounds(basic_triangle<3, T, P> const& triangle, vec3& axis, float& theta_o)
+{
+    vec3 n(cross(vec3(triangle.e1), vec3(triangle.e2)));
+
+    if (length(n) > 0.0f)
+    {
+        axis = normalize(n);
+        theta_o = 0.0f;
+    }
+    else
+    {
+        axis = vec3(0.0f, 0.0f, 1.0f);
+        theta_o = constants::pi_over_two<float>();
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Bounding cone of two (double-sided) orientation cones
+//
+
+inline void merge_cones(
+        vec3 const& axis_a,
+        float       theta_a,
+        vec3        axis_b,
+        float       theta_b,
+        vec3&       axis,
+        float&      theta_o
+        )
+{
+    float half_pi = constants::pi_over_two<float>();
+
+    if (theta_a >= half_pi || theta_b >= half_pi)
+    {
+        axis = axis_a;
+        theta_o = half_pi;
+        return;
+    }
+
+    // Cones are double-sided
+    if (dot(axis_a, axis_b) < 0.0f)
+    {
+        axis_b = -axis_b;
+    }
+
+    float cos_d = clamp(dot(axis_a, axis_b), -1.0f, 1.0f);
+    float theta_d = acos(cos_d);
+
+    if (theta_a >= theta_d + theta_b)
+    {
+        axis = axis_a;
+        theta_o = theta_a;
+        return;
+    }
+
+    if (theta_b >= theta_d + theta_a)
+    {
+        axis = axis_b;
+        theta_o = theta_b;
+        return;
+    }
+
+    theta_o = (theta_a + theta_d + theta_b) * 0.5f;
+
+    vec3 perp = axis_b - axis_a * cos_d;
+
+    if (theta_o >= half_pi || length(perp) <= 0.0f)
+    {
+        axis = axis_a;
+        theta_o = min(theta_o, half_pi);
+        return;
+    }
+
+    // Rotate axis_a towards axis_b
+    float theta_r = theta_o - theta_a;
+    axis = normalize(axis_a * cos(theta_r) + normalize(perp) * sin(theta_r));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Conservative estimate of the contribution of lights within the bounds to a shading point:
+// power / distance^2, times bounds for the cosines at the light and at the shading point.
+// The normal may be 0 for shading points w/o orientation (e.g. in volumes)
+//
+
+VSNRAY_FUNC
+inline float light_importance(
+        aabb const&     bbox,
+        vec3 const&     axis,
+        float           theta_o,
+        float           power,
+        vec3 const&     pos,
+        vec3 const&     normal
+        )
+{
+    if (power <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    vec3 d = bbox.center() - pos;
+    float dist2 = dot(d, d);
+    float r2 = dot(bbox.size(), bbox.size()) * 0.25f;
+
+    // Inside the bounding sphere, all directions are possible
+    if (dist2 <= r2)
+    {
+        return power / max(r2, 1e-12f);
+    }
+
+    float half_pi = constants::pi_over_two<float>();
+
+    vec3 w = d / sqrt(dist2);
+    float theta_u = asin(min(sqrt(r2 / dist2), 1.0f));
+
+    // Emission, double-sided
+    float theta = acos(min(abs(dot(axis, w)), 1.0f));
+    float theta_l = max(theta - theta_o - theta_u, 0.0f);
+
+    float cos_light = theta_l < half_pi ? cos(theta_l) : 0.0f;
+
+    // Incidence at the shading point
+    float cos_recv = 1.0f;
+
+    if (dot(normal, normal) > 0.0f)
+    {
+        float theta_i = acos(clamp(dot(normal, w), -1.0f, 1.0f));
+        theta_i = max(theta_i - theta_u, 0.0f);
+
+        cos_recv = theta_i < half_pi ? cos(theta_i) : 0.0f;
+    }
+
+    return power * cos_light * cos_recv / dist2;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Light index per primitive id
+//
+
+inline aligned_vector<int> make_prim_lights(std::vector<light_bounds> const& bounds)
+{
+    int num_prims = 0;
+
+    for (auto const& b : bounds)
+    {
+        num_prims = std::max(num_prims, b.prim_id + 1);
+    }
+
+    aligned_vector<int> result(num_prims, -1);
+
+    for (size_t i = 0; i < bounds.size(); ++i)
+    {
+        if (bounds[i].prim_id >= 0)
+        {
+            result[bounds[i].prim_id] = static_cast<int>(i);
+        }
+    }
+
+    return result;
+}
+
+template <typename Lights>
+inline std::vector<light_bounds> get_all_light_bounds(Lights begin, Lights end)
+{
+    std::vector<light_bounds> result;
+
+    for (auto it = begin; it != end; ++it)
+    {
+        result.push_back(get_light_bounds(*it));
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Visitor for generic lights
+//
+
+struct get_light_bounds_visitor
+{
+    using return_type = light_bounds;
+
+    template <typename X>
+    return_type operator()(X const& ref) const
+    {
+        return get_light_bounds(ref);
+    }
+};
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Light bounds
+//
+
+template <typename T, typename Geometry>
+inline light_bounds get_light_bounds(area_light<T, Geometry> const& light)
+{
+    auto const& geometry = light.geometry();
+
+    light_bounds result;
+
+    result.bbox = aabb(get_bounds(geometry));
+    detail::get_normal_bounds(geometry, result.axis, result.theta_o);
+    result.power = rgb_to_luminance(vec3(light.intensity(light.position()))) * area(geometry);
+    result.prim_id = static_cast<int>(geometry.prim_id);
+    result.infinite = false;
+
+    return result;
+}
+
+template <typename T>
+inline light_bounds get_light_bounds(point_light<T> const& light)
+{
+    vec3 pos(light.position());
+
+    light_bounds result;
+
+    result.bbox = aabb(pos, pos);
+    result.axis = vec3(0.0f, 0.0f, 1.0f);
+    result.theta_o = constants::pi_over_two<float>();
+    // Attenuated intensity at unit distance
+    result.power = rgb_to_luminance(vec3(light.intensity(light.position() + vector<3, T>(1, 0, 0))));
+    result.prim_id = -1;
+    result.infinite = false;
+
+    return result;
+}
+
+template <typename T>
+inline light_bounds get_light_bounds(spot_light<T> const& light)
+{
+    vec3 pos(light.position());
+
+    light_bounds result;
+
+    result.bbox = aabb(pos, pos);
+    result.axis = vec3(0.0f, 0.0f, 1.0f);
+    result.theta_o = constants::pi_over_two<float>();
+    // Intensity at unit distance along the spot direction
+    result.power = rgb_to_luminance(vec3(light.intensity(light.position() + light.spot_direction())));
+    result.prim_id = -1;
+    result.infinite = false;
+
+    return result;
+}
+
+template <typename T, typename Texture>
+inline light_bounds get_light_bounds(environment_light<T, Texture> const& light)
+{
+    VSNRAY_UNUSED(light);
+
+    light_bounds result;
+
+    result.bbox.invalidate();
+    result.axis = vec3(0.0f, 0.0f, 1.0f);
+    result.theta_o = constants::pi_over_two<float>();
+    // Not comparable to the power of other lights, samplers handle infinite lights separately
+    result.power = 1.0f;
+    result.prim_id = -1;
+    result.infinite = true;
+
+    return result;
+}
+
+template <typename ...Ts>
+inline light_bounds get_light_bounds(generic_light<Ts...> const& light)
+{
+    return apply_visitor(detail::get_light_bounds_visitor(), light);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// uniform_light_sampler
+//
+
+template <typename Lights>
+VSNRAY_FUNC
+inline int uniform_light_sampler::sample(
+        Lights          begin,
+        Lights          end,
+        vec3 const&     pos,
+        vec3 const&     normal,
+        float           u,
+        float&          pdf
+        ) const
+{
+    VSNRAY_UNUSED(pos, normal);
+
+    int num_lights = static_cast<int>(end - begin);
+
+    pdf = 1.0f / num_lights;
+
+    return min(static_cast<int>(u * num_lights), num_lights - 1);
+}
+
+template <typename Lights>
+VSNRAY_FUNC
+inline float uniform_light_sampler::pdf(
+        Lights          begin,
+        Lights          end,
+        int             prim_id,
+        vec3 const&     pos,
+        vec3 const&     normal
+        ) const
+{
+    VSNRAY_UNUSED(prim_id, pos, normal);
+
+    return 1.0f / static_cast<float>(end - begin);
+}
+
+template <typename Lights>
+VSNRAY_FUNC
+inline float uniform_light_sampler::light_pdf(
+        Lights          begin,
+        Lights          end,
+        int             light_index,
+        vec3 const&     pos,
+        vec3 const&     normal
+        ) const
+{
+    VSNRAY_UNUSED(light_index, pos, normal);
+
+    return 1.0f / static_cast<float>(end - begin);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// power_light_sampler_ref
+//
+
+VSNRAY_FUNC
+inline power_light_sampler_ref::power_light_sampler_ref(
+        alias_table_entry const*    table,
+        int                         num_lights,
+        int const*                  prim_lights,
+        int                         num_prims
+        )
+    : table_(table)
+    , num_lights_(num_lights)
+    , prim_lights_(prim_lights)
+    , num_prims_(num_prims)
+{
+}
+
+template <typename Lights>
+VSNRAY_FUNC
+inline int power_light_sampler_ref::sample(
+        Lights          begin,
+        Lights          end,
+        vec3 const&     pos,
+        vec3 const&     normal,
+        float           u,
+        float&          pdf
+        ) const
+{
+    VSNRAY_UNUSED(begin, end, pos, normal);
+
+    float x = u * num_lights_;
+    int bin = min(static_cast<int>(x), num_lights_ - 1);
+
+    int light_index = x - bin < table_[bin].prob ? bin : table_[bin].alias;
+
+    pdf = table_[light_index].pdf;
+
+    return light_index;
+}
+
+template <typename Lights>
+VSNRAY_FUNC
+inline float power_light_sampler_ref::pdf(
+        Lights          begin,
+        Lights          end,
+        int             prim_id,
+        vec3 const&     pos,
+        vec3 const&     normal
+        ) const
+{
+    VSNRAY_UNUSED(begin, end, pos, normal);
+
+    if (prim_id < 0 || prim_id >= num_prims_ || prim_lights_[prim_id] < 0)
+    {
+        return 0.0f;
+    }
+
+    return table_[prim_lights_[prim_id]].pdf;
+}
+
+template <typename Lights>
+VSNRAY_FUNC
+inline float power_light_sampler_ref::light_pdf(
+        Lights          begin,
+        Lights          end,
+        int             light_index,
+        vec3 const&     pos,
+        vec3 const&     normal
+        ) const
+{
+    VSNRAY_UNUSED(begin, end, pos, normal);
+
+    if (light_index < 0 || light_index >= num_lights_)
+    {
+        return 0.0f;
+    }
+
+    return table_[light_index].pdf;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// power_light_sampler
+//
+
+template <typename Lights>
+inline power_light_sampler::power_light_sampler(Lights begin, Lights end)
+{
+    build(begin, end);
+}
+
+template <typename Lights>
+inline void power_light_sampler::build(Lights begin, Lights end)
+{
+    auto bounds = detail::get_all_light_bounds(begin, end);
+
+    int num_lights = static_cast<int>(bounds.size());
+
+    table_.resize(num_lights);
+    prim_lights_ = detail::make_prim_lights(bounds);
+
+    double total = 0.0;
+    int num_finite = 0;
+    int num_infinite = 0;
+
+    for (auto const& b : bounds)
+    {
+        if (b.infinite)
+        {
+            ++num_infinite;
+        }
+        else
+        {
+            total += max(b.power, 0.0f);
+            ++num_finite;
+        }
+    }
+
+    // Infinite lights are picked with a fixed probability
+    double infinite_prob = num_infinite > 0
+            ? static_cast<double>(num_infinite) / (num_infinite + (num_finite > 0 ? 1 : 0))
+            : 0.0;
+
+    // Vose's alias method
+    std::vector<double> scaled(num_lights);
+    std::vector<int> small;
+    std::vector<int> large;
+
+    for (int i = 0; i < num_lights; ++i)
+    {
+        double w = 0.0;
+
+        if (bounds[i].infinite)
+        {
+            w = infinite_prob / num_infinite;
+        }
+        else
+        {
+            w = total > 0.0 ? max(bounds[i].power, 0.0f) / total : 1.0 / num_finite;
+            w *= 1.0 - infinite_prob;
+        }
+
+        table_[i].pdf = static_cast<float>(w);
+        table_[i].alias = i;
+
+        scaled[i] = w * num_lights;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        int s = small.back();
+        int l = large.back();
+        small.pop_back();
+
+        table_[s].prob = static_cast<float>(scaled[s]);
+        table_[s].alias = l;
+
+        scaled[l] -= 1.0 - scaled[s];
+
+        if (scaled[l] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Remaining bins are (up to round-off) full
+    for (int i : small)
+    {
+        table_[i].prob = 1.0f;
+    }
+
+    for (int i : large)
+    {
+        table_[i].prob = 1.0f;
+    }
+}
+
+inline power_light_sampler::ref_type power_light_sampler::ref() const
+{
+    return ref_type(
+            table_.data(),
+            static_cast<int>(table_.size()),
+            prim_lights_.data(),
+            static_cast<int>(prim_lights_.size())
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// light_bvh_ref
+//
+
+VSNRAY_FUNC
+inline light_bvh_ref::light_bvh_ref(
+        light_bvh_node const*   nodes,
+        int                     num_nodes,
+        int const*              light_leaves,
+        int const*              prim_lights,
+        int                     num_prims,
+        int const*              infinite_lights,
+        int                     num_infinite
+        )
+    : nodes_(nodes)
+    , num_nodes_(num_nodes)
+    , light_leaves_(light_leaves)
+    , prim_lights_(prim_lights)
+    , num_prims_(num_prims)
+    , infinite_lights_(infinite_lights)
+    , num_infinite_(num_infinite)
+{
+}
+
+VSNRAY_FUNC
+inline float light_bvh_ref::infinite_prob() const
+{
+    if (num_infinite_ == 0)
+    {
+        return 0.0f;
+    }
+
+    return static_cast<float>(num_infinite_) / (num_infinite_ + (num_nodes_ > 0 ? 1 : 0));
+}
+
+VSNRAY_FUNC
+inline float light_bvh_ref::first_child_prob(
+        light_bvh_node const&   node,
+        vec3 const&             pos,
+        vec3 const&             normal
+        ) const
+{
+    auto const& l = nodes_[node.index];
+    auto const& r = nodes_[node.index + 1];
+
+    float il = detail::light_importance(l.bbox, l.axis, l.theta_o, l.power, pos, normal);
+    float ir = detail::light_importance(r.bbox, r.axis, r.theta_o, r.power, pos, normal);
+
+    // Neither child contributes, pick any
+    if (il + ir <= 0.0f)
+    {
+        return 0.5f;
+    }
+
+    return il / (il + ir);
+}
+
+template <typename Lights>
+VSNRAY_FUNC
+inline int light_bvh_ref::sample(
+        Lights          begin,
+        Lights          end,
+        vec3 const&     pos,
+        vec3 const&     normal,
+        float           u,
+        float&          pdf
+        ) const
+{
+    VSNRAY_UNUSED(begin, end);
+
+    float p_inf = infinite_prob();
+
+    if (u < p_inf)
+    {
+        int k = min(static_cast<int>(u / p_inf * num_infinite_), num_infinite_ - 1);
+        pdf = p_inf / num_infinite_;
+        return infinite_lights_[k];
+    }
+
+    u = min((u - p_inf) / (1.0f - p_inf), 0.99999994f);
+    pdf = 1.0f - p_inf;
+
+    int i = 0;
+
+    while (!nodes_[i].is_leaf)
+    {
+        float p = first_child_prob(nodes_[i], pos, normal);
+
+        // Reuse u for the next level
+        if (u < p)
+        {
+            u /= p;
+            pdf *= p;
+            i = nodes_[i].index;
+        }
+        else
+        {
+            u = (u - p) / (1.0f - p);
+            pdf *= 1.0f - p;
+            i = nodes_[i].index + 1;
+        }
+
+        u = min(u, 0.99999994f);
+    }
+
+    return nodes_[i].index;
+}
+
+template <typename Lights>
+VSNRAY_FUNC
+inline float light_bvh_ref::pdf(
+        Lights          begin,
+        Lights          end,
+        int             prim_id,
+        vec3 const&     pos,
+        vec3 const&     normal
+        ) const
+{
+    VSNRAY_UNUSED(begin, end);
+
+    if (prim_id < 0 || prim_id >= num_prims_ || prim_lights_[prim_id] < 0)
+    {
+        return 0.0f;
+    }
+
+    return light_pdf(prim_lights_[prim_id], pos, normal);
+}
+
+template <typename Lights>
+VSNRAY_FUNC
+inline float light_bvh_ref::light_pdf(
+        Lights          begin,
+        Lights          end,
+        int             light_index,
+        vec3 const&     pos,
+        vec3 const&     normal
+        ) const
+{
+    if (light_index < 0 || light_index >= static_cast<int>(end - begin))
+    {
+        return 0.0f;
+    }
+
+    return light_pdf(light_index, pos, normal);
+}
+
+VSNRAY_FUNC
+inline float light_bvh_ref::light_pdf(int light_index, vec3 const& pos, vec3 const& normal) const
+{
+    float p_inf = infinite_prob();
+
+    int i = light_leaves_[light_index];
+
+    if (i < 0)
+    {
+        return p_inf / num_infinite_;
+    }
+
+    float pdf = 1.0f - p_inf;
+
+    while (nodes_[i].parent >= 0)
+    {
+        auto const& parent = nodes_[nodes_[i].parent];
+
+        float p = first_child_prob(parent, pos, normal);
+        pdf *= i == parent.index ? p : 1.0f - p;
+
+        i = nodes_[i].parent;
+    }
+
+    return pdf;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// light_bvh
+//
+
+namespace detail
+{
+
+inline void build_light_bvh_node(
+        aligned_vector<light_bvh_node>&     nodes,
+        aligned_vector<int>&                light_leaves,
+        std::vector<light_bounds> const&    bounds,
+        int                                 node_index,
+        int                                 parent,
+        int*                                first,
+        int*                                last
+        )
+{
+    if (last - first == 1)
+    {
+        auto const& b = bounds[*first];
+
+        light_bvh_node& node = nodes[node_index];
+        node.bbox = b.bbox;
+        node.axis = b.axis;
+        node.theta_o = b.theta_o;
+        node.power = max(b.power, 0.0f);
+        node.index = *first;
+        node.parent = parent;
+        node.is_leaf = 1;
+
+        light_leaves[*first] = node_index;
+        return;
+    }
+
+    // Split at the median of the axis with the largest extent
+    aabb centers;
+    centers.invalidate();
+
+    for (int* it = first; it != last; ++it)
+    {
+        centers.insert(bounds[*it].bbox.center());
+    }
+
+    vec3 size = centers.size();
+    int axis = size.x >= size.y && size.x >= size.z ? 0 : size.y >= size.z ? 1 : 2;
+
+    int* mid = first + (last - first) / 2;
+
+    std::nth_element(first, mid, last, [&](int a, int b)
+    {
+        return bounds[a].bbox.center()[axis] < bounds[b].bbox.center()[axis];
+    });
+
+    // Children are adjacent
+    int child = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    nodes.emplace_back();
+
+    build_light_bvh_node(nodes, light_leaves, bounds, child, node_index, first, mid);
+    build_light_bvh_node(nodes, light_leaves, bounds, child + 1, node_index, mid, last);
+
+    auto const& l = nodes[child];
+    auto const& r = nodes[child + 1];
+
+    light_bvh_node& node = nodes[node_index];
+    node.bbox = combine(l.bbox, r.bbox);
+    merge_cones(l.axis, l.theta_o, r.axis, r.theta_o, node.axis, node.theta_o);
+    node.power = l.power + r.power;
+    node.index = child;
+    node.parent = parent;
+    node.is_leaf = 0;
+}
+
+} // detail
+
+template <typename Lights>
+inline light_bvh::light_bvh(Lights begin, Lights end)
+{
+    build(begin, end);
+}
+
+template <typename Lights>
+inline void light_bvh::build(Lights begin, Lights end)
+{
+    auto bounds = detail::get_all_light_bounds(begin, end);
+
+    int num_lights = static_cast<int>(bounds.size());
+
+    nodes_.clear();
+    light_leaves_.assign(num_lights, -1);
+    prim_lights_ = detail::make_prim_lights(bounds);
+    infinite_lights_.clear();
+
+    std::vector<int> indices;
+
+    for (int i = 0; i < num_lights; ++i)
+    {
+        if (bounds[i].infinite)
+        {
+            infinite_lights_.push_back(i);
+        }
+        else
+        {
+            indices.push_back(i);
+        }
+    }
+
+    if (indices.empty())
+    {
+        return;
+    }
+
+    int num_finite = static_cast<int>(indices.size());
+
+    nodes_.reserve(2 * num_finite - 1);
+    nodes_.emplace_back();
+
+    detail::build_light_bvh_node(
+            nodes_,
+            light_leaves_,
+            bounds,
+            0,
+            -1,
+            indices.data(),
+            indices.data() + num_finite
+            );
+}
+
+inline light_bvh::ref_type light_bvh::ref() const
+{
+    return ref_type(
+            nodes_.data(),
+            static_cast<int>(nodes_.size()),
+            light_leaves_.data(),
+            prim_lights_.data(),
+            static_cast<int>(prim_lights_.size()),
+            infinite_lights_.data(),
+            static_cast<int>(infinite_lights_.size())
+            );
+}
+
+inline aligned_vector<light_bvh_node> const& light_bvh::nodes() const
+{
+    return nodes_;
+}
+
+} // visionaray
@@ -5,6 +5,29 @@
 
 namespace visionaray
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Continue with the state of a where m is set, with that of b otherwise
+//
+
+template <typename Generator>
+VSNRAY_FUNC
+inline Generator select_generator(bool m, Generator const& a, Generator const& b)
+{
+    return m ? a : b;
+}
+
+template <typename M, typename Generator>
+VSNRAY_FUNC
+inline Generator select_generator(M const& m, Generator const& a, Generator const& b)
+{
+    return select(m, a, b);
+}
+
+} // detail
+
 
 //-------------------------------------------------------------------------------------------------
 // Public interface
@@ -79,9 +102,13 @@ inline spectrum<U> plastic<T>::sample(
     n = faceforward( n, shade_rec.view_dir, shade_rec.geometric_normal );
 #endif
 
+    // Lanes only draw the numbers of the BRDF they chose, the diffuse BRDF samples
+    // with a copy of the generator that is merged back for the diffuse lanes
+    Generator diff_gen(gen);
+
     if (any(u < U(prob_diff)))
     {
-        diff       = from_rgb(shade_rec.tex_color) * diffuse_brdf_.sample_f(n, shade_rec.view_dir, refl1, pdf1, inter1, gen);
+        diff       = from_rgb(shade_rec.tex_color) * diffuse_brdf_.sample_f(n, shade_rec.view_dir, refl1, pdf1, inter1, diff_gen);
     }
 
     if (any(u >= U(prob_diff)))
@@ -89,6 +116,8 @@ inline spectrum<U> plastic<T>::sample(
         spec       = specular_brdf_.sample_f(n, shade_rec.view_dir, refl2, pdf2, inter2, gen);
     }
 
+    gen = detail::select_generator(u < U(prob_diff), diff_gen, gen);
+
     pdf            = select( u < U(prob_diff), pdf1,   pdf2   );
     refl_dir       = select( u < U(prob_diff), refl1,  refl2  );
     inter          = select( u < U(prob_diff), inter1, inter2 );
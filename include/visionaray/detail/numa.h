@@ -0,0 +1,270 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_NUMA_H
+#define VSNRAY_DETAIL_NUMA_H 1
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "platform.h"
+
+#if VSNRAY_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Thread placement for thread pools and schedulers
+//
+// FloatingThreads:     threads are scheduled by the OS
+// PinnedPerNumaNode:   threads are distributed evenly over the NUMA nodes and pinned to
+//                      the CPUs of their node
+//
+
+enum thread_affinity
+{
+    FloatingThreads,
+    PinnedPerNumaNode
+};
+
+
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Parse Linux cpu lists like "0-15,32-47"
+//
+
+inline std::vector<unsigned> parse_cpu_list(std::string const& str)
+{
+    std::vector<unsigned> result;
+
+    size_t pos = 0;
+
+    while (pos < str.size())
+    {
+        size_t end = str.find(',', pos);
+        end = end == std::string::npos ? str.size() : end;
+
+        std::string range = str.substr(pos, end - pos);
+        size_t dash = range.find('-');
+
+        try
+        {
+            unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+            unsigned last = dash == std::string::npos
+                          ? first
+                          : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+
+            for (unsigned i = first; i <= last; ++i)
+            {
+                result.push_back(i);
+            }
+        }
+        catch (...)
+        {
+        }
+
+        pos = end + 1;
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// CPUs of each NUMA node, a single node with all CPUs if the topology is unknown
+//
+
+inline std::vector<std::vector<unsigned>> query_numa_node_cpus()
+{
+    std::vector<std::vector<unsigned>> result;
+
+#if VSNRAY_OS_LINUX
+    std::string online;
+    std::ifstream online_file("/sys/devices/system/node/online");
+
+    if (std::getline(online_file, online))
+    {
+        for (unsigned node : parse_cpu_list(online))
+        {
+            std::string cpulist;
+            std::ifstream cpulist_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+
+            if (std::getline(cpulist_file, cpulist))
+            {
+                auto cpus = parse_cpu_list(cpulist);
+
+                // Skip memory-only nodes
+                if (!cpus.empty())
+                {
+                    result.push_back(cpus);
+                }
+            }
+        }
+    }
+#endif
+
+    if (result.empty())
+    {
+        result.resize(1);
+
+        for (unsigned i = 0; i < std::thread::hardware_concurrency(); ++i)
+        {
+            result[0].push_back(i);
+        }
+    }
+
+    return result;
+}
+
+inline std::vector<std::vector<unsigned>> const& numa_node_cpus()
+{
+    static const std::vector<std::vector<unsigned>> node_cpus = query_numa_node_cpus();
+    return node_cpus;
+}
+
+inline unsigned numa_num_nodes()
+{
+    return static_cast<unsigned>(numa_node_cpus().size());
+}
+
+// NUMA node that the calling thread was pinned to, 0 for threads that were not pinned
+inline unsigned& this_thread_numa_node()
+{
+    static thread_local unsigned node = 0;
+    return node;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Pin the calling thread to the CPUs of a NUMA node
+//
+
+inline bool pin_this_thread_to_numa_node(unsigned node)
+{
+    auto const& node_cpus = numa_node_cpus();
+
+    if (node >= node_cpus.size())
+    {
+        return false;
+    }
+
+    this_thread_numa_node() = node;
+
+#if VSNRAY_OS_LINUX
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    for (unsigned cpu : node_cpus[node])
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Call func(node) from a thread pinned to each NUMA node, e.g. to first-touch memory so
+// that the OS places its pages on that node. Calls func(0) directly on single-node systems
+//
+
+template <typename Func>
+void for_each_numa_node(Func func)
+{
+    unsigned num_nodes = numa_num_nodes();
+
+    if (num_nodes <= 1)
+    {
+        func(0U);
+        return;
+    }
+
+    std::vector<std::thread> threads(num_nodes);
+
+    for (unsigned node = 0; node < num_nodes; ++node)
+    {
+        threads[node] = std::thread([&func, node]()
+        {
+            pin_this_thread_to_numa_node(node);
+            func(node);
+        });
+    }
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// One copy of a read-only object (e.g. a BVH or a primitive array) per NUMA node
+//
+// Each copy is constructed by a thread on its node, so that its memory is local to that
+// node. Threads of a pool with PinnedPerNumaNode affinity access their node's copy with
+// local(), e.g. to create the BVH refs of a kernel:
+//
+//  numa_replicated<index_bvh<basic_triangle<3, float>>> bvhs(bvh);
+//  ...
+//  auto& b = bvhs.local();
+//
+
+template <typename T>
+class numa_replicated
+{
+public:
+
+    explicit numa_replicated(T const& value)
+        : replicas_(detail::numa_num_nodes())
+    {
+        detail::for_each_numa_node([&](unsigned node)
+        {
+            replicas_[node].reset(new T(value));
+        });
+    }
+
+    // Copy on the calling thread's NUMA node
+    T const& local() const
+    {
+        return *replicas_[detail::this_thread_numa_node() % replicas_.size()];
+    }
+
+    T const& operator[](size_t node) const
+    {
+        return *replicas_[node];
+    }
+
+    size_t size() const
+    {
+        return replicas_.size();
+    }
+
+private:
+
+    std::vector<std::unique_ptr<T>> replicas_;
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_NUMA_H
@@ -6,6 +6,9 @@
 #ifndef VSNRAY_DETAIL_PATHTRACING_INL
 #define VSNRAY_DETAIL_PATHTRACING_INL 1
 
+#include <cstddef>
+
+#include <visionaray/math/limits.h>
 #include <visionaray/get_area.h>
 #include <visionaray/get_surface.h>
 #include <visionaray/result_record.h>
@@ -16,6 +19,73 @@
 
 namespace visionaray
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Radiance of rays that leave the scene
+//
+
+// No environment light, constant ambient color
+template <typename Params, typename V, typename S, typename M>
+VSNRAY_FUNC
+inline spectrum<S> escaped_radiance(
+        Params const&   params,
+        std::nullptr_t  environment,
+        V const&        dir,
+        V const&        last_pos,
+        V const&        last_normal,
+        S const&        last_brdf_pdf,
+        M const&        use_mis
+        )
+{
+    VSNRAY_UNUSED(environment, dir, last_pos, last_normal, last_brdf_pdf, use_mis);
+
+    return spectrum<S>(from_rgba(params.ambient_color));
+}
+
+// Environment light, weighted against next event estimation at the last bounce
+template <typename Params, typename Environment, typename V, typename S, typename M>
+VSNRAY_FUNC
+inline spectrum<S> escaped_radiance(
+        Params const&       params,
+        Environment const&  environment,
+        V const&            dir,
+        V const&            last_pos,
+        V const&            last_normal,
+        S const&            last_brdf_pdf,
+        M const&            use_mis
+        )
+{
+    auto radiance = from_rgb(environment.radiance(dir));
+
+    if (params.environment.index < 0)
+    {
+        return radiance;
+    }
+
+    auto select_pdf = light_index_pdf(
+            params.light_sampler,
+            params.lights.begin,
+            params.lights.end,
+            params.environment.index,
+            last_pos,
+            last_normal
+            );
+
+    S light_pdf = environment.pdf(dir) * select_pdf;
+
+    S mis_weight = select(
+            use_mis,
+            power_heuristic(last_brdf_pdf, light_pdf),
+            S(1.0)
+            );
+
+    return radiance * mis_weight;
+}
+
+} // detail
+
 namespace pathtracing
 {
 
@@ -43,6 +113,12 @@ struct kernel
         C intensity(0.0);
         C throughput(1.0);
 
+        // Shading point, normal and BRDF pdf of the last bounce, to weight hits of
+        // emissive surfaces against next event estimation at the last bounce
+        V last_pos(0.0);
+        V last_normal(0.0);
+        S last_brdf_pdf(0.0);
+
         result_record<S> result;
         result.color = params.bg_color;
 
@@ -52,11 +128,25 @@ struct kernel
 
             // Handle rays that just exited
             auto exited = active_rays & !hit_rec.hit;
-            intensity += select(
-                exited,
-                C(from_rgba(params.ambient_color)) * throughput,
-                C(0.0)
-                );
+
+            if (any(exited))
+            {
+                auto env = detail::escaped_radiance(
+                        params,
+                        params.environment.light,
+                        ray.dir,
+                        last_pos,
+                        last_normal,
+                        last_brdf_pdf,
+                        bounce > 0 && !last_specular
+                        );
+
+                intensity += select(
+                    exited,
+                    env * throughput,
+                    C(0.0)
+                    );
+            }
 
 
             // Exit if no ray is active anymore
@@ -106,16 +196,27 @@ struct kernel
                 auto ldotln = abs(dot(-L, n));
                 auto solid_angle = (ldotln * A) / (ld * ld);
 
+                // Probability that next event estimation at the last bounce
+                // picked the light that was hit
+                auto select_pdf = light_selection_pdf(
+                        params.light_sampler,
+                        params.lights.begin,
+                        params.lights.end,
+                        hit_rec.prim_id,
+                        last_pos,
+                        last_normal
+                        );
+
                 light_pdf = select(
                     inter == surface_interaction::Emission,
-                    S(1.0) / solid_angle,
+                    select_pdf / solid_angle,
                     S(0.0)
                     );
             }
 
             S mis_weight = select(
                 bounce > 0 && num_lights > 0 && !last_specular,
-                power_heuristic(brdf_pdf, light_pdf / static_cast<float>(num_lights)),
+                power_heuristic(last_brdf_pdf, light_pdf),
                 S(1.0)
                 );
 
@@ -135,10 +236,28 @@ struct kernel
 
             if (num_lights > 0)
             {
-                auto ls = sample_random_light(params.lights.begin, params.lights.end, gen);
-
-                auto ld = length(ls.pos - hit_rec.isect_pos);
-                auto L = normalize(ls.pos - hit_rec.isect_pos);
+                S select_pdf(0.0);
+                auto ls = sample_light(
+                        params.light_sampler,
+                        params.lights.begin,
+                        params.lights.end,
+                        hit_rec.isect_pos,
+                        n,
+                        select_pdf,
+                        gen
+                        );
+
+                // Samples from lights at infinity store the direction towards the light
+                auto ld = select(
+                    ls.infinite_light,
+                    S(numeric_limits<float>::max()),
+                    length(ls.pos - hit_rec.isect_pos)
+                    );
+                auto L = select(
+                    ls.infinite_light,
+                    ls.pos,
+                    normalize(ls.pos - hit_rec.isect_pos)
+                    );
 
                 auto ln = select(ls.delta_light, -L, ls.normal);
 #if 1
@@ -161,18 +280,23 @@ struct kernel
                 // TODO: inv_pi / dot(n, wi) factor only valid for plastic and matte
                 auto src = surf.shade(view_dir, L, ls.intensity) * constants::inv_pi<S>() / ldotn;
                 auto solid_angle = (ldotln * ls.area);
-                solid_angle = select(!ls.delta_light, solid_angle / (ld * ld), solid_angle);
+                solid_angle = select(!ls.delta_light && !ls.infinite_light, solid_angle / (ld * ld), solid_angle);
                 auto light_pdf = S(1.0) / solid_angle;
 
-                S mis_weight = power_heuristic(light_pdf / static_cast<float>(num_lights), brdf_pdf);
+                S mis_weight = power_heuristic(light_pdf * select_pdf, brdf_pdf);
 
                 intensity += select(
-                    active_rays && !lhr.hit && ldotn > S(0.0) && ldotln > S(0.0),
-                    mis_weight * throughput * src * (ldotn / light_pdf) * S(static_cast<float>(num_lights)),
+                    active_rays && !lhr.hit && ldotn > S(0.0) && ldotln > S(0.0) && solid_angle > S(0.0) && select_pdf > S(0.0),
+                    mis_weight * throughput * src * (ldotn / light_pdf) / select_pdf,
                     C(0.0)
                     );
             }
 
+            // Weighted like the BRDF pdf of next event estimation
+            last_pos = hit_rec.isect_pos;
+            last_normal = n;
+            last_brdf_pdf = brdf_pdf * max_element(throughput.samples());
+
             throughput *= src * (dot(n, refl_dir) / brdf_pdf);
             throughput = select(zero_pdf, C(0.0), throughput);
 
@@ -1304,6 +1304,110 @@ inline void blend(
         );
 }
 
+
+// Accumulate -------------------------------------------------------------
+
+
+//-------------------------------------------------------------------------------------------------
+// Add an rgba color to the running sum of a pixel and increment its sample count
+//
+
+template <typename T>
+VSNRAY_FUNC
+inline void accumulate(
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        vector<4, float> const&     color,
+        vector<4, T>*               sums,
+        unsigned*                   counts
+        )
+{
+    VSNRAY_UNUSED(height);
+
+    int idx = y * width + x;
+
+    sums[idx] += vector<4, T>(color);
+    counts[idx]++;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Add SIMD rgba colors to the running sums of the pixels of a packet, skip pixels outside
+// the image
+//
+
+template <
+    typename T,
+    typename FloatT,
+    typename = typename std::enable_if<simd::is_simd_vector<FloatT>::value>::type
+    >
+VSNRAY_FUNC
+inline void accumulate(
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        vector<4, FloatT> const&    color,
+        vector<4, T>*               sums,
+        unsigned*                   counts
+        )
+{
+    using float_array = simd::aligned_array_t<FloatT>;
+
+    float_array r;
+    float_array g;
+    float_array b;
+    float_array a;
+
+    store(r, color.x);
+    store(g, color.y);
+    store(b, color.z);
+    store(a, color.w);
+
+    const int w = packet_size<FloatT>::w;
+    const int h = packet_size<FloatT>::h;
+
+    for (int row = 0; row < h; ++row)
+    {
+        for (int col = 0; col < w; ++col)
+        {
+            if (x + col < width && y + row < height)
+            {
+                int idx = row * w + col;
+                accumulate(
+                    x + col,
+                    y + row,
+                    width,
+                    height,
+                    vec4(r[idx], g[idx], b[idx], a[idx]),
+                    sums,
+                    counts
+                    );
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// Accumulate color from result record
+//
+
+template <typename S, typename T>
+VSNRAY_FUNC
+inline void accumulate(
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        result_record<S> const&     rr,
+        vector<4, T>*               sums,
+        unsigned*                   counts
+        )
+{
+    accumulate(x, y, width, height, rr.color, sums, counts);
+}
+
 } // pixel_access
 
 } // detail
@@ -45,6 +45,7 @@ inline light_sample<U> point_light<T>::sample(Generator& gen) const
             ) );
     result.area = U(1.0);
     result.delta_light = true;
+    result.infinite_light = false;
 
     return result;
 }
@@ -6,12 +6,17 @@
 #ifndef VSNRAY_DETAIL_SCHED_COMMON_H
 #define VSNRAY_DETAIL_SCHED_COMMON_H 1
 
+#include <type_traits>
 #include <utility>
 
 #include <visionaray/math/array.h>
+#include <visionaray/adaptive_sampling.h>
+#include <visionaray/make_generator.h>
 #include <visionaray/packet_traits.h>
 #include <visionaray/pixel_format.h>
 #include <visionaray/pixel_sampler_types.h>
+#include <visionaray/quasi_random_generator.h>
+#include <visionaray/random_generator.h>
 #include <visionaray/render_target.h>
 #include <visionaray/result_record.h>
 
@@ -73,6 +78,151 @@ inline auto invoke_kernel(K kernel, R r, Generator& gen, int x, int y)
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Make random generator seed(s) for a pixel (packet)
+//
+// Seeds only depend on pixel position, frame number and the user seed, so that a frame
+// renders identically regardless of the order in which threads process the pixels
+//
+
+template <
+    typename T,
+    typename = typename std::enable_if<std::is_floating_point<T>::value>::type
+    >
+VSNRAY_FUNC
+inline unsigned make_pixel_seed(T /* */, int x, int y, int width, unsigned frame_num, unsigned seed)
+{
+    return make_seed(static_cast<unsigned>(y * width + x), frame_num, seed);
+}
+
+template <
+    typename T,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+VSNRAY_FUNC
+inline array<unsigned, simd::num_elements<T>::value> make_pixel_seed(
+        T           /* */,
+        int         x,
+        int         y,
+        int         width,
+        unsigned    frame_num,
+        unsigned    seed
+        )
+{
+    array<unsigned, simd::num_elements<T>::value> result;
+
+    // Same lane layout as expand_pixel
+    int w = packet_size<T>::w;
+
+    for (int i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        result[i] = make_pixel_seed(float{}, x + i % w, y + i / w, width, frame_num, seed);
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Make the number generator for a pixel (packet)
+//
+// Random generators are seeded from pixel position, frame number and user seed,
+// low-discrepancy generators use the frame number as sample index and the user seed
+// to rotate the sequence
+//
+
+template <typename T, typename PixelSampler>
+using pixel_generator_t = typename make_generator_impl<T, PixelSampler>::generator_type;
+
+template <typename T, typename PixelSampler>
+VSNRAY_FUNC
+inline auto make_pixel_generator(
+        T               /* */,
+        PixelSampler    sample_params,
+        int             x,
+        int             y,
+        int             width,
+        unsigned        frame_num,
+        unsigned        seed
+        )
+    -> typename std::enable_if<
+            !is_quasi_random_generator<pixel_generator_t<T, PixelSampler>>::value,
+            pixel_generator_t<T, PixelSampler>
+            >::type
+{
+    return make_generator(T{}, sample_params, make_pixel_seed(T{}, x, y, width, frame_num, seed));
+}
+
+template <typename T, typename PixelSampler>
+VSNRAY_FUNC
+inline auto make_pixel_generator(
+        T               /* */,
+        PixelSampler    sample_params,
+        int             x,
+        int             y,
+        int             width,
+        unsigned        frame_num,
+        unsigned        seed
+        )
+    -> typename std::enable_if<
+            is_quasi_random_generator<pixel_generator_t<T, PixelSampler>>::value,
+            pixel_generator_t<T, PixelSampler>
+            >::type
+{
+    VSNRAY_UNUSED(width);
+
+    return make_generator(T{}, sample_params, x, y, frame_num, seed);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Placement of a render target in the image
+//
+// Tile render targets (e.g. tile_buffer_rt) cover a sub-rectangle of the image and provide
+// offset() and image_size(). Schedulers generate primary rays and random numbers for image
+// coordinates, so that tiles render the same pixels as a full-frame render target, but
+// store the results at render target coordinates. Other render targets cover the whole image
+//
+
+template <typename RT>
+inline auto render_target_offset(RT const& rt, int)
+    -> decltype(rt.offset())
+{
+    return rt.offset();
+}
+
+template <typename RT>
+inline vec2i render_target_offset(RT const& /* */, long)
+{
+    return vec2i(0);
+}
+
+template <typename RT>
+inline auto render_target_image_size(RT const& rt, int)
+    -> decltype(rt.image_size())
+{
+    return rt.image_size();
+}
+
+template <typename RT>
+inline vec2i render_target_image_size(RT const& rt, long)
+{
+    return vec2i(rt.width(), rt.height());
+}
+
+template <typename RT>
+inline vec2i render_target_offset(RT const& rt)
+{
+    return render_target_offset(rt, 0);
+}
+
+template <typename RT>
+inline vec2i render_target_image_size(RT const& rt)
+{
+    return render_target_image_size(rt, 0);
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Invoke cam::primary_ray()
 //
@@ -621,6 +771,208 @@ inline void sample_pixel_impl(
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Adaptive pixel sampler, result is blended on top of color buffer with per-pixel weights,
+// packets whose pixels all converged are skipped
+//
+
+template <
+    typename K,
+    typename T,
+    typename R,
+    typename Generator,
+    pixel_format CF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                                           kernel,
+        pixel_sampler::basic_adaptive_blend_type<T> params,
+        R const&                                    r,
+        Generator&                                  gen,
+        render_target_ref<CF>                       rt_ref,
+        int                                         x,
+        int                                         y,
+        int                                         width,
+        int                                         height,
+        Camera const&                               cam
+        )
+{
+    VSNRAY_UNUSED(cam);
+
+    using S = typename R::scalar_type;
+
+    if (pixels_converged(S{}, params.stats, x, y, width, height, params.max_error))
+    {
+        return;
+    }
+
+    auto result = invoke_kernel(kernel, r, gen, x, y);
+
+    S weight = update_pixel_stats(
+            sample_luminance(result.color),
+            params.stats,
+            x,
+            y,
+            width,
+            height,
+            params.max_error,
+            params.min_samples
+            );
+
+    pixel_access::blend(
+            pixel_format_constant<CF>{},
+            pixel_format_constant<PF_RGBA32F>{},
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.color(),
+            weight,
+            S(1.0) - weight
+            );
+}
+
+template <
+    typename K,
+    typename T,
+    typename R,
+    typename Generator,
+    pixel_format CF,
+    pixel_format DF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                                           kernel,
+        pixel_sampler::basic_adaptive_blend_type<T> params,
+        R const&                                    r,
+        Generator&                                  gen,
+        render_target_ref<CF, DF>                   rt_ref,
+        int                                         x,
+        int                                         y,
+        int                                         width,
+        int                                         height,
+        Camera const&                               cam
+        )
+{
+    using S = typename R::scalar_type;
+
+    if (pixels_converged(S{}, params.stats, x, y, width, height, params.max_error))
+    {
+        return;
+    }
+
+    auto result = invoke_kernel(kernel, r, gen, x, y);
+
+    result.depth = select( result.hit, depth_transform(result.isect_pos, cam), S(1.0) );
+
+    S weight = update_pixel_stats(
+            sample_luminance(result.color),
+            params.stats,
+            x,
+            y,
+            width,
+            height,
+            params.max_error,
+            params.min_samples
+            );
+
+    pixel_access::blend(
+            pixel_format_constant<CF>{},
+            pixel_format_constant<PF_RGBA32F>{},
+            pixel_format_constant<DF>{},
+            pixel_format_constant<PF_DEPTH32F>{},
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.color(),
+            rt_ref.depth(),
+            weight,
+            S(1.0) - weight
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Uniform or jittered pixel sampler, result is added to the running sums of an accumulation
+// target. Blend factors of derived pixel sampler types are ignored
+//
+
+template <
+    typename K,
+    typename T,
+    typename R,
+    typename Generator,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                                   kernel,
+        pixel_sampler::uniform_type         /* */,
+        R const&                            r,
+        Generator&                          gen,
+        accumulation_target_ref<T>          rt_ref,
+        int                                 x,
+        int                                 y,
+        int                                 width,
+        int                                 height,
+        Camera const&                       cam
+        )
+{
+    VSNRAY_UNUSED(cam);
+
+    auto result = invoke_kernel(kernel, r, gen, x, y);
+    pixel_access::accumulate(
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.sums(),
+            rt_ref.counts()
+            );
+}
+
+template <
+    typename K,
+    typename T,
+    typename R,
+    typename Generator,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                                   kernel,
+        pixel_sampler::jittered_type        /* */,
+        R const&                            r,
+        Generator&                          gen,
+        accumulation_target_ref<T>          rt_ref,
+        int                                 x,
+        int                                 y,
+        int                                 width,
+        int                                 height,
+        Camera const&                       cam
+        )
+{
+    VSNRAY_UNUSED(cam);
+
+    auto result = invoke_kernel(kernel, r, gen, x, y);
+    pixel_access::accumulate(
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.sums(),
+            rt_ref.counts()
+            );
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // SSAA pixel sampler
 //
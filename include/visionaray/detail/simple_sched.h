@@ -17,6 +17,24 @@ public:
     template <typename K, typename SP>
     void frame(K kernel, SP sched_params);
 
+    // Seed for the number generators of the pixel samplers, combined with pixel position
+    // and sample index. Frames only depend on the seed and the sample index, and match
+    // the frames that the other CPU schedulers render with the same ray type
+    void set_seed(unsigned seed);
+
+    // Sample index of the next frame, incremented after each frame. E.g. to split the
+    // samples of a progressive render over two processes, one renders frames [0..n), the
+    // other one starts with set_sample_offset(n), and the sums of both are merged
+    void set_sample_offset(unsigned offset);
+    unsigned sample_offset() const;
+
+private:
+
+    // Seeds random generators, advanced every frame
+    unsigned frame_num_ = 0;
+
+    unsigned seed_ = 0;
+
 };
 
 } // visionaray
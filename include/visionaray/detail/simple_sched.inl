@@ -23,6 +23,12 @@ void simple_sched<R>::frame(K kernel, SP sched_params)
 
     auto scissor_box = sched_params.scissor_box;
 
+    unsigned frame_num = frame_num_++;
+
+    // Rays and random numbers for image coordinates, see tile_buffer_rt
+    vec2i offset = detail::render_target_offset(sched_params.rt);
+    vec2i image_size = detail::render_target_image_size(sched_params.rt);
+
     for (int y = 0; y < sched_params.rt.height(); ++y)
     {
         for (int x = 0; x < sched_params.rt.width(); ++x)
@@ -32,26 +38,30 @@ void simple_sched<R>::frame(K kernel, SP sched_params)
                 continue;
             }
 
-            auto gen = make_generator(
+            auto gen = detail::make_pixel_generator(
                     typename R::scalar_type{},
-                    typename SP::pixel_sampler_type{},
-                    detail::tic(typename R::scalar_type{})
+                    sched_params.sample_params,
+                    x + offset.x,
+                    y + offset.y,
+                    image_size.x,
+                    frame_num,
+                    seed_
                     );
 
             auto r = detail::make_primary_rays(
                     R{},
-                    typename SP::pixel_sampler_type{},
+                    sched_params.sample_params,
                     gen,
-                    x,
-                    y,
-                    sched_params.rt.width(),
-                    sched_params.rt.height(),
+                    x + offset.x,
+                    y + offset.y,
+                    image_size.x,
+                    image_size.y,
                     sched_params.cam
                     );
 
             sample_pixel(
                     kernel,
-                    typename SP::pixel_sampler_type{},
+                    sched_params.sample_params,
                     r,
                     gen,
                     sched_params.rt.ref(),
@@ -70,4 +80,22 @@ void simple_sched<R>::frame(K kernel, SP sched_params)
     sched_params.cam.end_frame();
 }
 
+template <typename R>
+void simple_sched<R>::set_seed(unsigned seed)
+{
+    seed_ = seed;
+}
+
+template <typename R>
+void simple_sched<R>::set_sample_offset(unsigned offset)
+{
+    frame_num_ = offset;
+}
+
+template <typename R>
+unsigned simple_sched<R>::sample_offset() const
+{
+    return frame_num_;
+}
+
 } // visionaray
@@ -2,6 +2,7 @@
 // See the LICENSE file for details.
 
 #include <ostream>
+#include <type_traits>
 
 #include <visionaray/math/array.h>
 #include <visionaray/texture/texture.h>
@@ -446,6 +447,25 @@ inline spectrum<float_from_simd_width_t<N>> pack(array<spectrum<float>, N> const
     return spectrum<T>(pack(arr));
 }
 
+template <
+    typename T,
+    typename = typename std::enable_if<is_simd_vector<T>::value>::type
+    >
+VSNRAY_FUNC
+inline array<spectrum<float>, num_elements<T>::value> unpack(spectrum<T> const& s)
+{
+    auto arr = unpack(s.samples());
+
+    array<spectrum<float>, num_elements<T>::value> result;
+
+    for (int i = 0; i < num_elements<T>::value; ++i)
+    {
+        result[i] = spectrum<float>(arr[i]);
+    }
+
+    return result;
+}
+
 } // simd
 
 } // visionaray
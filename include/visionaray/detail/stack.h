@@ -6,6 +6,8 @@
 #ifndef VSNRAY_DETAIL_STACK_H
 #define VSNRAY_DETAIL_STACK_H 1
 
+#include <cassert>
+
 #include "macros.h"
 
 namespace visionaray
@@ -31,13 +33,21 @@ struct stack
         return ptr;
     }
 
+    VSNRAY_FUNC bool full() const
+    {
+        return ptr + 1 >= N;
+    }
+
     VSNRAY_FUNC void clear()
     {
         ptr = 0;
     }
 
+    // Check full() before pushing, the stack does not grow
     VSNRAY_FUNC void push(unsigned v)
     {
+        assert(!full()); // Stack overflow
+
         data[++ptr] = v;
     }
 
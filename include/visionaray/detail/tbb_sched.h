@@ -6,6 +6,8 @@
 #ifndef VSNRAY_DETAIL_TBB_SCHED_H
 #define VSNRAY_DETAIL_TBB_SCHED_H 1
 
+#include <algorithm>
+
 #include <tbb/blocked_range2d.h>
 #include <tbb/parallel_for.h>
 #include <tbb/task_scheduler_init.h>
@@ -20,12 +22,19 @@ struct tbb_sched_backend
 {
     explicit tbb_sched_backend(unsigned num_threads)
         : init_(num_threads)
+        , num_threads_(num_threads)
     {
     }
 
     void reset(unsigned num_threads)
     {
         init_.initialize(num_threads);
+        num_threads_ = num_threads;
+    }
+
+    unsigned concurrency() const
+    {
+        return std::max(num_threads_, 1U);
     }
 
     template <typename Func>
@@ -60,6 +69,7 @@ struct tbb_sched_backend
     }
 
     tbb::task_scheduler_init init_;
+    unsigned num_threads_;
 };
 
 template <typename R>
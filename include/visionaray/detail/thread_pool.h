@@ -9,29 +9,67 @@
 #include <atomic>
 #include <cassert>
 #include <condition_variable>
-#include <functional>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <thread>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VSNRAY_DETAIL_THREAD_POOL_HAVE_PAUSE 1
+#endif
+
+#include "numa.h"
 #include "semaphore.h"
 
 namespace visionaray
 {
+namespace detail
+{
+
+// Busy wait iteration, hint to the CPU and occasionally give up the time slice in case
+// the threads we're waiting for share our core
+inline void spin_wait(unsigned iteration)
+{
+#if VSNRAY_DETAIL_THREAD_POOL_HAVE_PAUSE
+    _mm_pause();
+#endif
+
+    if (iteration % 64 == 63)
+    {
+        std::this_thread::yield();
+    }
+}
+
+} // detail
+
 
 //-------------------------------------------------------------------------------------------------
 // Thread pool
 //
+// Work-stealing pool of persistent threads. run(func, n) calls func(i) for i in [0..n)
+// and blocks until all work items were processed.
+//
+// The work items are initially split into one contiguous range per thread. Each thread
+// processes its range front to back, threads that run out of work steal the back half
+// of another thread's range. Ranges are packed into a single 64-bit word, so that both
+// popping and stealing are a compare-and-swap on the victim's cache line only.
+//
+// Idle threads spin for a while before they park on a condition variable, so that
+// consecutive calls to run() (e.g. one per frame) don't pay for a kernel roundtrip.
+//
+// With PinnedPerNumaNode affinity, consecutive threads are pinned to the same node, so
+// that each node processes a contiguous range of work items, and threads steal from
+// threads on their own node first.
+//
 
 class thread_pool
 {
 public:
 
-    explicit thread_pool(unsigned num_threads)
+    explicit thread_pool(unsigned num_threads, thread_affinity affinity = FloatingThreads)
     {
-        sync_params.start_threads = false;
-        sync_params.join_threads = false;
-        reset(num_threads);
+        reset(num_threads, affinity);
     }
 
    ~thread_pool()
@@ -39,19 +77,49 @@ public:
         join_threads();
     }
 
-    void reset(unsigned num_threads)
+    void reset(unsigned num_threads, thread_affinity affinity = FloatingThreads)
     {
         join_threads();
 
         threads.reset(new std::thread[num_threads]);
+        queues_.reset(new work_queue[num_threads]);
         this->num_threads = num_threads;
+        affinity_ = affinity;
+
+        // Threads wait for the next generation, even if they start after run() was called
+        unsigned generation = generation_.load();
 
         for (unsigned i = 0; i < num_threads; ++i)
         {
-            threads[i] = std::thread([this](){ thread_loop(); });
+            threads[i] = std::thread([this, i, generation]()
+            {
+                if (affinity_ == PinnedPerNumaNode)
+                {
+                    detail::pin_this_thread_to_numa_node(numa_node(i));
+                }
+
+                thread_loop(i, generation);
+            });
         }
     }
 
+    thread_affinity affinity() const
+    {
+        return affinity_;
+    }
+
+    // Number of NUMA nodes the threads are distributed over
+    unsigned num_numa_nodes() const
+    {
+        return affinity_ == PinnedPerNumaNode ? detail::numa_num_nodes() : 1;
+    }
+
+    // NUMA node of thread i
+    unsigned numa_node(unsigned i) const
+    {
+        return static_cast<unsigned>(static_cast<uint64_t>(i) * num_numa_nodes() / num_threads);
+    }
+
     void join_threads()
     {
         if (num_threads == 0)
@@ -59,9 +127,8 @@ public:
             return;
         }
 
-        sync_params.start_threads = true;
-        sync_params.join_threads = true;
-        sync_params.threads_start.notify_all();
+        join_ = true;
+        start_threads();
 
         for (unsigned i = 0; i < num_threads; ++i)
         {
@@ -71,31 +138,63 @@ public:
             }
         }
 
-        sync_params.start_threads = false;
-        sync_params.join_threads = false;
+        join_ = false;
         threads.reset(nullptr);
+        queues_.reset(nullptr);
+        num_threads = 0;
     }
 
     template <typename Func>
     void run(Func f, long queue_length)
     {
-        // Set worker function
-        func = f;
+        assert(queue_length >= 0 && static_cast<uint64_t>(queue_length) <= UINT32_MAX);
+
+        if (queue_length <= 0)
+        {
+            return;
+        }
+
+        // Process serially w/o threads
+        if (num_threads == 0)
+        {
+            for (long i = 0; i < queue_length; ++i)
+            {
+                f(i);
+            }
 
-        // Set counters
-        sync_params.num_work_items = queue_length;
-        sync_params.work_item_counter = 0;
-        sync_params.work_items_finished_counter = 0;
+            return;
+        }
+
+        // Set worker function, f outlives the threads' accesses as we block until they're done
+        func_ = static_cast<void const*>(&f);
+        invoke_ = &invoke<Func>;
+
+        // Distribute work items
+        for (unsigned i = 0; i < num_threads; ++i)
+        {
+            auto first = static_cast<uint32_t>(static_cast<uint64_t>(queue_length) * i / num_threads);
+            auto last  = static_cast<uint32_t>(static_cast<uint64_t>(queue_length) * (i + 1) / num_threads);
+            queues_[i].range.store(make_range(first, last), std::memory_order_relaxed);
+        }
+
+        threads_done_.store(0, std::memory_order_relaxed);
 
         // Activate persistent threads
-        sync_params.start_threads = true;
-        sync_params.threads_start.notify_all();
+        start_threads();
+
+        // Wait for all threads to finish, spin first
+        for (unsigned i = 0; i < SpinCount; ++i)
+        {
+            if (threads_done_.load(std::memory_order_acquire) == num_threads)
+            {
+                break;
+            }
 
-        // Wait for all threads to finish
-        sync_params.threads_ready.wait();
+            detail::spin_wait(i);
+        }
 
-        // Idle w/o work
-        sync_params.start_threads = false;
+        // Returns immediately if the last thread already notified
+        threads_ready_.wait();
     }
 
     std::unique_ptr<std::thread[]> threads;
@@ -103,69 +202,203 @@ public:
 
 private:
 
-    using func_t = std::function<void(unsigned)>;
-    func_t func;
+    // Iterations to busy wait before parking, a few tens of microseconds
+    enum { SpinCount = 1 << 12 };
 
+    // Work items [first..last), packed as last << 32 | first
+    using range_t = uint64_t;
 
-    struct
+    struct alignas(64) work_queue
     {
-        std::mutex              mutex;
-        std::condition_variable threads_start;
-        visionaray::semaphore   threads_ready;
+        std::atomic<range_t> range;
+    };
 
-        std::atomic<bool>       start_threads;
-        std::atomic<bool>       join_threads;
+    // Templated dispatch, avoids std::function
+    using invoke_t = void (*)(void const*, long);
 
-        std::atomic<long>       num_work_items;
-        std::atomic<long>       work_item_counter;
-        std::atomic<long>       work_items_finished_counter;
-    } sync_params;
+    template <typename Func>
+    static void invoke(void const* func, long i)
+    {
+        (*static_cast<Func const*>(func))(i);
+    }
+
+    thread_affinity                 affinity_ = FloatingThreads;
+
+    void const*                     func_ = nullptr;
+    invoke_t                        invoke_ = nullptr;
+
+    std::unique_ptr<work_queue[]>   queues_;
+
+    alignas(64) std::atomic<unsigned> generation_{0};
+    std::atomic<unsigned>           num_parked_{0};
+    std::atomic<bool>               join_{false};
+
+    std::mutex                      mutex_;
+    std::condition_variable         threads_start_;
+
+    alignas(64) std::atomic<unsigned> threads_done_{0};
+    visionaray::semaphore           threads_ready_;
+
+
+    static range_t make_range(uint32_t first, uint32_t last)
+    {
+        return (static_cast<range_t>(last) << 32) | first;
+    }
+
+    static uint32_t range_first(range_t r)
+    {
+        return static_cast<uint32_t>(r);
+    }
 
-    void thread_loop()
+    static uint32_t range_last(range_t r)
     {
+        return static_cast<uint32_t>(r >> 32);
+    }
+
+    void start_threads()
+    {
+        // Sequentially consistent, pairs with the parked thread checking the generation
+        // after announcing itself in num_parked_
+        generation_.fetch_add(1);
+
+        if (num_parked_.load() > 0)
+        {
+            // Parked threads either haven't checked the generation yet or are waiting
+            std::lock_guard<std::mutex> l(mutex_);
+            threads_start_.notify_all();
+        }
+    }
+
+    void wait_for_start(unsigned generation)
+    {
+        for (unsigned i = 0; i < SpinCount; ++i)
+        {
+            if (generation_.load(std::memory_order_acquire) != generation)
+            {
+                return;
+            }
+
+            detail::spin_wait(i);
+        }
+
+        std::unique_lock<std::mutex> l(mutex_);
+        num_parked_.fetch_add(1);
+        threads_start_.wait(l, [&]() { return generation_.load() != generation; });
+        num_parked_.fetch_sub(1);
+    }
+
+    // Take the first work item from the thread's own queue
+    bool pop(work_queue& q, long& item)
+    {
+        range_t r = q.range.load(std::memory_order_relaxed);
+
         for (;;)
         {
-            // Wait until activated
+            uint32_t first = range_first(r);
+            uint32_t last  = range_last(r);
+
+            if (first >= last)
             {
-                std::unique_lock<std::mutex> lock(sync_params.mutex);
-                sync_params.threads_start.wait(
-                        lock,
-                        [this]()
-                            -> std::atomic<bool> const&
-                        {
-                            return sync_params.start_threads;
-                        }
-                        );
+                return false;
             }
 
-            // Exit?
-            if (sync_params.join_threads)
+            if (q.range.compare_exchange_weak(r, make_range(first + 1, last), std::memory_order_acquire))
             {
-                break;
+                item = static_cast<long>(first);
+                return true;
             }
+        }
+    }
 
+    // Move the back half of another thread's queue to the (empty) own queue
+    bool steal_from(unsigned victim_id, unsigned thread_id)
+    {
+        auto& victim = queues_[victim_id];
+
+        range_t r = victim.range.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            uint32_t first = range_first(r);
+            uint32_t last  = range_last(r);
 
-            // Perform work in queue
-            for (;;)
+            if (first >= last)
             {
-                auto work_item = sync_params.work_item_counter.fetch_add(1);
+                return false;
+            }
 
-                if (work_item >= sync_params.num_work_items)
+            // Takes the single remaining item, too
+            uint32_t mid = first + (last - first) / 2;
+
+            if (victim.range.compare_exchange_weak(r, make_range(first, mid), std::memory_order_acquire))
+            {
+                queues_[thread_id].range.store(make_range(mid, last), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    bool steal(unsigned thread_id)
+    {
+        unsigned node = numa_node(thread_id);
+
+        // Victims on the own NUMA node first
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (unsigned j = 1; j < num_threads; ++j)
+            {
+                unsigned victim_id = (thread_id + j) % num_threads;
+
+                if ((numa_node(victim_id) == node) != (pass == 0))
+                {
+                    continue;
+                }
+
+                if (steal_from(victim_id, thread_id))
                 {
-                    break;
+                    return true;
                 }
+            }
+        }
+
+        return false;
+    }
+
+    void thread_loop(unsigned thread_id, unsigned generation)
+    {
+        for (;;)
+        {
+            // Wait until activated
+            wait_for_start(generation);
+            generation = generation_.load(std::memory_order_acquire);
+
+            // Exit?
+            if (join_)
+            {
+                break;
+            }
 
-                func(work_item);
 
-                auto finished = sync_params.work_items_finished_counter.fetch_add(1);
+            // Perform work in own queue, then steal
+            auto& queue = queues_[thread_id];
+
+            do
+            {
+                long work_item = 0;
 
-                if (finished >= sync_params.num_work_items - 1)
+                while (pop(queue, work_item))
                 {
-                    assert(finished == sync_params.num_work_items - 1);
-                    sync_params.threads_ready.notify();
-                    break;
+                    invoke_(func_, work_item);
                 }
             }
+            while (steal(thread_id));
+
+
+            // All queues are empty, items stolen by others are processed by these threads
+            if (threads_done_.fetch_add(1, std::memory_order_acq_rel) == num_threads - 1)
+            {
+                threads_ready_.notify();
+            }
         }
     }
 };
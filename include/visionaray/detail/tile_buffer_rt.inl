@@ -0,0 +1,89 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Placement
+//
+
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+void tile_buffer_rt<ColorFormat, DepthFormat>::set_offset(int x, int y)
+{
+    offset_ = vec2i(x, y);
+}
+
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+vec2i tile_buffer_rt<ColorFormat, DepthFormat>::offset() const
+{
+    return offset_;
+}
+
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+void tile_buffer_rt<ColorFormat, DepthFormat>::set_image_size(int w, int h)
+{
+    image_size_ = vec2i(w, h);
+}
+
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+vec2i tile_buffer_rt<ColorFormat, DepthFormat>::image_size() const
+{
+    if (image_size_.x <= 0 || image_size_.y <= 0)
+    {
+        return vec2i(this->width(), this->height());
+    }
+
+    return image_size_;
+}
+
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+recti tile_buffer_rt<ColorFormat, DepthFormat>::region() const
+{
+    return recti(offset_.x, offset_.y, this->width(), this->height());
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Hand off
+//
+
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+void tile_buffer_rt<ColorFormat, DepthFormat>::copy_to(ref_type dst) const
+{
+    // Clip the tile against dst
+    int x0 = std::max(offset_.x, 0);
+    int y0 = std::max(offset_.y, 0);
+    int x1 = std::min(offset_.x + this->width(), dst.width());
+    int y1 = std::min(offset_.y + this->height(), dst.height());
+
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    for (int y = y0; y < y1; ++y)
+    {
+        int src_row = (y - offset_.y) * this->width() - offset_.x;
+        int dst_row = y * dst.width();
+
+        std::copy(
+                this->color() + src_row + x0,
+                this->color() + src_row + x1,
+                dst.color() + dst_row + x0
+                );
+
+        if (DepthFormat != PF_UNSPECIFIED)
+        {
+            std::copy(
+                    this->depth() + src_row + x0,
+                    this->depth() + src_row + x1,
+                    dst.depth() + dst_row + x0
+                    );
+        }
+    }
+}
+
+} // visionaray
@@ -6,6 +6,16 @@
 #ifndef VSNRAY_DETAIL_TILED_SCHED_H
 #define VSNRAY_DETAIL_TILED_SCHED_H 1
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../math/detail/math.h"
+#include "../morton.h"
 #include "basic_sched.h"
 #include "parallel_for.h"
 #include "range.h"
@@ -14,16 +24,52 @@
 namespace visionaray
 {
 
+//-------------------------------------------------------------------------------------------------
+// Backend for tiled_sched
+//
+// Tiles are handed out in Morton order, so that threads work on nearby tiles and share
+// BVH nodes and textures in cache. The packet rows of a tile are claimed one at a time.
+// Once all tiles were started, threads that are done help with the remaining rows of
+// the tiles that are still being rendered, so that slow tiles (e.g. glass or volumes)
+// don't serialize the end of the frame.
+//
+// With PinnedPerNumaNode affinity, the image is split into one horizontal band of tiles
+// per NUMA node, which is rendered by the threads of that node. Render targets like
+// cpu_buffer_rt first-touch their memory in the same bands, so that the threads mostly
+// write to memory on their own node.
+//
+// With a frame budget, tiles are claimed from a single queue of the tiles that were not
+// rendered yet in the current pass over the image. A thread doesn't start another tile if
+// the cost measured for that tile in earlier frames would exceed the deadline. Tiles that
+// were not started are carried over to the next frame, which continues the pass. Each tile
+// is rendered exactly once per pass.
+//
+
 struct tiled_sched_backend
 {
-    explicit tiled_sched_backend(unsigned num_threads)
-        : pool_(num_threads)
+    explicit tiled_sched_backend(unsigned num_threads, thread_affinity affinity = FloatingThreads)
+        : pool_(num_threads, affinity)
     {
     }
 
-    void reset(unsigned num_threads)
+    void reset(unsigned num_threads, thread_affinity affinity = FloatingThreads)
     {
-        pool_.reset(num_threads);
+        pool_.reset(num_threads, affinity);
+    }
+
+    unsigned concurrency() const
+    {
+        return std::max(pool_.num_threads, 1U);
+    }
+
+    void set_frame_budget(double seconds)
+    {
+        frame_budget_ = seconds;
+    }
+
+    bool frame_complete() const
+    {
+        return frame_complete_;
     }
 
     template <typename Func>
@@ -34,22 +80,268 @@ struct tiled_sched_backend
             Func const& func
             )
     {
-        visionaray::parallel_for(
-            pool_,
-            tr,
-            [=](range2d<int> const& r)
+        int x0 = tr.rows().begin();
+        int y0 = tr.cols().begin();
+
+        int width = tr.rows().length();
+        int height = tr.cols().length();
+
+        int dx = tr.rows().tile_size();
+        int dy = tr.cols().tile_size();
+
+        if (width <= 0 || height <= 0)
+        {
+            return;
+        }
+
+        int num_tiles_x = div_up(width, dx);
+        int num_tiles_y = div_up(height, dy);
+        int num_tiles = num_tiles_x * num_tiles_y;
+
+        int rows_per_tile = div_up(dy, packet_height);
+
+        update_tiles(num_tiles_x, num_tiles_y);
+
+        for (int i = 0; i < num_tiles; ++i)
+        {
+            next_row_[i].store(0, std::memory_order_relaxed);
+        }
+
+        std::atomic<int> tiles_started(0);
+
+        // Render packet rows of a tile until all rows were claimed
+        auto render_tile = [&](int tile)
+        {
+            auto& next_row = next_row_[tile];
+
+            int first_x = (tile % num_tiles_x) * dx + x0;
+            int last_x = std::min(first_x + dx, x0 + width);
+
+            int first_y = (tile / num_tiles_x) * dy + y0;
+            int last_y = std::min(first_y + dy, y0 + height);
+
+            while (next_row.load(std::memory_order_relaxed) < rows_per_tile)
+            {
+                int row = next_row.fetch_add(1, std::memory_order_relaxed);
+                int y = first_y + row * packet_height;
+
+                if (row >= rows_per_tile || y >= last_y)
+                {
+                    break;
+                }
+
+                for (int x = first_x; x < last_x; x += packet_width)
+                {
+                    func(x, y);
+                }
+            }
+        };
+
+        if (frame_budget_ > 0.0)
+        {
+            render_tiles_with_budget(num_tiles, render_tile);
+            return;
+        }
+
+        pool_.run([&](long tile_index)
             {
-                for (int y = r.cols().begin(); y < r.cols().end(); y += packet_height)
+                tiles_started.fetch_add(1, std::memory_order_relaxed);
+
+                render_tile(tile_order_[tile_index]);
+
+                // Split on demand: no tiles left to start, help with the slow ones
+                if (tiles_started.load(std::memory_order_relaxed) == num_tiles)
                 {
-                    for (int x = r.rows().begin(); x < r.rows().end(); x += packet_width)
+                    for (int i = 0; i < num_tiles; ++i)
                     {
-                        func(x, y);
+                        render_tile(tile_order_[i]);
                     }
                 }
-            });
+
+            }, static_cast<long>(num_tiles));
+
+        // All tiles were rendered, budget frames start a new pass
+        frame_complete_ = true;
+        ++pass_;
+    }
+
+    template <typename RenderTile>
+    void render_tiles_with_budget(int num_tiles, RenderTile const& render_tile)
+    {
+        using clock = std::chrono::steady_clock;
+
+        auto deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(frame_budget_)
+                );
+
+        // Tiles that were not rendered yet in this pass, in Morton order
+        pending_.clear();
+
+        for (int i = 0; i < num_tiles; ++i)
+        {
+            int tile = tile_order_[i];
+
+            if (tile_pass_[tile].load(std::memory_order_relaxed) != pass_)
+            {
+                pending_.push_back(tile);
+            }
+        }
+
+        int num_pending = static_cast<int>(pending_.size());
+
+        std::atomic<int> next_tile(0);
+
+        pool_.run([&](long)
+            {
+                // Each thread renders at least one tile, so that tiny budgets still progress
+                bool first = true;
+
+                for (;;)
+                {
+                    int i = next_tile.fetch_add(1, std::memory_order_relaxed);
+
+                    if (i >= num_pending)
+                    {
+                        break;
+                    }
+
+                    int tile = pending_[i];
+
+                    auto start = clock::now();
+                    auto cost = std::chrono::duration_cast<clock::duration>(
+                            std::chrono::duration<float>(tile_cost_[tile])
+                            );
+
+                    if (!first && start + cost > deadline)
+                    {
+                        // Tile i is carried over. Other threads may still claim and
+                        // render later tiles that are cheaper
+                        break;
+                    }
+
+                    first = false;
+
+                    // Mark as rendered in this pass before any row is rendered,
+                    // so that helping threads see the tile as started
+                    tile_pass_[tile].store(pass_, std::memory_order_relaxed);
+
+                    render_tile(tile);
+
+                    // Smoothed cost, only the thread that claimed the tile accesses it
+                    float elapsed = std::chrono::duration<float>(clock::now() - start).count();
+                    tile_cost_[tile] = tile_cost_[tile] > 0.0f ? (tile_cost_[tile] + elapsed) * 0.5f : elapsed;
+                }
+
+                // Help with the tiles that were started
+                for (int i = 0; i < num_pending; ++i)
+                {
+                    int tile = pending_[i];
+
+                    if (tile_pass_[tile].load(std::memory_order_relaxed) == pass_)
+                    {
+                        render_tile(tile);
+                    }
+                }
+
+            }, static_cast<long>(concurrency()));
+
+        // Tiles that were not started are carried over to the next frame
+        frame_complete_ = true;
+
+        for (int tile : pending_)
+        {
+            if (tile_pass_[tile].load(std::memory_order_relaxed) != pass_)
+            {
+                frame_complete_ = false;
+                break;
+            }
+        }
+
+        if (frame_complete_)
+        {
+            ++pass_;
+        }
+    }
+
+    // Tile order and per-tile state, only recomputed when the number of tiles changes
+    void update_tiles(int num_tiles_x, int num_tiles_y)
+    {
+        unsigned num_nodes = pool_.num_numa_nodes();
+
+        if (num_tiles_x == num_tiles_x_ && num_tiles_y == num_tiles_y_ && num_nodes == num_nodes_)
+        {
+            return;
+        }
+
+        num_tiles_x_ = num_tiles_x;
+        num_tiles_y_ = num_tiles_y;
+        num_nodes_ = num_nodes;
+
+        size_t num_tiles = static_cast<size_t>(num_tiles_x) * num_tiles_y;
+
+        // Sort by NUMA band, then by Morton code
+        std::vector<std::pair<unsigned long long, int>> codes(num_tiles);
+
+        for (int y = 0; y < num_tiles_y; ++y)
+        {
+            unsigned long long band = static_cast<unsigned long long>(y) * num_nodes / num_tiles_y;
+
+            for (int x = 0; x < num_tiles_x; ++x)
+            {
+                int tile = y * num_tiles_x + x;
+                codes[tile] = { (band << 32) | morton_encode2D(x, y), tile };
+            }
+        }
+
+        std::sort(codes.begin(), codes.end());
+
+        tile_order_.resize(num_tiles);
+
+        for (size_t i = 0; i < num_tiles; ++i)
+        {
+            tile_order_[i] = codes[i].second;
+        }
+
+        next_row_.reset(new std::atomic<int>[num_tiles]);
+        tile_pass_.reset(new std::atomic<unsigned>[num_tiles]);
+
+        ++pass_;
+
+        for (size_t i = 0; i < num_tiles; ++i)
+        {
+            tile_pass_[i].store(pass_ - 1, std::memory_order_relaxed);
+        }
+
+        tile_cost_.assign(num_tiles, 0.0f);
     }
 
     thread_pool pool_;
+
+    int num_tiles_x_ = 0;
+    int num_tiles_y_ = 0;
+    unsigned num_nodes_ = 0;
+
+    // Tile indices (row-major) in Morton order
+    std::vector<int> tile_order_;
+
+    // Next packet row to render, per tile
+    std::unique_ptr<std::atomic<int>[]> next_row_;
+
+    // Frame budget in seconds, 0 renders complete frames
+    double frame_budget_ = 0.0;
+
+    bool frame_complete_ = true;
+
+    // With a frame budget, all tiles are rendered once per pass, which may span several
+    // frames. A tile was rendered in the current pass if its tile_pass_ equals pass_
+    unsigned pass_ = 0;
+    std::unique_ptr<std::atomic<unsigned>[]> tile_pass_;
+
+    // Tiles of the current frame that were not rendered in this pass yet
+    std::vector<int> pending_;
+
+    // Render time of each tile in seconds, measured in earlier frames
+    std::vector<float> tile_cost_;
 };
 
 template <typename R>
@@ -0,0 +1,690 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "../math/simd/type_traits.h"
+#include "../math/array.h"
+#include "../math/constants.h"
+#include "../math/limits.h"
+#include "../get_area.h"
+#include "../get_surface.h"
+#include "../intersector.h"
+#include "../kernels.h"
+#include "../random_generator.h"
+#include "../sampling.h"
+#include "../surface_interaction.h"
+#include "../traverse.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Move data between the lanes of a packet of type S and per-path storage
+//
+
+// non-simd
+template <typename S, typename = void>
+struct wavefront_packet
+{
+    enum { size = 1 };
+
+    using float_array   = float[1];
+    using int_array     = int[1];
+
+    static S load(float_array const& arr)
+    {
+        return arr[0];
+    }
+
+    static int load(int_array const& arr)
+    {
+        return arr[0];
+    }
+
+    static void store(float_array& arr, S const& s)
+    {
+        arr[0] = s;
+    }
+
+    static void store_mask(float_array& arr, bool m)
+    {
+        arr[0] = m ? 1.0f : 0.0f;
+    }
+
+    template <typename T>
+    static T pack_lanes(array<T, 1> const& arr)
+    {
+        return arr[0];
+    }
+
+    template <typename T>
+    static array<T, 1> unpack_lanes(T const& t)
+    {
+        return {{ t }};
+    }
+
+    static random_generator<S> make_generator(array<unsigned, 1> const& seeds)
+    {
+        return random_generator<S>(seeds[0]);
+    }
+};
+
+// simd
+template <typename S>
+struct wavefront_packet<S, typename std::enable_if<simd::is_simd_vector<S>::value>::type>
+{
+    enum { size = simd::num_elements<S>::value };
+
+    using I             = simd::int_type_t<S>;
+    using float_array   = simd::aligned_array_t<S>;
+    using int_array     = simd::aligned_array_t<I>;
+
+    static S load(float_array const& arr)
+    {
+        return S(arr);
+    }
+
+    static I load(int_array const& arr)
+    {
+        return I(arr);
+    }
+
+    static void store(float_array& arr, S const& s)
+    {
+        visionaray::simd::store(arr, s);
+    }
+
+    static void store_mask(float_array& arr, simd::mask_type_t<S> const& m)
+    {
+        visionaray::simd::store(arr, select(m, S(1.0), S(0.0)));
+    }
+
+    template <typename T>
+    static auto pack_lanes(array<T, size> const& arr)
+        -> decltype(simd::pack(arr))
+    {
+        return simd::pack(arr);
+    }
+
+    template <typename T>
+    static auto unpack_lanes(T const& t)
+        -> decltype(simd::unpack(t))
+    {
+        return simd::unpack(t);
+    }
+
+    static random_generator<S> make_generator(array<unsigned, size> const& seeds)
+    {
+        return random_generator<S>(seeds);
+    }
+};
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Public interface
+//
+
+template <typename Params, typename S>
+inline wavefront_pathtracer<Params, S>::wavefront_pathtracer(Params const& params)
+    : params_(params)
+    , bin_offsets_(material_list::size + 1)
+    , num_shaded_(material_list::size)
+{
+}
+
+template <typename Params, typename S>
+template <typename Intersector>
+inline void wavefront_pathtracer<Params, S>::trace(
+        ray_type const* rays,
+        unsigned const* seeds,
+        size_t          count,
+        result_type*    results,
+        Intersector&    isect
+        )
+{
+    paths_.resize(count);
+    queue_.resize(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        path_state path;
+        path.ray = rays[i];
+        path.seed = seeds[i];
+        path.result.color = params_.bg_color;
+
+        paths_[i] = path;
+        queue_[i] = static_cast<unsigned>(i);
+    }
+
+    std::fill(num_shaded_.begin(), num_shaded_.end(), size_t(0));
+
+    for (unsigned bounce = 0; bounce < params_.num_bounces && !queue_.empty(); ++bounce)
+    {
+        intersect(bounce, isect);
+        sort_by_material();
+        shade(bounce, std::integral_constant<unsigned, 0>{});
+        trace_shadow_rays(isect);
+        compact();
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto const& path = paths_[i];
+
+        results[i] = path.result;
+        results[i].color = path.result.hit ? to_rgba(path.intensity) : path.result.color;
+    }
+}
+
+template <typename Params, typename S>
+inline void wavefront_pathtracer<Params, S>::trace(
+        ray_type const* rays,
+        unsigned const* seeds,
+        size_t          count,
+        result_type*    results
+        )
+{
+    default_intersector ignore;
+    trace(rays, seeds, count, results, ignore);
+}
+
+template <typename Params, typename S>
+inline size_t wavefront_pathtracer<Params, S>::num_shaded(unsigned type_index) const
+{
+    return num_shaded_[type_index];
+}
+
+template <typename Params, typename S>
+inline Params const& wavefront_pathtracer<Params, S>::params() const
+{
+    return params_;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Intersect stage
+//
+
+template <typename Params, typename S>
+template <typename Intersector>
+inline void wavefront_pathtracer<Params, S>::intersect(unsigned bounce, Intersector& isect)
+{
+    using P = detail::wavefront_packet<S>;
+
+    size_t const W = P::size;
+
+    for (size_t first = 0; first < queue_.size(); first += W)
+    {
+        size_t count = std::min(W, queue_.size() - first);
+
+        // Fill up partial packets with the first path, results of these lanes are ignored
+        array<ray_type, P::size> rays;
+
+        for (size_t i = 0; i < W; ++i)
+        {
+            rays[i] = paths_[queue_[first + (i < count ? i : 0)]].ray;
+        }
+
+        auto hit_rec = closest_hit(P::pack_lanes(rays), params_.prims.begin, params_.prims.end, isect);
+
+        auto hit_recs = P::unpack_lanes(hit_rec);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            record_hit(queue_[first + i], hit_recs[i], bounce);
+        }
+    }
+}
+
+template <typename Params, typename S>
+template <typename HR>
+inline void wavefront_pathtracer<Params, S>::record_hit(unsigned index, HR hit_rec, unsigned bounce)
+{
+    auto& path = paths_[index];
+
+    if (!hit_rec.hit)
+    {
+        // Path exited the scene
+        auto env = detail::escaped_radiance(
+                params_,
+                params_.environment.light,
+                path.ray.dir,
+                path.last_pos,
+                path.last_normal,
+                path.last_brdf_pdf,
+                bounce > 0 && !path.last_specular
+                );
+
+        path.intensity += env * path.throughput;
+        path.active = false;
+        return;
+    }
+
+    hit_rec.isect_pos = path.ray.ori + path.ray.dir * hit_rec.t;
+
+    if (bounce == 0)
+    {
+        path.result.hit = true;
+        path.result.isect_pos = hit_rec.isect_pos;
+    }
+
+    path.surf = get_surface(hit_rec, params_);
+    path.isect_pos = hit_rec.isect_pos;
+    path.prim_id = hit_rec.prim_id;
+    path.area = params_.lights.end != params_.lights.begin
+            ? static_cast<float>(get_area(params_.prims.begin, hit_rec))
+            : 0.0f;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Sort stage
+//
+
+template <typename Params, typename S>
+inline void wavefront_pathtracer<Params, S>::sort_by_material()
+{
+    std::fill(bin_offsets_.begin(), bin_offsets_.end(), size_t(0));
+
+    for (auto index : queue_)
+    {
+        auto const& path = paths_[index];
+
+        if (path.active)
+        {
+            ++bin_offsets_[material_list::index(path.surf.material) + 1];
+        }
+    }
+
+    for (size_t i = 1; i < bin_offsets_.size(); ++i)
+    {
+        bin_offsets_[i] += bin_offsets_[i - 1];
+    }
+
+    material_queue_.resize(bin_offsets_.back());
+
+    // Stable, paths keep their order inside a bin
+    aligned_vector<size_t> next(bin_offsets_.begin(), bin_offsets_.end() - 1);
+
+    for (auto index : queue_)
+    {
+        auto const& path = paths_[index];
+
+        if (path.active)
+        {
+            material_queue_[next[material_list::index(path.surf.material)]++] = index;
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Shade stage
+//
+
+template <typename Params, typename S>
+template <unsigned I>
+inline void wavefront_pathtracer<Params, S>::shade(unsigned bounce, std::integral_constant<unsigned, I>)
+{
+    using M = typename material_list::template type<I>;
+
+    size_t const W = simd::num_elements<S>::value;
+
+    // Shade materials w/o SIMD representation one path at a time
+    using SS = typename std::conditional<
+            (W > 1) && detail::is_packable<M, simd::num_elements<S>::value>::value,
+            S,
+            float
+            >::type;
+
+    size_t const WS = detail::wavefront_packet<SS>::size;
+
+    size_t first = bin_offsets_[I];
+    size_t last = bin_offsets_[I + 1];
+
+    for (size_t i = first; i < last; i += WS)
+    {
+        shade_packet<SS, M>(material_queue_.data() + i, std::min(WS, last - i), bounce);
+    }
+
+    num_shaded_[I] += last - first;
+
+    shade(bounce, std::integral_constant<unsigned, I + 1>{});
+}
+
+template <typename Params, typename S>
+inline void wavefront_pathtracer<Params, S>::shade(unsigned, std::integral_constant<unsigned, material_list::size>)
+{
+}
+
+template <typename Params, typename S>
+template <typename SS, typename M>
+inline void wavefront_pathtracer<Params, S>::shade_packet(unsigned const* indices, size_t count, unsigned bounce)
+{
+    using P = detail::wavefront_packet<SS>;
+    using I = simd::int_type_t<SS>;
+    using V = vector<3, SS>;
+    using C = spectrum<SS>;
+    using N_ = typename Params::normal_type;
+    using C_ = typename Params::color_type;
+
+    size_t const W = P::size;
+
+
+    // Gather
+
+    array<surface<N_, C_, M>, P::size> surfs;
+    array<vec3, P::size> oris;
+    array<vec3, P::size> dirs;
+    array<vec3, P::size> isect_poss;
+    array<vec3, P::size> last_poss;
+    array<vec3, P::size> last_normals;
+    array<spectrum<float>, P::size> throughputs;
+    array<unsigned, P::size> seeds;
+
+    typename P::float_array areas;
+    typename P::float_array last_brdf_pdfs;
+    typename P::float_array last_speculars;
+    typename P::float_array valid;
+    typename P::int_array prim_ids;
+
+    for (size_t i = 0; i < W; ++i)
+    {
+        // Fill up partial packets with the first path, results of these lanes are ignored
+        auto const& path = paths_[indices[i < count ? i : 0]];
+
+        surfs[i].geometric_normal = path.surf.geometric_normal;
+        surfs[i].shading_normal   = path.surf.shading_normal;
+        surfs[i].tex_color        = path.surf.tex_color;
+        surfs[i].material         = material_list::template get<M>(path.surf.material);
+
+        oris[i]           = path.ray.ori;
+        dirs[i]           = path.ray.dir;
+        isect_poss[i]     = path.isect_pos;
+        last_poss[i]      = path.last_pos;
+        last_normals[i]   = path.last_normal;
+        throughputs[i]    = path.throughput;
+        seeds[i]          = detail::make_seed(path.seed, bounce);
+
+        areas[i]          = path.area;
+        last_brdf_pdfs[i] = path.last_brdf_pdf;
+        last_speculars[i] = path.last_specular ? 1.0f : 0.0f;
+        valid[i]          = i < count ? 1.0f : 0.0f;
+        prim_ids[i]       = path.prim_id;
+    }
+
+    auto surf          = P::pack_lanes(surfs);
+    V ori              = P::pack_lanes(oris);
+    V dir              = P::pack_lanes(dirs);
+    V isect_pos        = P::pack_lanes(isect_poss);
+    V last_pos         = P::pack_lanes(last_poss);
+    V last_normal      = P::pack_lanes(last_normals);
+    C throughput       = P::pack_lanes(throughputs);
+    SS area            = P::load(areas);
+    SS last_brdf_pdf   = P::load(last_brdf_pdfs);
+    auto last_specular = P::load(last_speculars) > SS(0.0);
+    auto active        = P::load(valid) > SS(0.0);
+    I prim_id          = P::load(prim_ids);
+
+    auto gen = P::make_generator(seeds);
+
+
+    // Shade, cf. pathtracing::kernel
+
+    C intensity(0.0);
+
+    V refl_dir(0.0);
+    V view_dir = -dir;
+
+    SS brdf_pdf(0.0);
+
+    I inter = 0;
+    auto src = surf.sample(view_dir, refl_dir, brdf_pdf, inter, gen);
+
+    auto zero_pdf = brdf_pdf <= SS(0.0);
+
+    SS light_pdf(0.0);
+    auto num_lights = params_.lights.end - params_.lights.begin;
+
+    if (num_lights > 0 && any(inter == surface_interaction::Emission))
+    {
+        auto ld = length(isect_pos - ori);
+        auto L = normalize(isect_pos - ori);
+        auto n = surf.geometric_normal;
+        auto ldotln = abs(dot(-L, n));
+        auto solid_angle = (ldotln * area) / (ld * ld);
+
+        auto select_pdf = light_selection_pdf(
+                params_.light_sampler,
+                params_.lights.begin,
+                params_.lights.end,
+                prim_id,
+                last_pos,
+                last_normal
+                );
+
+        light_pdf = select(
+            inter == surface_interaction::Emission,
+            select_pdf / solid_angle,
+            SS(0.0)
+            );
+    }
+
+    SS mis_weight = select(
+        bounce > 0 && num_lights > 0 && !last_specular,
+        power_heuristic(last_brdf_pdf, light_pdf),
+        SS(1.0)
+        );
+
+    intensity += select(
+        active && inter == surface_interaction::Emission,
+        mis_weight * throughput * src,
+        C(0.0)
+        );
+
+    active &= inter != surface_interaction::Emission;
+    active &= !zero_pdf;
+
+    auto n = surf.shading_normal;
+#if 1
+    n = faceforward( n, view_dir, surf.geometric_normal );
+#endif
+
+    // Light samples, shadow rays are traced in the next stage
+    decltype(active) shadow_valid(false);
+    V shadow_dir(0.0);
+    SS shadow_max_t(0.0);
+    C shadow_contribution(0.0);
+
+    if (num_lights > 0)
+    {
+        SS select_pdf(0.0);
+        auto ls = sample_light(
+                params_.light_sampler,
+                params_.lights.begin,
+                params_.lights.end,
+                isect_pos,
+                n,
+                select_pdf,
+                gen
+                );
+
+        // Samples from lights at infinity store the direction towards the light
+        auto ld = select(
+            ls.infinite_light,
+            SS(numeric_limits<float>::max()),
+            length(ls.pos - isect_pos)
+            );
+        auto L = select(
+            ls.infinite_light,
+            ls.pos,
+            normalize(ls.pos - isect_pos)
+            );
+
+        auto ln = select(ls.delta_light, -L, ls.normal);
+#if 1
+        ln = faceforward( ln, -L, ln );
+#endif
+        auto ldotn = dot(L, n);
+        auto ldotln = abs(dot(-L, ln));
+
+        auto light_brdf_pdf = surf.pdf(view_dir, L, inter);
+        auto prob = max_element(throughput.samples());
+        light_brdf_pdf *= prob;
+
+        // TODO: inv_pi / dot(n, wi) factor only valid for plastic and matte
+        auto light_src = surf.shade(view_dir, L, ls.intensity) * constants::inv_pi<SS>() / ldotn;
+        auto solid_angle = (ldotln * ls.area);
+        solid_angle = select(!ls.delta_light && !ls.infinite_light, solid_angle / (ld * ld), solid_angle);
+        auto light_sample_pdf = SS(1.0) / solid_angle;
+
+        SS light_mis_weight = power_heuristic(light_sample_pdf * select_pdf, light_brdf_pdf);
+
+        shadow_valid = active && ldotn > SS(0.0) && ldotln > SS(0.0) && solid_angle > SS(0.0) && select_pdf > SS(0.0);
+        shadow_dir = L;
+        shadow_max_t = ld - SS(2.0f * params_.epsilon);
+        shadow_contribution = light_mis_weight * throughput * light_src * (ldotn / light_sample_pdf) / select_pdf;
+    }
+
+    // Weighted like the BRDF pdf of next event estimation
+    last_brdf_pdf = brdf_pdf * max_element(throughput.samples());
+
+    throughput *= src * (dot(n, refl_dir) / brdf_pdf);
+    throughput = select(zero_pdf, C(0.0), throughput);
+
+    if (bounce >= 2)
+    {
+        // Russian roulette
+        auto prob = max_element(throughput.samples());
+        auto terminate = gen.next() > prob;
+        active &= !terminate;
+        throughput /= prob;
+    }
+
+    last_specular = inter == surface_interaction::SpecularReflection ||
+                    inter == surface_interaction::SpecularTransmission;
+
+
+    // Scatter
+
+    auto intensities = P::unpack_lanes(intensity);
+    auto throughputs_out = P::unpack_lanes(throughput);
+    auto normals = P::unpack_lanes(n);
+    auto refl_dirs = P::unpack_lanes(refl_dir);
+    auto shadow_dirs = P::unpack_lanes(shadow_dir);
+    auto shadow_contributions = P::unpack_lanes(shadow_contribution);
+
+    typename P::float_array actives;
+    typename P::float_array shadow_valids;
+    typename P::float_array shadow_max_ts;
+    typename P::float_array brdf_pdfs_out;
+    typename P::float_array speculars_out;
+
+    P::store_mask(actives, active);
+    P::store_mask(shadow_valids, shadow_valid);
+    P::store(shadow_max_ts, shadow_max_t);
+    P::store(brdf_pdfs_out, last_brdf_pdf);
+    P::store_mask(speculars_out, last_specular);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto& path = paths_[indices[i]];
+
+        path.intensity += intensities[i];
+
+        if (shadow_valids[i] > 0.0f)
+        {
+            shadow_ray sr;
+            sr.path = indices[i];
+            sr.ray = ray_type(isect_poss[i] + shadow_dirs[i] * params_.epsilon, shadow_dirs[i]);
+            sr.max_t = shadow_max_ts[i];
+            sr.contribution = shadow_contributions[i];
+            shadow_queue_.push_back(sr);
+        }
+
+        path.active = actives[i] > 0.0f;
+        path.throughput = throughputs_out[i];
+        path.last_pos = isect_poss[i];
+        path.last_normal = normals[i];
+        path.last_brdf_pdf = brdf_pdfs_out[i];
+        path.last_specular = speculars_out[i] > 0.0f;
+        path.ray.ori = isect_poss[i] + refl_dirs[i] * params_.epsilon;
+        path.ray.dir = refl_dirs[i];
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Shadow and accumulate stages
+//
+
+template <typename Params, typename S>
+template <typename Intersector>
+inline void wavefront_pathtracer<Params, S>::trace_shadow_rays(Intersector& isect)
+{
+    using P = detail::wavefront_packet<S>;
+
+    size_t const W = P::size;
+
+    for (size_t first = 0; first < shadow_queue_.size(); first += W)
+    {
+        size_t count = std::min(W, shadow_queue_.size() - first);
+
+        array<ray_type, P::size> rays;
+        typename P::float_array max_t;
+
+        for (size_t i = 0; i < W; ++i)
+        {
+            auto const& sr = shadow_queue_[first + (i < count ? i : 0)];
+
+            rays[i] = sr.ray;
+            max_t[i] = sr.max_t;
+        }
+
+        auto hit_rec = any_hit(
+                P::pack_lanes(rays),
+                params_.prims.begin,
+                params_.prims.end,
+                P::load(max_t),
+                isect
+                );
+
+        typename P::float_array occluded;
+        P::store_mask(occluded, hit_rec.hit);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto const& sr = shadow_queue_[first + i];
+
+            if (!(occluded[i] > 0.0f))
+            {
+                paths_[sr.path].intensity += sr.contribution;
+            }
+        }
+    }
+
+    shadow_queue_.clear();
+}
+
+template <typename Params, typename S>
+inline void wavefront_pathtracer<Params, S>::compact()
+{
+    queue_.erase(
+            std::remove_if(
+                queue_.begin(),
+                queue_.end(),
+                [this](unsigned index) { return !paths_[index].active; }
+                ),
+            queue_.end()
+            );
+}
+
+} // visionaray
@@ -0,0 +1,101 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DISTRIBUTION_2D_H
+#define VSNRAY_DISTRIBUTION_2D_H 1
+
+#include "detail/macros.h"
+#include "math/forward.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Piecewise-constant 2D distribution over [0..1)^2
+//
+// Built on the host from width x height non-negative function values, samples are drawn
+// proportional to the function with a marginal distribution over the rows and conditional
+// distributions over the cells of each row. Kernels use the distribution's ref()
+//
+
+class distribution_2d_ref
+{
+public:
+
+    distribution_2d_ref() = default;
+
+    VSNRAY_FUNC distribution_2d_ref(
+            float const*    pdf,
+            float const*    conditional_cdf,
+            float const*    marginal_cdf,
+            int             width,
+            int             height
+            );
+
+    // Sample a point with u1 and u2 in [0..1), pdf is the density at the point
+    VSNRAY_FUNC vec2 sample(float u1, float u2, float& pdf) const;
+
+    // Density at the point uv
+    template <typename T>
+    VSNRAY_FUNC T pdf(vector<2, T> const& uv) const;
+
+    VSNRAY_FUNC int width() const;
+    VSNRAY_FUNC int height() const;
+
+private:
+
+    // Density per cell
+    float const*    pdf_ = nullptr;
+
+    // height rows with width + 1 entries
+    float const*    conditional_cdf_ = nullptr;
+
+    // height + 1 entries
+    float const*    marginal_cdf_ = nullptr;
+
+    int             width_ = 0;
+    int             height_ = 0;
+
+};
+
+class distribution_2d
+{
+public:
+
+    using ref_type = distribution_2d_ref;
+
+public:
+
+    distribution_2d() = default;
+
+    distribution_2d(float const* func, int width, int height);
+
+    // Build from width x height function values, row by row. If all values are zero,
+    // the distribution is uniform
+    void build(float const* func, int width, int height);
+
+    ref_type ref() const;
+
+    int width() const;
+    int height() const;
+
+private:
+
+    aligned_vector<float>   pdf_;
+    aligned_vector<float>   conditional_cdf_;
+    aligned_vector<float>   marginal_cdf_;
+
+    int                     width_ = 0;
+    int                     height_ = 0;
+
+};
+
+} // visionaray
+
+#include "detail/distribution_2d.inl"
+
+#endif // VSNRAY_DISTRIBUTION_2D_H
@@ -0,0 +1,99 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_ENVIRONMENT_LIGHT_H
+#define VSNRAY_ENVIRONMENT_LIGHT_H 1
+
+#include "detail/macros.h"
+#include "math/matrix.h"
+#include "math/vector.h"
+#include "distribution_2d.h"
+#include "light_sample.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Environment light
+//
+// Light at infinity with radiance from a latitude-longitude environment map. The map's
+// v coordinate goes from +y (v = 0) to -y (v = 1), u = 0.5 is the -z direction.
+//
+// Directions are sampled with a piecewise-constant distribution over the map's texels, see
+// make_environment_distribution(). Light samples store the direction towards the light in
+// pos and the sample's solid angle (1 / pdf) in area, infinite_light is set.
+//
+
+template <typename T, typename Texture>
+class environment_light
+{
+public:
+
+    using scalar_type   = T;
+    using vec_type      = vector<3, T>;
+    using color_type    = vector<3, T>;
+
+public:
+
+    environment_light() = default;
+    environment_light(Texture texture, distribution_2d_ref distribution);
+
+    // Evaluate the radiance arriving from direction pos (not necessarily normalized).
+    template <typename U>
+    VSNRAY_FUNC vector<3, U> intensity(vector<3, U> const& pos) const;
+
+    // Radiance arriving from direction dir.
+    template <typename U>
+    VSNRAY_FUNC vector<3, U> radiance(vector<3, U> const& dir) const;
+
+    // Solid angle density of sampling direction dir.
+    template <typename U>
+    VSNRAY_FUNC U pdf(vector<3, U> const& dir) const;
+
+    template <typename Generator, typename U = typename Generator::value_type>
+    VSNRAY_FUNC light_sample<U> sample(Generator& gen) const;
+
+    // Light is at infinity, return origin
+    VSNRAY_FUNC vector<3, T> position() const;
+
+    VSNRAY_FUNC Texture const& texture() const;
+    VSNRAY_FUNC distribution_2d_ref const& distribution() const;
+
+    VSNRAY_FUNC void set_texture(Texture const& texture);
+    VSNRAY_FUNC void set_distribution(distribution_2d_ref const& distribution);
+
+    // Scales the map's radiance
+    VSNRAY_FUNC void set_scale(T scale);
+    VSNRAY_FUNC T scale() const;
+
+    // Rotation of the map, translation is ignored
+    VSNRAY_FUNC void set_light_to_world_transform(matrix<4, 4, T> const& light_to_world);
+
+private:
+
+    Texture                 texture_;
+    distribution_2d_ref     distribution_;
+
+    T                       scale_ = T(1.0);
+
+    matrix<3, 3, T>         light_to_world_ = matrix<3, 3, T>::identity();
+    matrix<3, 3, T>         world_to_light_ = matrix<3, 3, T>::identity();
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Build the sampling distribution for a latitude-longitude environment map, texels are
+// weighted by luminance and by the solid angle they cover
+//
+
+template <typename Texture>
+distribution_2d make_environment_distribution(Texture const& texture);
+
+} // visionaray
+
+#include "detail/environment_light.inl"
+
+#endif // VSNRAY_ENVIRONMENT_LIGHT_H
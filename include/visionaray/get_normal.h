@@ -16,6 +16,7 @@
 #include "math/sphere.h"
 #include "math/triangle.h"
 #include "math/vector.h"
+#include "math/woop_triangle.h"
 #include "prim_traits.h"
 #include "tags.h"
 
@@ -102,6 +103,19 @@ inline auto get_normal(
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Woop triangles use the same normal list as triangles
+//
+
+template <typename Normals, typename HR, typename T>
+VSNRAY_FUNC
+inline auto get_normal(Normals normals, HR const& hr, basic_woop_triangle<T> const& triangle)
+    -> decltype( get_normal(normals, hr, basic_triangle<3, T>{}) )
+{
+    return get_normal(normals, hr, static_cast<basic_triangle<3, T> const&>(triangle));
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Get normal from triangle primitive
 //
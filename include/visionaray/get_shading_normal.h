@@ -14,6 +14,7 @@
 #include "math/detail/math.h"
 #include "math/simd/type_traits.h"
 #include "math/triangle.h"
+#include "math/woop_triangle.h"
 #include "get_normal.h"
 #include "prim_traits.h"
 #include "tags.h"
@@ -175,6 +176,24 @@ inline auto get_shading_normal(
     return normalize( lerp(n1, n2, n3, hr.u, hr.v) );
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Woop triangles use the same normal list as triangles
+//
+
+template <typename Normals, typename HR, typename T>
+VSNRAY_FUNC
+inline auto get_shading_normal(
+        Normals                     normals,
+        HR const&                   hr,
+        basic_woop_triangle<T>      triangle,
+        normals_per_vertex_binding  binding
+        )
+    -> decltype( get_shading_normal(normals, hr, basic_triangle<3, T>{}, binding) )
+{
+    return get_shading_normal(normals, hr, static_cast<basic_triangle<3, T> const&>(triangle), binding);
+}
+
 } // visionaray
 
 #endif // VSNRAY_GET_SHADING_NORMAL_H
@@ -17,6 +17,7 @@
 #include "math/sphere.h"
 #include "math/triangle.h"
 #include "math/vector.h"
+#include "math/woop_triangle.h"
 
 
 namespace visionaray
@@ -114,6 +115,19 @@ inline auto get_tex_coord(TexCoords tex_coords, HR const& hr, basic_triangle<3,
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Woop triangle, same tex coord list as triangles
+//
+
+template <typename TexCoords, typename HR, typename T>
+VSNRAY_FUNC
+inline auto get_tex_coord(TexCoords tex_coords, HR const& hr, basic_woop_triangle<T> const& triangle)
+    -> decltype( get_tex_coord(tex_coords, hr, basic_triangle<3, T>{}) )
+{
+    return get_tex_coord(tex_coords, hr, static_cast<basic_triangle<3, T> const&>(triangle));
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // Sphere
 //
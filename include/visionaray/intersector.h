@@ -11,6 +11,8 @@
 
 #include "detail/macros.h"
 #include "detail/tags.h"
+#include "math/intersect.h"
+#include "math/triangle.h"
 #include "bvh.h"
 
 namespace visionaray
@@ -32,7 +34,7 @@ struct basic_intersector
     auto operator()(R const& ray, P const& prim, Args&&... args)
         -> decltype( intersect(ray, prim, std::forward<Args>(args)...) )
     {
-        return intersect(ray, prim);
+        return intersect(ray, prim, std::forward<Args>(args)...);
     }
 
 
@@ -126,6 +128,32 @@ struct default_intersector : basic_intersector<default_intersector>
 {
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// Watertight intersector
+//
+// Intersects triangles with the watertight test, so that rays through shared edges and
+// vertices never fall through cracks. Other primitives use their default test.
+//
+// Usage:
+//
+//  watertight_intersector isect;
+//  auto hr = intersect<detail::ClosestHit>(ray, bvh, isect);
+//
+
+struct watertight_intersector : basic_intersector<watertight_intersector>
+{
+    using basic_intersector<watertight_intersector>::operator();
+
+    template <typename R, typename T>
+    VSNRAY_FUNC
+    auto operator()(R const& ray, basic_triangle<3, T, unsigned> const& tri)
+        -> decltype( intersect_watertight(ray, tri) )
+    {
+        return intersect_watertight(ray, tri);
+    }
+};
+
 } // visionaray
 
 #endif // VSNRAY_INTERSECTOR_H
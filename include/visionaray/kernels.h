@@ -6,11 +6,13 @@
 #ifndef VSNRAY_KERNELS_H
 #define VSNRAY_KERNELS_H 1
 
+#include <cstddef>
 #include <iterator>
 #include <limits>
 
 #include "math/forward.h"
 #include "math/vector.h"
+#include "light_sampler.h"
 #include "prim_traits.h"
 #include "tags.h"
 
@@ -31,7 +33,9 @@ template <
     typename Colors,
     typename Textures,
     typename Lights,
-    typename Color
+    typename Color,
+    typename LightSampler = uniform_light_sampler,
+    typename Environment = std::nullptr_t
     >
 struct kernel_params
 {
@@ -69,6 +73,16 @@ struct kernel_params
 
     Color bg_color;
     Color ambient_color;
+
+    // Selects lights for next event estimation, see light_sampler.h
+    LightSampler light_sampler;
+
+    // Radiance of rays that leave the scene, ambient_color if nullptr
+    struct
+    {
+        Environment light;
+        int index;          // index in lights for MIS, -1 if not in lights
+    } environment;
 };
 
 
@@ -116,7 +130,9 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        uniform_light_sampler{},
+        { nullptr, -1 } // no environment light
         };
 }
 
@@ -164,7 +180,9 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        uniform_light_sampler{},
+        { nullptr, -1 } // no environment light
         };
 }
 
@@ -218,7 +236,9 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        uniform_light_sampler{},
+        { nullptr, -1 } // no environment light
         };
 }
 
@@ -276,7 +296,9 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        uniform_light_sampler{},
+        { nullptr, -1 } // no environment light
         };
 }
 
@@ -339,7 +361,162 @@ auto make_kernel_params(
         num_bounces,
         epsilon,
         bg_color,
-        ambient_color
+        ambient_color,
+        uniform_light_sampler{},
+        { nullptr, -1 } // no environment light
+        };
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Replace the light sampler of a param struct, e.g.:
+//
+//  light_bvh lbvh(lights.begin(), lights.end());
+//  auto kparams = with_light_sampler(make_kernel_params(...), lbvh.ref());
+//
+
+template <
+    typename NormalBinding,
+    typename ColorBinding,
+    typename Primitives,
+    typename Normals,
+    typename TexCoords,
+    typename Materials,
+    typename Colors,
+    typename Textures,
+    typename Lights,
+    typename Color,
+    typename LightSampler,
+    typename Environment,
+    typename NewLightSampler
+    >
+auto with_light_sampler(
+        kernel_params<
+            NormalBinding,
+            ColorBinding,
+            Primitives,
+            Normals,
+            TexCoords,
+            Materials,
+            Colors,
+            Textures,
+            Lights,
+            Color,
+            LightSampler,
+            Environment
+            > const&                params,
+        NewLightSampler const&      light_sampler
+        )
+    -> kernel_params<
+        NormalBinding,
+        ColorBinding,
+        Primitives,
+        Normals,
+        TexCoords,
+        Materials,
+        Colors,
+        Textures,
+        Lights,
+        Color,
+        NewLightSampler,
+        Environment
+        >
+{
+    return {
+        { params.prims.begin, params.prims.end },
+        params.geometric_normals,
+        params.shading_normals,
+        params.tex_coords,
+        params.materials,
+        params.colors,
+        params.textures,
+        { params.lights.begin, params.lights.end },
+        params.num_bounces,
+        params.epsilon,
+        params.bg_color,
+        params.ambient_color,
+        light_sampler,
+        { params.environment.light, params.environment.index }
+        };
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Add an environment light for rays that leave the scene, e.g.:
+//
+//  auto dist = make_environment_distribution(env_map);
+//  environment_light<float, texture_ref<vec4, 2>> env(texture_ref<vec4, 2>(env_map), dist.ref());
+//  lights.push_back(env);
+//  auto kparams = with_environment_light(make_kernel_params(...), env, lights.size() - 1);
+//
+// light_index is the environment light's index in the param struct's lights, it is needed to
+// weight environment radiance against next event estimation. Pass -1 if the environment light
+// is not sampled with the other lights, its radiance is then only found by BRDF sampling
+//
+
+template <
+    typename NormalBinding,
+    typename ColorBinding,
+    typename Primitives,
+    typename Normals,
+    typename TexCoords,
+    typename Materials,
+    typename Colors,
+    typename Textures,
+    typename Lights,
+    typename Color,
+    typename LightSampler,
+    typename Environment,
+    typename NewEnvironment
+    >
+auto with_environment_light(
+        kernel_params<
+            NormalBinding,
+            ColorBinding,
+            Primitives,
+            Normals,
+            TexCoords,
+            Materials,
+            Colors,
+            Textures,
+            Lights,
+            Color,
+            LightSampler,
+            Environment
+            > const&                params,
+        NewEnvironment const&       environment,
+        int                         light_index = -1
+        )
+    -> kernel_params<
+        NormalBinding,
+        ColorBinding,
+        Primitives,
+        Normals,
+        TexCoords,
+        Materials,
+        Colors,
+        Textures,
+        Lights,
+        Color,
+        LightSampler,
+        NewEnvironment
+        >
+{
+    return {
+        { params.prims.begin, params.prims.end },
+        params.geometric_normals,
+        params.shading_normals,
+        params.tex_coords,
+        params.materials,
+        params.colors,
+        params.textures,
+        { params.lights.begin, params.lights.end },
+        params.num_bounces,
+        params.epsilon,
+        params.bg_color,
+        params.ambient_color,
+        params.light_sampler,
+        { environment, light_index }
         };
 }
 
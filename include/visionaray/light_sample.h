@@ -29,6 +29,10 @@ struct light_sample
 
     // Indicates if sample was generated from a delta light
     simd::mask_type_t<T> delta_light;
+
+    // Indicates if sample was generated from a light at infinity (e.g. an environment
+    // light). Then pos is the direction towards the light and area the sample's solid angle
+    simd::mask_type_t<T> infinite_light;
 };
 
 } // visionaray
@@ -0,0 +1,353 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_LIGHT_SAMPLER_H
+#define VSNRAY_LIGHT_SAMPLER_H 1
+
+#include "detail/macros.h"
+#include "math/aabb.h"
+#include "math/forward.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+#include "area_light.h"
+#include "environment_light.h"
+#include "generic_light.h"
+#include "point_light.h"
+#include "spot_light.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Light samplers
+//
+// Select one light out of many for next event estimation. Samplers implement:
+//
+//  // Pick a light for a shading point with u in [0..1), returns the light index and
+//  // the probability of picking that light
+//  int sample(Lights begin, Lights end, vec3 pos, vec3 normal, float u, float& pdf) const;
+//
+//  // Probability of picking the light with geometry prim_id (e.g. an emissive triangle
+//  // that was hit by a BRDF sample) for a shading point, for MIS
+//  float pdf(Lights begin, Lights end, int prim_id, vec3 pos, vec3 normal) const;
+//
+//  // Probability of picking the light with index light_index for a shading point, e.g. for
+//  // lights w/o geometry like environment lights
+//  float light_pdf(Lights begin, Lights end, int light_index, vec3 pos, vec3 normal) const;
+//
+// uniform_light_sampler:   picks all lights with the same probability
+// power_light_sampler:     picks lights proportional to their emitted power (alias table)
+// light_bvh:               picks lights by power, distance and orientation relative to the
+//                          shading point (light BVH with orientation cones, similar to
+//                          lightcuts and "Importance Sampling of Many Lights", Estevez and
+//                          Kulla 2018)
+//
+// power_light_sampler and light_bvh are built on the host, kernels use their ref()s. Lights
+// are associated with primitives via get_light_bounds().prim_id, light_bvh and
+// power_light_sampler assume that primitive ids are unique. Lights at infinity have no
+// position and power comparable to other lights, power_light_sampler and light_bvh pick
+// them with a fixed probability: each infinite light is picked as often as all other
+// lights together.
+//
+
+
+//-------------------------------------------------------------------------------------------------
+// Spatial and directional bounds and (approximate) power of a light
+//
+
+struct light_bounds
+{
+    // Bounds of the light's geometry
+    aabb    bbox;
+
+    // Light emits to both sides of surfaces with normals within theta_o of +/- axis,
+    // theta_o = pi/2 for lights that emit in all directions
+    vec3    axis;
+    float   theta_o;
+
+    // Luminance of intensity times area, used as the light's weight
+    float   power;
+
+    // Primitive id of the light's geometry, -1 for lights w/o geometry
+    int     prim_id;
+
+    // Light is at infinity (e.g. an environment light), bbox and axis are meaningless
+    bool    infinite;
+};
+
+template <typename T, typename Geometry>
+light_bounds get_light_bounds(area_light<T, Geometry> const& light);
+
+template <typename T>
+light_bounds get_light_bounds(point_light<T> const& light);
+
+template <typename T>
+light_bounds get_light_bounds(spot_light<T> const& light);
+
+template <typename T, typename Texture>
+light_bounds get_light_bounds(environment_light<T, Texture> const& light);
+
+template <typename ...Ts>
+light_bounds get_light_bounds(generic_light<Ts...> const& light);
+
+
+//-------------------------------------------------------------------------------------------------
+// Uniform light sampler, stateless
+//
+
+struct uniform_light_sampler
+{
+    template <typename Lights>
+    VSNRAY_FUNC int sample(
+            Lights          begin,
+            Lights          end,
+            vec3 const&     pos,
+            vec3 const&     normal,
+            float           u,
+            float&          pdf
+            ) const;
+
+    template <typename Lights>
+    VSNRAY_FUNC float pdf(
+            Lights          begin,
+            Lights          end,
+            int             prim_id,
+            vec3 const&     pos,
+            vec3 const&     normal
+            ) const;
+
+    template <typename Lights>
+    VSNRAY_FUNC float light_pdf(
+            Lights          begin,
+            Lights          end,
+            int             light_index,
+            vec3 const&     pos,
+            vec3 const&     normal
+            ) const;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Power light sampler, picks lights with an alias table in O(1)
+//
+
+struct alias_table_entry
+{
+    // Probability to keep the bin's light, otherwise pick alias
+    float   prob;
+    int     alias;
+
+    // Probability to pick the bin's light
+    float   pdf;
+};
+
+class power_light_sampler_ref
+{
+public:
+
+    power_light_sampler_ref() = default;
+
+    VSNRAY_FUNC power_light_sampler_ref(
+            alias_table_entry const*    table,
+            int                         num_lights,
+            int const*                  prim_lights,
+            int                         num_prims
+            );
+
+    template <typename Lights>
+    VSNRAY_FUNC int sample(
+            Lights          begin,
+            Lights          end,
+            vec3 const&     pos,
+            vec3 const&     normal,
+            float           u,
+            float&          pdf
+            ) const;
+
+    template <typename Lights>
+    VSNRAY_FUNC float pdf(
+            Lights          begin,
+            Lights          end,
+            int             prim_id,
+            vec3 const&     pos,
+            vec3 const&     normal
+            ) const;
+
+    template <typename Lights>
+    VSNRAY_FUNC float light_pdf(
+            Lights          begin,
+            Lights          end,
+            int             light_index,
+            vec3 const&     pos,
+            vec3 const&     normal
+            ) const;
+
+private:
+
+    alias_table_entry const*    table_ = nullptr;
+    int                         num_lights_ = 0;
+
+    // Light index per primitive id, -1 for primitives that are not lights
+    int const*                  prim_lights_ = nullptr;
+    int                         num_prims_ = 0;
+
+};
+
+class power_light_sampler
+{
+public:
+
+    using ref_type = power_light_sampler_ref;
+
+public:
+
+    power_light_sampler() = default;
+
+    template <typename Lights>
+    power_light_sampler(Lights begin, Lights end);
+
+    // Build the alias table from the lights' powers
+    template <typename Lights>
+    void build(Lights begin, Lights end);
+
+    ref_type ref() const;
+
+private:
+
+    aligned_vector<alias_table_entry>   table_;
+    aligned_vector<int>                 prim_lights_;
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Light BVH
+//
+// Binary tree over the lights, one light per leaf. Nodes store the lights' combined bounds,
+// orientation cone and power. Lights are sampled by traversing the tree and picking children
+// proportional to their importance for the shading point, the light's pdf is the product of
+// the probabilities along its path
+//
+
+struct light_bvh_node
+{
+    aabb    bbox;
+    vec3    axis;
+    float   theta_o;
+    float   power;
+
+    // Leaf: light index, inner node: index of the first child, children are adjacent
+    int     index;
+    int     parent;
+    int     is_leaf;
+};
+
+class light_bvh_ref
+{
+public:
+
+    light_bvh_ref() = default;
+
+    VSNRAY_FUNC light_bvh_ref(
+            light_bvh_node const*   nodes,
+            int                     num_nodes,
+            int const*              light_leaves,
+            int const*              prim_lights,
+            int                     num_prims,
+            int const*              infinite_lights,
+            int                     num_infinite
+            );
+
+    template <typename Lights>
+    VSNRAY_FUNC int sample(
+            Lights          begin,
+            Lights          end,
+            vec3 const&     pos,
+            vec3 const&     normal,
+            float           u,
+            float&          pdf
+            ) const;
+
+    template <typename Lights>
+    VSNRAY_FUNC float pdf(
+            Lights          begin,
+            Lights          end,
+            int             prim_id,
+            vec3 const&     pos,
+            vec3 const&     normal
+            ) const;
+
+    template <typename Lights>
+    VSNRAY_FUNC float light_pdf(
+            Lights          begin,
+            Lights          end,
+            int             light_index,
+            vec3 const&     pos,
+            vec3 const&     normal
+            ) const;
+
+    // Probability of picking light_index
+    VSNRAY_FUNC float light_pdf(int light_index, vec3 const& pos, vec3 const& normal) const;
+
+    // Probability of picking one of the infinite lights over the tree
+    VSNRAY_FUNC float infinite_prob() const;
+
+    // Probability of picking the first child of an inner node
+    VSNRAY_FUNC float first_child_prob(light_bvh_node const& node, vec3 const& pos, vec3 const& normal) const;
+
+private:
+
+    light_bvh_node const*   nodes_ = nullptr;
+    int                     num_nodes_ = 0;
+
+    // Leaf node index per light, -1 for infinite lights
+    int const*              light_leaves_ = nullptr;
+
+    // Light index per primitive id, -1 for primitives that are not lights
+    int const*              prim_lights_ = nullptr;
+    int                     num_prims_ = 0;
+
+    // Indices of lights at infinity, these are not part of the tree
+    int const*              infinite_lights_ = nullptr;
+    int                     num_infinite_ = 0;
+
+};
+
+class light_bvh
+{
+public:
+
+    using ref_type = light_bvh_ref;
+
+public:
+
+    light_bvh() = default;
+
+    template <typename Lights>
+    light_bvh(Lights begin, Lights end);
+
+    // Build the tree by recursively splitting the lights at the median of the axis
+    // with the largest extent of the lights' centers. Infinite lights are kept aside
+    template <typename Lights>
+    void build(Lights begin, Lights end);
+
+    ref_type ref() const;
+
+    aligned_vector<light_bvh_node> const& nodes() const;
+
+private:
+
+    aligned_vector<light_bvh_node>  nodes_;
+    aligned_vector<int>             light_leaves_;
+    aligned_vector<int>             prim_lights_;
+    aligned_vector<int>             infinite_lights_;
+
+};
+
+} // visionaray
+
+#include "detail/light_sampler.inl"
+
+#endif // VSNRAY_LIGHT_SAMPLER_H
@@ -10,6 +10,7 @@
 
 #include "detail/macros.h"
 #include "pixel_sampler_types.h"
+#include "quasi_random_generator.h"
 #include "random_generator.h"
 
 namespace visionaray
@@ -45,6 +46,48 @@ struct make_generator_impl<T, pixel_sampler::basic_jittered_blend_type<U>>
     using generator_type = random_generator<T>;
 };
 
+template <typename T, typename U>
+struct make_generator_impl<T, pixel_sampler::basic_adaptive_blend_type<U>>
+{
+    using generator_type = random_generator<T>;
+};
+
+template <typename T>
+struct make_generator_impl<T, pixel_sampler::sobol_type>
+{
+    using generator_type = sobol_generator<T>;
+};
+
+template <typename T, typename U>
+struct make_generator_impl<T, pixel_sampler::basic_sobol_blend_type<U>>
+{
+    using generator_type = sobol_generator<T>;
+};
+
+template <typename T>
+struct make_generator_impl<T, pixel_sampler::halton_type>
+{
+    using generator_type = halton_generator<T>;
+};
+
+template <typename T, typename U>
+struct make_generator_impl<T, pixel_sampler::basic_halton_blend_type<U>>
+{
+    using generator_type = halton_generator<T>;
+};
+
+template <typename T>
+struct make_generator_impl<T, pixel_sampler::blue_noise_type>
+{
+    using generator_type = blue_noise_generator<T>;
+};
+
+template <typename T, typename U>
+struct make_generator_impl<T, pixel_sampler::basic_blue_noise_blend_type<U>>
+{
+    using generator_type = blue_noise_generator<T>;
+};
+
 } // detail
 
 
@@ -0,0 +1,73 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+namespace MATH_NAMESPACE
+{
+
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Compute the unit triangle transform
+//
+// The inverse of the matrix with columns e1, e2, n and translation v1. Degenerate triangles
+// get a zero transform so that rays never hit them.
+//
+
+template <typename T, typename P>
+MATH_FUNC
+inline void init_woop_transform(basic_woop_triangle<T, P>& tri)
+{
+    vector<3, T> n = cross(tri.e1, tri.e2);
+    T len = length(n);
+
+    if (len == T(0.0))
+    {
+        tri.m0 = vector<4, T>(T(0.0));
+        tri.m1 = vector<4, T>(T(0.0));
+        tri.m2 = vector<4, T>(T(0.0));
+        return;
+    }
+
+    n /= len;
+
+    // det(e1, e2, n) = dot(cross(e1, e2), n) = len
+    T inv_det = T(1.0) / len;
+
+    vector<3, T> r0 = cross(tri.e2, n) * inv_det;
+    vector<3, T> r1 = cross(n, tri.e1) * inv_det;
+    vector<3, T> r2 = n * inv_det;
+
+    tri.m0 = vector<4, T>(r0, -dot(r0, tri.v1));
+    tri.m1 = vector<4, T>(r1, -dot(r1, tri.v1));
+    tri.m2 = vector<4, T>(r2, -dot(r2, tri.v1));
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Woop triangle members
+//
+
+template <typename T, typename P>
+MATH_FUNC
+basic_woop_triangle<T, P>::basic_woop_triangle(
+        vector<3, T> const& v1,
+        vector<3, T> const& e1,
+        vector<3, T> const& e2
+        )
+    : basic_triangle<3, T, P>(v1, e1, e2)
+{
+    detail::init_woop_transform(*this);
+}
+
+template <typename T, typename P>
+MATH_FUNC
+basic_woop_triangle<T, P>::basic_woop_triangle(basic_triangle<3, T, P> const& tri)
+    : basic_triangle<3, T, P>(tri)
+{
+    detail::init_woop_transform(*this);
+}
+
+} // MATH_NAMESPACE
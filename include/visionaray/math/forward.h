@@ -55,6 +55,9 @@ class basic_sphere;
 template <size_t Dim, typename T, typename P = unsigned>
 class basic_triangle;
 
+template <typename T, typename P = unsigned>
+class basic_woop_triangle;
+
 template <typename Layout, typename T>
 class rectangle;
 
@@ -18,6 +18,7 @@
 #include "sphere.h"
 #include "triangle.h"
 #include "vector.h"
+#include "woop_triangle.h"
 
 namespace MATH_NAMESPACE
 {
@@ -156,6 +157,159 @@ inline hit_record<R, primitive<unsigned>> intersect(R const& ray, basic_triangle
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// ray / Woop triangle
+//
+
+template <typename R, typename U>
+MATH_FUNC
+inline hit_record<R, primitive<unsigned>> intersect(R const& ray, basic_woop_triangle<U, unsigned> const& tri)
+{
+    using T = typename R::scalar_type;
+    using vec_type = vector<3, T>;
+
+    hit_record<R, primitive<unsigned>> result;
+    result.t = T(-1.0);
+
+    // Transform the ray to unit triangle space and intersect with the z = 0 plane
+
+    vec_type r2(tri.m2.xyz());
+    T dz = dot(r2, ray.dir);
+
+    result.hit = ( dz != T(0.0) );
+
+    if ( !any(result.hit) )
+    {
+        return result;
+    }
+
+    T t = -( T(tri.m2.w) + dot(r2, ray.ori) ) / dz;
+
+    vec_type r0(tri.m0.xyz());
+    T b1 = T(tri.m0.w) + dot(r0, ray.ori) + t * dot(r0, ray.dir);
+
+    result.hit &= ( b1 >= T(0.0) && b1 <= T(1.0) );
+
+    if ( !any(result.hit) )
+    {
+        return result;
+    }
+
+    vec_type r1(tri.m1.xyz());
+    T b2 = T(tri.m1.w) + dot(r1, ray.ori) + t * dot(r1, ray.dir);
+
+    result.hit &= ( b2 >= T(0.0) && b1 + b2 <= T(1.0) );
+
+    if ( !any(result.hit) )
+    {
+        return result;
+    }
+
+    result.prim_id = tri.prim_id;
+    result.geom_id = tri.geom_id;
+    result.t = t;
+    result.u = b1;
+    result.v = b2;
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// ray / triangle, watertight
+//
+// Edges that are shared by two triangles are never missed: the test is performed in a ray
+// space where the ray is the z axis, the edge functions are evaluated with the same
+// vertices for both triangles and points exactly on an edge count as hits. The vertices
+// are v1, v1 + e1 and v1 + e2, which are only exactly shared when they were rounded the
+// same way. Use with watertight_intersector.
+//
+// cf. Woop, Benthin, Wald (2013): Watertight Ray/Triangle Intersection
+//
+
+namespace detail
+{
+
+// Permute so that the dominant ray direction component is z
+template <typename T, typename M>
+MATH_FUNC
+inline vector<3, T> permute_max_z(vector<3, T> const& v, M const& kx, M const& ky)
+{
+    return vector<3, T>(
+            select(kx, v.y, select(ky, v.z, v.x)),
+            select(kx, v.z, select(ky, v.x, v.y)),
+            select(kx, v.x, select(ky, v.y, v.z))
+            );
+}
+
+} // detail
+
+template <typename R, typename U>
+MATH_FUNC
+inline hit_record<R, primitive<unsigned>> intersect_watertight(R const& ray, basic_triangle<3, U, unsigned> const& tri)
+{
+    using T = typename R::scalar_type;
+    using vec_type = vector<3, T>;
+
+    hit_record<R, primitive<unsigned>> result;
+    result.t = T(-1.0);
+
+    // Dominant direction: x (kx), y (ky), else z
+    T ax = abs(ray.dir.x);
+    T ay = abs(ray.dir.y);
+    T az = abs(ray.dir.z);
+    auto kx = ax >= ay && ax >= az;
+    auto ky = !kx && ay >= az;
+
+    vec_type dir = detail::permute_max_z(ray.dir, kx, ky);
+
+    // Shear and scale so that the ray direction becomes (0, 0, 1)
+    T sz = T(1.0) / dir.z;
+    T sx = dir.x * sz;
+    T sy = dir.y * sz;
+
+    vec_type v1(tri.v1);
+    vec_type v2(tri.v1 + tri.e1);
+    vec_type v3(tri.v1 + tri.e2);
+
+    vec_type a = detail::permute_max_z(v1 - ray.ori, kx, ky);
+    vec_type b = detail::permute_max_z(v2 - ray.ori, kx, ky);
+    vec_type c = detail::permute_max_z(v3 - ray.ori, kx, ky);
+
+    ax = a.x - sx * a.z;
+    ay = a.y - sy * a.z;
+    T bx = b.x - sx * b.z;
+    T by = b.y - sy * b.z;
+    T cx = c.x - sx * c.z;
+    T cy = c.y - sy * c.z;
+
+    // Scaled barycentric coordinates
+    T u = cx * by - cy * bx;
+    T v = ax * cy - ay * cx;
+    T w = bx * ay - by * ax;
+
+    result.hit = !( (u < T(0.0) || v < T(0.0) || w < T(0.0)) && (u > T(0.0) || v > T(0.0) || w > T(0.0)) );
+
+    T det = u + v + w;
+
+    result.hit &= ( det != T(0.0) );
+
+    if ( !any(result.hit) )
+    {
+        return result;
+    }
+
+    T t = u * (sz * a.z) + v * (sz * b.z) + w * (sz * c.z);
+    T inv_det = T(1.0) / det;
+
+    result.prim_id = tri.prim_id;
+    result.geom_id = tri.geom_id;
+    result.t = t * inv_det;
+    result.u = v * inv_det;
+    result.v = w * inv_det;
+    return result;
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // ray / sphere
 //
@@ -31,5 +31,6 @@
 #include "triangle.h"
 #include "unorm.h"
 #include "vector.h"
+#include "woop_triangle.h"
 
 #endif // VSNRAY_MATH_H
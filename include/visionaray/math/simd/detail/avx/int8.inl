@@ -135,7 +135,7 @@ VSNRAY_FORCE_INLINE int8 operator+(int8 const& v)
 #if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
     return _mm256_add_epi32(_mm256_setzero_si256(), v);
 #else
-    return int8(float8(0.0f) + float8(v));
+    return v;
 #endif
 }
 
@@ -144,7 +144,9 @@ VSNRAY_FORCE_INLINE int8 operator-(int8 const& v)
 #if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
     return _mm256_sub_epi32(_mm256_setzero_si256(), v);
 #else
-    return int8(float8(0.0f) - float8(v));
+    __m128i lo = _mm_sub_epi32(_mm_setzero_si128(), _mm256_castsi256_si128(v));
+    __m128i hi = _mm_sub_epi32(_mm_setzero_si128(), _mm256_extractf128_si256(v, 1));
+    return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
 #endif
 }
 
@@ -153,7 +155,14 @@ VSNRAY_FORCE_INLINE int8 operator+(int8 const& u, int8 const& v)
 #if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
     return _mm256_add_epi32(u, v);
 #else
-    return int8(float8(u) + float8(v));
+    // Integer arithmetic on 128-bit halves, wraps around like AVX2
+    __m128i ulo = _mm256_castsi256_si128(u);
+    __m128i uhi = _mm256_extractf128_si256(u, 1);
+    __m128i vlo = _mm256_castsi256_si128(v);
+    __m128i vhi = _mm256_extractf128_si256(v, 1);
+    __m128i lo  = _mm_add_epi32(ulo, vlo);
+    __m128i hi  = _mm_add_epi32(uhi, vhi);
+    return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
 #endif
 }
 
@@ -162,7 +171,13 @@ VSNRAY_FORCE_INLINE int8 operator-(int8 const& u, int8 const& v)
 #if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
     return _mm256_sub_epi32(u, v);
 #else
-    return int8(float8(u) - float8(v));
+    __m128i ulo = _mm256_castsi256_si128(u);
+    __m128i uhi = _mm256_extractf128_si256(u, 1);
+    __m128i vlo = _mm256_castsi256_si128(v);
+    __m128i vhi = _mm256_extractf128_si256(v, 1);
+    __m128i lo  = _mm_sub_epi32(ulo, vlo);
+    __m128i hi  = _mm_sub_epi32(uhi, vhi);
+    return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
 #endif
 }
 
@@ -171,7 +186,13 @@ VSNRAY_FORCE_INLINE int8 operator*(int8 const& u, int8 const& v)
 #if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
     return _mm256_mullo_epi32(u, v);
 #else
-    return int8(float8(u) * float8(v));
+    __m128i ulo = _mm256_castsi256_si128(u);
+    __m128i uhi = _mm256_extractf128_si256(u, 1);
+    __m128i vlo = _mm256_castsi256_si128(v);
+    __m128i vhi = _mm256_extractf128_si256(v, 1);
+    __m128i lo  = _mm_mullo_epi32(ulo, vlo);
+    __m128i hi  = _mm_mullo_epi32(uhi, vhi);
+    return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
 #endif
 }
 
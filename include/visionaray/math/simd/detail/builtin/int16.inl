@@ -204,6 +204,8 @@ VSNRAY_FORCE_INLINE int const& get(int16 const& v)
 //-------------------------------------------------------------------------------------------------
 // Basic arithmethic
 //
+// Computed with unsigned ints so that results wrap around like with the SIMD intrinsics
+//
 
 MATH_FUNC
 VSNRAY_FORCE_INLINE int16 operator+(int16 const& v)
@@ -255,22 +257,22 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int16 operator+(int16 const& u, int16 const& v)
 {
     return int16(
-            u.value[ 0] + v.value[ 0],
-            u.value[ 1] + v.value[ 1],
-            u.value[ 2] + v.value[ 2],
-            u.value[ 3] + v.value[ 3],
-            u.value[ 4] + v.value[ 4],
-            u.value[ 5] + v.value[ 5],
-            u.value[ 6] + v.value[ 6],
-            u.value[ 7] + v.value[ 7],
-            u.value[ 8] + v.value[ 8],
-            u.value[ 9] + v.value[ 9],
-            u.value[10] + v.value[10],
-            u.value[11] + v.value[11],
-            u.value[12] + v.value[12],
-            u.value[13] + v.value[13],
-            u.value[14] + v.value[14],
-            u.value[15] + v.value[15]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) + static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) + static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) + static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) + static_cast<unsigned>(v.value[3])),
+            static_cast<int>(static_cast<unsigned>(u.value[4]) + static_cast<unsigned>(v.value[4])),
+            static_cast<int>(static_cast<unsigned>(u.value[5]) + static_cast<unsigned>(v.value[5])),
+            static_cast<int>(static_cast<unsigned>(u.value[6]) + static_cast<unsigned>(v.value[6])),
+            static_cast<int>(static_cast<unsigned>(u.value[7]) + static_cast<unsigned>(v.value[7])),
+            static_cast<int>(static_cast<unsigned>(u.value[8]) + static_cast<unsigned>(v.value[8])),
+            static_cast<int>(static_cast<unsigned>(u.value[9]) + static_cast<unsigned>(v.value[9])),
+            static_cast<int>(static_cast<unsigned>(u.value[10]) + static_cast<unsigned>(v.value[10])),
+            static_cast<int>(static_cast<unsigned>(u.value[11]) + static_cast<unsigned>(v.value[11])),
+            static_cast<int>(static_cast<unsigned>(u.value[12]) + static_cast<unsigned>(v.value[12])),
+            static_cast<int>(static_cast<unsigned>(u.value[13]) + static_cast<unsigned>(v.value[13])),
+            static_cast<int>(static_cast<unsigned>(u.value[14]) + static_cast<unsigned>(v.value[14])),
+            static_cast<int>(static_cast<unsigned>(u.value[15]) + static_cast<unsigned>(v.value[15]))
             );
 }
 
@@ -278,22 +280,22 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int16 operator-(int16 const& u, int16 const& v)
 {
     return int16(
-            u.value[ 0] - v.value[ 0],
-            u.value[ 1] - v.value[ 1],
-            u.value[ 2] - v.value[ 2],
-            u.value[ 3] - v.value[ 3],
-            u.value[ 4] - v.value[ 4],
-            u.value[ 5] - v.value[ 5],
-            u.value[ 6] - v.value[ 6],
-            u.value[ 7] - v.value[ 7],
-            u.value[ 8] - v.value[ 8],
-            u.value[ 9] - v.value[ 9],
-            u.value[10] - v.value[10],
-            u.value[11] - v.value[11],
-            u.value[12] - v.value[12],
-            u.value[13] - v.value[13],
-            u.value[14] - v.value[14],
-            u.value[15] - v.value[15]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) - static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) - static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) - static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) - static_cast<unsigned>(v.value[3])),
+            static_cast<int>(static_cast<unsigned>(u.value[4]) - static_cast<unsigned>(v.value[4])),
+            static_cast<int>(static_cast<unsigned>(u.value[5]) - static_cast<unsigned>(v.value[5])),
+            static_cast<int>(static_cast<unsigned>(u.value[6]) - static_cast<unsigned>(v.value[6])),
+            static_cast<int>(static_cast<unsigned>(u.value[7]) - static_cast<unsigned>(v.value[7])),
+            static_cast<int>(static_cast<unsigned>(u.value[8]) - static_cast<unsigned>(v.value[8])),
+            static_cast<int>(static_cast<unsigned>(u.value[9]) - static_cast<unsigned>(v.value[9])),
+            static_cast<int>(static_cast<unsigned>(u.value[10]) - static_cast<unsigned>(v.value[10])),
+            static_cast<int>(static_cast<unsigned>(u.value[11]) - static_cast<unsigned>(v.value[11])),
+            static_cast<int>(static_cast<unsigned>(u.value[12]) - static_cast<unsigned>(v.value[12])),
+            static_cast<int>(static_cast<unsigned>(u.value[13]) - static_cast<unsigned>(v.value[13])),
+            static_cast<int>(static_cast<unsigned>(u.value[14]) - static_cast<unsigned>(v.value[14])),
+            static_cast<int>(static_cast<unsigned>(u.value[15]) - static_cast<unsigned>(v.value[15]))
             );
 }
 
@@ -301,22 +303,22 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int16 operator*(int16 const& u, int16 const& v)
 {
     return int16(
-            u.value[ 0] * v.value[ 0],
-            u.value[ 1] * v.value[ 1],
-            u.value[ 2] * v.value[ 2],
-            u.value[ 3] * v.value[ 3],
-            u.value[ 4] * v.value[ 4],
-            u.value[ 5] * v.value[ 5],
-            u.value[ 6] * v.value[ 6],
-            u.value[ 7] * v.value[ 7],
-            u.value[ 8] * v.value[ 8],
-            u.value[ 9] * v.value[ 9],
-            u.value[10] * v.value[10],
-            u.value[11] * v.value[11],
-            u.value[12] * v.value[12],
-            u.value[13] * v.value[13],
-            u.value[14] * v.value[14],
-            u.value[15] * v.value[15]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) * static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) * static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) * static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) * static_cast<unsigned>(v.value[3])),
+            static_cast<int>(static_cast<unsigned>(u.value[4]) * static_cast<unsigned>(v.value[4])),
+            static_cast<int>(static_cast<unsigned>(u.value[5]) * static_cast<unsigned>(v.value[5])),
+            static_cast<int>(static_cast<unsigned>(u.value[6]) * static_cast<unsigned>(v.value[6])),
+            static_cast<int>(static_cast<unsigned>(u.value[7]) * static_cast<unsigned>(v.value[7])),
+            static_cast<int>(static_cast<unsigned>(u.value[8]) * static_cast<unsigned>(v.value[8])),
+            static_cast<int>(static_cast<unsigned>(u.value[9]) * static_cast<unsigned>(v.value[9])),
+            static_cast<int>(static_cast<unsigned>(u.value[10]) * static_cast<unsigned>(v.value[10])),
+            static_cast<int>(static_cast<unsigned>(u.value[11]) * static_cast<unsigned>(v.value[11])),
+            static_cast<int>(static_cast<unsigned>(u.value[12]) * static_cast<unsigned>(v.value[12])),
+            static_cast<int>(static_cast<unsigned>(u.value[13]) * static_cast<unsigned>(v.value[13])),
+            static_cast<int>(static_cast<unsigned>(u.value[14]) * static_cast<unsigned>(v.value[14])),
+            static_cast<int>(static_cast<unsigned>(u.value[15]) * static_cast<unsigned>(v.value[15]))
             );
 }
 
@@ -444,22 +446,22 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int16 operator<<(int16 const& a, int count)
 {
     return int16(
-            a.value[ 0] << count,
-            a.value[ 1] << count,
-            a.value[ 2] << count,
-            a.value[ 3] << count,
-            a.value[ 4] << count,
-            a.value[ 5] << count,
-            a.value[ 6] << count,
-            a.value[ 7] << count,
-            a.value[ 8] << count,
-            a.value[ 9] << count,
-            a.value[10] << count,
-            a.value[11] << count,
-            a.value[12] << count,
-            a.value[13] << count,
-            a.value[14] << count,
-            a.value[15] << count
+            static_cast<int>(static_cast<unsigned>(a.value[0]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[1]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[2]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[3]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[4]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[5]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[6]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[7]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[8]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[9]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[10]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[11]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[12]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[13]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[14]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[15]) << count)
             );
 }
 
@@ -131,6 +131,8 @@ VSNRAY_FORCE_INLINE int const& get(int4 const& v)
 //-------------------------------------------------------------------------------------------------
 // Basic arithmethic
 //
+// Computed with unsigned ints so that results wrap around like with the SIMD intrinsics
+//
 
 MATH_FUNC
 VSNRAY_FORCE_INLINE int4 operator+(int4 const& v)
@@ -158,10 +160,10 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int4 operator+(int4 const& u, int4 const& v)
 {
     return int4(
-            u.value[0] + v.value[0],
-            u.value[1] + v.value[1],
-            u.value[2] + v.value[2],
-            u.value[3] + v.value[3]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) + static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) + static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) + static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) + static_cast<unsigned>(v.value[3]))
             );
 }
 
@@ -169,10 +171,10 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int4 operator-(int4 const& u, int4 const& v)
 {
     return int4(
-            u.value[0] - v.value[0],
-            u.value[1] - v.value[1],
-            u.value[2] - v.value[2],
-            u.value[3] - v.value[3]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) - static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) - static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) - static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) - static_cast<unsigned>(v.value[3]))
             );
 }
 
@@ -180,10 +182,10 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int4 operator*(int4 const& u, int4 const& v)
 {
     return int4(
-            u.value[0] * v.value[0],
-            u.value[1] * v.value[1],
-            u.value[2] * v.value[2],
-            u.value[3] * v.value[3]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) * static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) * static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) * static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) * static_cast<unsigned>(v.value[3]))
             );
 }
 
@@ -251,10 +253,10 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int4 operator<<(int4 const& a, int count)
 {
     return int4(
-            a.value[0] << count,
-            a.value[1] << count,
-            a.value[2] << count,
-            a.value[3] << count
+            static_cast<int>(static_cast<unsigned>(a.value[0]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[1]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[2]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[3]) << count)
             );
 }
 
@@ -158,6 +158,8 @@ VSNRAY_FORCE_INLINE int const& get(int8 const& v)
 //-------------------------------------------------------------------------------------------------
 // Basic arithmethic
 //
+// Computed with unsigned ints so that results wrap around like with the SIMD intrinsics
+//
 
 MATH_FUNC
 VSNRAY_FORCE_INLINE int8 operator+(int8 const& v)
@@ -193,14 +195,14 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int8 operator+(int8 const& u, int8 const& v)
 {
     return int8(
-            u.value[0] + v.value[0],
-            u.value[1] + v.value[1],
-            u.value[2] + v.value[2],
-            u.value[3] + v.value[3],
-            u.value[4] + v.value[4],
-            u.value[5] + v.value[5],
-            u.value[6] + v.value[6],
-            u.value[7] + v.value[7]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) + static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) + static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) + static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) + static_cast<unsigned>(v.value[3])),
+            static_cast<int>(static_cast<unsigned>(u.value[4]) + static_cast<unsigned>(v.value[4])),
+            static_cast<int>(static_cast<unsigned>(u.value[5]) + static_cast<unsigned>(v.value[5])),
+            static_cast<int>(static_cast<unsigned>(u.value[6]) + static_cast<unsigned>(v.value[6])),
+            static_cast<int>(static_cast<unsigned>(u.value[7]) + static_cast<unsigned>(v.value[7]))
             );
 }
 
@@ -208,14 +210,14 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int8 operator-(int8 const& u, int8 const& v)
 {
     return int8(
-            u.value[0] - v.value[0],
-            u.value[1] - v.value[1],
-            u.value[2] - v.value[2],
-            u.value[3] - v.value[3],
-            u.value[4] - v.value[4],
-            u.value[5] - v.value[5],
-            u.value[6] - v.value[6],
-            u.value[7] - v.value[7]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) - static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) - static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) - static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) - static_cast<unsigned>(v.value[3])),
+            static_cast<int>(static_cast<unsigned>(u.value[4]) - static_cast<unsigned>(v.value[4])),
+            static_cast<int>(static_cast<unsigned>(u.value[5]) - static_cast<unsigned>(v.value[5])),
+            static_cast<int>(static_cast<unsigned>(u.value[6]) - static_cast<unsigned>(v.value[6])),
+            static_cast<int>(static_cast<unsigned>(u.value[7]) - static_cast<unsigned>(v.value[7]))
             );
 }
 
@@ -223,14 +225,14 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int8 operator*(int8 const& u, int8 const& v)
 {
     return int8(
-            u.value[0] * v.value[0],
-            u.value[1] * v.value[1],
-            u.value[2] * v.value[2],
-            u.value[3] * v.value[3],
-            u.value[4] * v.value[4],
-            u.value[5] * v.value[5],
-            u.value[6] * v.value[6],
-            u.value[7] * v.value[7]
+            static_cast<int>(static_cast<unsigned>(u.value[0]) * static_cast<unsigned>(v.value[0])),
+            static_cast<int>(static_cast<unsigned>(u.value[1]) * static_cast<unsigned>(v.value[1])),
+            static_cast<int>(static_cast<unsigned>(u.value[2]) * static_cast<unsigned>(v.value[2])),
+            static_cast<int>(static_cast<unsigned>(u.value[3]) * static_cast<unsigned>(v.value[3])),
+            static_cast<int>(static_cast<unsigned>(u.value[4]) * static_cast<unsigned>(v.value[4])),
+            static_cast<int>(static_cast<unsigned>(u.value[5]) * static_cast<unsigned>(v.value[5])),
+            static_cast<int>(static_cast<unsigned>(u.value[6]) * static_cast<unsigned>(v.value[6])),
+            static_cast<int>(static_cast<unsigned>(u.value[7]) * static_cast<unsigned>(v.value[7]))
             );
 }
 
@@ -318,14 +320,14 @@ MATH_FUNC
 VSNRAY_FORCE_INLINE int8 operator<<(int8 const& a, int count)
 {
     return int8(
-            a.value[0] << count,
-            a.value[1] << count,
-            a.value[2] << count,
-            a.value[3] << count,
-            a.value[4] << count,
-            a.value[5] << count,
-            a.value[6] << count,
-            a.value[7] << count
+            static_cast<int>(static_cast<unsigned>(a.value[0]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[1]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[2]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[3]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[4]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[5]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[6]) << count),
+            static_cast<int>(static_cast<unsigned>(a.value[7]) << count)
             );
 }
 
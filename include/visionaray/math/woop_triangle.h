@@ -0,0 +1,65 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_MATH_WOOP_TRIANGLE_H
+#define VSNRAY_MATH_WOOP_TRIANGLE_H 1
+
+#include "config.h"
+#include "triangle.h"
+#include "vector.h"
+
+namespace MATH_NAMESPACE
+{
+
+//-------------------------------------------------------------------------------------------------
+// Triangle with a precomputed transform to unit triangle space
+//
+// Stores the affine transform that maps the triangle to the unit triangle (0,0,0), (1,0,0),
+// (0,1,0) in addition to the vertex and edges of basic_triangle. Ray / triangle intersection
+// transforms the ray with the three rows and needs no cross products. Can be used with the
+// same functions as basic_triangle (bounds, normals, SBVH splits, ...). Triangles convert
+// implicitly, so BVHs can be built from a triangle list directly:
+//
+//  auto bvh = builder.build(index_bvh<basic_woop_triangle<float>>{}, tris.data(), tris.size());
+//
+// or converted from an existing triangle BVH:
+//
+//  index_bvh<basic_woop_triangle<float>> woop_bvh(bvh);
+//
+// cf. Woop (2004): A Ray Tracing Hardware Architecture for Dynamic Scenes
+//
+
+template <typename T, typename P>
+class basic_woop_triangle : public basic_triangle<3, T, P>
+{
+public:
+
+    using scalar_type = T;
+    using vec_type    = vector<3, T>;
+
+public:
+
+    basic_woop_triangle() = default;
+    MATH_FUNC basic_woop_triangle(
+            vector<3, T> const& v1,
+            vector<3, T> const& e1,
+            vector<3, T> const& e2
+            );
+
+    // Convert from triangle, keeps prim_id and geom_id
+    MATH_FUNC basic_woop_triangle(basic_triangle<3, T, P> const& tri);
+
+    // Rows of the world to unit triangle space transform, (x, y, z) * p + w
+    vector<4, T> m0;
+    vector<4, T> m1;
+    vector<4, T> m2;
+
+};
+
+} // MATH_NAMESPACE
+
+#include "detail/woop_triangle.inl"
+
+#endif // VSNRAY_MATH_WOOP_TRIANGLE_H
@@ -45,6 +45,23 @@ inline unsigned morton_encode3D(unsigned x, unsigned y, unsigned z)
     return separate_bits(x) | (separate_bits(y) << 1) | (separate_bits(z) << 2); 
 }
 
+VSNRAY_FUNC
+inline unsigned long long morton_encode3D_64(unsigned x, unsigned y, unsigned z)
+{
+    auto separate_bits = [](unsigned long long n)
+    {
+        n &= 0x00000000001FFFFFULL;
+        n = (n ^ (n << 32)) & 0x001F00000000FFFFULL;
+        n = (n ^ (n << 16)) & 0x001F0000FF0000FFULL;
+        n = (n ^ (n <<  8)) & 0x100F00F00F00F00FULL;
+        n = (n ^ (n <<  4)) & 0x10C30C30C30C30C3ULL;
+        n = (n ^ (n <<  2)) & 0x1249249249249249ULL;
+        return n;
+    };
+
+    return separate_bits(x) | (separate_bits(y) << 1) | (separate_bits(z) << 2);
+}
+
 VSNRAY_FUNC
 inline vec2ui morton_decode2D(unsigned index)
 {
@@ -77,6 +94,23 @@ inline vec3ui morton_decode3D(unsigned index)
     return { compact_bits(index), compact_bits(index >> 1), compact_bits(index >> 2) };
 }
 
+VSNRAY_FUNC
+inline vec3ui morton_decode3D_64(unsigned long long index)
+{
+    auto compact_bits = [](unsigned long long n)
+    {
+        n &= 0x1249249249249249ULL;
+        n = (n ^ (n >>  2)) & 0x10C30C30C30C30C3ULL;
+        n = (n ^ (n >>  4)) & 0x100F00F00F00F00FULL;
+        n = (n ^ (n >>  8)) & 0x001F0000FF0000FFULL;
+        n = (n ^ (n >> 16)) & 0x001F00000000FFFFULL;
+        n = (n ^ (n >> 32)) & 0x00000000001FFFFFULL;
+        return static_cast<unsigned>(n);
+    };
+
+    return { compact_bits(index), compact_bits(index >> 1), compact_bits(index >> 2) };
+}
+
 } // visionaray
 
 #endif // VSNRAY_MORTON_H
@@ -9,6 +9,8 @@
 namespace visionaray
 {
 
+struct pixel_stats;
+
 //-------------------------------------------------------------------------------------------------
 // Pixel sampler types for use in scheduler params
 //
@@ -53,6 +55,49 @@ struct basic_jittered_blend_type : jittered_type
 
 using jittered_blend_type = basic_jittered_blend_type<float>;
 
+// Jittered and adaptive blending. Each pixel accumulates samples until the estimated relative
+// error of its mean drops below max_error, after at least min_samples samples. The per-pixel
+// statistics are kept in stats (e.g. cpu_buffer_rt::stats()), converged pixels are skipped
+template <typename T>
+struct basic_adaptive_blend_type : jittered_type
+{
+    pixel_stats* stats;
+    T max_error;
+    unsigned min_samples;
+};
+
+using adaptive_blend_type = basic_adaptive_blend_type<float>;
+
+
+// Low-discrepancy pixel samplers -------------------------
+//
+// Jittered pixel positions and all further numbers that the kernel draws with gen.next()
+// are the dimensions of one low-discrepancy sample point per pixel and frame
+//
+
+// Owen-scrambled Sobol sequence
+struct sobol_type : jittered_type {};
+
+// Halton sequence, randomly rotated per pixel
+struct halton_type : jittered_type {};
+
+// Rank-1 lattice, shifted per pixel with a blue-noise mask
+struct blue_noise_type : jittered_type {};
+
+// Low-discrepancy sampling and successive blending
+template <typename T>
+struct basic_sobol_blend_type : basic_jittered_blend_type<T> {};
+
+template <typename T>
+struct basic_halton_blend_type : basic_jittered_blend_type<T> {};
+
+template <typename T>
+struct basic_blue_noise_blend_type : basic_jittered_blend_type<T> {};
+
+using sobol_blend_type = basic_sobol_blend_type<float>;
+using halton_blend_type = basic_halton_blend_type<float>;
+using blue_noise_blend_type = basic_blue_noise_blend_type<float>;
+
 } // pixel_sampler
 } // visionaray
 
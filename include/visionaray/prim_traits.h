@@ -11,6 +11,7 @@
 #include <visionaray/math/plane.h>
 #include <visionaray/math/sphere.h>
 #include <visionaray/math/triangle.h>
+#include <visionaray/math/woop_triangle.h>
 
 #include <visionaray/tags.h>
 
@@ -75,6 +76,12 @@ struct scalar_type<basic_triangle<Dim, T, P>>
     using type = T;
 };
 
+template <typename T, typename P>
+struct scalar_type<basic_woop_triangle<T, P>>
+{
+    using type = T;
+};
+
 //-------------------------------------------------------------------------------------------------
 // Number of vertices
 //
@@ -95,6 +102,12 @@ struct num_vertices<basic_triangle<Dim, T, P>>
     enum { value = 3 };
 };
 
+template <typename T, typename P>
+struct num_vertices<basic_woop_triangle<T, P>>
+{
+    enum { value = 3 };
+};
+
 
 //-------------------------------------------------------------------------------------------------
 // Number of precalculated normals
@@ -122,6 +135,18 @@ struct num_normals<basic_triangle<Dim, T, P>, normals_per_vertex_binding>
     enum { value = 3 };
 };
 
+template <typename T, typename P>
+struct num_normals<basic_woop_triangle<T, P>, normals_per_face_binding>
+{
+    enum { value = 1 };
+};
+
+template <typename T, typename P>
+struct num_normals<basic_woop_triangle<T, P>, normals_per_vertex_binding>
+{
+    enum { value = 3 };
+};
+
 
 //-------------------------------------------------------------------------------------------------
 // Number of texture coordinates
@@ -143,6 +168,12 @@ struct num_tex_coords<basic_triangle<Dim, T, P>>
     enum { value = 3 };
 };
 
+template <typename T, typename P>
+struct num_tex_coords<basic_woop_triangle<T, P>>
+{
+    enum { value = 3 };
+};
+
 } // visionaray
 
 #endif // VSNRAY_PRIM_TRAITS_H
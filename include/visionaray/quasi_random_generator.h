@@ -0,0 +1,455 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_QUASI_RANDOM_GENERATOR_H
+#define VSNRAY_QUASI_RANDOM_GENERATOR_H 1
+
+#include <cstddef>
+#include <type_traits>
+
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+#include "math/array.h"
+#include "morton.h"
+#include "packet_traits.h"
+#include "random_generator.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Bit manipulation helpers, I is either unsigned or a SIMD int vector
+//
+
+// 32-bit constant, also for signed SIMD ints
+template <typename I>
+VSNRAY_FUNC
+inline I bits32(unsigned u)
+{
+    return I(static_cast<int>(u));
+}
+
+// Mask after shifting as SIMD int shifts may be arithmetic
+template <typename I>
+VSNRAY_FUNC
+inline I reverse_bits(I x)
+{
+    x = ((x >>  1) & I(0x55555555)) | ((x & I(0x55555555)) <<  1);
+    x = ((x >>  2) & I(0x33333333)) | ((x & I(0x33333333)) <<  2);
+    x = ((x >>  4) & I(0x0F0F0F0F)) | ((x & I(0x0F0F0F0F)) <<  4);
+    x = ((x >>  8) & I(0x00FF00FF)) | ((x & I(0x00FF00FF)) <<  8);
+    x = ((x >> 16) & I(0x0000FFFF)) |  (x << 16);
+    return x;
+}
+
+template <typename I>
+VSNRAY_FUNC
+inline I hash_combine(I seed, I value)
+{
+    return hash32(seed ^ (hash32(value) + bits32<I>(0x9E3779B9u)));
+}
+
+// Owen scrambling of the bits of x, interpreted as a binary fraction
+//
+// cf. Burley (2020): Practical Hash-based Owen Scrambling
+template <typename I>
+VSNRAY_FUNC
+inline I nested_uniform_scramble(I x, I seed)
+{
+    x = reverse_bits(x);
+
+    // Laine-Karras style permutation, bit i only depends on bits [0..i]
+    x = x + seed;
+    x = x ^ (x * bits32<I>(0x6C50B47Cu));
+    x = x ^ (x * bits32<I>(0xB82F1E52u));
+    x = x ^ (x * bits32<I>(0xC7AFE638u));
+    x = x ^ (x * bits32<I>(0x8D22F6E6u));
+
+    return reverse_bits(x);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Sequences for quasi_random_generator
+//
+// key():    per-pixel key, computed once
+// sample(): 32-bit fixed point sample in [0,1) for sample index, dimension and key
+//
+
+// Owen-scrambled Sobol sequence, dimensions are padded from shuffled 2D Sobol points
+struct sobol_sequence
+{
+    VSNRAY_FUNC
+    static unsigned key(unsigned x, unsigned y)
+    {
+        return hash_combine(hash32(x), y);
+    }
+
+    // Second Sobol dimension (primitive polynomial x + 1)
+    template <typename I>
+    VSNRAY_FUNC
+    static I sobol_dim1(I index)
+    {
+        I result(0);
+        unsigned v = 0x80000000u;
+
+        for (int i = 0; i < 32; ++i)
+        {
+            I bit = (index >> i) & I(1);
+            result = result ^ (bits32<I>(v) & (I(0) - bit));
+            v ^= v >> 1;
+        }
+
+        return result;
+    }
+
+    template <typename I>
+    VSNRAY_FUNC
+    static I sample(I index, I dim, I key)
+    {
+        I pair = (dim >> 1) & I(0x7FFFFFFF);
+        I comp = dim & I(1);
+
+        // Each dimension pair has its own shuffled index and scrambling
+        I pair_key = hash_combine(key, pair);
+        I i = nested_uniform_scramble(index, pair_key);
+
+        I x0 = reverse_bits(i);
+        I x1 = sobol_dim1(i);
+        I x = x0 ^ ((x0 ^ x1) & (I(0) - comp));
+
+        return nested_uniform_scramble(x, hash_combine(pair_key, comp + I(1)));
+    }
+};
+
+// Halton sequence with per-pixel Cranley-Patterson rotation
+struct halton_sequence
+{
+    enum { NumBases = 32 };
+
+    VSNRAY_FUNC
+    static unsigned key(unsigned x, unsigned y)
+    {
+        return hash_combine(hash32(x), y);
+    }
+
+    VSNRAY_FUNC
+    static unsigned sample(unsigned index, unsigned dim, unsigned key)
+    {
+        unsigned const primes[NumBases] = {
+              2,   3,   5,   7,  11,  13,  17,  19,  23,  29,  31,  37,  41,  43,  47,  53,
+             59,  61,  67,  71,  73,  79,  83,  89,  97, 101, 103, 107, 109, 113, 127, 131
+            };
+
+        unsigned base = primes[dim % NumBases];
+
+        // Radical inverse
+        float inv_base = 1.0f / base;
+        float f = inv_base;
+        float r = 0.0f;
+
+        for (unsigned n = index; n > 0; n /= base)
+        {
+            r += (n % base) * f;
+            f *= inv_base;
+        }
+
+        unsigned bits = static_cast<unsigned>(r * 16777216.0f) << 8;
+
+        return bits + hash_combine(key, dim);
+    }
+
+    // Digit expansion with runtime bases, computed per lane
+    template <typename I>
+    VSNRAY_FUNC
+    static I sample(I index, I dim, I key)
+    {
+        using int_array = simd::aligned_array_t<I>;
+
+        int_array indices;
+        int_array dims;
+        int_array keys;
+
+        store(indices, index);
+        store(dims, dim);
+        store(keys, key);
+
+        for (int i = 0; i < simd::num_elements<I>::value; ++i)
+        {
+            indices[i] = static_cast<int>(sample(
+                    static_cast<unsigned>(indices[i]),
+                    static_cast<unsigned>(dims[i]),
+                    static_cast<unsigned>(keys[i])
+                    ));
+        }
+
+        return I(indices);
+    }
+};
+
+// Rank-1 lattice sequence, shifted per pixel so that the error is distributed as blue noise
+// in screen space. Pixels are ordered hierarchically (Morton order), consecutive pixels get
+// shifts that are well distributed in all dimensions, e.g. every 2x2 block is stratified
+//
+// Rank-1 lattice: Cools, Kuo, Nuyens (2006): Constructing Embedded Lattice Rules for
+// Multivariate Integration
+// Pixel ordering: Ahmed, Wonka (2020): Screen-Space Blue-Noise Diffusion of Monte Carlo
+// Sampling Error via Hierarchical Ordering of Pixels
+struct blue_noise_sequence
+{
+    enum { NumDims = 32 };
+
+    // Position of the pixel in Morton order, as binary fraction
+    VSNRAY_FUNC
+    static unsigned key(unsigned x, unsigned y)
+    {
+        return reverse_bits(morton_encode2D(x, y));
+    }
+
+    VSNRAY_FUNC
+    static unsigned generating_vector(unsigned dim)
+    {
+        unsigned const g[NumDims] = {
+                 1, 182667, 469891, 498753, 110745, 446247, 250185, 118627,
+            245333, 283199, 408519, 391023, 246327, 126539, 399185, 461527,
+            300343,  69681, 516695, 436179, 106383, 238523, 413283,  70841,
+             47719, 300129, 113029, 123925, 410745, 211325,  17489, 511893
+            };
+
+        return g[dim % NumDims];
+    }
+
+    template <typename I>
+    VSNRAY_FUNC
+    static I generating_vector(I dim)
+    {
+        using int_array = simd::aligned_array_t<I>;
+
+        int_array dims;
+        store(dims, dim);
+
+        for (int i = 0; i < simd::num_elements<I>::value; ++i)
+        {
+            dims[i] = static_cast<int>(generating_vector(static_cast<unsigned>(dims[i])));
+        }
+
+        return I(dims);
+    }
+
+    template <typename I>
+    VSNRAY_FUNC
+    static I sample(I index, I dim, I key)
+    {
+        // Lattice points over the pixels, with a different generating vector than over
+        // the samples of each pixel
+        I shift_bits = key * generating_vector(dim + I(NumDims / 2)) + hash32(dim);
+
+        return reverse_bits(index) * generating_vector(dim) + shift_bits;
+    }
+};
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// quasi_random_generator classes
+//
+// Return the dimensions of one low-discrepancy sample point per call to next(). The sample
+// index is usually the frame number, the pixel decorrelates the sequences of neighboring
+// pixels. Kernels draw dimensions for each bounce with next(), just like with
+// random_generator.
+//
+// A non-zero seed rotates each dimension of the sequence (Cranley-Patterson rotation), so
+// that renders with different seeds are decorrelated.
+//
+// SIMD generators are constructed with the position of the upper left pixel of the
+// packet, lanes are laid out like with expand_pixel.
+//
+
+template <typename T, typename Sequence, typename = void>
+class quasi_random_generator
+{
+public:
+
+    using value_type = T;
+
+public:
+
+    quasi_random_generator() = default;
+
+    VSNRAY_FUNC quasi_random_generator(int x, int y, unsigned sample_index, unsigned seed = 0)
+        : key_(Sequence::key(static_cast<unsigned>(x), static_cast<unsigned>(y)))
+        , index_(sample_index)
+        , dim_(0)
+        , seed_(seed)
+    {
+    }
+
+    VSNRAY_FUNC T next()
+    {
+        unsigned dim = dim_++;
+        unsigned bits = Sequence::sample(index_, dim, key_);
+
+        if (seed_ != 0)
+        {
+            bits += detail::hash_combine(seed_, dim);
+        }
+
+        return detail::uniform_from_bits<T>(bits);
+    }
+
+private:
+
+    unsigned key_ = 0;
+    unsigned index_ = 0;
+    unsigned dim_ = 0;
+    unsigned seed_ = 0;
+
+};
+
+template <typename T, typename Sequence>
+class quasi_random_generator<T, Sequence, typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+{
+public:
+
+    using value_type = T;
+    using int_type   = simd::int_type_t<T>;
+    using int_array  = simd::aligned_array_t<int_type>;
+
+    // Scalar view of one lane, shares the lane's dimension
+    class lane_generator
+    {
+    public:
+
+        using value_type = float;
+
+    public:
+
+        lane_generator() = default;
+
+        VSNRAY_FUNC lane_generator(int* key, int* index, int* dim, unsigned seed)
+            : key_(key)
+            , index_(index)
+            , dim_(dim)
+            , seed_(seed)
+        {
+        }
+
+        VSNRAY_FUNC float next()
+        {
+            unsigned dim = static_cast<unsigned>((*dim_)++);
+            unsigned bits = Sequence::sample(
+                    static_cast<unsigned>(*index_),
+                    dim,
+                    static_cast<unsigned>(*key_)
+                    );
+
+            if (seed_ != 0)
+            {
+                bits += detail::hash_combine(seed_, dim);
+            }
+
+            return detail::uniform_from_bits<float>(bits);
+        }
+
+    private:
+
+        int* key_ = nullptr;
+        int* index_ = nullptr;
+        int* dim_ = nullptr;
+        unsigned seed_ = 0;
+
+    };
+
+public:
+
+    typedef lane_generator generator_type;
+
+    VSNRAY_FUNC quasi_random_generator(int x, int y, unsigned sample_index, unsigned seed = 0)
+        : seed_(seed)
+    {
+        int w = packet_size<T>::w;
+
+        for (int i = 0; i < simd::num_elements<T>::value; ++i)
+        {
+            keys_[i] = static_cast<int>(Sequence::key(
+                    static_cast<unsigned>(x + i % w),
+                    static_cast<unsigned>(y + i / w)
+                    ));
+            indices_[i] = static_cast<int>(sample_index);
+            dims_[i] = 0;
+        }
+    }
+
+    VSNRAY_FUNC value_type next()
+    {
+        int_type dim(dims_);
+
+        store(dims_, dim + int_type(1));
+
+        int_type bits = Sequence::sample(int_type(indices_), dim, int_type(keys_));
+
+        if (seed_ != 0)
+        {
+            bits = bits + detail::hash_combine(detail::bits32<int_type>(seed_), dim);
+        }
+
+        return detail::uniform_from_bits<value_type>(bits);
+    }
+
+    VSNRAY_FUNC generator_type& get_generator(size_t i)
+    {
+        // Refresh, *this may have been copied since the last call
+        lanes_[i] = generator_type(&keys_[i], &indices_[i], &dims_[i], seed_);
+        return lanes_[i];
+    }
+
+    // Lanes where m is set continue at the dimension of a, the others at that of b
+    template <typename M>
+    VSNRAY_FUNC
+    friend quasi_random_generator select(M const& m, quasi_random_generator const& a, quasi_random_generator const& b)
+    {
+        quasi_random_generator result(a);
+        store(result.dims_, select(m, int_type(a.dims_), int_type(b.dims_)));
+        return result;
+    }
+
+private:
+
+    int_array keys_;
+    int_array indices_;
+    int_array dims_;
+    unsigned seed_ = 0;
+
+    array<generator_type, simd::num_elements<T>::value> lanes_;
+
+};
+
+template <typename T>
+using sobol_generator = quasi_random_generator<T, detail::sobol_sequence>;
+
+template <typename T>
+using halton_generator = quasi_random_generator<T, detail::halton_sequence>;
+
+template <typename T>
+using blue_noise_generator = quasi_random_generator<T, detail::blue_noise_sequence>;
+
+
+//-------------------------------------------------------------------------------------------------
+// Quasi-random generators are constructed from pixel position and sample index, other
+// generators from a random seed
+//
+
+template <typename Generator>
+struct is_quasi_random_generator : std::false_type {};
+
+template <typename T, typename Sequence>
+struct is_quasi_random_generator<quasi_random_generator<T, Sequence>> : std::true_type {};
+
+} // visionaray
+
+#endif // VSNRAY_QUASI_RANDOM_GENERATOR_H
@@ -10,14 +10,6 @@
 #include <cstddef>
 #include <type_traits>
 
-#if defined(__CUDACC__)
-#include <thrust/random.h>
-#elif defined(__HCC__)
-#include "hcc/random.h"
-#else
-#include <random>
-#endif
-
 #include "math/simd/type_traits.h"
 #include "math/array.h"
 
@@ -79,11 +71,79 @@ VSNRAY_FUNC array<unsigned, simd::num_elements<T>::value> tic(T /* */)
     return result;
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Counter-based random number generation
+//
+// The n-th number of a stream is a pure function of the stream key and n, so streams can
+// be seeded from (pixel, frame, sample) and results are reproducible. Numbers are computed
+// with integer multiplies and fixed shifts only, so N lanes are generated at once with SIMD
+// integer vectors.
+//
+// cf. Salmon et al. (2011): Parallel Random Numbers: As Easy as 1, 2, 3
+//     Wellons (2018): Prospecting for Hash Functions
+//
+
+// 32-bit integer hash, avalanches all input bits
+template <typename I>
+VSNRAY_FUNC
+inline I hash32(I x)
+{
+    // Mask after shifting as SIMD int shifts may be arithmetic
+    x = x ^ ((x >> 16) & I(0x0000FFFF));
+    x = x * I(0x7FEB352D);
+    x = x ^ ((x >> 15) & I(0x0001FFFF));
+    x = x * I(static_cast<int>(0x846CA68Bu));
+    x = x ^ ((x >> 16) & I(0x0000FFFF));
+    return x;
+}
+
+VSNRAY_FUNC
+inline unsigned hash32(unsigned x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Random bits for position counter in stream key
+template <typename I>
+VSNRAY_FUNC
+inline I counter_hash(I counter, I key)
+{
+    return hash32(hash32(counter) ^ key);
+}
+
+// Uniform float in [0,1) from the upper 24 bits
+template <typename T>
+VSNRAY_FUNC
+inline T uniform_from_bits(unsigned bits)
+{
+    return T(bits >> 8) * T(1.0 / 16777216.0);
+}
+
+template <typename T, typename I>
+VSNRAY_FUNC
+inline T uniform_from_bits(I bits)
+{
+    return convert_to_float((bits >> 8) & I(0x00FFFFFF)) * T(1.0f / 16777216.0f);
+}
+
+// Seed from pixel index, frame number and sample number
+VSNRAY_FUNC
+inline unsigned make_seed(unsigned pixel, unsigned frame, unsigned sample = 0)
+{
+    return hash32(hash32(hash32(pixel) ^ frame) ^ sample);
+}
+
 } // detail
 
 
 //-------------------------------------------------------------------------------------------------
-// random_generator classes, uses a standard pseudo RNG to generate samples
+// random_generator classes, generate uniformly distributed numbers in [0,1)
 //
 
 template <typename T, typename = void>
@@ -95,34 +155,23 @@ public:
 
 public:
 
-#if defined(__CUDACC__)
-    typedef thrust::default_random_engine rand_engine;
-    typedef thrust::uniform_real_distribution<T> uniform_dist;
-#elif defined(__HCC__)
-    typedef hcc::default_random_engine rand_engine;
-    typedef hcc::uniform_real_distribution<T> uniform_dist;
-#else
-    typedef std::default_random_engine rand_engine;
-    typedef std::uniform_real_distribution<T> uniform_dist;
-#endif
-
     random_generator() = default;
 
     VSNRAY_FUNC random_generator(unsigned seed)
-        : rng_(rand_engine(seed))
-        , dist_(uniform_dist(0, 1))
+        : key_(detail::hash32(seed))
+        , counter_(0)
     {
     }
 
     VSNRAY_FUNC T next()
     {
-        return dist_(rng_);
+        return detail::uniform_from_bits<T>(detail::counter_hash(counter_++, key_));
     }
 
 private:
 
-    rand_engine  rng_;
-    uniform_dist dist_;
+    unsigned key_ = 0;
+    unsigned counter_ = 0;
 
 };
 
@@ -132,40 +181,90 @@ class random_generator<T, typename std::enable_if<simd::is_simd_vector<T>::value
 public:
 
     using value_type = T;
+    using int_type   = simd::int_type_t<T>;
+    using int_array  = simd::aligned_array_t<int_type>;
+
+    // Scalar view of one lane, shares the lane's stream
+    class lane_generator
+    {
+    public:
+
+        using value_type = float;
+
+    public:
+
+        lane_generator() = default;
+
+        VSNRAY_FUNC lane_generator(int* key, int* counter)
+            : key_(key)
+            , counter_(counter)
+        {
+        }
+
+        VSNRAY_FUNC float next()
+        {
+            unsigned counter = static_cast<unsigned>((*counter_)++);
+            return detail::uniform_from_bits<float>(
+                    detail::counter_hash(counter, static_cast<unsigned>(*key_))
+                    );
+        }
+
+    private:
+
+        int* key_ = nullptr;
+        int* counter_ = nullptr;
+
+    };
 
 public:
 
-    typedef random_generator<float> generator_type;
+    typedef lane_generator generator_type;
 
     VSNRAY_FUNC random_generator(array<unsigned, simd::num_elements<value_type>::value> const& seed)
     {
         for (int i = 0; i < simd::num_elements<value_type>::value; ++i)
         {
-            generators_[i] = generator_type(seed[i]);
+            keys_[i] = static_cast<int>(detail::hash32(seed[i]));
+            counters_[i] = 0;
         }
     }
 
     VSNRAY_FUNC value_type next()
     {
-        simd::aligned_array_t<value_type> arr;
+        int_type key(keys_);
+        int_type counter(counters_);
 
-        for (int i = 0; i < simd::num_elements<value_type>::value; ++i)
-        {
-            arr[i] = generators_[i].next();
-        }
+        store(counters_, counter + int_type(1));
 
-        return value_type(arr);
+        return detail::uniform_from_bits<value_type>(detail::counter_hash(counter, key));
     }
 
     // TODO: maybe don't have a random_generatorN at all?
     VSNRAY_FUNC generator_type& get_generator(size_t i)
     {
-        return generators_[i];
+        // Refresh, *this may have been copied since the last call
+        lanes_[i] = generator_type(&keys_[i], &counters_[i]);
+        return lanes_[i];
+    }
+
+    // Lanes where m is set continue the streams of a, the others those of b. Keeps
+    // streams of inactive lanes from advancing when only some lanes drew numbers
+    template <typename M>
+    VSNRAY_FUNC
+    friend random_generator select(M const& m, random_generator const& a, random_generator const& b)
+    {
+        random_generator result(a);
+        store(result.counters_, select(m, int_type(a.counters_), int_type(b.counters_)));
+        return result;
     }
 
 private:
 
-    array<generator_type, simd::num_elements<value_type>::value> generators_;
+    // Stream keys and positions in streams, one per lane
+    int_array keys_;
+    int_array counters_;
+
+    array<generator_type, simd::num_elements<value_type>::value> lanes_;
 
 };
 
@@ -0,0 +1,127 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_RAY_STREAM_H
+#define VSNRAY_RAY_STREAM_H 1
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "math/simd/type_traits.h"
+#include "math/ray.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// ray_stream
+//
+// A large batch of (usually incoherent) single rays, e.g. all the secondary rays of one
+// bounce. The rays are stored as a structure of arrays so that stream traversal can gather
+// them into SIMD vectors of type S. Intersect a stream with a BVH with
+//
+//  intersect<detail::ClosestHit>(stream, bvh, isect, hits);
+//
+// which writes one hit record per ray to hits.
+//
+
+template <typename S = simd::float4>
+class ray_stream
+{
+public:
+
+    using float_type = S;
+
+    enum { Width = simd::num_elements<S>::value };
+
+    // Sub-range of the ray index buffer with the rays that hit a BVH node
+    struct node_rays
+    {
+        unsigned node;
+        size_t first;
+        size_t count;
+    };
+
+public:
+
+    size_t size() const
+    {
+        return ori_x.size();
+    }
+
+    bool empty() const
+    {
+        return ori_x.empty();
+    }
+
+    void reserve(size_t capacity)
+    {
+        ori_x.reserve(capacity);
+        ori_y.reserve(capacity);
+        ori_z.reserve(capacity);
+        dir_x.reserve(capacity);
+        dir_y.reserve(capacity);
+        dir_z.reserve(capacity);
+    }
+
+    void clear()
+    {
+        ori_x.clear();
+        ori_y.clear();
+        ori_z.clear();
+        dir_x.clear();
+        dir_y.clear();
+        dir_z.clear();
+    }
+
+    void push_back(basic_ray<float> const& r)
+    {
+        ori_x.push_back(r.ori.x);
+        ori_y.push_back(r.ori.y);
+        ori_z.push_back(r.ori.z);
+        dir_x.push_back(r.dir.x);
+        dir_y.push_back(r.dir.y);
+        dir_z.push_back(r.dir.z);
+    }
+
+    basic_ray<float> get(size_t index) const
+    {
+        assert(index < size());
+
+        return basic_ray<float>(
+                vec3(ori_x[index], ori_y[index], ori_z[index]),
+                vec3(dir_x[index], dir_y[index], dir_z[index])
+                );
+    }
+
+public:
+
+    // Ray origins and directions
+
+    aligned_vector<float> ori_x;
+    aligned_vector<float> ori_y;
+    aligned_vector<float> ori_z;
+    aligned_vector<float> dir_x;
+    aligned_vector<float> dir_y;
+    aligned_vector<float> dir_z;
+
+    // Scratch memory for traversal, kept to avoid reallocations per bounce
+
+    aligned_vector<float> inv_dir_x;
+    aligned_vector<float> inv_dir_y;
+    aligned_vector<float> inv_dir_z;
+    aligned_vector<float> t;                // Current closest distance
+    std::vector<int> active;                // Compacted ray indices, one sub-range per node
+    std::vector<int> child_active[2];
+    std::vector<node_rays> todo;
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_RAY_STREAM_H
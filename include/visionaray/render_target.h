@@ -7,6 +7,7 @@
 #define VSNRAY_RENDER_TARGET_H 1
 
 #include "detail/macros.h"
+#include "math/vector.h"
 #include "pixel_traits.h"
 
 namespace visionaray
@@ -86,6 +87,57 @@ struct render_target_ref
 
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// Accumulation target ref
+//
+// Running sums of RGBA samples and per-pixel sample counts, see accumulation_buffer_rt
+//
+
+template <typename T>
+struct accumulation_target_ref
+{
+    using accum_type = vector<4, T>;
+
+    VSNRAY_FUNC accum_type* sums()
+    {
+        return sums_;
+    }
+
+    VSNRAY_FUNC unsigned* counts()
+    {
+        return counts_;
+    }
+
+    VSNRAY_FUNC accum_type const* sums() const
+    {
+        return sums_;
+    }
+
+    VSNRAY_FUNC unsigned const* counts() const
+    {
+        return counts_;
+    }
+
+    VSNRAY_FUNC int width() const
+    {
+        return width_;
+    }
+
+    VSNRAY_FUNC int height() const
+    {
+        return height_;
+    }
+
+    // Public, to allow for aggregate initialization!
+    accum_type* sums_;
+    unsigned* counts_;
+
+    int width_;
+    int height_;
+
+};
+
 } // visionaray
 
 #endif // VSNRAY_RENDER_TARGET_H
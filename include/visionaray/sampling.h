@@ -160,6 +160,36 @@ struct has_sample : has_sample_impl<T, Generator>::type
 {
 };
 
+// Pack single-precision light samples into a SIMD light sample
+template <typename T>
+light_sample<T> pack_light_samples(array<light_sample<float>, simd::num_elements<T>::value> const& samples)
+{
+    light_sample<T> result;
+
+    array<vector<3, float>, simd::num_elements<T>::value> poss;
+    array<vector<3, float>, simd::num_elements<T>::value> intensities;
+    array<vector<3, float>, simd::num_elements<T>::value> normals;
+    float* area = reinterpret_cast<float*>(&result.area);
+    int* delta_light = reinterpret_cast<int*>(&result.delta_light);
+    int* infinite_light = reinterpret_cast<int*>(&result.infinite_light);
+
+    for (size_t i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        poss[i] = samples[i].pos;
+        intensities[i] = samples[i].intensity;
+        normals[i] = samples[i].normal;
+        area[i] = samples[i].area;
+        delta_light[i] = samples[i].delta_light ? 0xFFFFFFFF : 0x00000000;
+        infinite_light[i] = samples[i].infinite_light ? 0xFFFFFFFF : 0x00000000;
+    }
+
+    result.pos = simd::pack(poss);
+    result.intensity = simd::pack(intensities);
+    result.normal = simd::pack(normals);
+
+    return result;
+}
+
 } // detail
 
 // empty default
@@ -219,32 +249,254 @@ light_sample<T> sample_random_light(Lights begin, Lights end, Generator& gen, T
     float_array uf;
     store(uf, u);
 
-    light_sample<T> result;
-
-    array<vector<3, float>, simd::num_elements<T>::value> poss;
-    array<vector<3, float>, simd::num_elements<T>::value> intensities;
-    array<vector<3, float>, simd::num_elements<T>::value> normals;
-    float* area = reinterpret_cast<float*>(&result.area);
-    int* delta_light = reinterpret_cast<int*>(&result.delta_light);
+    array<light_sample<float>, simd::num_elements<T>::value> samples;
 
     for (size_t i = 0; i < simd::num_elements<T>::value; ++i)
     {
         int light_id = static_cast<int>(uf[i] * num_lights);
 
-        auto ls = begin[light_id].sample(gen.get_generator(i));
+        samples[i] = begin[light_id].sample(gen.get_generator(i));
+    }
 
-        poss[i] = ls.pos;
-        intensities[i] = ls.intensity;
-        normals[i] = ls.normal;
-        area[i] = ls.area;
-        delta_light[i] = ls.delta_light ? 0xFFFFFFFF : 0x00000000;
+    return detail::pack_light_samples<T>(samples);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Sample a light with a light sampler (see light_sampler.h)
+//
+// The sampler picks a light based on the shading point and its normal, pdf is the
+// probability of picking the sampled light
+//
+
+// empty default
+template <
+    typename LightSampler,
+    typename Lights,
+    typename Generator,
+    typename T = typename Generator::value_type,
+    typename = typename std::enable_if<
+        !detail::has_sample<typename std::iterator_traits<Lights>::value_type, Generator>::value>::type
+    >
+VSNRAY_FUNC
+light_sample<T> sample_light(
+        LightSampler const& sampler,
+        Lights              begin,
+        Lights              end,
+        vector<3, T> const& pos,
+        vector<3, T> const& normal,
+        T&                  pdf,
+        Generator&          gen
+        )
+{
+    VSNRAY_UNUSED(sampler, begin, end, pos, normal, gen);
+
+    pdf = T(0.0);
+
+    return {};
+}
+
+// non-simd
+template <
+    typename LightSampler,
+    typename Lights,
+    typename Generator,
+    typename T = typename Generator::value_type,
+    typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type,
+    typename = typename std::enable_if<
+        detail::has_sample<typename std::iterator_traits<Lights>::value_type, Generator>::value>::type
+    >
+VSNRAY_FUNC
+light_sample<T> sample_light(
+        LightSampler const& sampler,
+        Lights              begin,
+        Lights              end,
+        vector<3, T> const& pos,
+        vector<3, T> const& normal,
+        T&                  pdf,
+        Generator&          gen
+        )
+{
+    // Light samplers work in single precision
+    float select_pdf = 0.0f;
+
+    int light_id = sampler.sample(
+            begin,
+            end,
+            vector<3, float>(pos),
+            vector<3, float>(normal),
+            static_cast<float>(gen.next()),
+            select_pdf
+            );
+
+    pdf = T(select_pdf);
+
+    return begin[light_id].sample(gen);
+}
+
+// simd
+template <
+    typename LightSampler,
+    typename Lights,
+    typename Generator,
+    typename T = typename Generator::value_type,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type,
+    typename = typename std::enable_if<
+        detail::has_sample<typename std::iterator_traits<Lights>::value_type, Generator>::value>::type
+    >
+light_sample<T> sample_light(
+        LightSampler const& sampler,
+        Lights              begin,
+        Lights              end,
+        vector<3, T> const& pos,
+        vector<3, T> const& normal,
+        T&                  pdf,
+        Generator&          gen,
+        T                   = T()
+        )
+{
+    using float_array = simd::aligned_array_t<T>;
+
+    auto u = gen.next();
+
+    float_array uf;
+    store(uf, u);
+
+    auto poss = unpack(pos);
+    auto normals = unpack(normal);
+
+    float_array pdfs;
+    array<light_sample<float>, simd::num_elements<T>::value> samples;
+
+    for (size_t i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        int light_id = sampler.sample(begin, end, poss[i], normals[i], uf[i], pdfs[i]);
+
+        samples[i] = begin[light_id].sample(gen.get_generator(i));
     }
 
-    result.pos = simd::pack(poss);
-    result.intensity = simd::pack(intensities);
-    result.normal = simd::pack(normals);
+    pdf = T(pdfs);
 
-    return result;
+    return detail::pack_light_samples<T>(samples);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Probability that a light sampler picks the light with geometry prim_id for a shading point,
+// e.g. to weight hits of emissive geometry with multiple importance sampling
+//
+
+// non-simd
+template <
+    typename LightSampler,
+    typename Lights,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type
+    >
+VSNRAY_FUNC
+T light_selection_pdf(
+        LightSampler const& sampler,
+        Lights              begin,
+        Lights              end,
+        int                 prim_id,
+        vector<3, T> const& pos,
+        vector<3, T> const& normal
+        )
+{
+    return T(sampler.pdf(begin, end, prim_id, vector<3, float>(pos), vector<3, float>(normal)));
+}
+
+// simd
+template <
+    typename LightSampler,
+    typename Lights,
+    typename T,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+T light_selection_pdf(
+        LightSampler const&         sampler,
+        Lights                      begin,
+        Lights                      end,
+        simd::int_type_t<T> const&  prim_id,
+        vector<3, T> const&         pos,
+        vector<3, T> const&         normal
+        )
+{
+    using float_array = simd::aligned_array_t<T>;
+    using int_array = simd::aligned_array_t<simd::int_type_t<T>>;
+
+    int_array prim_ids;
+    store(prim_ids, prim_id);
+
+    auto poss = unpack(pos);
+    auto normals = unpack(normal);
+
+    float_array pdfs;
+
+    for (size_t i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        pdfs[i] = sampler.pdf(begin, end, prim_ids[i], poss[i], normals[i]);
+    }
+
+    return T(pdfs);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Probability that a light sampler picks the light with index light_index for a shading point,
+// e.g. to weight radiance from an environment light with multiple importance sampling
+//
+
+// non-simd
+template <
+    typename LightSampler,
+    typename Lights,
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type
+    >
+VSNRAY_FUNC
+T light_index_pdf(
+        LightSampler const& sampler,
+        Lights              begin,
+        Lights              end,
+        int                 light_index,
+        vector<3, T> const& pos,
+        vector<3, T> const& normal
+        )
+{
+    return T(sampler.light_pdf(begin, end, light_index, vector<3, float>(pos), vector<3, float>(normal)));
+}
+
+// simd
+template <
+    typename LightSampler,
+    typename Lights,
+    typename T,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+T light_index_pdf(
+        LightSampler const&         sampler,
+        Lights                      begin,
+        Lights                      end,
+        int                         light_index,
+        vector<3, T> const&         pos,
+        vector<3, T> const&         normal,
+        T                           = T()
+        )
+{
+    using float_array = simd::aligned_array_t<T>;
+
+    auto poss = unpack(pos);
+    auto normals = unpack(normal);
+
+    float_array pdfs;
+
+    for (size_t i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        pdfs[i] = sampler.light_pdf(begin, end, light_index, poss[i], normals[i]);
+    }
+
+    return T(pdfs);
 }
 
 } // visionaray
@@ -0,0 +1,75 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TILE_BUFFER_RT_H
+#define VSNRAY_TILE_BUFFER_RT_H 1
+
+#include "math/forward.h"
+#include "math/rectangle.h"
+#include "math/vector.h"
+#include "pixel_format.h"
+#include "render_target.h"
+#include "simple_buffer_rt.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Render target that covers a tile (a sub-rectangle) of an image
+//
+// Only stores the pixels of the tile, width() and height() are the tile size. Schedulers
+// generate the primary rays and random numbers for the tile's pixels in the image, so that
+// a tile renders the same values as the corresponding region of a full-frame render target.
+// Kernels that are passed pixel coordinates, the scissor box and pixel sampler buffers
+// (e.g. adaptive sampling stats) use tile coordinates.
+//
+// Workers can render tiles into compact, cache-resident buffers and hand them off, e.g. to
+// composite them with copy_to():
+//
+//  tile_buffer_rt<PF_RGBA8, PF_UNSPECIFIED> tile;
+//  tile.resize(64, 64);
+//  tile.set_image_size(w, h);
+//  tile.set_offset(x, y);
+//  sched.frame(kernel, make_sched_params(cam, tile));
+//  tile.copy_to(image.ref());
+//
+
+template <pixel_format ColorFormat, pixel_format DepthFormat>
+class tile_buffer_rt : public simple_buffer_rt<ColorFormat, DepthFormat>
+{
+public:
+
+    using base_type     = simple_buffer_rt<ColorFormat, DepthFormat>;
+    using ref_type      = typename base_type::ref_type;
+
+public:
+
+    // Position of the tile's pixel (0, 0) in the image
+    void set_offset(int x, int y);
+    vec2i offset() const;
+
+    // Size of the image, defaults to the tile size
+    void set_image_size(int w, int h);
+    vec2i image_size() const;
+
+    // Tile in image coordinates
+    recti region() const;
+
+    // Copy the tile to the corresponding region of an image-sized render target,
+    // pixels outside dst are skipped
+    void copy_to(ref_type dst) const;
+
+private:
+
+    vec2i offset_ = vec2i(0);
+    vec2i image_size_ = vec2i(0);
+
+};
+
+} // visionaray
+
+#include "detail/tile_buffer_rt.inl"
+
+#endif // VSNRAY_TILE_BUFFER_RT_H
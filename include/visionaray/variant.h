@@ -94,6 +94,10 @@ union variant_storage<T, Ts...>
     T element;
     variant_storage<Ts...> elementN;
 
+    // Elements may have non-trivial default constructors (e.g. texture references),
+    // the variant assigns the active element
+    VSNRAY_FUNC variant_storage() {}
+
     // access
 
     VSNRAY_FUNC T& get(type_index<1>)
@@ -160,45 +164,92 @@ public:
             : nullptr;
     }
 
+    // Zero-based index of the active alternative in Ts..., unsigned(-1) if no
+    // alternative was assigned
+    VSNRAY_FUNC unsigned which() const
+    {
+        return type_index_ - 1;
+    }
+
 private:
 
-    unsigned                        type_index_;
+    // 0 if no alternative was assigned
+    unsigned                        type_index_ = 0;
     detail::variant_storage<Ts...>  storage_;
 
 };
 
 
-template <unsigned I, typename ...Ts>
-struct apply_visitor_impl;
+//-------------------------------------------------------------------------------------------------
+// Visitor dispatch
+//
+// Switches over the type index in blocks of 8 alternatives, so that the compiler can emit a
+// jump table instead of a chain of comparisons. Variants with more than 8 alternatives
+// dispatch the remaining ones in the default case.
+//
 
-template <unsigned I, typename T, typename ...Ts>
-struct apply_visitor_impl<I, T, Ts...>
+template <unsigned Offset, typename ...Ts>
+struct apply_visitor_impl
 {
     template <typename Visitor, typename Variant>
     VSNRAY_FUNC
     typename Visitor::return_type operator()(Visitor const& visitor, Variant const& var) const
     {
-        auto ptr = var.template as<T>();
-
-        if (ptr)
-        {
-            return visitor(*ptr);
-        }
-        else
+        switch (var.which() - Offset)
         {
-            return apply_visitor_impl<I - 1, Ts...>()(visitor, var);
+        case 0: return visit<Offset + 1>(visitor, var);
+        case 1: return visit<Offset + 2>(visitor, var);
+        case 2: return visit<Offset + 3>(visitor, var);
+        case 3: return visit<Offset + 4>(visitor, var);
+        case 4: return visit<Offset + 5>(visitor, var);
+        case 5: return visit<Offset + 6>(visitor, var);
+        case 6: return visit<Offset + 7>(visitor, var);
+        case 7: return visit<Offset + 8>(visitor, var);
+        default:
+            return next(visitor, var, std::integral_constant<bool, (Offset + 8 < sizeof...(Ts))>{});
         }
     }
-};
 
-template <>
-struct apply_visitor_impl<0>
-{
+private:
+
+    // Alternative I (one-based) exists
+    template <unsigned I, typename Visitor, typename Variant>
+    VSNRAY_FUNC
+    typename Visitor::return_type visit(Visitor const& visitor, Variant const& var, std::true_type) const
+    {
+        return visitor(*var.template as<detail::type_at<I, Ts...>>());
+    }
+
+    template <unsigned I, typename Visitor, typename Variant>
+    VSNRAY_FUNC
+    typename Visitor::return_type visit(Visitor const&, Variant const&, std::false_type) const
+    {
+        // Index past the last alternative, only reached if no alternative was
+        // assigned (which() == unsigned(-1)): return a default-constructed result
+        return typename Visitor::return_type();
+    }
+
+    template <unsigned I, typename Visitor, typename Variant>
+    VSNRAY_FUNC
+    typename Visitor::return_type visit(Visitor const& visitor, Variant const& var) const
+    {
+        return visit<I>(visitor, var, std::integral_constant<bool, (I <= sizeof...(Ts))>{});
+    }
+
+    // More than 8 alternatives left
+    template <typename Visitor, typename Variant>
+    VSNRAY_FUNC
+    typename Visitor::return_type next(Visitor const& visitor, Variant const& var, std::true_type) const
+    {
+        return apply_visitor_impl<Offset + 8, Ts...>()(visitor, var);
+    }
+
     template <typename Visitor, typename Variant>
     VSNRAY_FUNC
-    typename Visitor::return_type operator()(Visitor const&, Variant const&)
+    typename Visitor::return_type next(Visitor const&, Variant const&, std::false_type) const
     {
-        // TODO
+        // No block of alternatives left, the variant is unassigned:
+        // return a default-constructed result
         return typename Visitor::return_type();
     }
 };
@@ -207,7 +258,7 @@ template <typename Visitor, typename ...Ts>
 VSNRAY_FUNC
 typename Visitor::return_type apply_visitor(Visitor const& visitor, variant<Ts...> const& var)
 {
-    return apply_visitor_impl<sizeof...(Ts), Ts...>()(visitor, var);
+    return apply_visitor_impl<0, Ts...>()(visitor, var);
 }
 
 } // visionaray
@@ -0,0 +1,216 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_WAVEFRONT_PATHTRACER_H
+#define VSNRAY_WAVEFRONT_PATHTRACER_H 1
+
+#include <cstddef>
+#include <type_traits>
+
+#include "math/forward.h"
+#include "math/ray.h"
+#include "math/vector.h"
+#include "aligned_vector.h"
+#include "generic_material.h"
+#include "result_record.h"
+#include "spectrum.h"
+#include "surface.h"
+#include "variant.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Concrete material types of a material type, generic materials have one type per
+// alternative, other materials a single type
+//
+
+template <typename M>
+struct material_type_list
+{
+    enum { size = 1 };
+
+    template <unsigned I>
+    using type = M;
+
+    static unsigned index(M const&)
+    {
+        return 0;
+    }
+
+    template <typename T>
+    static T const& get(M const& m)
+    {
+        return m;
+    }
+};
+
+template <typename ...Ts>
+struct material_type_list<generic_material<Ts...>>
+{
+    enum { size = sizeof...(Ts) };
+
+    template <unsigned I>
+    using type = type_at<I + 1, Ts...>;
+
+    static unsigned index(generic_material<Ts...> const& m)
+    {
+        return m.which();
+    }
+
+    template <typename T>
+    static T const& get(generic_material<Ts...> const& m)
+    {
+        return *m.template as<T>();
+    }
+};
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Wavefront path tracer
+//
+// Computes the same estimate as pathtracing::kernel, but advances a whole batch of paths
+// one stage at a time instead of tracing each packet to completion:
+//
+//  - intersect: closest hits for all active paths, packets of S
+//  - sort:      hits are binned by the type index of their material (stable counting sort)
+//  - shade:     each bin is shaded with its concrete material type in packets of S,
+//               w/o per-lane variant dispatch. Materials w/o SIMD representation
+//               (disney, glass) are shaded one path at a time
+//  - shadow:    shadow rays emitted by the shade stage are traced with any_hit
+//  - accumulate: unoccluded light samples are added to the paths' radiance
+//
+// Each path draws its random numbers from one stream per bounce, seeded from the path's
+// seed. Bins keep the order of the paths, so results are reproducible for a given S.
+//
+// Host only.
+//
+
+template <typename Params, typename S = float>
+class wavefront_pathtracer
+{
+public:
+
+    using scalar_type   = S;
+    using ray_type      = basic_ray<float>;
+    using result_type   = result_record<float>;
+    using surface_type  = surface<
+            typename Params::normal_type,
+            typename Params::color_type,
+            typename Params::material_type
+            >;
+
+public:
+
+    explicit wavefront_pathtracer(Params const& params);
+
+    // Trace one path per ray, seeds[i] seeds the random numbers of path i
+    template <typename Intersector>
+    void trace(
+            ray_type const* rays,
+            unsigned const* seeds,
+            size_t          count,
+            result_type*    results,
+            Intersector&    isect
+            );
+
+    void trace(
+            ray_type const* rays,
+            unsigned const* seeds,
+            size_t          count,
+            result_type*    results
+            );
+
+    // Number of hits shaded with the material type with index type_index during the last trace()
+    size_t num_shaded(unsigned type_index) const;
+
+    Params const& params() const;
+
+private:
+
+    using material_list = detail::material_type_list<typename Params::material_type>;
+
+    struct path_state
+    {
+        ray_type        ray;
+        spectrum<float> throughput      = spectrum<float>(1.0f);
+        spectrum<float> intensity       = spectrum<float>(0.0f);
+
+        // Shading point, normal and BRDF pdf of the last bounce, see pathtracing::kernel
+        vec3            last_pos        = vec3(0.0f);
+        vec3            last_normal     = vec3(0.0f);
+        float           last_brdf_pdf   = 0.0f;
+        bool            last_specular   = true;
+
+        bool            active          = true;
+        unsigned        seed            = 0;
+
+        // Current hit
+        surface_type    surf;
+        vec3            isect_pos       = vec3(0.0f);
+        int             prim_id         = 0;
+        float           area            = 0.0f;
+
+        result_type     result;
+    };
+
+    struct shadow_ray
+    {
+        unsigned        path;
+        ray_type        ray;
+        float           max_t;
+        spectrum<float> contribution;
+    };
+
+    Params                      params_;
+
+    aligned_vector<path_state>  paths_;
+
+    // Indices of active paths
+    aligned_vector<unsigned>    queue_;
+
+    // Indices of paths that hit a surface, sorted by material type index
+    aligned_vector<unsigned>    material_queue_;
+
+    // material_list::size + 1 offsets into material_queue_
+    aligned_vector<size_t>      bin_offsets_;
+
+    aligned_vector<shadow_ray>  shadow_queue_;
+
+    aligned_vector<size_t>      num_shaded_;
+
+    // Stages
+
+    template <typename Intersector>
+    void intersect(unsigned bounce, Intersector& isect);
+
+    template <typename HR>
+    void record_hit(unsigned path, HR hit_rec, unsigned bounce);
+
+    void sort_by_material();
+
+    template <unsigned I>
+    void shade(unsigned bounce, std::integral_constant<unsigned, I>);
+    void shade(unsigned bounce, std::integral_constant<unsigned, material_list::size>);
+
+    template <typename SS, typename M>
+    void shade_packet(unsigned const* paths, size_t count, unsigned bounce);
+
+    template <typename Intersector>
+    void trace_shadow_rays(Intersector& isect);
+
+    void compact();
+
+};
+
+} // visionaray
+
+#include "detail/wavefront_pathtracer.inl"
+
+#endif // VSNRAY_WAVEFRONT_PATHTRACER_H
@@ -0,0 +1,506 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "bvh_file.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// File layout
+//
+//  file_header
+//  file_record[num_bvhs]
+//  file_record (top-level BVH, if num_instances > 0)
+//  bvh_file_instance[num_instances]
+//  sections (primitives, nodes, indices), each aligned to Alignment bytes
+//
+// Offsets are relative to the beginning of the file.
+//
+
+namespace
+{
+
+static const char Magic[8] = { 'V', 'S', 'N', 'R', 'Y', 'B', 'V', 'H' };
+
+enum : uint32_t { Version = 1 };
+enum : uint32_t { ByteOrderMark = 0x01020304 };
+enum : uint64_t { Alignment = 64 };
+
+struct file_section
+{
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct file_record
+{
+    uint32_t kind;
+    uint32_t primitive_size;
+    file_section primitives;
+    file_section nodes;
+    file_section indices;
+};
+
+struct file_header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t node_size;
+    uint32_t instance_size;
+    uint64_t geometry_hash;
+    uint64_t num_bvhs;
+    uint64_t num_instances;
+    uint64_t file_size;
+};
+
+uint64_t align_up(uint64_t offset)
+{
+    return (offset + Alignment - 1) & ~(Alignment - 1);
+}
+
+// Assign an offset to a section and advance the file position
+file_section make_section(uint64_t& pos, uint64_t count, size_t element_size)
+{
+    file_section result = { 0, count };
+
+    if (count > 0)
+    {
+        pos = align_up(pos);
+        result.offset = pos;
+        pos += count * element_size;
+    }
+
+    return result;
+}
+
+bool write_at(std::ofstream& file, uint64_t& pos, uint64_t offset, void const* data, size_t size)
+{
+    static const char zeros[Alignment] = {};
+
+    if (size == 0)
+    {
+        return true;
+    }
+
+    // Pad up to the section start
+    while (pos < offset)
+    {
+        auto n = static_cast<size_t>(std::min<uint64_t>(offset - pos, Alignment));
+        file.write(zeros, n);
+        pos += n;
+    }
+
+    file.write(static_cast<char const*>(data), size);
+    pos += size;
+
+    return file.good();
+}
+
+} // namespace
+
+
+//-------------------------------------------------------------------------------------------------
+// FNV-1a, processing 8 bytes at a time
+//
+
+uint64_t hash_geometry(void const* data, size_t size)
+{
+    static const uint64_t Prime = 0x100000001B3ULL;
+
+    uint64_t h = 0xCBF29CE484222325ULL;
+
+    auto bytes = static_cast<unsigned char const*>(data);
+
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        h = (h ^ word) * Prime;
+    }
+
+    for (; i < size; ++i)
+    {
+        h = (h ^ bytes[i]) * Prime;
+    }
+
+    return (h ^ size) * Prime;
+}
+
+uint64_t hash_combine(uint64_t hash, uint64_t value)
+{
+    static const uint64_t Prime = 0x100000001B3ULL;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        hash = (hash ^ ((value >> (i * 8)) & 0xFF)) * Prime;
+    }
+
+    return hash;
+}
+
+
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Write BVH file
+//
+
+bool write_bvh_file(
+        std::string const&                      filename,
+        uint64_t                                geometry_hash,
+        std::vector<bvh_file_record> const&     bvhs,
+        std::vector<bvh_file_instance> const&   instances,
+        bvh_file_record const*                  top_level
+        )
+{
+    std::vector<bvh_file_record> all(bvhs);
+
+    if (top_level != nullptr)
+    {
+        all.push_back(*top_level);
+    }
+
+    // Lay out the sections
+
+    uint64_t pos = sizeof(file_header)
+                 + all.size() * sizeof(file_record)
+                 + instances.size() * sizeof(bvh_file_instance);
+
+    std::vector<file_record> records(all.size());
+
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+        records[i].kind = all[i].kind;
+        records[i].primitive_size = all[i].primitive_size;
+        records[i].primitives = make_section(pos, all[i].num_primitives, all[i].primitive_size);
+        records[i].nodes = make_section(pos, all[i].num_nodes, sizeof(bvh_node));
+        records[i].indices = make_section(pos, all[i].num_indices, sizeof(unsigned));
+    }
+
+    file_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byte_order = ByteOrderMark;
+    header.node_size = sizeof(bvh_node);
+    header.instance_size = sizeof(bvh_file_instance);
+    header.geometry_hash = geometry_hash;
+    header.num_bvhs = bvhs.size();
+    header.num_instances = top_level != nullptr ? instances.size() : 0;
+    header.file_size = pos;
+
+
+    // Write
+
+    std::ofstream file(filename, std::ios::binary);
+
+    if (!file.good())
+    {
+        return false;
+    }
+
+    uint64_t fpos = 0;
+
+    bool ok = write_at(file, fpos, 0, &header, sizeof(header));
+    ok &= write_at(file, fpos, fpos, records.data(), records.size() * sizeof(file_record));
+    ok &= write_at(file, fpos, fpos, instances.data(), instances.size() * sizeof(bvh_file_instance));
+
+    for (size_t i = 0; i < all.size() && ok; ++i)
+    {
+        ok &= write_at(
+                file,
+                fpos,
+                records[i].primitives.offset,
+                all[i].primitives,
+                all[i].num_primitives * all[i].primitive_size
+                );
+
+        ok &= write_at(
+                file,
+                fpos,
+                records[i].nodes.offset,
+                all[i].nodes,
+                all[i].num_nodes * sizeof(bvh_node)
+                );
+
+        ok &= write_at(
+                file,
+                fpos,
+                records[i].indices.offset,
+                all[i].indices,
+                all[i].num_indices * sizeof(unsigned)
+                );
+    }
+
+    return ok && fpos == pos;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// mapped_bvh_file
+//
+
+struct mapped_bvh_file::impl
+{
+    boost::iostreams::mapped_file_source file;
+};
+
+mapped_bvh_file::mapped_bvh_file()
+    : impl_(new impl)
+    , top_level_()
+{
+}
+
+mapped_bvh_file::~mapped_bvh_file()
+{
+}
+
+mapped_bvh_file::error_code mapped_bvh_file::map(
+        std::string const&  filename,
+        uint64_t            geometry_hash,
+        size_t              primitive_size
+        )
+{
+    close();
+
+    try
+    {
+        impl_->file.open(filename);
+    }
+    catch (...)
+    {
+        return NonExistent;
+    }
+
+    if (!impl_->file.is_open())
+    {
+        return NonExistent;
+    }
+
+    char const* data = impl_->file.data();
+    uint64_t size = impl_->file.size();
+
+    file_header header;
+
+    if (size < sizeof(header))
+    {
+        close();
+        return InvalidFile;
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.file_size != size)
+    {
+        close();
+        return InvalidFile;
+    }
+
+    if (header.version != Version)
+    {
+        close();
+        return VersionMismatch;
+    }
+
+    if (header.byte_order != ByteOrderMark
+     || header.node_size != sizeof(bvh_node)
+     || header.instance_size != sizeof(detail::bvh_file_instance))
+    {
+        close();
+        return LayoutMismatch;
+    }
+
+    if (header.geometry_hash != geometry_hash)
+    {
+        close();
+        return HashMismatch;
+    }
+
+    // The record and instance tables must fit into the file
+    uint64_t table_size = size - sizeof(header);
+
+    if (header.num_bvhs > table_size / sizeof(file_record)
+     || header.num_instances > table_size / sizeof(detail::bvh_file_instance))
+    {
+        close();
+        return InvalidFile;
+    }
+
+    uint64_t num_records = header.num_bvhs + (header.num_instances > 0 ? 1 : 0);
+
+    if (num_records * sizeof(file_record) + header.num_instances * sizeof(detail::bvh_file_instance) > table_size)
+    {
+        close();
+        return InvalidFile;
+    }
+
+    // Sections must be aligned and lie inside the file, written so that corrupt
+    // offsets and counts cannot overflow
+    auto get_section = [&](file_section s, uint64_t element_size, section& result)
+    {
+        if (s.count == 0)
+        {
+            result = { nullptr, 0 };
+            return true;
+        }
+
+        if (element_size == 0
+         || s.offset % Alignment != 0
+         || s.offset > size
+         || s.count > (size - s.offset) / element_size)
+        {
+            return false;
+        }
+
+        result.data = data + s.offset;
+        result.count = static_cast<size_t>(s.count);
+
+        return true;
+    };
+
+    std::vector<record> records(num_records);
+
+    for (uint64_t i = 0; i < num_records; ++i)
+    {
+        file_record fr;
+        std::memcpy(&fr, data + sizeof(header) + i * sizeof(file_record), sizeof(fr));
+
+        // Check the record before touching its sections. BVHs store primitives of the
+        // requested type, the top-level BVH stores no primitives at all
+        bool top_level = i == header.num_bvhs;
+
+        if ((fr.kind != detail::PlainBVH && fr.kind != detail::IndexBVH)
+         || (top_level && (fr.primitive_size != 0 || fr.primitives.count != 0))
+         || (!top_level && fr.primitive_size == 0))
+        {
+            close();
+            return InvalidFile;
+        }
+
+        if (!top_level && fr.primitive_size != primitive_size)
+        {
+            close();
+            return LayoutMismatch;
+        }
+
+        records[i].kind = fr.kind;
+        records[i].primitive_size = fr.primitive_size;
+
+        if (!get_section(fr.primitives, fr.primitive_size, records[i].primitives)
+         || !get_section(fr.nodes, sizeof(bvh_node), records[i].nodes)
+         || !get_section(fr.indices, sizeof(unsigned), records[i].indices))
+        {
+            close();
+            return InvalidFile;
+        }
+    }
+
+    if (header.num_instances > 0)
+    {
+        top_level_ = records.back();
+        records.pop_back();
+    }
+
+    bvhs_ = std::move(records);
+
+    instances_.resize(header.num_instances);
+
+    if (header.num_instances > 0)
+    {
+        std::memcpy(
+                instances_.data(),
+                data + sizeof(header) + num_records * sizeof(file_record),
+                header.num_instances * sizeof(detail::bvh_file_instance)
+                );
+    }
+
+    for (auto const& inst : instances_)
+    {
+        if (inst.bvh_index >= bvhs_.size())
+        {
+            close();
+            return InvalidFile;
+        }
+    }
+
+    return Ok;
+}
+
+void mapped_bvh_file::close()
+{
+    if (impl_->file.is_open())
+    {
+        impl_->file.close();
+    }
+
+    bvhs_.clear();
+    instances_.clear();
+    top_level_ = record();
+}
+
+bool mapped_bvh_file::good() const
+{
+    return impl_->file.is_open();
+}
+
+size_t mapped_bvh_file::num_bvhs() const
+{
+    return bvhs_.size();
+}
+
+bool mapped_bvh_file::is_index_bvh(size_t index) const
+{
+    assert(index < bvhs_.size());
+
+    return bvhs_[index].kind == detail::IndexBVH;
+}
+
+size_t mapped_bvh_file::num_instances() const
+{
+    return instances_.size();
+}
+
+bool mapped_bvh_file::has_top_level() const
+{
+    return !instances_.empty();
+}
+
+size_t mapped_bvh_file::get_instance_bvh(size_t index) const
+{
+    assert(index < instances_.size());
+
+    return instances_[index].bvh_index;
+}
+
+mat4 mapped_bvh_file::get_instance_transform(size_t index) const
+{
+    assert(index < instances_.size());
+
+    return instances_[index].transform;
+}
+
+bool mapped_bvh_file::check(size_t index, uint32_t kind, size_t primitive_size) const
+{
+    assert(index < bvhs_.size());
+    assert(bvhs_[index].kind == kind);
+    assert(bvhs_[index].primitive_size == primitive_size);
+
+    return index < bvhs_.size()
+        && bvhs_[index].kind == kind
+        && bvhs_[index].primitive_size == primitive_size;
+}
+
+} // visionaray
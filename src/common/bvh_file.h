@@ -0,0 +1,277 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_COMMON_BVH_FILE_H
+#define VSNRAY_COMMON_BVH_FILE_H 1
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <visionaray/math/forward.h>
+#include <visionaray/math/matrix.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Binary BVH files
+//
+// Stores one or more BVHs (nodes, indices and primitives) and optionally a two-level
+// instance structure in a versioned binary format. The sections are aligned so that a
+// memory-mapped file can be traversed in place, without copies or rebuilds:
+//
+//  mapped_bvh_file file;
+//  if (file.open<P>(filename, hash_geometry(prims.data(), prims.size() * sizeof(P))) == mapped_bvh_file::Ok)
+//  {
+//      auto ref = file.get_index_bvh_ref<P>(0);
+//      ...
+//  }
+//
+// A file is only valid with the geometry it was built from, and for the same primitive
+// and node layout. Files store the host byte order and are not portable between
+// architectures. Mix the builder into the hash with hash_combine() so that BVHs built
+// with another builder are not loaded.
+//
+
+// Hash of the source geometry, stored with the BVHs to detect stale files
+uint64_t hash_geometry(void const* data, size_t size);
+
+// Mix a value, e.g. a bvh_file_builder, into a hash
+uint64_t hash_combine(uint64_t hash, uint64_t value);
+
+// Builders and their settings, identifies how the BVHs in a file were built
+enum bvh_file_builder : uint64_t
+{
+    BinnedSAHBuilder = 0,   // binned_sah_builder without spatial splits
+    SplitBVHBuilder  = 1,   // binned_sah_builder with spatial splits
+    LBVHBuilder      = 2    // lbvh_builder
+};
+
+
+namespace detail
+{
+
+enum bvh_file_kind : uint32_t
+{
+    PlainBVH = 0,
+    IndexBVH = 1
+};
+
+// One BVH as raw memory
+struct bvh_file_record
+{
+    uint32_t    kind;
+    uint32_t    primitive_size;
+    void const* primitives;
+    uint64_t    num_primitives;
+    void const* nodes;
+    uint64_t    num_nodes;
+    void const* indices;
+    uint64_t    num_indices;
+};
+
+struct bvh_file_instance
+{
+    mat4        transform;
+    uint32_t    bvh_index;
+    uint32_t    pad[3];
+};
+
+template <typename PV, typename NV>
+inline bvh_file_record make_bvh_file_record(bvh_t<PV, NV> const& b)
+{
+    return {
+        PlainBVH,
+        static_cast<uint32_t>(sizeof(typename bvh_t<PV, NV>::primitive_type)),
+        b.primitives().data(),
+        b.primitives().size(),
+        b.nodes().data(),
+        b.nodes().size(),
+        nullptr,
+        0
+        };
+}
+
+template <typename PV, typename NV, typename IV>
+inline bvh_file_record make_bvh_file_record(index_bvh_t<PV, NV, IV> const& b)
+{
+    return {
+        IndexBVH,
+        static_cast<uint32_t>(sizeof(typename index_bvh_t<PV, NV, IV>::primitive_type)),
+        b.primitives().data(),
+        b.primitives().size(),
+        b.nodes().data(),
+        b.nodes().size(),
+        b.indices().data(),
+        b.indices().size()
+        };
+}
+
+bool write_bvh_file(
+        std::string const&                      filename,
+        uint64_t                                geometry_hash,
+        std::vector<bvh_file_record> const&     bvhs,
+        std::vector<bvh_file_instance> const&   instances,
+        bvh_file_record const*                  top_level
+        );
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Save a single BVH
+//
+
+template <typename BVH>
+bool save_bvh(std::string const& filename, BVH const& bvh, uint64_t geometry_hash)
+{
+    std::vector<detail::bvh_file_record> bvhs(1, detail::make_bvh_file_record(bvh));
+
+    return detail::write_bvh_file(filename, geometry_hash, bvhs, {}, nullptr);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Save a two-level BVH
+//
+// Instance i references bvhs[instance_bvhs[i]] with transform instance_transforms[i]. The
+// instance pointers of the top-level BVH are not stored, only its nodes and indices.
+//
+
+template <typename BVH, typename TopLevelBVH>
+bool save_bvh(
+        std::string const&          filename,
+        aligned_vector<BVH> const&  bvhs,
+        std::vector<size_t> const&  instance_bvhs,
+        aligned_vector<mat4> const& instance_transforms,
+        TopLevelBVH const&          top_level,
+        uint64_t                    geometry_hash
+        )
+{
+    assert(instance_bvhs.size() == instance_transforms.size());
+    assert(instance_bvhs.size() == top_level.num_primitives());
+
+    std::vector<detail::bvh_file_record> records;
+
+    for (auto const& b : bvhs)
+    {
+        records.push_back(detail::make_bvh_file_record(b));
+    }
+
+    std::vector<detail::bvh_file_instance> instances(instance_bvhs.size());
+
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+        instances[i].transform = instance_transforms[i];
+        instances[i].bvh_index = static_cast<uint32_t>(instance_bvhs[i]);
+    }
+
+    auto top = detail::make_bvh_file_record(top_level);
+    top.primitives = nullptr;
+    top.primitive_size = 0;
+    top.num_primitives = 0;
+
+    return detail::write_bvh_file(filename, geometry_hash, records, instances, &top);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Memory-mapped BVH file
+//
+// BVH refs point into the mapping and stay valid as long as the file is open.
+//
+
+class mapped_bvh_file
+{
+public:
+
+    enum error_code
+    {
+        Ok, NonExistent, InvalidFile, VersionMismatch, LayoutMismatch, HashMismatch
+    };
+
+public:
+
+    mapped_bvh_file();
+   ~mapped_bvh_file();
+
+    // Map the file and check that it was built from the geometry with this hash,
+    // and that its BVHs store primitives of type P
+    template <typename P>
+    error_code open(std::string const& filename, uint64_t geometry_hash);
+    void close();
+
+    bool good() const;
+
+    size_t num_bvhs() const;
+    bool is_index_bvh(size_t index) const;
+
+    template <typename P>
+    bvh_ref_t<P> get_bvh_ref(size_t index) const;
+
+    template <typename P>
+    index_bvh_ref_t<P> get_index_bvh_ref(size_t index) const;
+
+    // Copy into a BVH with its own storage
+    template <typename P>
+    bool load(size_t index, index_bvh<P>& bvh) const;
+
+    // Two-level BVHs
+
+    size_t num_instances() const;
+    bool has_top_level() const;
+
+    size_t get_instance_bvh(size_t index) const;
+    mat4 get_instance_transform(size_t index) const;
+
+    // Instances referencing the mapped BVHs
+    template <typename P>
+    aligned_vector<index_bvh_inst_t<P>> get_instances() const;
+
+    // Top-level BVH over instances created with get_instances()
+    template <typename Instance>
+    index_bvh_ref_t<Instance> get_top_level_ref(Instance const* instances) const;
+
+private:
+
+    struct section
+    {
+        char const* data;
+        size_t      count;
+    };
+
+    struct record
+    {
+        uint32_t    kind;
+        uint32_t    primitive_size;
+        section     primitives;
+        section     nodes;
+        section     indices;
+    };
+
+    struct impl;
+    std::unique_ptr<impl> impl_;
+
+    std::vector<record> bvhs_;
+    std::vector<detail::bvh_file_instance> instances_;
+    record top_level_;
+
+    error_code map(std::string const& filename, uint64_t geometry_hash, size_t primitive_size);
+
+    bool check(size_t index, uint32_t kind, size_t primitive_size) const;
+
+};
+
+} // visionaray
+
+#include "bvh_file.inl"
+
+#endif // VSNRAY_COMMON_BVH_FILE_H
@@ -0,0 +1,108 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// mapped_bvh_file members
+//
+
+template <typename P>
+mapped_bvh_file::error_code mapped_bvh_file::open(std::string const& filename, uint64_t geometry_hash)
+{
+    return map(filename, geometry_hash, sizeof(P));
+}
+
+template <typename P>
+bvh_ref_t<P> mapped_bvh_file::get_bvh_ref(size_t index) const
+{
+    if (!check(index, detail::PlainBVH, sizeof(P)))
+    {
+        return {};
+    }
+
+    auto const& r = bvhs_[index];
+
+    auto p0 = reinterpret_cast<P const*>(r.primitives.data);
+    auto n0 = reinterpret_cast<bvh_node const*>(r.nodes.data);
+
+    return { p0, p0 + r.primitives.count, n0, n0 + r.nodes.count };
+}
+
+template <typename P>
+index_bvh_ref_t<P> mapped_bvh_file::get_index_bvh_ref(size_t index) const
+{
+    if (!check(index, detail::IndexBVH, sizeof(P)))
+    {
+        return {};
+    }
+
+    auto const& r = bvhs_[index];
+
+    auto p0 = reinterpret_cast<P const*>(r.primitives.data);
+    auto n0 = reinterpret_cast<bvh_node const*>(r.nodes.data);
+    auto i0 = reinterpret_cast<unsigned const*>(r.indices.data);
+
+    return { p0, p0 + r.primitives.count, n0, n0 + r.nodes.count, i0, i0 + r.indices.count };
+}
+
+template <typename P>
+bool mapped_bvh_file::load(size_t index, index_bvh<P>& bvh) const
+{
+    if (!check(index, detail::IndexBVH, sizeof(P)))
+    {
+        return false;
+    }
+
+    auto const& r = bvhs_[index];
+
+    auto p0 = reinterpret_cast<P const*>(r.primitives.data);
+    auto n0 = reinterpret_cast<bvh_node const*>(r.nodes.data);
+    auto i0 = reinterpret_cast<unsigned const*>(r.indices.data);
+
+    bvh.primitives().assign(p0, p0 + r.primitives.count);
+    bvh.nodes().assign(n0, n0 + r.nodes.count);
+    bvh.indices().assign(i0, i0 + r.indices.count);
+
+    return true;
+}
+
+template <typename P>
+aligned_vector<index_bvh_inst_t<P>> mapped_bvh_file::get_instances() const
+{
+    aligned_vector<index_bvh_inst_t<P>> result(instances_.size());
+
+    for (size_t i = 0; i < instances_.size(); ++i)
+    {
+        result[i] = index_bvh_inst_t<P>(
+                get_index_bvh_ref<P>(instances_[i].bvh_index),
+                instances_[i].transform
+                );
+    }
+
+    return result;
+}
+
+template <typename Instance>
+index_bvh_ref_t<Instance> mapped_bvh_file::get_top_level_ref(Instance const* instances) const
+{
+    if (!has_top_level())
+    {
+        return {};
+    }
+
+    auto n0 = reinterpret_cast<bvh_node const*>(top_level_.nodes.data);
+    auto i0 = reinterpret_cast<unsigned const*>(top_level_.indices.data);
+
+    return {
+        instances,
+        instances + instances_.size(),
+        n0,
+        n0 + top_level_.nodes.count,
+        i0,
+        i0 + top_level_.indices.count
+        };
+}
+
+} // visionaray
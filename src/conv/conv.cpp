@@ -10,6 +10,9 @@
 #include <Support/CmdLine.h>
 #include <Support/CmdLineUtil.h>
 
+#include <visionaray/bvh.h>
+
+#include <common/bvh_file.h>
 #include <common/model.h>
 
 using namespace support;
@@ -24,6 +27,7 @@ public:
 
     std::string input_file;
     std::string output_file;
+    std::string bvh_file;
 
     file_base::save_options options;
 
@@ -53,6 +57,15 @@ void converter::parse_cmd_line(int argc, char** argv)
         cl::init(output_file)
         );
 
+    auto bfile = cl::makeOption<std::string&>(
+        cl::Parser<>(),
+        cmd,
+        "bvh",
+        cl::Desc("Also build a BVH with spatial splits for the model and write it to this file (see vsnray-viewer -bvh=split -bvh-file)"),
+        cl::ArgRequired,
+        cl::init(bvh_file)
+        );
+
 
     auto args = std::vector<std::string>(argv + 1, argv + argc);
     cl::expandWildcards(args);
@@ -86,4 +99,34 @@ int main(int argc, char** argv)
         std::cout << "Error: cannot save output file: " << conv.output_file << '\n';
         exit(EXIT_FAILURE);
     }
+
+    if (!conv.bvh_file.empty())
+    {
+        if (mod.scene_graph != nullptr)
+        {
+            std::cout << "Error: BVH files can only be written for models without scene graph\n";
+            exit(EXIT_FAILURE);
+        }
+
+        binned_sah_builder builder;
+        builder.enable_spatial_splits(true);
+        builder.enable_parallel_build(true);
+
+        auto bvh = builder.build(
+                index_bvh<model::triangle_type>{},
+                mod.primitives.data(),
+                mod.primitives.size()
+                );
+
+        auto geometry_hash = hash_combine(
+                hash_geometry(mod.primitives.data(), mod.primitives.size() * sizeof(model::triangle_type)),
+                SplitBVHBuilder
+                );
+
+        if (!save_bvh(conv.bvh_file, bvh, geometry_hash))
+        {
+            std::cout << "Error: cannot save BVH file: " << conv.bvh_file << '\n';
+            exit(EXIT_FAILURE);
+        }
+    }
 }
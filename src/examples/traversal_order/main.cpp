@@ -0,0 +1,282 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <Support/CmdLine.h>
+#include <Support/CmdLineUtil.h>
+
+#include <visionaray/math/math.h>
+#include <visionaray/bvh.h>
+#include <visionaray/pinhole_camera.h>
+
+#include <common/model.h>
+
+using namespace support;
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark state
+//
+
+struct benchmark
+{
+    void parse_cmd_line(int argc, char** argv);
+
+    std::set<std::string> filenames;
+
+    int width = 1024;
+    int height = 1024;
+    int runs = 5;
+
+    model mod;
+    pinhole_camera cam;
+};
+
+void benchmark::parse_cmd_line(int argc, char** argv)
+{
+    cl::CmdLine cmd;
+
+    auto files = cl::makeOption<std::set<std::string>&>(
+        cl::Parser<>(),
+        cmd,
+        "filenames",
+        cl::Desc("Input files in wavefront obj format"),
+        cl::Positional,
+        cl::OneOrMore,
+        cl::init(filenames)
+        );
+
+    auto w = cl::makeOption<int&>(
+        cl::Parser<>(),
+        cmd,
+        "width",
+        cl::Desc("Image width"),
+        cl::ArgRequired,
+        cl::init(width)
+        );
+
+    auto h = cl::makeOption<int&>(
+        cl::Parser<>(),
+        cmd,
+        "height",
+        cl::Desc("Image height"),
+        cl::ArgRequired,
+        cl::init(height)
+        );
+
+    auto r = cl::makeOption<int&>(
+        cl::Parser<>(),
+        cmd,
+        "runs",
+        cl::Desc("Number of runs, the fastest one is reported"),
+        cl::ArgRequired,
+        cl::init(runs)
+        );
+
+
+    auto args = std::vector<std::string>(argv + 1, argv + argc);
+    cl::expandWildcards(args);
+    cl::expandResponseFiles(args, cl::TokenizeUnix());
+
+    try
+    {
+        cmd.parse(args);
+    }
+    catch (...)
+    {
+        std::cout << cmd.help(argv[0]) << '\n';
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Trace one primary ray per pixel, return the time of the fastest run in seconds
+//
+
+template <typename Order, typename BVH>
+double trace_single_rays(benchmark const& bench, BVH const& b, size_t& num_hits)
+{
+    using R = basic_ray<float>;
+
+    default_intersector isect;
+    double best = 0.0;
+
+    for (int run = 0; run < bench.runs; ++run)
+    {
+        num_hits = 0;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (int y = 0; y < bench.height; ++y)
+        {
+            for (int x = 0; x < bench.width; ++x)
+            {
+                auto r = bench.cam.primary_ray(
+                        R{},
+                        static_cast<float>(x),
+                        static_cast<float>(y),
+                        static_cast<float>(bench.width),
+                        static_cast<float>(bench.height)
+                        );
+
+                auto hr = intersect<detail::ClosestHit, 1, Order>(r, b, isect);
+
+                num_hits += hr.hit ? 1 : 0;
+            }
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        double sec = std::chrono::duration<double>(t1 - t0).count();
+
+        best = run == 0 ? sec : std::min(best, sec);
+    }
+
+    return best;
+}
+
+// Same with 2x2 ray packets
+template <typename Order, typename BVH>
+double trace_packets(benchmark const& bench, BVH const& b, size_t& num_hits)
+{
+    using S = simd::float4;
+    using R = basic_ray<S>;
+
+    default_intersector isect;
+    double best = 0.0;
+
+    for (int run = 0; run < bench.runs; ++run)
+    {
+        num_hits = 0;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (int y = 0; y < bench.height; y += 2)
+        {
+            for (int x = 0; x < bench.width; x += 2)
+            {
+                S xs(x + 0.0f, x + 1.0f, x + 0.0f, x + 1.0f);
+                S ys(y + 0.0f, y + 0.0f, y + 1.0f, y + 1.0f);
+
+                auto r = bench.cam.primary_ray(
+                        R{},
+                        xs,
+                        ys,
+                        S(static_cast<float>(bench.width)),
+                        S(static_cast<float>(bench.height))
+                        );
+
+                auto hr = intersect<detail::ClosestHit, 1, Order>(r, b, isect);
+
+                for (auto const& h : simd::unpack(hr))
+                {
+                    num_hits += h.hit ? 1 : 0;
+                }
+            }
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        double sec = std::chrono::duration<double>(t1 - t0).count();
+
+        best = run == 0 ? sec : std::min(best, sec);
+    }
+
+    return best;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Compare distance_order and split_axis_order
+//
+
+template <typename BVH>
+void run_benchmark(benchmark const& bench, BVH const& b, std::string const& builder_name)
+{
+    double mrays = bench.width * static_cast<double>(bench.height) / 1.0e6;
+
+    auto print = [&](char const* mode, char const* order, double sec, size_t hits)
+    {
+        std::cout << std::left
+                  << std::setw(8) << builder_name
+                  << std::setw(10) << mode
+                  << std::setw(12) << order
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << mrays / sec << " MRays/s"
+                  << std::setw(12) << hits << " hits\n";
+    };
+
+    size_t hits = 0;
+    double sec = 0.0;
+
+    sec = trace_single_rays<detail::distance_order>(bench, b, hits);
+    print("single", "distance", sec, hits);
+
+    sec = trace_single_rays<detail::split_axis_order>(bench, b, hits);
+    print("single", "split axis", sec, hits);
+
+    sec = trace_packets<detail::distance_order>(bench, b, hits);
+    print("packet4", "distance", sec, hits);
+
+    sec = trace_packets<detail::split_axis_order>(bench, b, hits);
+    print("packet4", "split axis", sec, hits);
+}
+
+int main(int argc, char** argv)
+{
+    benchmark bench;
+    bench.parse_cmd_line(argc, argv);
+
+    std::vector<std::string> filenames;
+    std::copy(bench.filenames.begin(), bench.filenames.end(), std::back_inserter(filenames));
+
+    if (!bench.mod.load(filenames))
+    {
+        std::cout << "Error: cannot load input files\n";
+        exit(EXIT_FAILURE);
+    }
+
+    if (bench.width % 2 != 0 || bench.height % 2 != 0)
+    {
+        std::cout << "Error: width and height must be multiples of 2\n";
+        exit(EXIT_FAILURE);
+    }
+
+    float aspect = bench.width / static_cast<float>(bench.height);
+
+    bench.cam.perspective(45.0f * constants::degrees_to_radians<float>(), aspect, 0.001f, 1000.0f);
+    bench.cam.set_viewport(0, 0, bench.width, bench.height);
+    bench.cam.view_all(bench.mod.bbox);
+    bench.cam.begin_frame();
+
+    std::cout << bench.mod.primitives.size() << " triangles, "
+              << bench.width << "x" << bench.height << " rays, best of "
+              << bench.runs << " runs\n\n";
+
+    binned_sah_builder sah;
+    sah.enable_spatial_splits(true);
+
+    run_benchmark(
+            bench,
+            sah.build(index_bvh<model::triangle_type>{}, bench.mod.primitives.data(), bench.mod.primitives.size()),
+            "sbvh"
+            );
+
+    lbvh_builder lbvh;
+
+    run_benchmark(
+            bench,
+            lbvh.build(index_bvh<model::triangle_type>{}, bench.mod.primitives.data(), bench.mod.primitives.size()),
+            "lbvh"
+            );
+}
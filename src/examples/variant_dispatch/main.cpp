@@ -0,0 +1,263 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Support/CmdLine.h>
+#include <Support/CmdLineUtil.h>
+
+#include <visionaray/variant.h>
+
+using namespace support;
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark state
+//
+
+struct benchmark
+{
+    void parse_cmd_line(int argc, char** argv);
+
+    int count = 1 << 22;
+    int runs = 10;
+};
+
+void benchmark::parse_cmd_line(int argc, char** argv)
+{
+    cl::CmdLine cmd;
+
+    auto c = cl::makeOption<int&>(
+        cl::Parser<>(),
+        cmd,
+        "count",
+        cl::Desc("Number of variants visited per run"),
+        cl::ArgRequired,
+        cl::init(count)
+        );
+
+    auto r = cl::makeOption<int&>(
+        cl::Parser<>(),
+        cmd,
+        "runs",
+        cl::Desc("Number of runs, the fastest one is reported"),
+        cl::ArgRequired,
+        cl::init(runs)
+        );
+
+
+    auto args = std::vector<std::string>(argv + 1, argv + argc);
+    cl::expandWildcards(args);
+    cl::expandResponseFiles(args, cl::TokenizeUnix());
+
+    try
+    {
+        cmd.parse(args);
+    }
+    catch (...)
+    {
+        std::cout << cmd.help(argv[0]) << '\n';
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Reference: the recursive dispatch that apply_visitor used before the switch,
+// tests the alternatives one after another
+//
+
+template <unsigned I, typename ...Ts>
+struct chain_visitor_impl;
+
+template <unsigned I, typename T, typename ...Ts>
+struct chain_visitor_impl<I, T, Ts...>
+{
+    template <typename Visitor, typename Variant>
+    typename Visitor::return_type operator()(Visitor const& visitor, Variant const& var) const
+    {
+        auto ptr = var.template as<T>();
+
+        if (ptr)
+        {
+            return visitor(*ptr);
+        }
+        else
+        {
+            return chain_visitor_impl<I - 1, Ts...>()(visitor, var);
+        }
+    }
+};
+
+template <>
+struct chain_visitor_impl<0>
+{
+    template <typename Visitor, typename Variant>
+    typename Visitor::return_type operator()(Visitor const&, Variant const&) const
+    {
+        return typename Visitor::return_type();
+    }
+};
+
+template <typename Visitor, typename ...Ts>
+typename Visitor::return_type apply_visitor_chain(Visitor const& visitor, variant<Ts...> const& var)
+{
+    return chain_visitor_impl<sizeof...(Ts), Ts...>()(visitor, var);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Alternatives and visitor, a little arithmetic per alternative so that the
+// calls cannot be merged
+//
+
+template <int ...Is>
+struct indices
+{
+};
+
+template <int I>
+struct alternative
+{
+    float a;
+    float b;
+};
+
+struct eval_visitor
+{
+    using return_type = float;
+
+    template <int I>
+    float operator()(alternative<I> const& alt) const
+    {
+        return alt.a * (I + 1) + alt.b * (I ^ 3);
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Visit all variants, return the time of the fastest run in milliseconds
+//
+
+template <typename Dispatch, typename Variant>
+double visit_all(benchmark const& bench, std::vector<Variant> const& vars, Dispatch dispatch, float& sum)
+{
+    double best = 0.0;
+
+    for (int run = 0; run < bench.runs; ++run)
+    {
+        sum = 0.0f;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (auto const& var : vars)
+        {
+            sum += dispatch(eval_visitor(), var);
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+        best = run == 0 ? ms : std::min(best, ms);
+    }
+
+    return best;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Compare chain and switch dispatch for variants with sizeof...(Is) alternatives,
+// in random order and sorted by alternative
+//
+
+template <int ...Is>
+void run_benchmark(benchmark const& bench, indices<Is...>)
+{
+    using variant_type = variant<alternative<Is>...>;
+
+    variant_type table[] = { variant_type(alternative<Is>{ static_cast<float>(Is), 2.0f })... };
+
+    std::vector<variant_type> vars(bench.count);
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<size_t> dist(0, sizeof...(Is) - 1);
+
+    for (auto& var : vars)
+    {
+        var = table[dist(rng)];
+    }
+
+    auto chain = [](eval_visitor const& visitor, variant_type const& var)
+    {
+        return apply_visitor_chain(visitor, var);
+    };
+
+    auto dispatch = [](eval_visitor const& visitor, variant_type const& var)
+    {
+        return apply_visitor(visitor, var);
+    };
+
+    auto print = [&](char const* order, double chain_ms, double switch_ms)
+    {
+        std::cout << std::left
+                  << std::setw(4) << sizeof...(Is)
+                  << std::setw(8) << order
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << chain_ms << " ms"
+                  << std::setw(10) << switch_ms << " ms"
+                  << std::setw(10) << chain_ms / switch_ms << "x\n";
+    };
+
+    float sum_chain = 0.0f;
+    float sum_switch = 0.0f;
+
+    double chain_ms = visit_all(bench, vars, chain, sum_chain);
+    double switch_ms = visit_all(bench, vars, dispatch, sum_switch);
+    print("random", chain_ms, switch_ms);
+
+    std::sort(
+            vars.begin(),
+            vars.end(),
+            [](variant_type const& a, variant_type const& b) { return a.which() < b.which(); }
+            );
+
+    chain_ms = visit_all(bench, vars, chain, sum_chain);
+    switch_ms = visit_all(bench, vars, dispatch, sum_switch);
+    print("sorted", chain_ms, switch_ms);
+
+    if (sum_chain != sum_switch)
+    {
+        std::cout << "Error: chain and switch dispatch disagree\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    benchmark bench;
+    bench.parse_cmd_line(argc, argv);
+
+    std::cout << bench.count << " variants, best of " << bench.runs << " runs\n\n";
+
+    std::cout << std::left
+              << std::setw(4) << "N"
+              << std::setw(8) << "order"
+              << std::right
+              << std::setw(13) << "chain"
+              << std::setw(13) << "switch"
+              << std::setw(11) << "speedup\n";
+
+    run_benchmark(bench, indices<0, 1>{});
+    run_benchmark(bench, indices<0, 1, 2, 3>{});
+    run_benchmark(bench, indices<0, 1, 2, 3, 4, 5, 6, 7>{});
+}
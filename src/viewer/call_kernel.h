@@ -8,6 +8,7 @@
 
 #include <utility>
 
+#include <visionaray/accumulation_buffer_rt.h>
 #include <visionaray/kernels.h>
 #include <visionaray/pinhole_camera.h>
 #include <visionaray/scheduler.h>
@@ -15,6 +16,8 @@
 #include <visionaray/thin_lens_camera.h>
 #include <visionaray/variant.h>
 
+#include "host_device_rt.h"
+
 namespace visionaray
 {
 
@@ -32,6 +35,83 @@ namespace visionaray
 enum algorithm { Simple, Whitted, Pathtracing };
 
 
+//-------------------------------------------------------------------------------------------------
+// Path tracing
+//
+// Blend each frame on top of the color buffer, or add it to an accumulation buffer. Host
+// render targets accumulate on the CPU, resolve_accum_buffer() has to be called before
+// the frame is displayed
+//
+
+template <typename Sched, typename KParams, typename Camera, typename RT>
+inline void blend_pathtracing_frame(
+        Sched&          sched,
+        KParams const&  kparams,
+        unsigned&       frame_num,
+        Camera const&   cam,
+        RT&             rt
+        )
+{
+    float alpha = 1.0f / ++frame_num;
+    pixel_sampler::jittered_blend_type blend_params;
+    blend_params.sfactor = alpha;
+    blend_params.dfactor = 1.0f - alpha;
+    sched.frame(
+        pathtracing::kernel<KParams>({kparams}),
+        make_sched_params(blend_params, cam, rt)
+        );
+}
+
+template <typename Sched, typename KParams, typename Camera, typename RT>
+inline void call_pathtracing_kernel(
+        Sched&          sched,
+        KParams const&  kparams,
+        unsigned&       frame_num,
+        Camera const&   cam,
+        RT&             rt
+        )
+{
+    blend_pathtracing_frame(sched, kparams, frame_num, cam, rt);
+}
+
+template <typename Sched, typename KParams, typename Camera, typename T>
+inline void call_pathtracing_kernel(
+        Sched&                      sched,
+        KParams const&              kparams,
+        unsigned&                   frame_num,
+        Camera const&               cam,
+        accumulation_buffer_rt<T>&  rt
+        )
+{
+    ++frame_num;
+    sched.frame(
+        pathtracing::kernel<KParams>({kparams}),
+        make_sched_params(pixel_sampler::jittered_type{}, cam, rt)
+        );
+}
+
+#ifndef __CUDACC__
+template <typename Sched, typename KParams, typename Camera>
+inline void call_pathtracing_kernel(
+        Sched&          sched,
+        KParams const&  kparams,
+        unsigned&       frame_num,
+        Camera const&   cam,
+        host_device_rt& rt
+        )
+{
+    if (rt.mode() == host_device_rt::CPU)
+    {
+        call_pathtracing_kernel(sched, kparams, frame_num, cam, rt.accum_buffer());
+    }
+    else
+    {
+        blend_pathtracing_frame(sched, kparams, frame_num, cam, rt);
+    }
+}
+#endif
+
+
 //-------------------------------------------------------------------------------------------------
 // Pinhole camera vs. thin lens camera
 //
@@ -78,7 +158,7 @@ inline void call_kernel(
 // Call one of the built-in kernels
 //
 // Simple, Whitted: mind ssaa_samples
-// Pathtracing:     jittered-blend sampling
+// Pathtracing:     jittered-blend sampling or accumulation, see call_pathtracing_kernel()
 //
 
 template <typename Sched, typename KParams, typename ...Args>
@@ -157,18 +237,9 @@ void call_kernel(
         break;
 
     case Pathtracing:
-    {
-        float alpha = 1.0f / ++frame_num;
-        pixel_sampler::jittered_blend_type blend_params;
-        blend_params.sfactor = alpha;
-        blend_params.dfactor = 1.0f - alpha;
-        sched.frame(
-            pathtracing::kernel<KParams>({kparams}),
-            make_sched_params(blend_params, std::forward<Args>(args)...)
-            );
+        call_pathtracing_kernel(sched, kparams, frame_num, std::forward<Args>(args)...);
         break;
     }
-    }
 }
 
 } // visionaray
@@ -2,6 +2,7 @@
 // See the LICENSE file for details.
 
 #include <cassert>
+#include <thread>
 #include <utility>
 
 #include <GL/glew.h>
@@ -39,6 +40,12 @@ struct host_device_rt::impl
     // Host render target
     cpu_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> host_rt[2];
 
+    // Progressive accumulation on the host, resolved to host_rt
+    accum_buffer_type accum_rt;
+
+    // Threads for resolving accum_rt
+    thread_pool resolve_pool{std::thread::hardware_concurrency()};
+
 #ifdef __CUDACC__
     // Device render target, uses PBO
     pixel_unpack_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> direct_rt[2];
@@ -165,6 +172,7 @@ host_device_rt::ref_type host_device_rt::ref(buffer buf)
 void host_device_rt::clear_color_buffer(vec4 const& color, buffer buf)
 {
     impl_->host_rt[impl_->buffer_index[buf]].clear_color_buffer(color);
+    impl_->accum_rt.clear();
 #ifdef __CUDACC__
     if (impl_->direct_rendering)
     {
@@ -223,6 +231,8 @@ void host_device_rt::resize(int w, int h)
 {
     render_target::resize(w, h);
 
+    impl_->accum_rt.resize(w, h);
+
     int num_buffers = impl_->double_buffering ? 2 : 1;
     for (int buf = 0; buf < num_buffers; ++buf)
     {
@@ -286,4 +296,19 @@ void host_device_rt::display_color_buffer(buffer buf) const
     }
 }
 
+host_device_rt::accum_buffer_type& host_device_rt::accum_buffer()
+{
+    return impl_->accum_rt;
+}
+
+void host_device_rt::resolve_accum_buffer(buffer buf)
+{
+    assert(impl_->mode == CPU);
+
+    impl_->accum_rt.resolve(
+            impl_->resolve_pool,
+            impl_->host_rt[impl_->buffer_index[buf]].ref()
+            );
+}
+
 } // visionaray
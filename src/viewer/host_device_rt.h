@@ -8,6 +8,7 @@
 
 #include <memory>
 
+#include <visionaray/accumulation_buffer_rt.h>
 #include <visionaray/render_target.h>
 
 namespace visionaray
@@ -19,6 +20,7 @@ public:
 
     using color_type = typename pixel_traits<PF_RGBA32F>::type;
     using ref_type = render_target_ref<PF_RGBA32F, PF_UNSPECIFIED>;
+    using accum_buffer_type = accumulation_buffer_rt<double>;
 
     enum buffer
     {
@@ -72,6 +74,12 @@ public:
     void resize(int w, int h);
     void display_color_buffer(buffer buf = Front) const;
 
+    // Running sums for progressive rendering on the CPU, cleared by clear_color_buffer()
+    accum_buffer_type& accum_buffer();
+
+    // Store the means of the accumulated samples in the color buffer (CPU only)
+    void resolve_accum_buffer(buffer buf = Back);
+
 private:
 
     struct impl;
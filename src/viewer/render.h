@@ -21,8 +21,10 @@
 #include <visionaray/aligned_vector.h>
 #include <visionaray/area_light.h>
 #include <visionaray/bvh.h>
+#include <visionaray/environment_light.h>
 #include <visionaray/generic_light.h>
 #include <visionaray/generic_material.h>
+#include <visionaray/light_sampler.h>
 #include <visionaray/material.h>
 #include <visionaray/pinhole_camera.h>
 #include <visionaray/point_light.h>
@@ -63,11 +65,13 @@ using ray_type_gpu              = basic_ray<scalar_type_gpu>;
 
 using camera_t = variant<pinhole_camera, thin_lens_camera>;
 using plastic_t = plastic<float>;
+using environment_light_t = environment_light<float, texture_ref<vec4, 2>>;
 using generic_light_t = generic_light<
         point_light<float>,
         spot_light<float>,
-        area_light<float, basic_triangle<3, float>>//,
-        //area_light<float, basic_sphere<float>>
+        area_light<float, basic_triangle<3, float>>,
+        //area_light<float, basic_sphere<float>>,
+        environment_light_t
         >;
 using generic_material_t = generic_material<
         emissive<float>,
@@ -149,6 +153,7 @@ void render_generic_material_cpp(
         aligned_vector<generic_material_t> const&                          materials,
         aligned_vector<texture_t> const&                                   textures,
         aligned_vector<area_light<float, basic_triangle<3, float>>> const& lights,
+        light_bvh const&                                                   light_sampler,
         unsigned                                                           bounces,
         float                                                              epsilon,
         vec4                                                               bgcolor,
@@ -197,6 +202,7 @@ void render_instances_cpp(
         aligned_vector<vec3> const&                               colors,
         aligned_vector<texture_t> const&                          textures,
         aligned_vector<generic_light_t> const&                    lights,
+        int                                                       environment_index,
         unsigned                                                  bounces,
         float                                                     epsilon,
         vec4                                                      bgcolor,
@@ -14,6 +14,7 @@ void render_generic_material_cpp(
         aligned_vector<generic_material_t> const&                          materials,
         aligned_vector<texture_t> const&                                   textures,
         aligned_vector<area_light<float, basic_triangle<3, float>>> const& lights,
+        light_bvh const&                                                   light_sampler,
         unsigned                                                           bounces,
         float                                                              epsilon,
         vec4                                                               bgcolor,
@@ -49,7 +50,15 @@ void render_generic_material_cpp(
             ambient
             );
 
-    call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+    call_kernel(
+            algo,
+            sched,
+            with_light_sampler(kparams, light_sampler.ref()),
+            frame_num,
+            ssaa_samples,
+            cam,
+            rt
+            );
 }
 
 } // visionaray
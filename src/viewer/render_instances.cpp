@@ -17,6 +17,7 @@ void render_instances_cpp(
         aligned_vector<vec3> const&                               colors,
         aligned_vector<texture_t> const&                          textures,
         aligned_vector<generic_light_t> const&                    lights,
+        int                                                       environment_index,
         unsigned                                                  bounces,
         float                                                     epsilon,
         vec4                                                      bgcolor,
@@ -54,7 +55,25 @@ void render_instances_cpp(
             ambient
             );
 
-    call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+    // Environment light is one of the lights, rays that leave the scene pick up its radiance
+    if (environment_index >= 0)
+    {
+        auto const& environment = *lights[environment_index].as<environment_light_t>();
+
+        call_kernel(
+                algo,
+                sched,
+                with_environment_light(kparams, environment, environment_index),
+                frame_num,
+                ssaa_samples,
+                cam,
+                rt
+                );
+    }
+    else
+    {
+        call_kernel( algo, sched, kparams, frame_num, ssaa_samples, cam, rt );
+    }
 }
 
 } // visionaray
@@ -53,6 +53,7 @@
 #include <common/manip/arcball_manipulator.h>
 #include <common/manip/pan_manipulator.h>
 #include <common/manip/zoom_manipulator.h>
+#include <common/bvh_file.h>
 #include <common/inifile.h>
 #include <common/make_materials.h>
 #include <common/model.h>
@@ -162,6 +163,14 @@ struct renderer : viewer_type
             cl::init(this->build_strategy)
             ) );
 
+        add_cmdline_option( cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "bvh-file",
+            cl::Desc("BVH cache file, loaded if it matches the model and build strategy, written otherwise"),
+            cl::ArgRequired,
+            cl::init(this->bvh_filename)
+            ) );
+
         add_cmdline_option( cl::makeOption<unsigned&>({
                 { "1",      1,      "1x supersampling" },
                 { "2",      2,      "2x supersampling" },
@@ -396,6 +405,7 @@ struct renderer : viewer_type
 
     std::set<std::string>                       filenames;
     std::string                                 initial_camera;
+    std::string                                 bvh_filename;
     std::string                                 current_cam;
 
     model                                       mod;
@@ -410,6 +420,8 @@ struct renderer : viewer_type
     aligned_vector<spot_light<float>>           spot_lights;
     aligned_vector<area_light<float,
                    basic_triangle<3, float>>>   area_lights;
+    light_bvh                                   area_light_bvh;
+    distribution_2d                             environment_distribution;
 #if VSNRAY_COMMON_HAVE_PTEX
     aligned_vector<ptex::face_id_t>             ptex_tex_coords;
     aligned_vector<ptex::texture>               ptex_textures;
@@ -434,6 +446,7 @@ struct renderer : viewer_type
 
     std::shared_ptr<visionaray::texture<vec4, 2>>
                                                 environment_map = nullptr;
+    mat4                                        environment_transform = mat4::identity();
 
 
     // List of cameras, e.g. read from scene graph
@@ -610,6 +623,7 @@ struct build_scene_visitor : sg::node_visitor
             environment_map->set_address_mode(tex->get_address_mode());
             environment_map->set_filter_mode(tex->get_filter_mode());
             environment_map->reset(tex->data());
+            environment_transform = current_transform_;
         }
 
         node_visitor::apply(el);
@@ -867,6 +881,7 @@ struct build_scene_visitor : sg::node_visitor
 
     // Environment map
     std::shared_ptr<visionaray::texture<vec4, 2>> environment_map;
+    mat4 environment_transform = mat4::identity();
 
     // Assign consecutive prim ids
     unsigned current_prim_id_ = 0;
@@ -900,19 +915,56 @@ void renderer::build_scene()
     {
         // Single BVH
         host_bvhs.resize(1);
-        if (build_strategy == LBVH)
+
+        uint64_t geometry_hash = 0;
+        bool loaded = false;
+
+        if (!bvh_filename.empty())
+        {
+            geometry_hash = hash_geometry(
+                    mod.primitives.data(),
+                    mod.primitives.size() * sizeof(primitive_type)
+                    );
+
+            // Don't load a BVH that was built with another strategy
+            geometry_hash = hash_combine(
+                    geometry_hash,
+                    build_strategy == LBVH  ? LBVHBuilder :
+                    build_strategy == Split ? SplitBVHBuilder : BinnedSAHBuilder
+                    );
+
+            mapped_bvh_file file;
+            loaded = file.open<primitive_type>(bvh_filename, geometry_hash) == mapped_bvh_file::Ok
+                  && file.num_bvhs() == 1
+                  && file.is_index_bvh(0)
+                  && file.load(0, host_bvhs[0]);
+
+            if (loaded)
+            {
+                std::cout << "Loaded BVH from " << bvh_filename << '\n';
+            }
+        }
+
+        if (!loaded && build_strategy == LBVH)
         {
             lbvh_builder builder;
+            builder.enable_parallel_build(true);
 
             host_bvhs[0] = builder.build(host_bvh_type{}, mod.primitives.data(), mod.primitives.size());
         }
-        else
+        else if (!loaded)
         {
             binned_sah_builder builder;
             builder.enable_spatial_splits(build_strategy == Split);
+            builder.enable_parallel_build(true);
 
             host_bvhs[0] = builder.build(host_bvh_type{}, mod.primitives.data(), mod.primitives.size());
         }
+
+        if (!loaded && !bvh_filename.empty() && !save_bvh(bvh_filename, host_bvhs[0], geometry_hash))
+        {
+            std::cerr << "Cannot write BVH file " << bvh_filename << '\n';
+        }
     }
     else
     {
@@ -1079,6 +1131,7 @@ void renderer::build_scene()
         }
 
         environment_map = build_visitor.environment_map;
+        environment_transform = build_visitor.environment_transform;
 
         mod.bbox = host_top_level_bvh.node(0).get_bounds();
         mod.materials.push_back({});
@@ -1668,6 +1721,18 @@ void renderer::render_impl()
                 temp_lights.push_back(al);
             }
 
+            // Importance sampled environment light, only the path tracer handles lights at infinity
+            int environment_index = -1;
+
+            if (environment_map != nullptr && algo == Pathtracing && tex_format == renderer::UV)
+            {
+                environment_light_t env(texture_ref<vec4, 2>(*environment_map), environment_distribution.ref());
+                env.set_light_to_world_transform(environment_transform);
+
+                environment_index = static_cast<int>(temp_lights.size());
+                temp_lights.push_back(env);
+            }
+
             if (tex_format == renderer::UV)
             {
                 render_instances_cpp(
@@ -1679,6 +1744,7 @@ void renderer::render_impl()
                         mod.colors,
                         mod.textures,
                         temp_lights,
+                        environment_index,
                         bounces,
                         epsilon,
                         vec4(background_color(), 1.0f),
@@ -1726,6 +1792,7 @@ void renderer::render_impl()
                     generic_materials,
                     mod.textures,
                     area_lights,
+                    area_light_bvh,
                     bounces,
                     epsilon,
                     vec4(background_color(), 1.0f),
@@ -1760,6 +1827,12 @@ void renderer::render_impl()
                     ssaa_samples
                     );
         }
+
+        // Path tracing accumulates samples, convert for display
+        if (algo == Pathtracing)
+        {
+            rt.resolve_accum_buffer();
+        }
     }
 #ifdef __CUDACC__
     else if (rt.mode() == host_device_rt::GPU)
@@ -2250,6 +2323,15 @@ int main(int argc, char** argv)
         }
     }
 
+    // Importance sample area lights by power, distance and orientation
+    rend.area_light_bvh.build(rend.area_lights.begin(), rend.area_lights.end());
+
+    // Importance sample the environment map by luminance
+    if (rend.environment_map != nullptr)
+    {
+        rend.environment_distribution = make_environment_distribution(*rend.environment_map);
+    }
+
     std::cout << "Ready\n";
 
 #ifdef __CUDACC__
@@ -0,0 +1,134 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <visionaray/math/math.h>
+#include <visionaray/accumulation_buffer_rt.h>
+#include <visionaray/result_record.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Accumulate num_frames frames, frame i stores (i, 2i, 1, 1) / num_frames in each pixel
+//
+
+template <typename R, typename Sched, typename RT>
+void accumulate_frames(R /* */, Sched& sched, RT& rt, int num_frames)
+{
+    using S = typename R::scalar_type;
+
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    auto sparams = make_sched_params(pixel_sampler::jittered_type{}, mv, pr, rt);
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        sched.frame([&](R) -> result_record<S>
+        {
+            float c = static_cast<float>(i) / num_frames;
+
+            result_record<S> result;
+            result.color = vector<4, S>(c, 2.0f * c, 1.0f, 1.0f);
+            return result;
+        }, sparams);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that each pixel gets one sample per frame, and that means are exact
+//
+
+TEST(AccumulationBufferRT, Accumulate)
+{
+    int num_frames = 16;
+
+    // Odd size, so that packets overlap the image borders
+    accumulation_buffer_rt<float> rt;
+    rt.resize(5, 3);
+
+    simple_sched<ray> sched;
+    accumulate_frames(ray(), sched, rt, num_frames);
+
+    // Sum of i / n for i in [0..n)
+    float mean = (num_frames - 1) / 2.0f / num_frames;
+
+    for (int y = 0; y < rt.height(); ++y)
+    {
+        for (int x = 0; x < rt.width(); ++x)
+        {
+            EXPECT_EQ(rt.counts()[y * rt.width() + x], static_cast<unsigned>(num_frames));
+
+            vec4 avg = rt.average(x, y);
+            EXPECT_FLOAT_EQ(avg.x, mean);
+            EXPECT_FLOAT_EQ(avg.y, 2.0f * mean);
+            EXPECT_FLOAT_EQ(avg.z, 1.0f);
+            EXPECT_FLOAT_EQ(avg.w, 1.0f);
+        }
+    }
+
+    // SIMD packets, double precision sums
+    accumulation_buffer_rt<double> rt_packet;
+    rt_packet.resize(5, 3);
+
+    tiled_sched<basic_ray<simd::float4>> packet_sched(2);
+    accumulate_frames(basic_ray<simd::float4>(), packet_sched, rt_packet, num_frames);
+
+    for (int y = 0; y < rt_packet.height(); ++y)
+    {
+        for (int x = 0; x < rt_packet.width(); ++x)
+        {
+            EXPECT_EQ(rt_packet.counts()[y * rt_packet.width() + x], static_cast<unsigned>(num_frames));
+            EXPECT_FLOAT_EQ(rt_packet.average(x, y).x, mean);
+        }
+    }
+
+    // No samples after clear
+    rt.clear();
+    EXPECT_EQ(rt.counts()[0], 0U);
+    EXPECT_FLOAT_EQ(rt.average(0, 0).x, 0.0f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test resolving to display render targets w/ and w/o tonemapping
+//
+
+TEST(AccumulationBufferRT, Resolve)
+{
+    int width = 37;
+    int height = 23;
+
+    accumulation_buffer_rt<double> rt;
+    rt.resize(width, height);
+
+    simple_sched<ray> sched;
+    accumulate_frames(ray(), sched, rt, 4);
+
+    thread_pool pool(4);
+
+    simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> rt_RGBA32F;
+    rt_RGBA32F.resize(width, height);
+    rt.resolve(pool, rt_RGBA32F.ref());
+
+    simple_buffer_rt<PF_RGBA8, PF_UNSPECIFIED> rt_RGBA8;
+    rt_RGBA8.resize(width, height);
+    rt.resolve(pool, rt_RGBA8.ref(), [](vec4 const& color) { return vec4(color.xyz() * 2.0f, color.w); });
+
+    for (int i = 0; i < width * height; ++i)
+    {
+        // Mean of 0, 1/4, 2/4, 3/4
+        EXPECT_FLOAT_EQ(rt_RGBA32F.color()[i].x, 0.375f);
+        EXPECT_FLOAT_EQ(rt_RGBA32F.color()[i].y, 0.75f);
+
+        // Tonemapped and clamped
+        EXPECT_EQ(static_cast<int>(rt_RGBA8.color()[i].x), static_cast<int>(0.75f * 255.0f + 0.5f));
+        EXPECT_EQ(static_cast<int>(rt_RGBA8.color()[i].y), 255);
+    }
+}
@@ -0,0 +1,130 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/adaptive_sampling.h>
+#include <visionaray/result_record.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Test running mean and variance against two-pass computation
+//
+
+TEST(AdaptiveSampling, PixelStats)
+{
+    float values[] = { 0.5f, 1.5f, 0.25f, 2.0f, 1.0f, 0.75f };
+
+    pixel_stats stats = detail::initial_pixel_stats();
+
+    float sum = 0.0f;
+
+    for (int i = 0; i < 6; ++i)
+    {
+        float weight = detail::update_pixel_stats(stats, values[i], 4);
+        EXPECT_FLOAT_EQ(weight, 1.0f / (i + 1));
+
+        sum += values[i];
+
+        // Not enough samples yet
+        if (i < 3)
+        {
+            EXPECT_EQ(stats.error, FLT_MAX);
+        }
+    }
+
+    float mean = sum / 6;
+    float variance = 0.0f;
+
+    for (int i = 0; i < 6; ++i)
+    {
+        variance += (values[i] - mean) * (values[i] - mean) / 5;
+    }
+
+    EXPECT_EQ(stats.count, 6U);
+    EXPECT_FLOAT_EQ(stats.mean, mean);
+    EXPECT_FLOAT_EQ(stats.m2 / 5, variance);
+    EXPECT_FLOAT_EQ(stats.error, std::sqrt(variance / 6) / mean);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Render an image with a constant left half and a noisy right half. The left half converges
+// after min_samples, the remaining samples go to the right half
+//
+
+TEST(AdaptiveSampling, Render)
+{
+    int width = 8;
+    int height = 8;
+
+    simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> rt;
+    rt.resize(width, height);
+
+    std::vector<pixel_stats> stats(width * height, detail::initial_pixel_stats());
+
+    pixel_sampler::adaptive_blend_type ps;
+    ps.stats = stats.data();
+    ps.max_error = 0.05f;
+    ps.min_samples = 8;
+
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    auto sparams = make_sched_params(ps, mv, pr, rt);
+
+    simple_sched<ray> sched;
+
+    std::vector<int> num_samples(width * height, 0);
+
+    for (int frame = 0; frame < 64; ++frame)
+    {
+        sched.frame([&](ray, int x, int y) -> result_record<float>
+        {
+            int n = num_samples[y * width + x]++;
+
+            // Deterministic noise in [0..1]
+            float noise = ((n * 7919 + y * width + x) % 97) / 96.0f;
+
+            result_record<float> result;
+            result.color = x < width / 2 ? vec4(0.5f) : vec4(noise);
+            return result;
+        }, sparams);
+    }
+
+    auto info = compute_convergence(stats.data(), stats.size(), ps.max_error);
+
+    EXPECT_EQ(info.num_pixels, static_cast<size_t>(width * height));
+    EXPECT_GE(info.num_converged, static_cast<size_t>(width * height / 2));
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            int i = y * width + x;
+
+            if (x < width / 2)
+            {
+                EXPECT_EQ(num_samples[i], 8);
+                EXPECT_EQ(stats[i].error, 0.0f);
+                EXPECT_FLOAT_EQ(rt.color()[i].x, 0.5f);
+            }
+            else
+            {
+                EXPECT_GT(num_samples[i], 8);
+                EXPECT_EQ(static_cast<int>(stats[i].count), num_samples[i]);
+                EXPECT_NEAR(rt.color()[i].x, stats[i].mean, 1e-4f);
+                EXPECT_NEAR(rt.color()[i].x, 0.5f, 0.25f);
+            }
+        }
+    }
+}
@@ -1,6 +1,9 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <algorithm>
+#include <random>
+
 #include <visionaray/aligned_vector.h>
 #include <visionaray/array_ref.h>
 #include <visionaray/bvh.h>
@@ -59,6 +62,84 @@ aligned_vector<sphere_t, 32> make_spheres()
     return spheres;
 }
 
+// generate lots of random triangles ----------------------
+
+aligned_vector<triangle_t, 32> make_random_triangles(size_t count)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> pos(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> ext(-1.0f, 1.0f);
+
+    aligned_vector<triangle_t, 32> triangles(count);
+
+    for (auto& t : triangles)
+    {
+        vec3 v1(pos(rng), pos(rng), pos(rng));
+        t = triangle_t(v1, vec3(ext(rng), ext(rng), ext(rng)), vec3(ext(rng), ext(rng), ext(rng)));
+    }
+
+    return triangles;
+}
+
+// check that each primitive is referenced exactly once ---
+
+template <typename BVH>
+bool all_primitives_referenced(BVH const& b)
+{
+    std::vector<int> refs(b.num_indices());
+
+    for (auto const& n : b.nodes())
+    {
+        if (is_leaf(n))
+        {
+            for (auto i = n.get_indices().first; i != n.get_indices().last; ++i)
+            {
+                ++refs[b.indices()[i]];
+            }
+        }
+    }
+
+    return std::all_of(refs.begin(), refs.end(), [](int r) { return r == 1; });
+}
+
+// check that the nodes' bounds contain their children ---
+
+template <typename BVH>
+bool bounds_contain_children(BVH const& b)
+{
+    for (auto const& n : b.nodes())
+    {
+        auto bounds = n.get_bounds();
+
+        if (is_inner(n))
+        {
+            for (unsigned i = 0; i < 2; ++i)
+            {
+                auto cb = b.node(n.get_child(i)).get_bounds();
+
+                if (combine(bounds, cb) != bounds)
+                {
+                    return false;
+                }
+            }
+        }
+        else
+        {
+            for (auto i = n.get_indices().first; i != n.get_indices().last; ++i)
+            {
+                auto pb = get_bounds(b.primitive(i));
+
+                if (combine(bounds, pb) != bounds)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
 
 //-------------------------------------------------------------------------------------------------
 // Test build methods for several BVH types
@@ -120,3 +201,207 @@ TEST(BVH, BuildArrayRefBvh)
     EXPECT_TRUE(triangle_bvh.primitives().size() == triangles.size());
     EXPECT_TRUE(sphere_bvh.primitives().size()   == spheres.size());
 }
+
+// parallel build -----------------------------------------
+
+TEST(BVH, BuildParallel)
+{
+    auto triangles = make_random_triangles(100000);
+
+    binned_sah_builder serial_builder;
+    auto serial_bvh = serial_builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    thread_pool pool(4);
+
+    binned_sah_builder builder;
+    auto parallel_bvh = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), pool);
+
+    // Same splits are found, only the node order (and thus
+    // the order in which SAH costs are summed up) may differ
+    EXPECT_EQ(parallel_bvh.num_nodes(), serial_bvh.num_nodes());
+    EXPECT_EQ(parallel_bvh.num_indices(), triangles.size());
+    EXPECT_TRUE(all_primitives_referenced(parallel_bvh));
+    EXPECT_NEAR(sah_cost(parallel_bvh), sah_cost(serial_bvh), 1.0e-5f * sah_cost(serial_bvh));
+
+    builder.enable_parallel_build(true);
+    auto default_bvh = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    EXPECT_EQ(default_bvh.num_nodes(), serial_bvh.num_nodes());
+    EXPECT_TRUE(all_primitives_referenced(default_bvh));
+
+    auto direct_bvh = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size(), pool);
+
+    EXPECT_EQ(direct_bvh.num_primitives(), triangles.size());
+    EXPECT_NEAR(sah_cost(direct_bvh), sah_cost(serial_bvh), 1.0e-5f * sah_cost(serial_bvh));
+}
+
+TEST(BVH, BuildParallelSpatialSplits)
+{
+    auto triangles = make_random_triangles(50000);
+
+    binned_sah_builder serial_builder;
+    serial_builder.enable_spatial_splits(true);
+    auto serial_bvh = serial_builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    thread_pool pool(4);
+
+    binned_sah_builder builder;
+    builder.enable_spatial_splits(true);
+    auto parallel_bvh = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), pool);
+
+    EXPECT_EQ(parallel_bvh.num_nodes(), serial_bvh.num_nodes());
+    EXPECT_EQ(parallel_bvh.num_indices(), serial_bvh.num_indices());
+    EXPECT_NEAR(sah_cost(parallel_bvh), sah_cost(serial_bvh), 1.0e-5f * sah_cost(serial_bvh));
+}
+
+// lbvh ---------------------------------------------------
+
+TEST(BVH, BuildLbvh)
+{
+    lbvh_builder builder;
+
+    auto triangles = make_triangles();
+    auto spheres   = make_spheres();
+
+    auto triangle_bvh = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size(), 1);
+    auto sphere_bvh   = builder.build(bvh<sphere_t>{}, spheres.data(), spheres.size(), 1);
+
+    EXPECT_EQ(triangle_bvh.num_nodes(), 2 * triangles.size() - 1);
+    EXPECT_EQ(sphere_bvh.num_nodes(), 2 * spheres.size() - 1);
+
+    EXPECT_TRUE(all_primitives_referenced(triangle_bvh));
+    EXPECT_TRUE(bounds_contain_children(triangle_bvh));
+
+    EXPECT_TRUE(sphere_bvh.primitives().size() == spheres.size());
+
+    auto random_triangles = make_random_triangles(100000);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        builder.enable_64bit_morton_codes(i == 1);
+
+        builder.enable_parallel_build(false);
+        auto serial_bvh = builder.build(index_bvh<triangle_t>{}, random_triangles.data(), random_triangles.size());
+
+        EXPECT_TRUE(all_primitives_referenced(serial_bvh));
+        EXPECT_TRUE(bounds_contain_children(serial_bvh));
+
+        thread_pool pool(4);
+        auto parallel_bvh = builder.build(index_bvh<triangle_t>{}, random_triangles.data(), random_triangles.size(), pool);
+
+        // Parallel build is deterministic
+        ASSERT_EQ(parallel_bvh.num_nodes(), serial_bvh.num_nodes());
+        EXPECT_TRUE(std::equal(
+                parallel_bvh.indices().begin(),
+                parallel_bvh.indices().end(),
+                serial_bvh.indices().begin()
+                ));
+
+        for (size_t j = 0; j < serial_bvh.num_nodes(); ++j)
+        {
+            EXPECT_TRUE(parallel_bvh.node(j) == serial_bvh.node(j));
+            EXPECT_TRUE(parallel_bvh.node(j).get_bounds() == serial_bvh.node(j).get_bounds());
+        }
+
+        builder.enable_parallel_build(true);
+        auto direct_bvh = builder.build(bvh<triangle_t>{}, random_triangles.data(), random_triangles.size());
+
+        EXPECT_EQ(direct_bvh.num_nodes(), serial_bvh.num_nodes());
+        EXPECT_TRUE(bounds_contain_children(direct_bvh));
+    }
+}
+
+// lbvh w/ duplicate morton codes -------------------------
+
+TEST(BVH, BuildLbvhDuplicates)
+{
+    aligned_vector<sphere_t, 32> spheres(1000, sphere_t(vec3(1.0f, 2.0f, 3.0f), 1.0f));
+
+    lbvh_builder builder;
+
+    auto sphere_bvh = builder.build(index_bvh<sphere_t>{}, spheres.data(), spheres.size());
+
+    EXPECT_TRUE(all_primitives_referenced(sphere_bvh));
+    EXPECT_TRUE(bounds_contain_children(sphere_bvh));
+}
+
+// refit --------------------------------------------------
+
+TEST(BVH, Refit)
+{
+    auto triangles = make_random_triangles(50000);
+
+    binned_sah_builder builder;
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    // Move the triangles, primitive order is kept by index bvhs
+    for (auto& t : tree.primitives())
+    {
+        t.v1 += vec3(t.v1.y * 0.1f, 0.0f, t.v1.x * 0.1f);
+    }
+
+    auto parallel_tree = tree;
+
+    bvh_refitter refitter;
+    refitter.refit(tree);
+
+    EXPECT_TRUE(bounds_contain_children(tree));
+    EXPECT_TRUE(all_primitives_referenced(tree));
+
+    thread_pool pool(4);
+    refitter.refit(parallel_tree, pool);
+
+    for (size_t i = 0; i < tree.num_nodes(); ++i)
+    {
+        EXPECT_TRUE(parallel_tree.node(i) == tree.node(i));
+        EXPECT_TRUE(parallel_tree.node(i).get_bounds() == tree.node(i).get_bounds());
+    }
+
+    // Root bounds are tight
+    aabb bounds;
+    bounds.invalidate();
+
+    for (auto const& t : tree.primitives())
+    {
+        bounds.insert(get_bounds(t));
+    }
+
+    EXPECT_TRUE(tree.node(0).get_bounds() == bounds);
+}
+
+TEST(BVH, RefitRestructure)
+{
+    auto triangles = make_random_triangles(50000);
+
+    lbvh_builder builder;
+    auto tree = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    float initial_cost = sah_cost(tree);
+
+    bvh_refitter refitter;
+    refitter.set_restructure_threshold(1.1f);
+
+    // Passing the tree before modifying the primitives records the initial cost
+    refitter.refit(tree);
+
+    EXPECT_NEAR(refitter.reference_cost(), initial_cost, 1.0e-5f * initial_cost);
+
+    // Scramble the triangle positions
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<float> pos(-100.0f, 100.0f);
+
+    for (auto& t : tree.primitives())
+    {
+        t.v1 = vec3(pos(rng), pos(rng), pos(rng));
+    }
+
+    auto refit_only = tree;
+    refit(refit_only);
+
+    refitter.enable_parallel_refit(true);
+    refitter.refit(tree);
+
+    EXPECT_TRUE(bounds_contain_children(tree));
+    EXPECT_TRUE(all_primitives_referenced(tree));
+    EXPECT_LT(sah_cost(tree), sah_cost(refit_only));
+}
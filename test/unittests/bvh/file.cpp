@@ -0,0 +1,263 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <common/bvh_file.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+static aligned_vector<triangle_t> make_triangles(size_t count, unsigned seed)
+{
+    std::default_random_engine rng(seed);
+    std::uniform_real_distribution<float> pos(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> ext(-1.0f, 1.0f);
+
+    aligned_vector<triangle_t> triangles(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 v1(pos(rng), pos(rng), pos(rng));
+        triangles[i] = triangle_t(v1, vec3(ext(rng), ext(rng), ext(rng)), vec3(ext(rng), ext(rng), ext(rng)));
+        triangles[i].prim_id = static_cast<unsigned>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    return triangles;
+}
+
+static std::vector<basic_ray<float>> make_rays(size_t count)
+{
+    std::default_random_engine rng(2);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    std::vector<basic_ray<float>> rays(count);
+
+    for (auto& r : rays)
+    {
+        vec3 ori = normalize(vec3(dist(rng), dist(rng), dist(rng))) * 30.0f;
+        vec3 target(dist(rng) * 10.0f, dist(rng) * 10.0f, dist(rng) * 10.0f);
+
+        r.ori = ori;
+        r.dir = normalize(target - ori);
+    }
+
+    return rays;
+}
+
+static uint64_t hash(aligned_vector<triangle_t> const& triangles)
+{
+    return hash_geometry(triangles.data(), triangles.size() * sizeof(triangle_t));
+}
+
+// Overwrite 8 bytes of a file in place
+static void patch_file(std::string const& path, std::streamoff offset, uint64_t value)
+{
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+struct temp_file
+{
+    temp_file()
+        : path((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string())
+    {
+    }
+
+   ~temp_file()
+    {
+        boost::filesystem::remove(path);
+    }
+
+    std::string path;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Save and map a single BVH
+//
+
+TEST(BVHFile, SaveLoad)
+{
+    auto triangles = make_triangles(3000, 0);
+    auto rays = make_rays(1000);
+
+    binned_sah_builder builder;
+    auto b = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    temp_file tmp;
+    ASSERT_TRUE(save_bvh(tmp.path, b, hash(triangles)));
+
+    mapped_bvh_file file;
+
+    // Stale files are rejected
+    auto other = make_triangles(3000, 3);
+    EXPECT_EQ(file.open<triangle_t>(tmp.path, hash(other)), mapped_bvh_file::HashMismatch);
+    EXPECT_FALSE(file.good());
+
+    EXPECT_EQ(file.open<triangle_t>(tmp.path + ".none", hash(triangles)), mapped_bvh_file::NonExistent);
+
+    ASSERT_EQ(file.open<triangle_t>(tmp.path, hash(triangles)), mapped_bvh_file::Ok);
+    ASSERT_EQ(file.num_bvhs(), size_t(1));
+    EXPECT_TRUE(file.is_index_bvh(0));
+    EXPECT_FALSE(file.has_top_level());
+
+    // Traverse the mapped BVH in place
+    auto ref = file.get_index_bvh_ref<triangle_t>(0);
+    EXPECT_EQ(ref.num_primitives(), b.num_primitives());
+    EXPECT_EQ(ref.num_nodes(), b.num_nodes());
+
+    // And copy it
+    index_bvh<triangle_t> copy;
+    ASSERT_TRUE(file.load(0, copy));
+    EXPECT_EQ(copy.num_indices(), b.num_indices());
+
+    for (auto const& r : rays)
+    {
+        auto hr1 = intersect(r, b);
+        auto hr2 = intersect(r, ref);
+        auto hr3 = intersect(r, copy);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+        ASSERT_EQ(hr1.hit, hr3.hit);
+
+        if (hr1.hit)
+        {
+            EXPECT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+            EXPECT_EQ(hr1.prim_id, hr3.prim_id);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Save and map a two-level BVH
+//
+
+TEST(BVHFile, SaveLoadInstances)
+{
+    auto t1 = make_triangles(1000, 0);
+    auto t2 = make_triangles(500, 3);
+    auto rays = make_rays(1000);
+
+    binned_sah_builder builder;
+
+    aligned_vector<index_bvh<triangle_t>> bvhs(2);
+    bvhs[0] = builder.build(index_bvh<triangle_t>{}, t1.data(), t1.size());
+    bvhs[1] = builder.build(index_bvh<triangle_t>{}, t2.data(), t2.size());
+
+    std::vector<size_t> instance_bvhs = { 0, 1, 0 };
+    aligned_vector<mat4> transforms = {
+        mat4::identity(),
+        mat4::translation(vec3(5.0f, 0.0f, 0.0f)),
+        mat4::translation(vec3(0.0f, -20.0f, 0.0f))
+        };
+
+    aligned_vector<index_bvh<triangle_t>::bvh_inst> instances;
+
+    for (size_t i = 0; i < instance_bvhs.size(); ++i)
+    {
+        instances.push_back(bvhs[instance_bvhs[i]].inst(transforms[i]));
+    }
+
+    auto top = builder.build(
+            index_bvh<index_bvh<triangle_t>::bvh_inst>{},
+            instances.data(),
+            instances.size()
+            );
+
+    // Any hash works, e.g. one of all source triangles
+    uint64_t h = hash(t1) ^ hash(t2);
+
+    temp_file tmp;
+    ASSERT_TRUE(save_bvh(tmp.path, bvhs, instance_bvhs, transforms, top, h));
+
+    mapped_bvh_file file;
+    ASSERT_EQ(file.open<triangle_t>(tmp.path, h), mapped_bvh_file::Ok);
+    ASSERT_EQ(file.num_bvhs(), size_t(2));
+    ASSERT_EQ(file.num_instances(), size_t(3));
+    ASSERT_TRUE(file.has_top_level());
+    EXPECT_EQ(file.get_instance_bvh(1), size_t(1));
+
+    auto mapped_instances = file.get_instances<triangle_t>();
+    auto mapped_top = file.get_top_level_ref(mapped_instances.data());
+
+    EXPECT_EQ(mapped_top.num_nodes(), top.num_nodes());
+
+    for (auto const& r : rays)
+    {
+        auto hr1 = intersect(r, top);
+        auto hr2 = intersect(r, mapped_top);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit)
+        {
+            EXPECT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+            EXPECT_EQ(hr1.primitive_list_index, hr2.primitive_list_index);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Reject files that don't match the primitive type or are corrupt
+//
+
+TEST(BVHFile, Invalid)
+{
+    auto triangles = make_triangles(100, 0);
+
+    binned_sah_builder builder;
+    auto b = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    // The first record follows the 56 byte header: kind, primitive size and the
+    // primitive section (offset, count)
+    std::streamoff record = 56;
+
+    temp_file tmp;
+    ASSERT_TRUE(save_bvh(tmp.path, b, hash(triangles)));
+
+    mapped_bvh_file file;
+    EXPECT_EQ(file.open<basic_sphere<float>>(tmp.path, hash(triangles)), mapped_bvh_file::LayoutMismatch);
+    EXPECT_FALSE(file.good());
+
+    // Zero primitive size
+    patch_file(tmp.path, record, uint64_t(detail::IndexBVH));
+    EXPECT_EQ(file.open<triangle_t>(tmp.path, hash(triangles)), mapped_bvh_file::InvalidFile);
+
+    // Primitive count that overflows when multiplied by the primitive size
+    ASSERT_TRUE(save_bvh(tmp.path, b, hash(triangles)));
+    patch_file(tmp.path, record + 16, uint64_t(1) << 62);
+    EXPECT_EQ(file.open<triangle_t>(tmp.path, hash(triangles)), mapped_bvh_file::InvalidFile);
+
+    // Record table larger than the file
+    ASSERT_TRUE(save_bvh(tmp.path, b, hash(triangles)));
+    patch_file(tmp.path, 32, ~uint64_t(0));
+    EXPECT_EQ(file.open<triangle_t>(tmp.path, hash(triangles)), mapped_bvh_file::InvalidFile);
+
+    ASSERT_TRUE(save_bvh(tmp.path, b, hash(triangles)));
+    EXPECT_EQ(file.open<triangle_t>(tmp.path, hash(triangles)), mapped_bvh_file::Ok);
+}
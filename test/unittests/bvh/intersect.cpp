@@ -0,0 +1,764 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <random>
+
+#include <visionaray/math/simd/simd.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/ray_stream.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+
+// generate a random triangle soup ------------------------
+
+static aligned_vector<triangle_t, 32> make_triangle_soup(size_t count)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> pos(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> ext(-1.0f, 1.0f);
+
+    aligned_vector<triangle_t, 32> triangles(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 v1(pos(rng), pos(rng), pos(rng));
+        triangles[i] = triangle_t(v1, vec3(ext(rng), ext(rng), ext(rng)), vec3(ext(rng), ext(rng), ext(rng)));
+        triangles[i].prim_id = static_cast<unsigned>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    return triangles;
+}
+
+// generate random rays that start outside the scene ------
+
+static aligned_vector<basic_ray<float>> make_rays(size_t count, unsigned seed = 1)
+{
+    std::default_random_engine rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    aligned_vector<basic_ray<float>> rays(count);
+
+    for (auto& r : rays)
+    {
+        vec3 ori = normalize(vec3(dist(rng), dist(rng), dist(rng))) * 30.0f;
+        vec3 target(dist(rng) * 10.0f, dist(rng) * 10.0f, dist(rng) * 10.0f);
+
+        r.ori = ori;
+        r.dir = normalize(target - ori);
+    }
+
+    return rays;
+}
+
+// compare closest hits of two BVHs -----------------------
+
+template <typename BVH1, typename BVH2>
+static void compare_closest_hits(BVH1 const& b1, BVH2 const& b2, aligned_vector<basic_ray<float>> const& rays)
+{
+    for (auto const& r : rays)
+    {
+        auto hr1 = intersect(r, b1);
+        auto hr2 = intersect(r, b2);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+    }
+}
+
+
+// intersector with a box test that rejects everything -----
+
+struct reject_boxes_intersector : basic_intersector<reject_boxes_intersector>
+{
+    using basic_intersector<reject_boxes_intersector>::operator();
+
+    template <typename T, typename U>
+    hit_record<basic_ray<T>, basic_aabb<U>> operator()(
+            basic_ray<T> const&     /* */,
+            basic_aabb<U> const&    /* */,
+            vector<3, T> const&     /* */
+            )
+    {
+        ++num_box_tests;
+        return {};
+    }
+
+    int num_box_tests = 0;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Test wide BVHs (4 and 8 children per node)
+//
+
+TEST(BVH, IntersectWide)
+{
+    auto triangles = make_triangle_soup(5000);
+    auto rays = make_rays(2000);
+
+    binned_sah_builder builder;
+
+    auto b = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    bvh4<triangle_t> b4(b);
+    bvh8<triangle_t> b8(b);
+
+    EXPECT_EQ(b4.num_primitives(), triangles.size());
+    EXPECT_EQ(b8.num_primitives(), triangles.size());
+    EXPECT_LT(b4.num_nodes(), b.num_nodes() / 2);
+    EXPECT_LT(b8.num_nodes(), b4.num_nodes());
+
+    // Root bounds are preserved
+    EXPECT_TRUE(get_bounds(b4).min == get_bounds(b).min);
+    EXPECT_TRUE(get_bounds(b8).max == get_bounds(b).max);
+
+    // Single rays, closest hit
+    compare_closest_hits(b, b4, rays);
+    compare_closest_hits(b, b8, rays);
+
+    // Any hit
+    default_intersector isect;
+
+    for (auto const& r : rays)
+    {
+        auto hr = intersect<detail::AnyHit>(r, b, isect);
+        auto hr4 = intersect<detail::AnyHit>(r, b4, isect);
+
+        EXPECT_EQ(hr.hit, hr4.hit);
+    }
+
+    // Ray packets
+    for (size_t i = 0; i < rays.size(); i += 4)
+    {
+        basic_ray<simd::float4> packet = simd::pack(
+                rays[i], rays[i + 1], rays[i + 2], rays[i + 3]
+                );
+
+        auto hr4 = simd::unpack(intersect(packet, b4));
+
+        for (int j = 0; j < 4; ++j)
+        {
+            auto ref = intersect(rays[i + j], b);
+
+            ASSERT_EQ(ref.hit, hr4[j].hit);
+
+            if (ref.hit)
+            {
+                EXPECT_FLOAT_EQ(ref.t, hr4[j].t);
+                EXPECT_EQ(ref.prim_id, hr4[j].prim_id);
+            }
+        }
+    }
+
+    // Collapse a plain BVH, too, and a tree that is only a single leaf
+    auto pb = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+    bvh4<triangle_t> pb4(pb);
+    compare_closest_hits(pb, pb4, rays);
+
+    auto leaf = builder.build(bvh<triangle_t>{}, triangles.data(), 3, 4);
+    ASSERT_EQ(leaf.num_nodes(), size_t(1));
+    bvh8<triangle_t> leaf8(leaf);
+    compare_closest_hits(leaf, leaf8, rays);
+
+    // Single rays and packets use the box test of the intersector, the root node is the
+    // only one tested
+    reject_boxes_intersector reject;
+
+    for (auto const& r : rays)
+    {
+        EXPECT_FALSE(intersect<detail::ClosestHit>(r, b4, reject).hit);
+        EXPECT_FALSE(intersect<detail::ClosestHit>(r, b8, reject).hit);
+    }
+
+    EXPECT_EQ(reject.num_box_tests, static_cast<int>(rays.size() * 2));
+
+    reject.num_box_tests = 0;
+
+    for (size_t i = 0; i < rays.size(); i += 4)
+    {
+        basic_ray<simd::float4> packet = simd::pack(
+                rays[i], rays[i + 1], rays[i + 2], rays[i + 3]
+                );
+
+        EXPECT_FALSE(any(intersect<detail::ClosestHit>(packet, b4, reject).hit));
+    }
+
+    EXPECT_GT(reject.num_box_tests, 0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test BVHs with quantized node bounds
+//
+
+TEST(BVH, IntersectQuantized)
+{
+    auto triangles = make_triangle_soup(5000);
+    auto rays = make_rays(2000);
+
+    lbvh_builder builder;
+
+    auto b = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    quantized_bvh<triangle_t> qb(b);
+    quantized_bvh<triangle_t, uint16_t> qb16(b);
+
+    EXPECT_EQ(qb.num_primitives(), triangles.size());
+    EXPECT_EQ(qb.num_nodes(), b.num_nodes() / 2);
+    EXPECT_LT(qb.num_nodes() * sizeof(quantized_bvh_node<uint8_t>), b.num_nodes() * sizeof(bvh_node));
+
+    // Quantized bounds are conservative
+    aabb bounds = get_bounds(b);
+    aabb qbounds = get_bounds(qb);
+    EXPECT_TRUE(qbounds.contains(bounds));
+
+    compare_closest_hits(b, qb, rays);
+    compare_closest_hits(b, qb16, rays);
+
+    // Ray packets
+    for (size_t i = 0; i < rays.size(); i += 4)
+    {
+        basic_ray<simd::float4> packet = simd::pack(
+                rays[i], rays[i + 1], rays[i + 2], rays[i + 3]
+                );
+
+        auto hr = simd::unpack(intersect(packet, qb));
+
+        for (int j = 0; j < 4; ++j)
+        {
+            auto ref = intersect(rays[i + j], b);
+
+            ASSERT_EQ(ref.hit, hr[j].hit);
+
+            if (ref.hit)
+            {
+                EXPECT_FLOAT_EQ(ref.t, hr[j].t);
+                EXPECT_EQ(ref.prim_id, hr[j].prim_id);
+            }
+        }
+    }
+
+    // Far away from the origin, rounding must not make the bounds shrink
+    auto offset = triangles;
+
+    for (auto& t : offset)
+    {
+        t.v1 += vec3(1.0e5f, -3.0e4f, 7.0e3f);
+    }
+
+    auto ob = builder.build(bvh<triangle_t>{}, offset.data(), offset.size());
+    quantized_bvh<triangle_t> oqb(ob);
+
+    auto offset_rays = rays;
+
+    for (auto& r : offset_rays)
+    {
+        r.ori += vec3(1.0e5f, -3.0e4f, 7.0e3f);
+    }
+
+    compare_closest_hits(ob, oqb, offset_rays);
+
+    // Traversal policies, leaf children are intersected once per node
+    default_intersector isect;
+
+    for (auto const& r : rays)
+    {
+        auto ref = intersect<detail::MultiHit, 16, detail::distance_order, detail::full_stack<>>(r, qb, isect);
+        auto multi1 = intersect<detail::MultiHit, 16>(r, qb, isect);
+        auto multi2 = intersect<detail::MultiHit, 16, detail::distance_order, detail::restart_trail<1>>(r, qb, isect);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            ASSERT_EQ(ref[i].hit, multi1[i].hit);
+            ASSERT_EQ(ref[i].hit, multi2[i].hit);
+
+            if (ref[i].hit)
+            {
+                EXPECT_EQ(ref[i].prim_id, multi1[i].prim_id);
+                EXPECT_EQ(ref[i].prim_id, multi2[i].prim_id);
+            }
+        }
+    }
+
+    // Single leaf
+    auto leaf = builder.build(bvh<triangle_t>{}, triangles.data(), 3, 4);
+    quantized_bvh<triangle_t> qleaf(leaf);
+    EXPECT_EQ(qleaf.num_nodes(), size_t(1));
+    compare_closest_hits(leaf, qleaf, rays);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test ordered traversal with the split axis stored in the nodes
+//
+
+template <typename BVH>
+static void test_split_axis_order(BVH const& b, aligned_vector<basic_ray<float>> const& rays)
+{
+    // The builders record the split axes
+    int axis_count[3] = { 0, 0, 0 };
+
+    for (auto const& n : b.nodes())
+    {
+        if (is_inner(n))
+        {
+            ASSERT_LT(n.get_split_axis(), 3U);
+            axis_count[n.get_split_axis()]++;
+        }
+    }
+
+    EXPECT_GT(axis_count[0], 0);
+    EXPECT_GT(axis_count[1], 0);
+    EXPECT_GT(axis_count[2], 0);
+
+    default_intersector isect;
+
+    for (auto const& r : rays)
+    {
+        auto hr1 = intersect<detail::ClosestHit>(r, b, isect);
+        auto hr2 = intersect<detail::ClosestHit, 1, detail::split_axis_order>(r, b, isect);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+    }
+
+    // Ray packets
+    for (size_t i = 0; i < rays.size(); i += 4)
+    {
+        basic_ray<simd::float4> packet = simd::pack(
+                rays[i], rays[i + 1], rays[i + 2], rays[i + 3]
+                );
+
+        auto hr = simd::unpack(intersect<detail::ClosestHit, 1, detail::split_axis_order>(packet, b, isect));
+
+        for (int j = 0; j < 4; ++j)
+        {
+            auto ref = intersect(rays[i + j], b);
+
+            ASSERT_EQ(ref.hit, hr[j].hit);
+
+            if (ref.hit)
+            {
+                EXPECT_FLOAT_EQ(ref.t, hr[j].t);
+            }
+        }
+    }
+}
+
+TEST(BVH, IntersectSplitAxisOrder)
+{
+    auto triangles = make_triangle_soup(5000);
+    auto rays = make_rays(2000);
+
+    binned_sah_builder sah;
+    test_split_axis_order(sah.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size()), rays);
+
+    sah.enable_spatial_splits(true);
+    test_split_axis_order(sah.build(bvh<triangle_t>{}, triangles.data(), triangles.size()), rays);
+
+    lbvh_builder lbvh;
+    test_split_axis_order(lbvh.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size()), rays);
+
+    // The split axis survives refitting
+    auto b = sah.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+    auto nodes = b.nodes();
+
+    refit(b);
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (is_inner(nodes[i]))
+        {
+            EXPECT_EQ(nodes[i].get_split_axis(), b.node(i).get_split_axis());
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test traversal with a restart trail and a short stack
+//
+
+template <typename Order, typename Stack, typename BVH>
+static void test_restart_trail(BVH const& b, aligned_vector<basic_ray<float>> const& rays)
+{
+    using full_stack = detail::full_stack<>;
+
+    default_intersector isect;
+
+    for (auto const& r : rays)
+    {
+        auto hr1 = intersect<detail::ClosestHit, 1, detail::distance_order, full_stack>(r, b, isect);
+        auto hr2 = intersect<detail::ClosestHit, 1, Order, Stack>(r, b, isect);
+
+        ASSERT_EQ(hr1.hit, hr2.hit);
+
+        if (hr1.hit)
+        {
+            EXPECT_FLOAT_EQ(hr1.t, hr2.t);
+            EXPECT_EQ(hr1.prim_id, hr2.prim_id);
+        }
+
+        auto any1 = intersect<detail::AnyHit, 1, detail::distance_order, full_stack>(r, b, isect);
+        auto any2 = intersect<detail::AnyHit, 1, Order, Stack>(r, b, isect);
+
+        EXPECT_EQ(any1.hit, any2.hit);
+
+        // Every primitive is reported once
+        auto multi1 = intersect<detail::MultiHit, 16, detail::distance_order, full_stack>(r, b, isect);
+        auto multi2 = intersect<detail::MultiHit, 16, Order, Stack>(r, b, isect);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            ASSERT_EQ(multi1[i].hit, multi2[i].hit);
+
+            if (multi1[i].hit)
+            {
+                EXPECT_FLOAT_EQ(multi1[i].t, multi2[i].t);
+            }
+        }
+    }
+
+    // Ray packets
+    for (size_t i = 0; i < rays.size(); i += 4)
+    {
+        basic_ray<simd::float4> packet = simd::pack(
+                rays[i], rays[i + 1], rays[i + 2], rays[i + 3]
+                );
+
+        auto hr = simd::unpack(intersect<detail::ClosestHit, 1, Order, Stack>(packet, b, isect));
+
+        for (int j = 0; j < 4; ++j)
+        {
+            auto ref = intersect<detail::ClosestHit, 1, detail::distance_order, full_stack>(rays[i + j], b, isect);
+
+            ASSERT_EQ(ref.hit, hr[j].hit);
+
+            if (ref.hit)
+            {
+                EXPECT_FLOAT_EQ(ref.t, hr[j].t);
+            }
+        }
+    }
+}
+
+TEST(BVH, IntersectRestartTrail)
+{
+    auto triangles = make_triangle_soup(5000);
+    auto rays = make_rays(1000);
+
+    binned_sah_builder sah;
+    auto b1 = sah.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    lbvh_builder lbvh;
+    auto b2 = lbvh.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    // A single stack entry makes traversal restart often
+    test_restart_trail<detail::distance_order, detail::restart_trail<1>>(b1, rays);
+    test_restart_trail<detail::distance_order, detail::restart_trail<>>(b1, rays);
+    test_restart_trail<detail::split_axis_order, detail::restart_trail<2>>(b2, rays);
+    test_restart_trail<detail::distance_order, detail::restart_trail<>>(b2, rays);
+}
+
+// A degenerate tree where every inner node has a leaf and a nearer inner child. The
+// leaves are visited last, a full stack would need one entry per level.
+static bvh<triangle_t> make_deep_bvh(unsigned depth)
+{
+    aligned_vector<triangle_t, 32> triangles(depth + 1);
+
+    for (unsigned i = 0; i <= depth; ++i)
+    {
+        float z = -static_cast<float>(depth - i);
+        triangles[i] = triangle_t(vec3(-1.0f, -1.0f, z), vec3(3.0f, 0.0f, 0.0f), vec3(0.0f, 3.0f, 0.0f));
+        triangles[i].prim_id = i;
+        triangles[i].geom_id = 0;
+    }
+
+    bvh<triangle_t> b(triangles.data(), triangles.size());
+
+    auto subtree_bounds = [&](unsigned first)
+    {
+        aabb bounds;
+        bounds.invalidate();
+
+        for (unsigned i = first; i <= depth; ++i)
+        {
+            bounds.insert(get_bounds(triangles[i]));
+        }
+
+        return bounds;
+    };
+
+    // node 2k+1 is the leaf with primitive k, node 2k+2 is the subtree with k+1..depth
+    b.nodes()[0].set_inner(subtree_bounds(0), 1, 2);
+
+    for (unsigned k = 0; k < depth; ++k)
+    {
+        b.nodes()[2 * k + 1].set_leaf(get_bounds(triangles[k]), k, 1);
+
+        if (k + 1 < depth)
+        {
+            b.nodes()[2 * k + 2].set_inner(subtree_bounds(k + 1), 2 * k + 3, 2);
+        }
+        else
+        {
+            b.nodes()[2 * k + 2].set_leaf(get_bounds(triangles[depth]), depth, 1);
+        }
+    }
+
+    return b;
+}
+
+// Closest hit, all hits and misses on the deep tree, independent of the traversal state
+template <typename Order, typename Stack, typename BVH>
+static void test_deep(BVH const& b, unsigned depth)
+{
+    default_intersector isect;
+
+    basic_ray<float> r;
+    r.ori = vec3(0.0f, 0.0f, 10.0f);
+    r.dir = vec3(0.0f, 0.0f, -1.0f);
+
+    auto hr = intersect<detail::ClosestHit, 1, Order, Stack>(r, b, isect);
+
+    ASSERT_TRUE(hr.hit);
+    EXPECT_EQ(hr.prim_id, depth);
+    EXPECT_FLOAT_EQ(hr.t, 10.0f);
+
+    // All primitives are hit exactly once
+    auto multi = intersect<detail::MultiHit, 256, Order, Stack>(r, b, isect);
+
+    for (unsigned i = 0; i <= depth && i < multi.size(); ++i)
+    {
+        ASSERT_TRUE(multi[i].hit);
+        EXPECT_EQ(multi[i].prim_id, depth - i);
+    }
+
+    if (depth + 1 < multi.size())
+    {
+        EXPECT_FALSE(multi[depth + 1].hit);
+    }
+
+    // Ray packets
+    basic_ray<simd::float4> packet = simd::pack(r, r, r, r);
+    auto phr = simd::unpack(intersect<detail::ClosestHit, 1, Order, Stack>(packet, b, isect));
+
+    for (int j = 0; j < 4; ++j)
+    {
+        ASSERT_TRUE(phr[j].hit);
+        EXPECT_EQ(phr[j].prim_id, depth);
+    }
+
+    // Rays that miss everything
+    r.ori = vec3(10.0f, 10.0f, 10.0f);
+    hr = intersect<detail::ClosestHit, 1, Order, Stack>(r, b, isect);
+    EXPECT_FALSE(hr.hit);
+}
+
+TEST(BVH, IntersectDeep)
+{
+    using detail::distance_order;
+    using detail::split_axis_order;
+    using detail::full_stack;
+    using detail::restart_trail;
+
+    // Deeper than a single 64-bit trail word
+    for (unsigned depth : { 60, 63, 64, 70, 100, 128 })
+    {
+        test_deep<distance_order, restart_trail<>>(make_deep_bvh(depth), depth);
+    }
+
+    auto b = make_deep_bvh(200);
+
+    test_deep<distance_order, restart_trail<1>>(make_deep_bvh(100), 100);
+    test_deep<split_axis_order, restart_trail<8, 256>>(b, 200);
+
+    // Deeper than the traversal state: a full stack starts over with a restart trail,
+    // a restart trail intersects all primitives
+    test_deep<distance_order, full_stack<8>>(make_deep_bvh(20), 20);
+    test_deep<split_axis_order, full_stack<>>(b, 200);
+    test_deep<distance_order, restart_trail<>>(b, 200);
+
+    // Default traversal state
+    auto deepest = make_deep_bvh(300);
+
+    basic_ray<float> r;
+    r.ori = vec3(0.0f, 0.0f, 10.0f);
+    r.dir = vec3(0.0f, 0.0f, -1.0f);
+
+    auto hr = intersect(r, deepest);
+    ASSERT_TRUE(hr.hit);
+    EXPECT_EQ(hr.prim_id, 300U);
+
+    // Index BVH
+    index_bvh<triangle_t> ib(b.primitives().data(), b.primitives().size());
+    ib.nodes() = b.nodes();
+    ib.indices().resize(b.num_primitives());
+
+    for (unsigned i = 0; i < ib.indices().size(); ++i)
+    {
+        ib.indices()[i] = i;
+    }
+
+    test_deep<distance_order, full_stack<>>(ib, 200);
+
+    // Quantized BVH, leaf children are intersected once
+    quantized_bvh<triangle_t> qb(b);
+    test_deep<distance_order, full_stack<>>(qb, 200);
+    test_deep<distance_order, full_stack<256>>(qb, 200);
+    test_deep<distance_order, restart_trail<>>(qb, 200);
+    test_deep<distance_order, restart_trail<1, 256>>(qb, 200);
+
+    // Wide BVHs
+    bvh4<triangle_t> b4(b);
+    test_deep<distance_order, detail::stack<8>>(b4, 200);
+    test_deep<distance_order, detail::stack<256>>(b4, 200);
+
+    // Single rays of a ray stream traverse subtrees with restart_trail<>
+    for (unsigned depth : { 100, 200 })
+    {
+        ray_stream<simd::float4> stream;
+        stream.push_back(r);
+
+        auto hits = intersect(stream, make_deep_bvh(depth));
+
+        ASSERT_TRUE(hits[0].hit);
+        EXPECT_EQ(hits[0].prim_id, depth);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test ray stream traversal
+//
+
+template <typename S, typename BVH>
+static void test_ray_stream(BVH const& b, aligned_vector<basic_ray<float>> const& rays)
+{
+    ray_stream<S> stream;
+
+    for (auto const& r : rays)
+    {
+        stream.push_back(r);
+    }
+
+    ASSERT_EQ(stream.size(), rays.size());
+
+    auto hits = intersect(stream, b);
+
+    ASSERT_EQ(hits.size(), rays.size());
+
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        auto ref = intersect(rays[i], b);
+
+        ASSERT_EQ(ref.hit, hits[i].hit);
+
+        if (ref.hit)
+        {
+            EXPECT_FLOAT_EQ(ref.t, hits[i].t);
+            EXPECT_EQ(ref.prim_id, hits[i].prim_id);
+            EXPECT_EQ(ref.primitive_list_index, hits[i].primitive_list_index);
+        }
+    }
+
+    // Any hit, the stream can be traversed again
+    default_intersector isect;
+    intersect<detail::AnyHit>(stream, b, isect, hits);
+
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        auto ref = intersect<detail::AnyHit>(rays[i], b, isect);
+
+        ASSERT_EQ(ref.hit, hits[i].hit);
+    }
+
+    // Empty stream
+    stream.clear();
+    hits = intersect(stream, b);
+    EXPECT_TRUE(hits.empty());
+}
+
+TEST(BVH, IntersectStream)
+{
+    auto triangles = make_triangle_soup(5000);
+    auto rays = make_rays(3001);
+
+    binned_sah_builder builder;
+
+    auto b1 = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+    test_ray_stream<simd::float4>(b1, rays);
+    test_ray_stream<simd::float8>(b1, rays);
+
+    auto b2 = builder.build(bvh<triangle_t>{}, triangles.data(), triangles.size());
+    test_ray_stream<simd::float4>(b2, rays);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test BVHs over Woop triangles and the watertight intersector
+//
+
+TEST(BVH, IntersectWoop)
+{
+    auto triangles = make_triangle_soup(5000);
+
+    // With seed 1, the ray targets are the first vertices of the triangles (the engine
+    // treats 0 like 1). The tests may disagree on such vertex hits, so avoid them.
+    auto rays = make_rays(2000, 2);
+
+    binned_sah_builder builder;
+
+    auto b = builder.build(index_bvh<triangle_t>{}, triangles.data(), triangles.size());
+
+    // Convert a finished BVH and build from triangles directly
+    index_bvh<basic_woop_triangle<float>> wb(b);
+    builder.enable_spatial_splits(true);
+    auto ws = builder.build(bvh<basic_woop_triangle<float>>{}, triangles.data(), triangles.size());
+
+    EXPECT_EQ(wb.num_primitives(), triangles.size());
+    EXPECT_EQ(wb.num_nodes(), b.num_nodes());
+
+    watertight_intersector isect;
+
+    for (auto const& r : rays)
+    {
+        auto ref = intersect(r, b);
+        auto hr1 = intersect(r, wb);
+        auto hr2 = intersect(r, ws);
+        auto hr3 = intersect<detail::ClosestHit>(r, b, isect);
+
+        EXPECT_EQ(ref.hit, hr1.hit);
+        EXPECT_EQ(ref.hit, hr2.hit);
+        EXPECT_EQ(ref.hit, hr3.hit);
+
+        if (ref.hit && hr1.hit && hr2.hit && hr3.hit)
+        {
+            EXPECT_NEAR(ref.t, hr1.t, 1e-3f * ref.t);
+            EXPECT_NEAR(ref.t, hr2.t, 1e-3f * ref.t);
+            EXPECT_NEAR(ref.t, hr3.t, 1e-3f * ref.t);
+        }
+    }
+}
@@ -0,0 +1,99 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <atomic>
+#include <vector>
+
+#include <visionaray/detail/numa.h>
+#include <visionaray/detail/thread_pool.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Test parsing of Linux cpu lists
+//
+
+TEST(Numa, ParseCpuList)
+{
+    EXPECT_EQ(detail::parse_cpu_list("0"), std::vector<unsigned>({ 0 }));
+    EXPECT_EQ(detail::parse_cpu_list("0-3"), std::vector<unsigned>({ 0, 1, 2, 3 }));
+    EXPECT_EQ(detail::parse_cpu_list("0-1,8,10-11"), std::vector<unsigned>({ 0, 1, 8, 10, 11 }));
+    EXPECT_TRUE(detail::parse_cpu_list("").empty());
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that there is at least one node and each node has CPUs
+//
+
+TEST(Numa, Topology)
+{
+    auto const& node_cpus = detail::numa_node_cpus();
+
+    ASSERT_GE(node_cpus.size(), 1U);
+    EXPECT_EQ(detail::numa_num_nodes(), node_cpus.size());
+
+    for (auto const& cpus : node_cpus)
+    {
+        EXPECT_FALSE(cpus.empty());
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test per-node copies
+//
+
+TEST(Numa, Replicated)
+{
+    std::vector<int> values(1000, 23);
+
+    numa_replicated<std::vector<int>> replicas(values);
+
+    ASSERT_EQ(replicas.size(), detail::numa_num_nodes());
+
+    for (size_t i = 0; i < replicas.size(); ++i)
+    {
+        EXPECT_EQ(replicas[i], values);
+        EXPECT_NE(replicas[i].data(), values.data());
+    }
+
+    EXPECT_EQ(replicas.local(), values);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that pinned threads process all work items and know their node
+//
+
+TEST(Numa, PinnedThreadPool)
+{
+    thread_pool pool(4, PinnedPerNumaNode);
+
+    EXPECT_EQ(pool.affinity(), PinnedPerNumaNode);
+    EXPECT_EQ(pool.num_numa_nodes(), detail::numa_num_nodes());
+
+    long n = 1000;
+    std::vector<std::atomic<int>> counts(n);
+    std::atomic<bool> valid_node(true);
+
+    pool.run([&](long i)
+    {
+        counts[i]++;
+
+        if (detail::this_thread_numa_node() >= detail::numa_num_nodes())
+        {
+            valid_node = false;
+        }
+    }, n);
+
+    for (long i = 0; i < n; ++i)
+    {
+        EXPECT_EQ(counts[i].load(), 1);
+    }
+
+    EXPECT_TRUE(valid_node);
+}
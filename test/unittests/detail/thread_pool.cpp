@@ -0,0 +1,149 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <visionaray/detail/parallel_for.h>
+#include <visionaray/detail/range.h>
+#include <visionaray/detail/thread_pool.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+// Run n work items and check that each one was processed exactly once
+void test_run(thread_pool& pool, long n)
+{
+    std::unique_ptr<std::atomic<int>[]> counts(new std::atomic<int>[n]);
+
+    for (long i = 0; i < n; ++i)
+    {
+        counts[i] = 0;
+    }
+
+    pool.run([&](long i) { counts[i]++; }, n);
+
+    for (long i = 0; i < n; ++i)
+    {
+        EXPECT_EQ(counts[i].load(), 1) << "item " << i;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that all work items are processed exactly once
+//
+
+TEST(ThreadPool, Run)
+{
+    thread_pool pool(4);
+
+    for (long n : { 1L, 2L, 3L, 4L, 5L, 17L, 1000L, 100000L })
+    {
+        test_run(pool, n);
+    }
+
+    // No work items
+    pool.run([](long) { FAIL(); }, 0);
+
+    // No threads
+    thread_pool serial(0);
+    test_run(serial, 100);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test consecutive runs, with and without the threads being parked in between
+//
+
+TEST(ThreadPool, Repeated)
+{
+    thread_pool pool(std::max(2U, std::thread::hardware_concurrency()));
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        test_run(pool, 64);
+    }
+
+    for (int i = 0; i < 5; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        test_run(pool, 64);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that idle threads steal work from a thread that is stuck on a slow work item
+//
+
+TEST(ThreadPool, WorkStealing)
+{
+    thread_pool pool(4);
+
+    long n = 400;
+    std::atomic<long> finished(0);
+    std::atomic<bool> release(false);
+
+    std::unique_ptr<std::thread::id[]> ids(new std::thread::id[n]);
+
+    pool.run([&](long i)
+    {
+        ids[i] = std::this_thread::get_id();
+
+        // Item 0 blocks its thread until all other items were processed
+        if (i == 0)
+        {
+            while (!release)
+            {
+                std::this_thread::yield();
+            }
+        }
+        else if (++finished == n - 1)
+        {
+            release = true;
+        }
+    }, n);
+
+    // The initial range of the first thread was processed by other threads
+    int stolen = 0;
+
+    for (long i = 1; i < n / 4; ++i)
+    {
+        stolen += ids[i] != ids[0];
+    }
+
+    EXPECT_EQ(stolen, n / 4 - 1);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test reset() and parallel_for() on top of the pool
+//
+
+TEST(ThreadPool, Reset)
+{
+    thread_pool pool(2);
+    test_run(pool, 100);
+
+    pool.reset(7);
+    EXPECT_EQ(pool.num_threads, 7U);
+    test_run(pool, 100);
+
+    std::atomic<int> sum(0);
+
+    parallel_for(pool, tiled_range2d<int>(0, 100, 8, 0, 100, 8), [&](range2d<int> const& r)
+    {
+        sum += (r.rows().end() - r.rows().begin()) * (r.cols().end() - r.cols().begin());
+    });
+
+    EXPECT_EQ(sum.load(), 100 * 100);
+}
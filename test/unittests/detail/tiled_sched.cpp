@@ -0,0 +1,499 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/accumulation_buffer_rt.h>
+#include <visionaray/morton.h>
+#include <visionaray/result_record.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+// Render a frame with a slow kernel, each pixel adds one sample to rt. With uneven_cost,
+// pixels in the left half of the image take longer
+template <typename Sched, typename RT>
+void render_slow_frame(Sched& sched, RT& rt, bool uneven_cost = false)
+{
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    auto sparams = make_sched_params(pixel_sampler::uniform_type{}, mv, pr, rt);
+
+    sched.frame([uneven_cost](ray r) -> result_record<float>
+    {
+        bool slow = uneven_cost && r.dir.x < 0.0f;
+        std::this_thread::sleep_for(std::chrono::microseconds(slow ? 100 : 20));
+
+        result_record<float> result;
+        result.color = vec4(1.0f);
+        return result;
+    }, sparams);
+}
+
+// Kernel that returns random numbers and the jittered ray direction
+struct noise_kernel
+{
+    template <typename R, typename Generator>
+    result_record<typename R::scalar_type> operator()(R const& r, Generator& gen) const
+    {
+        using S = typename R::scalar_type;
+
+        S u = gen.next();
+        S v = gen.next();
+
+        result_record<S> result;
+        result.color = vector<4, S>(u, v, r.dir.x, S(1.0));
+        return result;
+    }
+};
+
+// Render num_frames frames with noise_kernel
+template <typename Sched, typename PixelSampler, typename RT>
+void render_noise_frames(Sched& sched, PixelSampler ps, RT& rt, int num_frames)
+{
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    auto sparams = make_sched_params(ps, mv, pr, rt);
+
+    for (int i = 0; i < num_frames; ++i)
+    {
+        sched.frame(noise_kernel{}, sparams);
+    }
+}
+
+// Check that two accumulation buffers hold exactly the same samples
+template <typename RT>
+bool samples_equal(RT const& a, RT const& b)
+{
+    for (int i = 0; i < a.width() * a.height(); ++i)
+    {
+        if (a.counts()[i] != b.counts()[i] || any(a.sums()[i] != b.sums()[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename RT>
+void sample_count_range(RT const& rt, unsigned& min_count, unsigned& max_count)
+{
+    auto first = rt.counts();
+    auto last = rt.counts() + rt.width() * rt.height();
+
+    min_count = *std::min_element(first, last);
+    max_count = *std::max_element(first, last);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that every pixel is rendered exactly once, no matter the number of threads, the tile
+// size and the packet size
+//
+
+template <typename R>
+void test_pixels_rendered_once(unsigned num_threads, int tile_width, int tile_height)
+{
+    accumulation_buffer_rt<float> rt;
+    rt.resize(37, 21);
+
+    tiled_sched<R> sched(num_threads);
+    sched.set_tile_size(tile_width, tile_height);
+    render_noise_frames(sched, pixel_sampler::uniform_type{}, rt, 1);
+
+    unsigned min_count = 0;
+    unsigned max_count = 0;
+    sample_count_range(rt, min_count, max_count);
+
+    EXPECT_EQ(min_count, 1U) << num_threads << " threads, tile size " << tile_width << "x" << tile_height;
+    EXPECT_EQ(max_count, 1U) << num_threads << " threads, tile size " << tile_width << "x" << tile_height;
+}
+
+TEST(TiledSched, PixelsRenderedOnce)
+{
+    unsigned many_threads = std::max(std::thread::hardware_concurrency(), 2U) + 1;
+
+    for (unsigned num_threads : { 1U, 2U, many_threads })
+    {
+        // 0x0 selects the adaptive tile size
+        int tile_sizes[][2] = { { 0, 0 }, { 1, 1 }, { 7, 5 }, { 13, 3 }, { 64, 64 } };
+
+        for (auto ts : tile_sizes)
+        {
+            test_pixels_rendered_once<ray>(num_threads, ts[0], ts[1]);
+            test_pixels_rendered_once<basic_ray<simd::float4>>(num_threads, ts[0], ts[1]);
+            test_pixels_rendered_once<basic_ray<simd::float8>>(num_threads, ts[0], ts[1]);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test the default tile size
+//
+
+TEST(TiledSched, AdaptiveTileSize)
+{
+    for (unsigned concurrency : { 0U, 1U, 2U, 4U, 8U, 16U, 64U, 256U })
+    {
+        for (int width : { 1, 37, 640, 1920, 7680 })
+        {
+            int height = width * 9 / 16 + 1;
+
+            int size = basic_sched_impl::adaptive_tile_size(width, height, concurrency);
+
+            // Power of two in [8..64]
+            EXPECT_GE(size, 8);
+            EXPECT_LE(size, 64);
+            EXPECT_EQ(size & (size - 1), 0);
+
+            // Largest size that gives enough tiles per thread
+            long min_tiles = 16L * std::max(concurrency, 1U);
+
+            if (size > 8)
+            {
+                EXPECT_GE(static_cast<long>(div_up(width, size)) * div_up(height, size), min_tiles);
+            }
+
+            if (size < 64)
+            {
+                EXPECT_LT(static_cast<long>(div_up(width, size * 2)) * div_up(height, size * 2), min_tiles);
+            }
+        }
+    }
+
+    // 640x480 with 8 threads: 64x64 tiles would only give 10x8 tiles
+    EXPECT_EQ(basic_sched_impl::adaptive_tile_size(640, 480, 8), 32);
+    EXPECT_EQ(basic_sched_impl::adaptive_tile_size(1920, 1080, 8), 64);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that tiles are started in Morton order
+//
+
+TEST(TiledSched, MortonOrder)
+{
+    // A single thread processes the tiles in the order they are handed out
+    tiled_sched_backend backend(1);
+
+    int tile_size = 4;
+    int num_tiles_x = 8;
+    int num_tiles_y = 5;
+
+    std::vector<int> tiles;
+
+    backend.for_each_packet(
+            tiled_range2d<int>(0, num_tiles_x * tile_size, tile_size, 0, num_tiles_y * tile_size, tile_size),
+            1,
+            1,
+            [&](int x, int y)
+            {
+                int tile = (y / tile_size) * num_tiles_x + x / tile_size;
+
+                if (tiles.empty() || tiles.back() != tile)
+                {
+                    tiles.push_back(tile);
+                }
+            }
+            );
+
+    ASSERT_EQ(tiles.size(), static_cast<size_t>(num_tiles_x * num_tiles_y));
+
+    for (size_t i = 1; i < tiles.size(); ++i)
+    {
+        auto prev = morton_encode2D(tiles[i - 1] % num_tiles_x, tiles[i - 1] / num_tiles_x);
+        auto code = morton_encode2D(tiles[i] % num_tiles_x, tiles[i] / num_tiles_x);
+
+        EXPECT_LT(prev, code);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that threads w/o tiles left help with the rows of slow tiles
+//
+
+TEST(TiledSched, SplitOnDemand)
+{
+    tiled_sched_backend backend(4);
+
+    // Four 32x32 tiles, tile 0 is slow
+    int size = 64;
+    int tile_size = 32;
+
+    std::vector<std::atomic<int>> counts(size * size);
+
+    for (auto& c : counts)
+    {
+        c.store(0);
+    }
+
+    std::mutex mutex;
+    std::set<std::thread::id> slow_tile_threads;
+
+    backend.for_each_packet(
+            tiled_range2d<int>(0, size, tile_size, 0, size, tile_size),
+            1,
+            1,
+            [&](int x, int y)
+            {
+                ++counts[y * size + x];
+
+                if (x < tile_size && y < tile_size)
+                {
+                    if (x == 0)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        slow_tile_threads.insert(std::this_thread::get_id());
+                    }
+
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+            );
+
+    for (auto const& c : counts)
+    {
+        EXPECT_EQ(c.load(), 1);
+    }
+
+    // Rows of the slow tile were rendered by more than one thread
+    EXPECT_GT(slow_tile_threads.size(), 1U);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that frames with a budget render part of the tiles, and that the remaining tiles are
+// rendered in the following frames
+//
+
+TEST(TiledSched, FrameBudget)
+{
+    accumulation_buffer_rt<float> rt;
+    rt.resize(64, 32);
+
+    tiled_sched<ray> sched(2);
+    sched.set_tile_size(16, 16);
+
+    // Much less than the time for all 8 tiles
+    sched.set_frame_budget(0.001);
+
+    unsigned min_count = 0;
+    unsigned max_count = 0;
+
+    render_slow_frame(sched, rt);
+    sample_count_range(rt, min_count, max_count);
+
+    EXPECT_FALSE(sched.frame_complete());
+    EXPECT_EQ(min_count, 0U);
+    EXPECT_EQ(max_count, 1U);
+
+    // Each frame renders at least one tile per thread, and continues with the tiles that
+    // were carried over
+    for (int frame = 1; frame < 8 && min_count == 0; ++frame)
+    {
+        render_slow_frame(sched, rt);
+        sample_count_range(rt, min_count, max_count);
+    }
+
+    EXPECT_EQ(min_count, 1U);
+
+    // Complete frame w/o budget
+    sched.set_frame_budget(0.0);
+
+    unsigned prev_min_count = min_count;
+    unsigned prev_max_count = max_count;
+
+    render_slow_frame(sched, rt);
+    sample_count_range(rt, min_count, max_count);
+
+    EXPECT_TRUE(sched.frame_complete());
+    EXPECT_EQ(min_count, prev_min_count + 1);
+    EXPECT_EQ(max_count, prev_max_count + 1);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that each tile is rendered exactly once per pass over the image, also when threads
+// skip expensive tiles and render cheaper ones
+//
+
+TEST(TiledSched, FrameBudgetPasses)
+{
+    accumulation_buffer_rt<float> rt;
+    rt.resize(64, 64);
+
+    tiled_sched<ray> sched(4);
+    sched.set_tile_size(8, 8);
+    sched.set_frame_budget(0.002);
+
+    for (unsigned pass = 1; pass <= 3; ++pass)
+    {
+        int num_frames = 0;
+
+        do
+        {
+            render_slow_frame(sched, rt, true);
+            ++num_frames;
+        }
+        while (!sched.frame_complete() && num_frames < 1000);
+
+        unsigned min_count = 0;
+        unsigned max_count = 0;
+        sample_count_range(rt, min_count, max_count);
+
+        EXPECT_GT(num_frames, 1);
+        EXPECT_EQ(min_count, pass);
+        EXPECT_EQ(max_count, pass);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that pixel samplers with per-frame blend factors are rejected with a frame budget
+//
+
+TEST(TiledSched, FrameBudgetBlending)
+{
+    simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> rt;
+    rt.resize(16, 16);
+
+    // dummies
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    pixel_sampler::jittered_blend_type blend_params;
+    blend_params.sfactor = 1.0f;
+    blend_params.dfactor = 0.0f;
+
+    auto sparams = make_sched_params(blend_params, mv, pr, rt);
+
+    auto kernel = [](ray) -> result_record<float>
+    {
+        result_record<float> result;
+        result.color = vec4(1.0f);
+        return result;
+    };
+
+    tiled_sched<ray> sched(2);
+    EXPECT_NO_THROW(sched.frame(kernel, sparams));
+
+    sched.set_frame_budget(0.001);
+    EXPECT_THROW(sched.frame(kernel, sparams), std::invalid_argument);
+
+    // Accumulating pixel samplers are fine
+    auto accum_params = make_sched_params(pixel_sampler::jittered_type{}, mv, pr, rt);
+    EXPECT_NO_THROW(sched.frame(kernel, accum_params));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that images only depend on seed and sample index, but not on scheduler, number of
+// threads, tile size or packet size
+//
+
+template <typename PixelSampler>
+void test_deterministic(PixelSampler ps)
+{
+    int width = 37;
+    int height = 21;
+    int num_frames = 4;
+
+    accumulation_buffer_rt<double> reference;
+    reference.resize(width, height);
+
+    simple_sched<ray> reference_sched;
+    reference_sched.set_seed(42);
+    render_noise_frames(reference_sched, ps, reference, num_frames);
+
+    EXPECT_EQ(reference_sched.sample_offset(), static_cast<unsigned>(num_frames));
+
+    // Different threads and tiles
+    {
+        accumulation_buffer_rt<double> rt;
+        rt.resize(width, height);
+
+        tiled_sched<ray> sched(3);
+        sched.set_tile_size(8, 4);
+        sched.set_seed(42);
+        render_noise_frames(sched, ps, rt, num_frames);
+
+        EXPECT_TRUE(samples_equal(rt, reference));
+    }
+
+    // Packets
+    {
+        accumulation_buffer_rt<double> rt;
+        rt.resize(width, height);
+
+        tiled_sched<basic_ray<simd::float4>> sched(2);
+        sched.set_seed(42);
+        render_noise_frames(sched, ps, rt, num_frames);
+
+        EXPECT_TRUE(samples_equal(rt, reference));
+    }
+
+    // Different seed
+    {
+        accumulation_buffer_rt<double> rt;
+        rt.resize(width, height);
+
+        tiled_sched<ray> sched(2);
+        sched.set_seed(43);
+        render_noise_frames(sched, ps, rt, num_frames);
+
+        EXPECT_FALSE(samples_equal(rt, reference));
+    }
+
+    // Samples split over two renders and merged
+    {
+        accumulation_buffer_rt<double> rt1;
+        rt1.resize(width, height);
+
+        accumulation_buffer_rt<double> rt2;
+        rt2.resize(width, height);
+
+        tiled_sched<ray> sched1(2);
+        sched1.set_seed(42);
+        render_noise_frames(sched1, ps, rt1, num_frames / 2);
+
+        tiled_sched<ray> sched2(2);
+        sched2.set_seed(42);
+        sched2.set_sample_offset(num_frames / 2);
+        render_noise_frames(sched2, ps, rt2, num_frames - num_frames / 2);
+
+        rt1.merge(rt2);
+
+        EXPECT_TRUE(samples_equal(rt1, reference));
+    }
+}
+
+TEST(TiledSched, Deterministic)
+{
+    test_deterministic(pixel_sampler::jittered_type{});
+    test_deterministic(pixel_sampler::sobol_type{});
+    test_deterministic(pixel_sampler::halton_type{});
+    test_deterministic(pixel_sampler::blue_noise_type{});
+}
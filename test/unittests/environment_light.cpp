@@ -0,0 +1,443 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/area_light.h>
+#include <visionaray/distribution_2d.h>
+#include <visionaray/environment_light.h>
+#include <visionaray/generic_light.h>
+#include <visionaray/kernels.h>
+#include <visionaray/light_sampler.h>
+#include <visionaray/material.h>
+#include <visionaray/random_generator.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+using texture_type = texture<vec4, 2>;
+using env_light_type = environment_light<float, texture_ref<vec4, 2>>;
+
+int const env_width = 16;
+int const env_height = 8;
+
+// Environment map with radiance 1, and a bright texel in the upper hemisphere
+static texture_type make_environment_map()
+{
+    std::vector<vec4> data(env_width * env_height, vec4(1.0f));
+    data[2 * env_width + 5] = vec4(200.0f, 200.0f, 200.0f, 1.0f);
+
+    texture_type tex(env_width, env_height);
+    tex.reset(data.data());
+    tex.set_address_mode(Wrap);
+    tex.set_filter_mode(Nearest);
+
+    return tex;
+}
+
+// Integrate the map's radiance times cos^n(theta) over the texels in the upper hemisphere
+// (n = 1) or over the whole sphere (n = 0)
+static double integrate_environment_map(texture_type const& tex, int n)
+{
+    double pi = constants::pi<double>();
+    double dphi = 2.0 * pi / env_width;
+    double sum = 0.0;
+
+    for (int y = 0; y < env_height; ++y)
+    {
+        double theta0 = pi * y / env_height;
+        double theta1 = pi * (y + 1) / env_height;
+
+        double row = 0.0;
+
+        if (n == 0)
+        {
+            row = std::cos(theta0) - std::cos(theta1);
+        }
+        else if (theta1 <= pi / 2.0 + 1e-6)
+        {
+            row = (std::sin(theta1) * std::sin(theta1) - std::sin(theta0) * std::sin(theta0)) * 0.5;
+        }
+
+        for (int x = 0; x < env_width; ++x)
+        {
+            sum += tex.data()[y * env_width + x].x * dphi * row;
+        }
+    }
+
+    return sum;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that samples of the 2D distribution are distributed like the function
+//
+
+TEST(Distribution2D, Sample)
+{
+    float func[] = {
+        1.0f, 2.0f, 0.0f, 1.0f,
+        3.0f, 0.0f, 1.0f, 0.0f
+        };
+
+    distribution_2d dist(func, 4, 2);
+    auto ref = dist.ref();
+
+    int n = 128;
+    std::vector<int> hist(8, 0);
+
+    for (int j = 0; j < n; ++j)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            float pdf = 0.0f;
+            vec2 uv = ref.sample((i + 0.5f) / n, (j + 0.5f) / n, pdf);
+
+            ASSERT_GE(uv.x, 0.0f);
+            ASSERT_LT(uv.x, 1.0f);
+            ASSERT_GE(uv.y, 0.0f);
+            ASSERT_LT(uv.y, 1.0f);
+
+            int x = static_cast<int>(uv.x * 4);
+            int y = static_cast<int>(uv.y * 2);
+            ++hist[y * 4 + x];
+
+            // Density over [0..1)^2, function values sum up to 8
+            EXPECT_FLOAT_EQ(pdf, func[y * 4 + x]);
+            EXPECT_FLOAT_EQ(ref.pdf(uv), pdf);
+        }
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        EXPECT_NEAR(hist[i] / static_cast<float>(n * n), func[i] / 8.0f, 0.01f);
+    }
+}
+
+TEST(Distribution2D, Uniform)
+{
+    float func[] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    distribution_2d dist(func, 3, 2);
+    auto ref = dist.ref();
+
+    float pdf = 0.0f;
+    vec2 uv = ref.sample(0.4f, 0.7f, pdf);
+
+    EXPECT_FLOAT_EQ(pdf, 1.0f);
+    EXPECT_NEAR(uv.x, 0.4f, 1e-6f);
+    EXPECT_NEAR(uv.y, 0.7f, 1e-6f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test environment light samples against pdf() and radiance(), and integrate the map
+//
+
+TEST(EnvironmentLight, Sample)
+{
+    auto tex = make_environment_map();
+    auto dist = make_environment_distribution(tex);
+
+    env_light_type env(texture_ref<vec4, 2>(tex), dist.ref());
+    env.set_scale(0.5f);
+    env.set_light_to_world_transform(mat4::rotation(vec3(1.0f, 0.0f, 0.0f), 0.3f));
+
+    random_generator<float> gen(1234);
+
+    int n = 100000;
+    double sum = 0.0;
+    int mismatches = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        auto ls = env.sample(gen);
+
+        ASSERT_TRUE(ls.infinite_light);
+        ASSERT_FALSE(ls.delta_light);
+        ASSERT_GT(ls.area, 0.0f);
+
+        EXPECT_NEAR(length(ls.pos), 1.0f, 1e-5f);
+        EXPECT_FLOAT_EQ(ls.intensity.x, env.radiance(ls.pos).x);
+
+        if (std::abs(env.pdf(ls.pos) * ls.area - 1.0f) > 1e-3f)
+        {
+            ++mismatches;
+        }
+
+        sum += ls.intensity.x * ls.area;
+    }
+
+    // Round-off of sin(theta) near the poles
+    EXPECT_LT(mismatches, n / 1000);
+
+    // Map is importance sampled, texels are sampled proportional to their radiance
+    double expected = 0.5 * integrate_environment_map(tex, 0);
+    EXPECT_NEAR(sum / n, expected, expected * 0.01);
+
+    // SIMD
+    random_generator<float> gen4(4321);
+
+    array<vec3, 4> dirs;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        dirs[i] = env.sample(gen4).pos;
+    }
+
+    auto dir4 = simd::pack(dirs);
+
+    simd::aligned_array_t<simd::float4> pdfs;
+    store(pdfs, env.pdf(dir4));
+
+    simd::aligned_array_t<simd::float4> radiances;
+    store(radiances, env.radiance(dir4).x);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_FLOAT_EQ(pdfs[i], env.pdf(dirs[i]));
+        EXPECT_FLOAT_EQ(radiances[i], env.radiance(dirs[i]).x);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that light samplers pick infinite lights with a fixed probability
+//
+
+TEST(EnvironmentLight, LightSampler)
+{
+    using triangle_type = basic_triangle<3, float>;
+    using light_type = generic_light<area_light<float, triangle_type>, env_light_type>;
+
+    auto tex = make_environment_map();
+    auto dist = make_environment_distribution(tex);
+
+    aligned_vector<light_type> lights;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        triangle_type t(vec3(i * 2.0f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f));
+        t.prim_id = i;
+
+        area_light<float, triangle_type> light(t);
+        light.set_cl(vec3(1.0f));
+        light.set_kl(i + 1.0f);
+        lights.push_back(light);
+    }
+
+    lights.push_back(env_light_type(texture_ref<vec4, 2>(tex), dist.ref()));
+
+    EXPECT_TRUE(get_light_bounds(lights[3]).infinite);
+    EXPECT_FALSE(get_light_bounds(lights[0]).infinite);
+
+    power_light_sampler power(lights.begin(), lights.end());
+    light_bvh bvh(lights.begin(), lights.end());
+
+    auto pref = power.ref();
+    auto bref = bvh.ref();
+
+    // The tree only holds the area lights
+    EXPECT_EQ(bvh.nodes().size(), size_t(5));
+
+    vec3 pos(1.0f, 0.0f, 0.5f);
+    vec3 normal(0.0f, 1.0f, 0.0f);
+
+    EXPECT_FLOAT_EQ(pref.light_pdf(lights.begin(), lights.end(), 3, pos, normal), 0.5f);
+    EXPECT_FLOAT_EQ(bref.light_pdf(lights.begin(), lights.end(), 3, pos, normal), 0.5f);
+
+    float power_sum = 0.0f;
+    float bvh_sum = 0.0f;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        power_sum += pref.light_pdf(lights.begin(), lights.end(), i, pos, normal);
+        bvh_sum += bref.light_pdf(lights.begin(), lights.end(), i, pos, normal);
+    }
+
+    EXPECT_NEAR(power_sum, 1.0f, 1e-5f);
+    EXPECT_NEAR(bvh_sum, 1.0f, 1e-5f);
+
+    // Sampled pdfs match light_pdf()
+    for (int i = 0; i < 100; ++i)
+    {
+        float u = (i + 0.5f) / 100;
+        float pdf = 0.0f;
+
+        int index = bref.sample(lights.begin(), lights.end(), pos, normal, u, pdf);
+        EXPECT_FLOAT_EQ(pdf, bref.light_pdf(lights.begin(), lights.end(), index, pos, normal));
+        EXPECT_EQ(index == 3, u < 0.5f);
+
+        index = pref.sample(lights.begin(), lights.end(), pos, normal, u, pdf);
+        EXPECT_FLOAT_EQ(pdf, pref.light_pdf(lights.begin(), lights.end(), index, pos, normal));
+    }
+
+    // Area lights w/o environment light keep their probabilities
+    EXPECT_FLOAT_EQ(
+            bref.light_pdf(lights.begin(), lights.end(), 1, pos, normal) * 2.0f,
+            light_bvh(lights.begin(), lights.begin() + 3).ref().light_pdf(1, pos, normal)
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that path tracing a diffuse floor under the environment converges to the reflected
+// radiance, and that importance sampling the environment reduces variance
+//
+
+int const num_paths = 40000;
+
+static random_generator<float> make_test_generator(float)
+{
+    return random_generator<float>(1234);
+}
+
+static random_generator<simd::float4> make_test_generator(simd::float4)
+{
+    array<unsigned, 4> seed = {{ 1234, 1235, 1236, 1237 }};
+    return random_generator<simd::float4>(seed);
+}
+
+static void accumulate(float value, double& sum, double& sum2)
+{
+    sum += value;
+    sum2 += static_cast<double>(value) * value;
+}
+
+static void accumulate(simd::float4 const& value, double& sum, double& sum2)
+{
+    simd::aligned_array_t<simd::float4> values;
+    store(values, value);
+
+    for (float v : values)
+    {
+        accumulate(v, sum, sum2);
+    }
+}
+
+template <typename S, typename Params>
+static void render_floor_point(Params const& params, double& mean, double& variance)
+{
+    using V = vector<3, S>;
+
+    pathtracing::kernel<Params> kernel;
+    kernel.params = params;
+
+    auto gen = make_test_generator(S{});
+
+    int n = num_paths;
+    double sum = 0.0;
+    double sum2 = 0.0;
+
+    for (int i = 0; i < n / simd::num_elements<S>::value; ++i)
+    {
+        basic_ray<S> r(V(0.3f, 0.5f, 0.1f), V(0.0f, -1.0f, 0.0f));
+
+        auto result = kernel(r, gen);
+        accumulate(result.color.x, sum, sum2);
+    }
+
+    mean = sum / n;
+    variance = sum2 / n - mean * mean;
+}
+
+TEST(EnvironmentLight, Pathtracing)
+{
+    using triangle_type = basic_triangle<3, float>;
+
+    aligned_vector<triangle_type> triangles;
+
+    triangle_type f1(vec3(-20.0f, 0.0f, -20.0f), vec3(40.0f, 0.0f, 40.0f), vec3(40.0f, 0.0f, 0.0f));
+    triangle_type f2(vec3(-20.0f, 0.0f, -20.0f), vec3(0.0f, 0.0f, 40.0f), vec3(40.0f, 0.0f, 40.0f));
+    f1.prim_id = 0;
+    f2.prim_id = 1;
+    f1.geom_id = 0;
+    f2.geom_id = 0;
+    triangles.push_back(f1);
+    triangles.push_back(f2);
+
+    matte<float> m;
+    m.cd() = from_rgb(vec3(0.8f));
+    m.kd() = 1.0f;
+
+    aligned_vector<matte<float>> materials;
+    materials.push_back(m);
+
+    auto tex = make_environment_map();
+    auto dist = make_environment_distribution(tex);
+
+    env_light_type env(texture_ref<vec4, 2>(tex), dist.ref());
+
+    aligned_vector<env_light_type> lights;
+    lights.push_back(env);
+
+    auto params = make_kernel_params(
+            triangles.data(),
+            triangles.data() + triangles.size(),
+            materials.data(),
+            lights.data(),
+            lights.data() + lights.size(),
+            2,
+            1e-4f
+            );
+
+    // BRDF sampling only, the environment light is not in the lights
+    auto brdf_params = make_kernel_params(
+            triangles.data(),
+            triangles.data() + triangles.size(),
+            materials.data(),
+            lights.data(),
+            lights.data(),
+            2,
+            1e-4f
+            );
+
+    double brdf_mean = 0.0;
+    double brdf_variance = 0.0;
+    render_floor_point<float>(with_environment_light(brdf_params, env, -1), brdf_mean, brdf_variance);
+
+    // Next event estimation and MIS
+    double mis_mean = 0.0;
+    double mis_variance = 0.0;
+    render_floor_point<float>(with_environment_light(params, env, 0), mis_mean, mis_variance);
+
+    light_bvh bvh(lights.begin(), lights.end());
+
+    double bvh_mean = 0.0;
+    double bvh_variance = 0.0;
+    render_floor_point<float>(
+            with_environment_light(with_light_sampler(params, bvh.ref()), env, 0),
+            bvh_mean,
+            bvh_variance
+            );
+
+    double simd_mean = 0.0;
+    double simd_variance = 0.0;
+    render_floor_point<simd::float4>(with_environment_light(params, env, 0), simd_mean, simd_variance);
+
+    // Lambertian floor: albedo / pi * irradiance
+    double expected = 0.8 * constants::inv_pi<double>() * integrate_environment_map(tex, 1);
+
+    auto max_error = [](double variance)
+    {
+        return 4.0 * std::sqrt(variance / num_paths);
+    };
+
+    EXPECT_NEAR(brdf_mean, expected, max_error(brdf_variance));
+    EXPECT_NEAR(mis_mean, expected, max_error(mis_variance));
+    EXPECT_NEAR(bvh_mean, expected, max_error(bvh_variance));
+    EXPECT_NEAR(simd_mean, expected, max_error(simd_variance));
+
+    EXPECT_LT(mis_variance, brdf_variance * 0.5);
+}
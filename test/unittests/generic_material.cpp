@@ -1,10 +1,14 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <cmath>
 #include <vector>
 
+#include <visionaray/math/simd/simd.h>
 #include <visionaray/math/array.h>
 #include <visionaray/generic_material.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/shade_record.h>
 
 #include <gtest/gtest.h>
 
@@ -120,3 +124,266 @@ TEST(GenericMaterial, SIMD)
     }
     EXPECT_FLOAT_EQ( m4.ls(), em.ls() );
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Test SIMD evaluation of generic materials against per-lane scalar evaluation
+//
+
+using simd_test_material = generic_material<
+    matte<float>,
+    plastic<float>,
+    emissive<float>,
+    glass<float>
+    >;
+
+static array<simd_test_material, 4> make_simd_test_materials(int m0, int m1, int m2, int m3)
+{
+    matte<float> ma;
+    ma.ca() = from_rgb(vec3(0.1f, 0.1f, 0.1f));
+    ma.ka() = 1.0f;
+    ma.cd() = from_rgb(vec3(0.8f, 0.2f, 0.1f));
+    ma.kd() = 1.0f;
+
+    plastic<float> pl;
+    pl.ca() = from_rgb(vec3(0.2f, 0.2f, 0.2f));
+    pl.ka() = 0.5f;
+    pl.cd() = from_rgb(vec3(0.1f, 0.5f, 0.9f));
+    pl.kd() = 1.0f;
+    pl.cs() = from_rgb(vec3(0.5f, 0.5f, 0.5f));
+    pl.ks() = 0.5f;
+    pl.specular_exp() = 32.0f;
+
+    emissive<float> em;
+    em.ce() = from_rgb(vec3(1.0f, 0.9f, 0.8f));
+    em.ls() = 4.0f;
+
+    glass<float> gl;
+    gl.ct() = from_rgb(vec3(1.0f, 1.0f, 1.0f));
+    gl.kt() = 1.0f;
+    gl.cr() = from_rgb(vec3(1.0f, 1.0f, 1.0f));
+    gl.kr() = 1.0f;
+    gl.ior() = spectrum<float>(1.5f);
+
+    auto make = [&](int type)
+    {
+        switch (type)
+        {
+        case 0: return simd_test_material(ma);
+        case 1: return simd_test_material(pl);
+        case 2: return simd_test_material(em);
+        case 3: return simd_test_material(gl);
+        default: return simd_test_material();
+        }
+    };
+
+    return {{ make(m0), make(m1), make(m2), make(m3) }};
+}
+
+static array<shade_record<float>, 4> make_simd_test_shade_records()
+{
+    array<shade_record<float>, 4> result;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        result[i].normal = normalize(vec3(0.1f * i, 1.0f, 0.2f));
+        result[i].geometric_normal = result[i].normal;
+        result[i].view_dir = normalize(vec3(0.3f, 1.0f, -0.2f * i));
+        result[i].tex_color = vec3(1.0f);
+        result[i].light_dir = normalize(vec3(-0.2f, 1.0f, 0.1f * i));
+        result[i].light_intensity = vec3(2.0f);
+    }
+
+    return result;
+}
+
+static shade_record<simd::float4> pack_simd_test_shade_records(array<shade_record<float>, 4> const& srs)
+{
+    array<vec3, 4> normal;
+    array<vec3, 4> view_dir;
+    array<vec3, 4> light_dir;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        normal[i] = srs[i].normal;
+        view_dir[i] = srs[i].view_dir;
+        light_dir[i] = srs[i].light_dir;
+    }
+
+    shade_record<simd::float4> result;
+    result.normal = simd::pack(normal);
+    result.geometric_normal = result.normal;
+    result.view_dir = simd::pack(view_dir);
+    result.tex_color = vector<3, simd::float4>(1.0f);
+    result.light_dir = simd::pack(light_dir);
+    result.light_intensity = vector<3, simd::float4>(2.0f);
+    return result;
+}
+
+static void expect_spectrum_near(spectrum<float> const& a, spectrum<float> const& b)
+{
+    for (size_t i = 0; i < spectrum<float>::num_samples; ++i)
+    {
+        EXPECT_NEAR(a[i], b[i], 1e-4f * std::max(1.0f, std::abs(b[i])));
+    }
+}
+
+static void test_shade_and_pdf(array<simd_test_material, 4> const& mats)
+{
+    auto srs = make_simd_test_shade_records();
+    auto sr = pack_simd_test_shade_records(srs);
+
+    simd::generic_material<4, matte<float>, plastic<float>, emissive<float>, glass<float>> simd_mat(mats);
+
+    auto amb = simd::unpack(simd_mat.ambient());
+    auto shaded = simd::unpack(simd_mat.shade(sr));
+
+    simd::int4 inter(0);
+    simd::aligned_array_t<simd::float4> pdfs;
+    store(pdfs, simd_mat.pdf(sr, inter));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (mats[i].which() == unsigned(-1))
+        {
+            expect_spectrum_near(amb[i], spectrum<float>(0.0f));
+            expect_spectrum_near(shaded[i], spectrum<float>(0.0f));
+            EXPECT_FLOAT_EQ(pdfs[i], 0.0f);
+            continue;
+        }
+
+        expect_spectrum_near(amb[i], mats[i].ambient());
+        expect_spectrum_near(shaded[i], mats[i].shade(srs[i]));
+        EXPECT_NEAR(pdfs[i], mats[i].pdf(srs[i], 0), 1e-4f);
+    }
+}
+
+TEST(GenericMaterial, SIMDShadeCoherent)
+{
+    test_shade_and_pdf(make_simd_test_materials(0, 0, 0, 0));
+    test_shade_and_pdf(make_simd_test_materials(1, 1, 1, 1));
+    test_shade_and_pdf(make_simd_test_materials(2, 2, 2, 2));
+
+    // No SIMD glass, lanes are shaded one by one
+    test_shade_and_pdf(make_simd_test_materials(3, 3, 3, 3));
+}
+
+TEST(GenericMaterial, SIMDShadeMixed)
+{
+    test_shade_and_pdf(make_simd_test_materials(0, 1, 2, 3));
+    test_shade_and_pdf(make_simd_test_materials(1, 0, 1, 0));
+    test_shade_and_pdf(make_simd_test_materials(2, 3, 3, 0));
+
+    // Lanes w/o material
+    test_shade_and_pdf(make_simd_test_materials(0, -1, 1, -1));
+    test_shade_and_pdf(make_simd_test_materials(-1, -1, -1, -1));
+}
+
+TEST(GenericMaterial, SIMDSample)
+{
+    auto srs = make_simd_test_shade_records();
+    auto sr = pack_simd_test_shade_records(srs);
+
+    array<unsigned, 4> seeds{{ 1, 2, 3, 4 }};
+
+    // Matte lanes draw the same numbers from their streams as scalar matte,
+    // lanes w/o material return zero
+    auto mats = make_simd_test_materials(0, -1, 0, 3);
+
+    simd::generic_material<4, matte<float>, plastic<float>, emissive<float>, glass<float>> simd_mat(mats);
+
+    random_generator<simd::float4> gen(seeds);
+
+    vector<3, simd::float4> refl_dir;
+    simd::float4 pdf;
+    simd::int4 inter;
+    auto sampled = simd::unpack(simd_mat.sample(sr, refl_dir, pdf, inter, gen));
+
+    auto refl_dirs = simd::unpack(refl_dir);
+    simd::aligned_array_t<simd::float4> pdfs;
+    store(pdfs, pdf);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (i == 1)
+        {
+            expect_spectrum_near(sampled[i], spectrum<float>(0.0f));
+            EXPECT_FLOAT_EQ(pdfs[i], 0.0f);
+            continue;
+        }
+
+        if (i == 3)
+        {
+            // Glass is specular
+            EXPECT_GT(pdfs[i], 0.0f);
+            EXPECT_NEAR(length(refl_dirs[i]), 1.0f, 1e-4f);
+            continue;
+        }
+
+        random_generator<float> scalar_gen(seeds[i]);
+
+        vec3 rd;
+        float pd = 0.0f;
+        int it = 0;
+        auto expected = mats[i].sample(srs[i], rd, pd, it, scalar_gen);
+
+        expect_spectrum_near(sampled[i], expected);
+        EXPECT_NEAR(pdfs[i], pd, 1e-4f);
+
+        for (int j = 0; j < 3; ++j)
+        {
+            EXPECT_NEAR(refl_dirs[i][j], rd[j], 1e-4f);
+        }
+    }
+}
+
+TEST(GenericMaterial, SIMDSampleDeterministic)
+{
+    auto srs = make_simd_test_shade_records();
+    auto sr = pack_simd_test_shade_records(srs);
+
+    array<unsigned, 4> seeds{{ 5, 6, 7, 8 }};
+
+    // Lanes draw the same numbers as scalar materials with the same seeds, no matter
+    // which other materials the packet contains, also when sampling again
+    auto mats = make_simd_test_materials(0, 1, 3, 1);
+
+    simd::generic_material<4, matte<float>, plastic<float>, emissive<float>, glass<float>> simd_mat(mats);
+
+    random_generator<simd::float4> gen(seeds);
+
+    array<random_generator<float>, 4> scalar_gens;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        scalar_gens[i] = random_generator<float>(seeds[i]);
+    }
+
+    for (int n = 0; n < 8; ++n)
+    {
+        vector<3, simd::float4> refl_dir;
+        simd::float4 pdf;
+        simd::int4 inter;
+        auto sampled = simd::unpack(simd_mat.sample(sr, refl_dir, pdf, inter, gen));
+
+        auto refl_dirs = simd::unpack(refl_dir);
+        simd::aligned_array_t<simd::float4> pdfs;
+        store(pdfs, pdf);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            vec3 rd;
+            float pd = 0.0f;
+            int it = 0;
+            auto expected = mats[i].sample(srs[i], rd, pd, it, scalar_gens[i]);
+
+            expect_spectrum_near(sampled[i], expected);
+            EXPECT_NEAR(pdfs[i], pd, 1e-4f);
+
+            for (int j = 0; j < 3; ++j)
+            {
+                EXPECT_NEAR(refl_dirs[i][j], rd[j], 1e-4f);
+            }
+        }
+    }
+}
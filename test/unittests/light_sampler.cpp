@@ -0,0 +1,400 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/area_light.h>
+#include <visionaray/generic_light.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/kernels.h>
+#include <visionaray/light_sampler.h>
+#include <visionaray/material.h>
+#include <visionaray/point_light.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/spot_light.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+using triangle_type = basic_triangle<3, float>;
+using light_type = area_light<float, triangle_type>;
+
+// Emissive triangle facing down (-y), with the given center, size and prim_id
+triangle_type make_light_triangle(vec3 center, float size, int prim_id)
+{
+    vec3 v1 = center + vec3(-size, 0.0f, -size);
+    vec3 v2 = center + vec3( size, 0.0f, -size);
+    vec3 v3 = center + vec3( 0.0f, 0.0f,  size);
+
+    triangle_type t(v1, v2 - v1, v3 - v1);
+    t.prim_id = prim_id;
+    t.geom_id = 1;
+    return t;
+}
+
+light_type make_light(triangle_type const& t, float kl)
+{
+    light_type light(t);
+    light.set_cl(vec3(1.0f));
+    light.set_kl(kl);
+    return light;
+}
+
+// Grid of n x n lights at height 1 above the floor, with varying power
+aligned_vector<light_type> make_lights(int n, int first_prim_id)
+{
+    aligned_vector<light_type> lights;
+
+    for (int z = 0; z < n; ++z)
+    {
+        for (int x = 0; x < n; ++x)
+        {
+            vec3 center(x * 2.0f - n, 1.0f, z * 2.0f - n);
+            float kl = 1.0f + (x * 7 + z * 3) % 5;
+
+            lights.push_back(make_light(make_light_triangle(center, 0.2f, first_prim_id++), kl));
+        }
+    }
+
+    return lights;
+}
+
+// Check that a sampler's pdfs sum to one, and that sampled lights have the pdf that
+// pdf() reports for them
+template <typename Sampler, typename Lights>
+void test_sampler_pdfs(Sampler const& sampler, Lights const& lights, vec3 pos, vec3 normal)
+{
+    float sum = 0.0f;
+
+    for (auto const& l : lights)
+    {
+        float pdf = sampler.pdf(lights.begin(), lights.end(), l.geometry().prim_id, pos, normal);
+        EXPECT_GE(pdf, 0.0f);
+        sum += pdf;
+    }
+
+    EXPECT_NEAR(sum, 1.0f, 1e-4f);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        float u = (i + 0.5f) / 100;
+        float pdf = 0.0f;
+
+        int light_index = sampler.sample(lights.begin(), lights.end(), pos, normal, u, pdf);
+
+        ASSERT_GE(light_index, 0);
+        ASSERT_LT(light_index, static_cast<int>(lights.size()));
+
+        int prim_id = lights[light_index].geometry().prim_id;
+        EXPECT_GT(pdf, 0.0f);
+        EXPECT_NEAR(pdf, sampler.pdf(lights.begin(), lights.end(), prim_id, pos, normal), 1e-5f);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the alias table picks lights proportional to their power
+//
+
+TEST(LightSampler, Power)
+{
+    auto lights = make_lights(5, 3);
+
+    power_light_sampler sampler(lights.begin(), lights.end());
+    auto ref = sampler.ref();
+
+    float total = 0.0f;
+
+    for (auto const& l : lights)
+    {
+        total += get_light_bounds(l).power;
+    }
+
+    int n = 100000;
+    std::vector<int> counts(lights.size(), 0);
+
+    for (int i = 0; i < n; ++i)
+    {
+        float pdf = 0.0f;
+        int light_index = ref.sample(lights.begin(), lights.end(), vec3(0.0f), vec3(0.0f), (i + 0.5f) / n, pdf);
+
+        EXPECT_FLOAT_EQ(pdf, get_light_bounds(lights[light_index]).power / total);
+        counts[light_index]++;
+    }
+
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        float expected = get_light_bounds(lights[i]).power / total;
+        EXPECT_NEAR(counts[i] / static_cast<float>(n), expected, 1e-3f);
+    }
+
+    test_sampler_pdfs(ref, lights, vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+
+    // Primitives that are not lights
+    EXPECT_EQ(ref.pdf(lights.begin(), lights.end(), 0, vec3(0.0f), vec3(0.0f)), 0.0f);
+    EXPECT_EQ(ref.pdf(lights.begin(), lights.end(), 1000, vec3(0.0f), vec3(0.0f)), 0.0f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test light BVH pdfs and that close lights facing the shading point are preferred
+//
+
+TEST(LightSampler, LightBVH)
+{
+    auto lights = make_lights(8, 0);
+
+    light_bvh bvh(lights.begin(), lights.end());
+    auto ref = bvh.ref();
+
+    ASSERT_EQ(bvh.nodes().size(), 2 * lights.size() - 1);
+
+    // Node bounds contain their children, power adds up
+    for (auto const& node : bvh.nodes())
+    {
+        if (!node.is_leaf)
+        {
+            auto const& l = bvh.nodes()[node.index];
+            auto const& r = bvh.nodes()[node.index + 1];
+
+            EXPECT_TRUE(node.bbox.contains(l.bbox));
+            EXPECT_TRUE(node.bbox.contains(r.bbox));
+            EXPECT_NEAR(node.power, l.power + r.power, 1e-4f * node.power);
+
+            // All lights face down
+            EXPECT_NEAR(abs(dot(node.axis, vec3(0.0f, 1.0f, 0.0f))), 1.0f, 1e-5f);
+            EXPECT_LT(node.theta_o, 1e-3f);
+        }
+    }
+
+    vec3 up(0.0f, 1.0f, 0.0f);
+
+    test_sampler_pdfs(ref, lights, vec3(0.0f), up);
+    test_sampler_pdfs(ref, lights, vec3(-7.5f, 0.0f, 3.0f), up);
+    test_sampler_pdfs(ref, lights, vec3(2.0f, 0.5f, -1.0f), normalize(vec3(1.0f, 1.0f, 0.0f)));
+
+    // Shading point right below a light
+    vec3 pos(-8.0f, 0.9f, -8.0f);
+    float near_pdf = ref.pdf(lights.begin(), lights.end(), 0, pos, up);
+    float far_pdf = ref.pdf(lights.begin(), lights.end(), 63, pos, up);
+
+    EXPECT_GT(near_pdf, 0.5f);
+    EXPECT_LT(far_pdf, near_pdf * 1e-2f);
+
+    // Shading point facing away from all lights, any light can be picked
+    test_sampler_pdfs(ref, lights, vec3(0.0f, 0.5f, 0.0f), -up);
+
+    // Single light
+    light_bvh single(lights.begin(), lights.begin() + 1);
+    EXPECT_FLOAT_EQ(single.ref().pdf(lights.begin(), lights.begin() + 1, 0, pos, up), 1.0f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test light bounds of generic and point lights
+//
+
+TEST(LightSampler, GenericLight)
+{
+    using generic_light_type = generic_light<point_light<float>, spot_light<float>, light_type>;
+
+    point_light<float> pl;
+    pl.set_cl(vec3(1.0f));
+    pl.set_kl(2.0f);
+    pl.set_position(vec3(1.0f, 2.0f, 3.0f));
+    pl.set_constant_attenuation(1.0f);
+    pl.set_linear_attenuation(0.0f);
+    pl.set_quadratic_attenuation(0.0f);
+
+    auto al = make_light(make_light_triangle(vec3(0.0f), 1.0f, 7), 3.0f);
+
+    std::vector<generic_light_type> lights;
+    lights.push_back(pl);
+    lights.push_back(al);
+
+    auto pb = get_light_bounds(lights[0]);
+    EXPECT_EQ(pb.prim_id, -1);
+    EXPECT_FLOAT_EQ(pb.power, 2.0f);
+    EXPECT_TRUE(all(pb.bbox.center() == vec3(1.0f, 2.0f, 3.0f)));
+    EXPECT_FLOAT_EQ(pb.theta_o, constants::pi_over_two<float>());
+
+    auto ab = get_light_bounds(lights[1]);
+    EXPECT_EQ(ab.prim_id, 7);
+    EXPECT_FLOAT_EQ(ab.power, 3.0f * area(al.geometry()));
+    EXPECT_FLOAT_EQ(ab.theta_o, 0.0f);
+
+    light_bvh bvh(lights.begin(), lights.end());
+    auto ref = bvh.ref();
+
+    // Only the area light can be hit
+    vec3 pos(0.0f, -1.0f, 0.0f);
+    vec3 up(0.0f, 1.0f, 0.0f);
+    float pdf = ref.pdf(lights.begin(), lights.end(), 7, pos, up);
+    EXPECT_GT(pdf, 0.0f);
+    EXPECT_LT(pdf, 1.0f);
+    EXPECT_NEAR(pdf + ref.light_pdf(0, pos, up), 1.0f, 1e-5f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that path tracing with different light samplers converges to the same result, and
+// that the light BVH reduces variance
+//
+
+int const num_paths = 40000;
+
+random_generator<float> make_test_generator(float)
+{
+    return random_generator<float>(1234);
+}
+
+random_generator<simd::float4> make_test_generator(simd::float4)
+{
+    array<unsigned, 4> seed = {{ 1234, 1235, 1236, 1237 }};
+    return random_generator<simd::float4>(seed);
+}
+
+void accumulate(float value, double& sum, double& sum2)
+{
+    sum += value;
+    sum2 += static_cast<double>(value) * value;
+}
+
+void accumulate(simd::float4 const& value, double& sum, double& sum2)
+{
+    simd::aligned_array_t<simd::float4> values;
+    store(values, value);
+
+    for (float v : values)
+    {
+        accumulate(v, sum, sum2);
+    }
+}
+
+template <typename S, typename Params>
+void render_floor_point(Params const& params, double& mean, double& variance)
+{
+    using V = vector<3, S>;
+
+    pathtracing::kernel<Params> kernel;
+    kernel.params = params;
+
+    auto gen = make_test_generator(S{});
+
+    int n = num_paths;
+    double sum = 0.0;
+    double sum2 = 0.0;
+
+    for (int i = 0; i < n / simd::num_elements<S>::value; ++i)
+    {
+        // Looking down on the floor at (0.3, 0, 0.1)
+        basic_ray<S> r(V(0.3f, 0.5f, 0.1f), V(0.0f, -1.0f, 0.0f));
+
+        auto result = kernel(r, gen);
+        accumulate(result.color.x, sum, sum2);
+    }
+
+    mean = sum / n;
+    variance = sum2 / n - mean * mean;
+}
+
+TEST(LightSampler, Pathtracing)
+{
+    using material_type = generic_material<matte<float>, emissive<float>>;
+
+    aligned_vector<triangle_type> triangles;
+
+    // Floor, geom_id 0
+    triangle_type f1(vec3(-20.0f, 0.0f, -20.0f), vec3(40.0f, 0.0f, 40.0f), vec3(40.0f, 0.0f, 0.0f));
+    triangle_type f2(vec3(-20.0f, 0.0f, -20.0f), vec3(0.0f, 0.0f, 40.0f), vec3(40.0f, 0.0f, 40.0f));
+    f1.prim_id = 0;
+    f2.prim_id = 1;
+    f1.geom_id = 0;
+    f2.geom_id = 0;
+    triangles.push_back(f1);
+    triangles.push_back(f2);
+
+    // Lights, geom_id 1, the light closest to the shading point is brighter (geom_id 2)
+    auto lights = make_lights(6, 2);
+    size_t bright = 21;
+
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        lights[i].set_kl(i == bright ? 30.0f : 3.0f);
+        lights[i].geometry().geom_id = i == bright ? 2 : 1;
+        triangles.push_back(lights[i].geometry());
+    }
+
+    matte<float> m;
+    m.cd() = from_rgb(vec3(0.8f));
+    m.kd() = 1.0f;
+
+    // Emission matches the light intensities
+    emissive<float> e;
+    e.ce() = from_rgb(vec3(1.0f));
+    e.ls() = 3.0f;
+
+    emissive<float> eb;
+    eb.ce() = from_rgb(vec3(1.0f));
+    eb.ls() = 30.0f;
+
+    aligned_vector<material_type> materials;
+    materials.push_back(m);
+    materials.push_back(e);
+    materials.push_back(eb);
+
+    auto params = make_kernel_params(
+            triangles.data(),
+            triangles.data() + triangles.size(),
+            materials.data(),
+            lights.data(),
+            lights.data() + lights.size(),
+            2,
+            1e-4f
+            );
+
+    power_light_sampler power(lights.begin(), lights.end());
+    light_bvh bvh(lights.begin(), lights.end());
+
+    double uniform_mean = 0.0;
+    double uniform_variance = 0.0;
+    render_floor_point<float>(params, uniform_mean, uniform_variance);
+
+    double power_mean = 0.0;
+    double power_variance = 0.0;
+    render_floor_point<float>(with_light_sampler(params, power.ref()), power_mean, power_variance);
+
+    double bvh_mean = 0.0;
+    double bvh_variance = 0.0;
+    render_floor_point<float>(with_light_sampler(params, bvh.ref()), bvh_mean, bvh_variance);
+
+    // SIMD
+    double simd_mean = 0.0;
+    double simd_variance = 0.0;
+    render_floor_point<simd::float4>(with_light_sampler(params, bvh.ref()), simd_mean, simd_variance);
+
+    // Means agree within four standard errors
+    auto max_error = [](double variance_a, double variance_b)
+    {
+        return 4.0 * std::sqrt((variance_a + variance_b) / num_paths);
+    };
+
+    EXPECT_GT(uniform_mean, 0.0);
+    EXPECT_NEAR(power_mean, uniform_mean, max_error(power_variance, uniform_variance));
+    EXPECT_NEAR(bvh_mean, uniform_mean, max_error(bvh_variance, uniform_variance));
+    EXPECT_NEAR(bvh_mean, power_mean, max_error(bvh_variance, power_variance));
+    EXPECT_NEAR(simd_mean, bvh_mean, max_error(simd_variance, bvh_variance));
+
+    EXPECT_LT(power_variance, uniform_variance);
+    EXPECT_LT(bvh_variance, power_variance);
+}
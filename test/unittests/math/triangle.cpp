@@ -1,7 +1,13 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <random>
+
+#include <visionaray/math/simd/simd.h>
+#include <visionaray/math/intersect.h>
+#include <visionaray/math/ray.h>
 #include <visionaray/math/triangle.h>
+#include <visionaray/math/woop_triangle.h>
 
 #include <gtest/gtest.h>
 
@@ -42,3 +48,148 @@ TEST(Triangle, Area)
 
     EXPECT_FLOAT_EQ(area(tri), 2.8284271f);
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Woop triangle and watertight intersection give the same hits as Moeller-Trumbore
+//
+
+TEST(Triangle, Intersect)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        basic_triangle<3, float> tri(
+                vec3(dist(rng), dist(rng), dist(rng)),
+                vec3(dist(rng), dist(rng), dist(rng)),
+                vec3(dist(rng), dist(rng), dist(rng))
+                );
+        tri.prim_id = i;
+        tri.geom_id = 1;
+
+        // Slivers are ill-conditioned, the tests will disagree on the barycentrics
+        if (length(cross(tri.e1, tri.e2)) < 0.1f)
+        {
+            continue;
+        }
+
+        basic_woop_triangle<float> woop(tri);
+
+        EXPECT_EQ(woop.prim_id, tri.prim_id);
+        EXPECT_EQ(woop.geom_id, tri.geom_id);
+
+        for (int j = 0; j < 20; ++j)
+        {
+            vec3 ori = vec3(dist(rng), dist(rng), dist(rng)) * 5.0f;
+            vec3 target = tri.v1 + tri.e1 * (dist(rng) + 0.5f) + tri.e2 * (dist(rng) + 0.5f);
+            basic_ray<float> ray(ori, normalize(target - ori));
+
+            auto ref = intersect(ray, tri);
+            auto hr1 = intersect(ray, woop);
+            auto hr2 = intersect_watertight(ray, tri);
+
+            // Skip rays that graze the plane or an edge, the tests may round differently there
+            if (abs(dot(ray.dir, normalize(cross(tri.e1, tri.e2)))) < 0.1f
+             || ref.u < 1e-4f || ref.v < 1e-4f || ref.u + ref.v > 1.0f - 1e-4f)
+            {
+                continue;
+            }
+
+            ASSERT_EQ(ref.hit, hr1.hit);
+            ASSERT_EQ(ref.hit, hr2.hit);
+
+            if (ref.hit)
+            {
+                EXPECT_NEAR(ref.t, hr1.t, 1e-3f * ref.t);
+                EXPECT_NEAR(ref.u, hr1.u, 1e-3f);
+                EXPECT_NEAR(ref.v, hr1.v, 1e-3f);
+                EXPECT_EQ(ref.prim_id, hr1.prim_id);
+
+                EXPECT_NEAR(ref.t, hr2.t, 1e-3f * ref.t);
+                EXPECT_NEAR(ref.u, hr2.u, 1e-3f);
+                EXPECT_NEAR(ref.v, hr2.v, 1e-3f);
+                EXPECT_EQ(ref.geom_id, hr2.geom_id);
+            }
+        }
+    }
+
+    // Degenerate triangles are never hit
+    basic_woop_triangle<float> degen(vec3(0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(2.0f, 0.0f, 0.0f));
+    basic_ray<float> ray(vec3(0.5f, 0.0f, 1.0f), vec3(0.0f, 0.0f, -1.0f));
+    EXPECT_FALSE(intersect(ray, degen).hit);
+    EXPECT_FALSE(intersect_watertight(ray, degen).hit);
+
+    // SIMD rays
+    basic_woop_triangle<float> woop(vec3(-1.0f, -1.0f, 0.0f), vec3(2.0f, 0.0f, 0.0f), vec3(0.0f, 2.0f, 0.0f));
+    woop.prim_id = 0;
+    woop.geom_id = 0;
+
+    basic_ray<simd::float4> packet(
+            vector<3, simd::float4>(
+                simd::float4(0.0f, 0.5f, -2.0f, 0.9f),
+                simd::float4(0.0f, -0.5f, 0.0f, 0.9f),
+                simd::float4(1.0f)
+                ),
+            vector<3, simd::float4>(
+                simd::float4(0.0f),
+                simd::float4(0.0f),
+                simd::float4(-1.0f)
+                )
+            );
+
+    auto hr1 = simd::unpack(intersect(packet, woop));
+    auto hr2 = simd::unpack(intersect_watertight(packet, static_cast<basic_triangle<3, float> const&>(woop)));
+
+    bool expected[] = { true, true, false, false };
+
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(hr1[i].hit, expected[i]);
+        EXPECT_EQ(hr2[i].hit, expected[i]);
+
+        if (expected[i])
+        {
+            EXPECT_FLOAT_EQ(hr1[i].t, 1.0f);
+            EXPECT_FLOAT_EQ(hr2[i].t, 1.0f);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Rays through the shared edge of two triangles hit at least one of them
+//
+
+TEST(Triangle, IntersectWatertight)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    // Edges are exact so that both triangles have the very same vertices
+    vec3 v1(-0.25f, 0.125f, 0.75f);
+    vec3 v2(1.875f, -0.25f, 0.25f);
+    vec3 v3(0.125f, 1.75f, -0.5f);
+    vec3 v4(2.25f, 2.125f, 0.25f);
+
+    // v2 - v3 is the shared edge
+    basic_triangle<3, float> t1(v1, v2 - v1, v3 - v1);
+    basic_triangle<3, float> t2(v4, v3 - v4, v2 - v4);
+
+    int misses = 0;
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        vec3 target = lerp(v2, v3, dist(rng));
+        vec3 ori = vec3(dist(rng), dist(rng), 1.0f) * 10.0f;
+        basic_ray<float> ray(ori, normalize(target - ori));
+
+        if (!intersect_watertight(ray, t1).hit && !intersect_watertight(ray, t2).hit)
+        {
+            ++misses;
+        }
+    }
+
+    EXPECT_EQ(misses, 0);
+}
@@ -166,3 +166,31 @@ TEST(Morton, Decode3D)
     ASSERT_EQ(p.y, 1);
     ASSERT_EQ(p.z, 1);
 }
+
+TEST(Morton, EncodeDecode3D64)
+{
+    unsigned long long z;
+
+    z = morton_encode3D_64(1, 0, 0);
+    ASSERT_EQ(z, 1ULL);
+    z = morton_encode3D_64(0, 1, 0);
+    ASSERT_EQ(z, 2ULL);
+    z = morton_encode3D_64(0, 0, 1);
+    ASSERT_EQ(z, 4ULL);
+
+    // Agrees with the 32-bit version for 10-bit coordinates
+    for (unsigned i = 0; i < 1024; i += 7)
+    {
+        z = morton_encode3D_64(i, 1023 - i, i / 2);
+        ASSERT_EQ(z, static_cast<unsigned long long>(morton_encode3D(i, 1023 - i, i / 2)));
+    }
+
+    // Highest bits, 21 bits per coordinate
+    z = morton_encode3D_64(0x1FFFFF, 0x1FFFFF, 0x1FFFFF);
+    ASSERT_EQ(z, 0x7FFFFFFFFFFFFFFFULL);
+
+    vec3ui p = morton_decode3D_64(morton_encode3D_64(0x1ABCDE, 0x012345, 0x1FFFFF));
+    ASSERT_EQ(p.x, 0x1ABCDEU);
+    ASSERT_EQ(p.y, 0x012345U);
+    ASSERT_EQ(p.z, 0x1FFFFFU);
+}
@@ -0,0 +1,253 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+
+#include <visionaray/math/simd/simd.h>
+#include <visionaray/quasi_random_generator.h>
+#include <visionaray/random_generator.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+// Check that the SIMD generator produces the same numbers as one scalar generator per lane
+template <template <typename> class Generator, typename T>
+void test_lanes_match_scalar(int x, int y, unsigned sample_index)
+{
+    static const int N = simd::num_elements<T>::value;
+
+    Generator<T> genN(x, y, sample_index);
+
+    Generator<float> gen1[N];
+
+    for (int i = 0; i < N; ++i)
+    {
+        int w = packet_size<T>::w;
+        gen1[i] = Generator<float>(x + i % w, y + i / w, sample_index);
+    }
+
+    for (int d = 0; d < 40; ++d)
+    {
+        simd::aligned_array_t<T> values;
+        store(values, genN.next());
+
+        for (int i = 0; i < N; ++i)
+        {
+            EXPECT_EQ(values[i], gen1[i].next());
+        }
+    }
+
+    // Lanes that were advanced individually stay in sync
+    genN.get_generator(1).next();
+    gen1[1].next();
+
+    simd::aligned_array_t<T> values;
+    store(values, genN.next());
+
+    for (int i = 0; i < N; ++i)
+    {
+        EXPECT_EQ(values[i], gen1[i].next());
+    }
+}
+
+template <template <typename> class Generator>
+void test_lanes_match_scalar()
+{
+    test_lanes_match_scalar<Generator, simd::float4>(16, 32, 7);
+    test_lanes_match_scalar<Generator, simd::float8>(16, 32, 7);
+    test_lanes_match_scalar<Generator, simd::float16>(16, 32, 7);
+}
+
+// Integrate f(u) = prod(u_d) * 2^Dim for all pixels of an image, one sample per frame,
+// and return the RMS error
+template <template <typename> class Generator, int Dim>
+double rms_error(int num_frames)
+{
+    static const int W = 16;
+    static const int H = 16;
+
+    double error = 0.0;
+
+    for (int y = 0; y < H; ++y)
+    {
+        for (int x = 0; x < W; ++x)
+        {
+            double sum = 0.0;
+
+            for (int i = 0; i < num_frames; ++i)
+            {
+                Generator<float> gen(x, y, i);
+
+                double f = 1.0;
+
+                for (int d = 0; d < Dim; ++d)
+                {
+                    f *= 2.0 * gen.next();
+                }
+
+                sum += f;
+            }
+
+            double e = sum / num_frames - 1.0;
+            error += e * e;
+        }
+    }
+
+    return std::sqrt(error / (W * H));
+}
+
+// Same with random_generator, seeded like the schedulers do
+template <int Dim>
+double rms_error_random(int num_frames)
+{
+    static const int W = 16;
+    static const int H = 16;
+
+    double error = 0.0;
+
+    for (int y = 0; y < H; ++y)
+    {
+        for (int x = 0; x < W; ++x)
+        {
+            double sum = 0.0;
+
+            for (int i = 0; i < num_frames; ++i)
+            {
+                random_generator<float> gen(detail::make_seed(y * W + x, i));
+
+                double f = 1.0;
+
+                for (int d = 0; d < Dim; ++d)
+                {
+                    f *= 2.0 * gen.next();
+                }
+
+                sum += f;
+            }
+
+            double e = sum / num_frames - 1.0;
+            error += e * e;
+        }
+    }
+
+    return std::sqrt(error / (W * H));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test quasi_random_generator
+//
+
+TEST(QuasiRandomGenerator, Range)
+{
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        sobol_generator<float> sobol(3, 5, i);
+        halton_generator<float> halton(3, 5, i);
+        blue_noise_generator<float> blue_noise(3, 5, i);
+
+        for (int d = 0; d < 64; ++d)
+        {
+            float u1 = sobol.next();
+            float u2 = halton.next();
+            float u3 = blue_noise.next();
+
+            EXPECT_TRUE(u1 >= 0.0f && u1 < 1.0f);
+            EXPECT_TRUE(u2 >= 0.0f && u2 < 1.0f);
+            EXPECT_TRUE(u3 >= 0.0f && u3 < 1.0f);
+        }
+    }
+}
+
+TEST(QuasiRandomGenerator, SobolStratification)
+{
+    // The first 2^(2k) points of every dimension pair are stratified in 2^k x 2^k cells
+    static const int K = 3;
+    static const int N = 1 << (2 * K);
+
+    for (int pair = 0; pair < 4; ++pair)
+    {
+        int cells[N] = {};
+
+        for (unsigned i = 0; i < N; ++i)
+        {
+            sobol_generator<float> gen(11, 13, i);
+
+            for (int d = 0; d < pair * 2; ++d)
+            {
+                gen.next();
+            }
+
+            int cx = static_cast<int>(gen.next() * (1 << K));
+            int cy = static_cast<int>(gen.next() * (1 << K));
+
+            cells[cy * (1 << K) + cx]++;
+        }
+
+        for (int i = 0; i < N; ++i)
+        {
+            EXPECT_EQ(cells[i], 1);
+        }
+    }
+}
+
+TEST(QuasiRandomGenerator, BlueNoiseNeighborsStratified)
+{
+    // Every 2x2 block of pixels covers all four quarters of [0,1), in all dimensions
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        for (int y = 0; y < 16; y += 2)
+        {
+            for (int x = 0; x < 16; x += 2)
+            {
+                blue_noise_generator<float> gen[4] = {
+                    { x,     y,     i },
+                    { x + 1, y,     i },
+                    { x,     y + 1, i },
+                    { x + 1, y + 1, i }
+                    };
+
+                for (int d = 0; d < 8; ++d)
+                {
+                    int quarters[4] = {};
+
+                    for (int p = 0; p < 4; ++p)
+                    {
+                        quarters[static_cast<int>(gen[p].next() * 4)]++;
+                    }
+
+                    for (int q = 0; q < 4; ++q)
+                    {
+                        EXPECT_EQ(quarters[q], 1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(QuasiRandomGenerator, LanesMatchScalar)
+{
+    test_lanes_match_scalar<sobol_generator>();
+    test_lanes_match_scalar<halton_generator>();
+    test_lanes_match_scalar<blue_noise_generator>();
+}
+
+TEST(QuasiRandomGenerator, Convergence)
+{
+    // Low-discrepancy sequences converge faster than random numbers for smooth integrands
+    double rnd = rms_error_random<4>(256);
+    double sobol = rms_error<sobol_generator, 4>(256);
+    double halton = rms_error<halton_generator, 4>(256);
+    double blue_noise = rms_error<blue_noise_generator, 4>(256);
+
+    EXPECT_LT(sobol, rnd);
+    EXPECT_LT(halton, rnd);
+    EXPECT_LT(blue_noise, rnd);
+}
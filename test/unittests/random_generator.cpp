@@ -0,0 +1,126 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <visionaray/math/simd/simd.h>
+#include <visionaray/random_generator.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+// Check that the SIMD generator produces the same numbers as one scalar generator per lane
+template <typename T>
+void test_lanes_match_scalar()
+{
+    static const int N = simd::num_elements<T>::value;
+
+    array<unsigned, N> seeds;
+
+    for (int i = 0; i < N; ++i)
+    {
+        seeds[i] = detail::make_seed(i, 23);
+    }
+
+    random_generator<T> rngN(seeds);
+
+    random_generator<float> rng1[N];
+
+    for (int i = 0; i < N; ++i)
+    {
+        rng1[i] = random_generator<float>(seeds[i]);
+    }
+
+    for (int n = 0; n < 100; ++n)
+    {
+        simd::aligned_array_t<T> values;
+        store(values, rngN.next());
+
+        for (int i = 0; i < N; ++i)
+        {
+            EXPECT_EQ(values[i], rng1[i].next());
+        }
+    }
+
+    // Lanes that were advanced individually stay in sync
+    rngN.get_generator(0).next();
+    rng1[0].next();
+
+    simd::aligned_array_t<T> values;
+    store(values, rngN.next());
+
+    for (int i = 0; i < N; ++i)
+    {
+        EXPECT_EQ(values[i], rng1[i].next());
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test random_generator
+//
+
+TEST(RandomGenerator, Reproducible)
+{
+    random_generator<float> rng1(detail::make_seed(4711, 0));
+    random_generator<float> rng2(detail::make_seed(4711, 0));
+    random_generator<float> rng3(detail::make_seed(4711, 1));
+
+    int num_different = 0;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        float a = rng1.next();
+        float b = rng2.next();
+        float c = rng3.next();
+
+        EXPECT_EQ(a, b);
+
+        num_different += a != c;
+    }
+
+    // Different frames give different streams
+    EXPECT_GT(num_different, 990);
+}
+
+TEST(RandomGenerator, Uniform)
+{
+    static const int NumSamples = 1 << 20;
+    static const int NumBins = 16;
+
+    random_generator<float> rng(0U);
+
+    int bins[NumBins] = {};
+    double mean = 0.0;
+
+    for (int i = 0; i < NumSamples; ++i)
+    {
+        float u = rng.next();
+
+        ASSERT_GE(u, 0.0f);
+        ASSERT_LT(u, 1.0f);
+
+        bins[static_cast<int>(u * NumBins)]++;
+        mean += u;
+    }
+
+    mean /= NumSamples;
+
+    EXPECT_NEAR(mean, 0.5, 0.005);
+
+    for (int i = 0; i < NumBins; ++i)
+    {
+        EXPECT_NEAR(bins[i], NumSamples / NumBins, NumSamples / NumBins / 50);
+    }
+}
+
+TEST(RandomGenerator, LanesMatchScalar)
+{
+    test_lanes_match_scalar<simd::float4>();
+    test_lanes_match_scalar<simd::float8>();
+    test_lanes_match_scalar<simd::float16>();
+}
@@ -1,10 +1,13 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details
 
+#include <algorithm>
+
 #include <visionaray/math/math.h>
 #include <visionaray/result_record.h>
 #include <visionaray/simple_buffer_rt.h>
 #include <visionaray/scheduler.h>
+#include <visionaray/tile_buffer_rt.h>
 
 #include <gtest/gtest.h>
 
@@ -64,6 +67,22 @@ void test_pixel_access_result_record(
     }, sparams);
 }
 
+// kernel returns random numbers and the primary ray direction
+struct noise_kernel
+{
+    template <typename R, typename Generator>
+    result_record<typename R::scalar_type> operator()(R const& r, Generator& gen) const
+    {
+        using S = typename R::scalar_type;
+
+        S u = gen.next();
+
+        result_record<S> result;
+        result.color = vector<4, S>(u, r.dir.x, r.dir.y, S(1.0));
+        return result;
+    }
+};
+
 
 //-------------------------------------------------------------------------------------------------
 // Test if pixel access to render targets works
@@ -110,3 +129,93 @@ TEST(RenderTarget, PixelFormats)
     EXPECT_FLOAT_EQ(rt_RGBA32F.color()[0].y, 0.4f);
     EXPECT_FLOAT_EQ(rt_RGBA32F.color()[0].z, 0.4f);
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that rendering an image tile by tile into tile render targets gives the same result
+// as rendering it into a full-frame render target
+//
+
+TEST(RenderTarget, Tiles)
+{
+    using rt_type = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+    using tile_type = tile_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+    // Not a multiple of the tile or packet size
+    int width = 37;
+    int height = 21;
+
+    mat4 mv = mat4::identity();
+    mat4 pr = mat4::identity();
+
+    rt_type full;
+    full.resize(width, height);
+
+    simple_sched<ray> sched;
+    sched.frame(noise_kernel{}, make_sched_params(pixel_sampler::uniform_type{}, mv, pr, full));
+
+
+    // Tiles w/ packets, 6 (partial) tiles of 16x8 pixels -----------------------
+
+    rt_type composite;
+    composite.resize(width, height);
+    composite.clear_color_buffer(vec4(-1.0f));
+
+    tiled_sched<basic_ray<simd::float4>> tsched(2);
+
+    tile_type tile;
+    tile.set_image_size(width, height);
+
+    for (int y = 0; y < height; y += 8)
+    {
+        for (int x = 0; x < width; x += 16)
+        {
+            tile.resize(std::min(16, width - x), std::min(8, height - y));
+            tile.set_offset(x, y);
+
+            EXPECT_EQ(tile.image_size(), vec2i(width, height));
+            EXPECT_EQ(tile.region(), recti(x, y, tile.width(), tile.height()));
+
+            tsched.frame(noise_kernel{}, make_sched_params(pixel_sampler::uniform_type{}, mv, pr, tile));
+            tile.copy_to(composite.ref());
+        }
+    }
+
+    for (int i = 0; i < width * height; ++i)
+    {
+        EXPECT_TRUE(all(composite.color()[i] == full.color()[i])) << "pixel " << i;
+    }
+
+
+    // Tile that exceeds the image is clipped ---------------------------------
+
+    tile.resize(8, 8);
+    tile.set_offset(width - 4, -4);
+    tile.clear_color_buffer(vec4(2.0f));
+    tile.copy_to(composite.ref());
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            vec4 expected = x >= width - 4 && y < 4 ? vec4(2.0f) : full.color()[y * width + x];
+            EXPECT_TRUE(all(composite.color()[y * width + x] == expected));
+        }
+    }
+
+
+    // Image size defaults to the tile size ------------------------------------
+
+    tile_type single;
+    single.resize(width, height);
+
+    EXPECT_EQ(single.offset(), vec2i(0));
+    EXPECT_EQ(single.image_size(), vec2i(width, height));
+
+    sched.frame(noise_kernel{}, make_sched_params(pixel_sampler::uniform_type{}, mv, pr, single));
+
+    for (int i = 0; i < width * height; ++i)
+    {
+        EXPECT_TRUE(all(single.color()[i] == full.color()[i]));
+    }
+}
@@ -66,6 +66,24 @@ struct some_struct_visitor
 };
 
 
+template <int I>
+struct alternative
+{
+    int value;
+};
+
+struct alternative_visitor
+{
+    using return_type = int;
+
+    template <int I>
+    int operator()(alternative<I> const& a) const
+    {
+        return I * 100 + a.value;
+    }
+};
+
+
 //-------------------------------------------------------------------------------------------------
 // Unit tests
 //
@@ -92,6 +110,10 @@ TEST(VariantTest, General)
 
     variant<int, double> var_id1 = double(0.0);
     EXPECT_TRUE( apply_visitor( is_double_visitor(), var_id1 ) );
+    EXPECT_EQ( var_id1.which(), 1U );
+
+    var_id1 = 42;
+    EXPECT_EQ( var_id1.which(), 0U );
 
 
     // struct with some members
@@ -111,3 +133,44 @@ TEST(VariantTest, General)
 
     EXPECT_STREQ( str1.c_str(), str2.c_str() );
 }
+
+
+TEST(VariantTest, Dispatch)
+{
+    // More alternatives than handled by one dispatch block
+
+    using variant_type = variant<
+        alternative<0>,
+        alternative<1>,
+        alternative<2>,
+        alternative<3>,
+        alternative<4>,
+        alternative<5>,
+        alternative<6>,
+        alternative<7>,
+        alternative<8>,
+        alternative<9>
+        >;
+
+    variant_type var;
+
+    // No alternative assigned
+    EXPECT_EQ( var.which(), unsigned(-1) );
+    EXPECT_EQ( apply_visitor( alternative_visitor(), var ), 0 );
+
+    var = alternative<0>{ 1 };
+    EXPECT_EQ( apply_visitor( alternative_visitor(), var ), 1 );
+
+    var = alternative<3>{ 2 };
+    EXPECT_EQ( apply_visitor( alternative_visitor(), var ), 302 );
+
+    var = alternative<7>{ 3 };
+    EXPECT_EQ( apply_visitor( alternative_visitor(), var ), 703 );
+
+    var = alternative<8>{ 4 };
+    EXPECT_EQ( apply_visitor( alternative_visitor(), var ), 804 );
+
+    var = alternative<9>{ 5 };
+    EXPECT_EQ( var.which(), 9U );
+    EXPECT_EQ( apply_visitor( alternative_visitor(), var ), 905 );
+}
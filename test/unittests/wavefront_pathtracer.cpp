@@ -0,0 +1,352 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/area_light.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/wavefront_pathtracer.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+using triangle_type = basic_triangle<3, float>;
+using light_type = area_light<float, triangle_type>;
+using material_type = generic_material<
+        emissive<float>,
+        glass<float>,
+        matte<float>,
+        mirror<float>,
+        plastic<float>
+        >;
+
+// Material type indices
+enum { EmissiveIndex, GlassIndex, MatteIndex, MirrorIndex, PlasticIndex };
+
+struct test_scene
+{
+    aligned_vector<triangle_type> triangles;
+    aligned_vector<material_type> materials;
+    aligned_vector<light_type>    lights;
+};
+
+static void add_quad(test_scene& scene, vec3 v1, vec3 e1, vec3 e2, int geom_id)
+{
+    triangle_type t1(v1, e1, e2);
+    triangle_type t2(v1 + e1 + e2, -e1, -e2);
+
+    t1.prim_id = static_cast<int>(scene.triangles.size());
+    t2.prim_id = t1.prim_id + 1;
+    t1.geom_id = geom_id;
+    t2.geom_id = geom_id;
+
+    scene.triangles.push_back(t1);
+    scene.triangles.push_back(t2);
+}
+
+// Box w/o front wall, emissive patch under the ceiling, mirror, plastic and glass panels
+static test_scene make_scene()
+{
+    test_scene scene;
+
+    matte<float> white;
+    white.ca() = from_rgb(vec3(0.0f));
+    white.ka() = 0.0f;
+    white.cd() = from_rgb(vec3(0.7f));
+    white.kd() = 1.0f;
+
+    emissive<float> light;
+    light.ce() = from_rgb(vec3(1.0f, 0.9f, 0.8f));
+    light.ls() = 8.0f;
+
+    mirror<float> m;
+    m.cr() = from_rgb(vec3(0.9f));
+    m.kr() = 1.0f;
+    m.ior() = spectrum<float>(0.0f);
+    m.absorption() = spectrum<float>(0.0f);
+
+    plastic<float> p;
+    p.ca() = from_rgb(vec3(0.0f));
+    p.ka() = 0.0f;
+    p.cd() = from_rgb(vec3(0.2f, 0.4f, 0.8f));
+    p.kd() = 1.0f;
+    p.cs() = from_rgb(vec3(0.3f));
+    p.ks() = 1.0f;
+    p.specular_exp() = 16.0f;
+
+    glass<float> g;
+    g.ct() = from_rgb(vec3(0.9f));
+    g.kt() = 1.0f;
+    g.cr() = from_rgb(vec3(0.9f));
+    g.kr() = 1.0f;
+    g.ior() = spectrum<float>(1.5f);
+
+    scene.materials.push_back(white);   // geom_id 0
+    scene.materials.push_back(light);   // geom_id 1
+    scene.materials.push_back(m);       // geom_id 2
+    scene.materials.push_back(p);       // geom_id 3
+    scene.materials.push_back(g);       // geom_id 4
+
+    // Floor, ceiling, back wall, left and right walls
+    add_quad(scene, vec3(-1.0f, 0.0f, -1.0f), vec3(0.0f, 0.0f, 2.0f), vec3(2.0f, 0.0f, 0.0f), 0);
+    add_quad(scene, vec3(-1.0f, 2.0f, -1.0f), vec3(2.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 2.0f), 0);
+    add_quad(scene, vec3(-1.0f, 0.0f, -1.0f), vec3(2.0f, 0.0f, 0.0f), vec3(0.0f, 2.0f, 0.0f), 0);
+    add_quad(scene, vec3(-1.0f, 0.0f, -1.0f), vec3(0.0f, 2.0f, 0.0f), vec3(0.0f, 0.0f, 2.0f), 2);
+    add_quad(scene, vec3( 1.0f, 0.0f, -1.0f), vec3(0.0f, 0.0f, 2.0f), vec3(0.0f, 2.0f, 0.0f), 3);
+
+    // Light, facing down
+    size_t first_light = scene.triangles.size();
+    add_quad(scene, vec3(-0.3f, 1.99f, -0.3f), vec3(0.6f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.6f), 1);
+
+    for (size_t i = first_light; i < scene.triangles.size(); ++i)
+    {
+        light_type l(scene.triangles[i]);
+        l.set_cl(vec3(1.0f, 0.9f, 0.8f));
+        l.set_kl(8.0f);
+        scene.lights.push_back(l);
+    }
+
+    // Glass panel
+    add_quad(scene, vec3(-0.5f, 0.2f, 0.2f), vec3(0.6f, 0.0f, 0.0f), vec3(0.0f, 0.8f, 0.0f), 4);
+
+    return scene;
+}
+
+static auto make_params(test_scene const& scene)
+    -> decltype(make_kernel_params(
+            scene.triangles.data(),
+            scene.triangles.data(),
+            scene.materials.data(),
+            scene.lights.data(),
+            scene.lights.data(),
+            5,
+            1e-4f
+            ))
+{
+    return make_kernel_params(
+            scene.triangles.data(),
+            scene.triangles.data() + scene.triangles.size(),
+            scene.materials.data(),
+            scene.lights.data(),
+            scene.lights.data() + scene.lights.size(),
+            5,
+            1e-4f
+            );
+}
+
+int const num_pixels = 64;
+int const num_samples = 256;
+
+// Primary rays through an 8x8 grid, num_samples rays per pixel
+static void make_camera_rays(std::vector<basic_ray<float>>& rays, std::vector<unsigned>& seeds)
+{
+    for (int s = 0; s < num_samples; ++s)
+    {
+        for (int p = 0; p < num_pixels; ++p)
+        {
+            float x = ((p % 8) + 0.5f) / 8.0f * 1.6f - 0.8f;
+            float y = ((p / 8) + 0.5f) / 8.0f * 1.6f + 0.2f;
+
+            vec3 ori(0.0f, 1.0f, 3.0f);
+            vec3 dir = normalize(vec3(x, y, -1.0f) - vec3(0.0f, 1.0f, 2.0f));
+
+            rays.push_back(basic_ray<float>(ori, dir));
+            seeds.push_back(detail::make_seed(p, 0, s));
+        }
+    }
+}
+
+// Per pixel mean and variance of the summed color channels
+struct pixel_estimate
+{
+    double mean = 0.0;
+    double variance = 0.0;
+};
+
+template <typename Results>
+static std::vector<pixel_estimate> estimate_pixels(Results const& results)
+{
+    std::vector<double> sum(num_pixels, 0.0);
+    std::vector<double> sum2(num_pixels, 0.0);
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        double value = results[i].color.x + results[i].color.y + results[i].color.z;
+
+        sum[i % num_pixels] += value;
+        sum2[i % num_pixels] += value * value;
+    }
+
+    std::vector<pixel_estimate> result(num_pixels);
+
+    for (int p = 0; p < num_pixels; ++p)
+    {
+        result[p].mean = sum[p] / num_samples;
+        result[p].variance = sum2[p] / num_samples - result[p].mean * result[p].mean;
+    }
+
+    return result;
+}
+
+// Expect the estimates to agree within 5 sigma of their difference
+static void expect_same_estimate(std::vector<pixel_estimate> const& a, std::vector<pixel_estimate> const& b)
+{
+    double total_a = 0.0;
+    double total_b = 0.0;
+    double total_variance = 0.0;
+
+    for (int p = 0; p < num_pixels; ++p)
+    {
+        double variance = (a[p].variance + b[p].variance) / num_samples;
+
+        EXPECT_NEAR(a[p].mean, b[p].mean, 5.0 * std::sqrt(variance) + 1e-6) << "pixel " << p;
+
+        total_a += a[p].mean;
+        total_b += b[p].mean;
+        total_variance += variance;
+    }
+
+    EXPECT_GT(total_a, 0.0);
+    EXPECT_NEAR(total_a, total_b, 5.0 * std::sqrt(total_variance));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that the wavefront path tracer computes the same estimate as pathtracing::kernel
+//
+
+TEST(WavefrontPathtracer, MatchesKernel)
+{
+    auto scene = make_scene();
+    auto params = make_params(scene);
+
+    std::vector<basic_ray<float>> rays;
+    std::vector<unsigned> seeds;
+    make_camera_rays(rays, seeds);
+
+    size_t n = rays.size();
+
+    pathtracing::kernel<decltype(params)> kernel;
+    kernel.params = params;
+
+    std::vector<result_record<float>> kernel_results(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        random_generator<float> gen(seeds[i] ^ 0x5bd1e995u);
+        kernel_results[i] = kernel(rays[i], gen);
+    }
+
+    wavefront_pathtracer<decltype(params)> scalar(params);
+    wavefront_pathtracer<decltype(params), simd::float4> packets(params);
+
+    std::vector<result_record<float>> scalar_results(n);
+    std::vector<result_record<float>> packet_results(n);
+
+    scalar.trace(rays.data(), seeds.data(), n, scalar_results.data());
+    packets.trace(rays.data(), seeds.data(), n, packet_results.data());
+
+    auto expected = estimate_pixels(kernel_results);
+
+    expect_same_estimate(expected, estimate_pixels(scalar_results));
+    expect_same_estimate(expected, estimate_pixels(packet_results));
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        EXPECT_EQ(kernel_results[i].hit, scalar_results[i].hit);
+        EXPECT_EQ(kernel_results[i].hit, packet_results[i].hit);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that results are reproducible, also for partial packets
+//
+
+TEST(WavefrontPathtracer, Reproducible)
+{
+    auto scene = make_scene();
+    auto params = make_params(scene);
+
+    std::vector<basic_ray<float>> rays;
+    std::vector<unsigned> seeds;
+    make_camera_rays(rays, seeds);
+
+    // Not a multiple of the packet width
+    size_t n = rays.size() - 3;
+
+    wavefront_pathtracer<decltype(params), simd::float4> wavefront(params);
+
+    std::vector<result_record<float>> results1(n);
+    std::vector<result_record<float>> results2(n);
+
+    wavefront.trace(rays.data(), seeds.data(), n, results1.data());
+    wavefront.trace(rays.data(), seeds.data(), n, results2.data());
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        EXPECT_EQ(results1[i].hit, results2[i].hit);
+        EXPECT_FLOAT_EQ(results1[i].color.x, results2[i].color.x);
+        EXPECT_FLOAT_EQ(results1[i].color.y, results2[i].color.y);
+        EXPECT_FLOAT_EQ(results1[i].color.z, results2[i].color.z);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that hits are binned by material type
+//
+
+TEST(WavefrontPathtracer, Binning)
+{
+    auto scene = make_scene();
+    auto params = make_params(scene);
+
+    std::vector<basic_ray<float>> rays;
+    std::vector<unsigned> seeds;
+    make_camera_rays(rays, seeds);
+
+    size_t n = num_pixels;
+
+    // Primary rays only
+    params.num_bounces = 1;
+
+    wavefront_pathtracer<decltype(params), simd::float4> wavefront(params);
+
+    std::vector<result_record<float>> results(n);
+    wavefront.trace(rays.data(), seeds.data(), n, results.data());
+
+    size_t counts[5] = { 0, 0, 0, 0, 0 };
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto hr = closest_hit(rays[i], scene.triangles.begin(), scene.triangles.end());
+
+        if (hr.hit)
+        {
+            ++counts[scene.materials[hr.geom_id].which()];
+        }
+    }
+
+    EXPECT_EQ(counts[MatteIndex], wavefront.num_shaded(MatteIndex));
+    EXPECT_EQ(counts[EmissiveIndex], wavefront.num_shaded(EmissiveIndex));
+    EXPECT_EQ(counts[MirrorIndex], wavefront.num_shaded(MirrorIndex));
+    EXPECT_EQ(counts[PlasticIndex], wavefront.num_shaded(PlasticIndex));
+    EXPECT_EQ(counts[GlassIndex], wavefront.num_shaded(GlassIndex));
+
+    EXPECT_GT(wavefront.num_shaded(MatteIndex), size_t(0));
+    EXPECT_GT(wavefront.num_shaded(GlassIndex), size_t(0));
+}